@@ -0,0 +1,2832 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* Бенчмарк моделей процентов выплат
+ *
+ * Сверяет быстрые пути (курсор календаря, таблица, пакетные методы, поиск символа,
+ * модель с правилами времени компиляции, маршрутизатор сделок, файл поверхности выплат,
+ * распределение ставок между сигналами)
+ * с эталонной реализацией на каждой минуте недели и праздничных дней,
+ * затем измеряет время вызовов на нескольких распределениях меток времени.
+ *
+ * Параметры запуска:
+ * --check-only             только сверка с эталонной реализацией
+ * --bench-only             только измерение времени
+ * --filter <строка>        измерять только тесты, в имени которых есть строка
+ * --min-time-ms <мс>       минимальное время измерения одного теста (по умолчанию 100)
+ * --save-baseline <файл>   сохранить результаты как базовые
+ * --baseline <файл>        сравнить результаты с базовыми
+ * --threshold <процент>    допустимое замедление относительно базовых результатов (по умолчанию 10)
+ *
+ * Код возврата: 0 - успех, 1 - расхождение с эталонной реализацией,
+ * 2 - замедление больше допустимого, 3 - ошибка параметров или файла
+ */
+
+#include "intrade-bar-payout-model.hpp"
+#include "intrade-bar-payout-table.hpp"
+#include "grandcapital-payout-model.hpp"
+#include "payout-model-policy.hpp"
+#include "payout-model-router.hpp"
+#include "payout-model-surface.hpp"
+#include "payout-model-portfolio.hpp"
+#include "payout-model-backtest.hpp"
+#include "payout-model-monte-carlo.hpp"
+#include "payout-model-trading-calendar.hpp"
+#include "payout-model-stats.hpp"
+#include "payout-model-trace.hpp"
+#include "payout-model-signal-file.hpp"
+#include "payout-model-segments.hpp"
+#include "payout-model-rcu.hpp"
+#include "payout-model-rules.hpp"
+#include "payout-model-timeline.hpp"
+#if defined(PAYOUT_MODEL_BENCHMARK_C_API)
+#include "payout-model-c.h"
+#endif
+#include "reference/intrade-bar-payout-model.hpp"
+#include "reference/grandcapital-payout-model.hpp"
+#include <chrono>
+#include <vector>
+#include <array>
+#include <string>
+#include <map>
+#include <limits>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+namespace {
+
+    /// Параметры модели брокера Intrade.bar для сверки и бенчмарка
+    class IntradeBarTraits {
+    public:
+        typedef payout_model::IntradeBar Model;
+        typedef payout_model_reference::IntradeBar Reference;
+        typedef payout_model::IntradeBarPolicy Policy;
+        static constexpr const char *NAME = "intrade_bar";
+        static const uint32_t PAIRS = payout_model::INTRADE_BAR_CURRENCY_PAIRS;
+        static const bool IS_EXIT_IN_SESSION = true;    ///< Экспирация должна закончиться до конца сессии
+
+        static const std::string get_pair_name(const uint32_t index) {
+            return std::string(payout_model::intrade_bar_currency_pairs[index]);
+        }
+
+        static const payout_model::IntradeBarRules &get_rules(const payout_model::PayoutRules &rules) {
+            return rules.intrade_bar;
+        }
+
+        static const std::vector<uint32_t> &get_check_durations() {
+            static const std::vector<uint32_t> durations = {
+                0, 59, 60, 61, 120, 179, 180, 181, 239, 240, 300, 3600, 30000, 30001};
+            return durations;
+        }
+
+        /// Все длительности, которые принимает брокер (с шагом в минуту)
+        static const std::vector<uint32_t> &get_all_durations() {
+            static const std::vector<uint32_t> durations = [](){
+                std::vector<uint32_t> temp = {60, 180};
+                for(uint32_t d = 240; d <= 30000; d += 60) temp.push_back(d);
+                return temp;
+            }();
+            return durations;
+        }
+
+        static const std::vector<uint32_t> &get_bench_durations() {
+            static const std::vector<uint32_t> durations = {60, 180, 180, 300, 600, 3600};
+            return durations;
+        }
+    };
+
+    /// Параметры модели брокера Grandcapital для сверки и бенчмарка
+    class GrandcapitalTraits {
+    public:
+        typedef payout_model::Grandcapital Model;
+        typedef payout_model_reference::Grandcapital Reference;
+        typedef payout_model::GrandcapitalPolicy Policy;
+        static constexpr const char *NAME = "grandcapital";
+        static const uint32_t PAIRS = payout_model::GRANDCAPITAL_CURRENCY_PAIRS;
+        static const bool IS_EXIT_IN_SESSION = false;   ///< Экспирация может выходить за конец сессии
+
+        static const std::string get_pair_name(const uint32_t index) {
+            return std::string(payout_model::grandcapital_currency_pairs[index]);
+        }
+
+        static const payout_model::GrandcapitalRules &get_rules(const payout_model::PayoutRules &rules) {
+            return rules.grandcapital;
+        }
+
+        static const std::vector<uint32_t> &get_check_durations() {
+            static const std::vector<uint32_t> durations = {
+                0, 59, 60, 61, 180, 3600, 14400, 86400, 172800, 172801};
+            return durations;
+        }
+
+        /// Длительности, которые принимает брокер (с шагом в минуту до часа, затем с шагом в час)
+        static const std::vector<uint32_t> &get_all_durations() {
+            static const std::vector<uint32_t> durations = [](){
+                std::vector<uint32_t> temp;
+                for(uint32_t d = 60; d < 3600; d += 60) temp.push_back(d);
+                for(uint32_t d = 3600; d <= 172800; d += 3600) temp.push_back(d);
+                return temp;
+            }();
+            return durations;
+        }
+
+        static const std::vector<uint32_t> &get_bench_durations() {
+            static const std::vector<uint32_t> durations = {60, 180, 300, 3600, 14400, 86400};
+            return durations;
+        }
+    };
+
+    const double check_amounts[] = {0.5, 10.0, 100.0, 6000.0};
+    const double check_balances[] = {20.0, 10000.0};
+    const double check_winrates[] = {0.5, 0.55, 0.56, 0.6, 0.7};
+
+    /// Ограничители для get_amount: без ограничений, по выплате, по винрейту
+    const double check_payout_limiters[] = {1.0, 0.8, 1.0};
+    const double check_winrate_limiters[] = {1.0, 1.0, 0.58};
+
+    /** \brief Счетчик расхождений с эталонной реализацией
+     */
+    class CheckReport {
+    public:
+        static const uint64_t MAX_MESSAGES = 10;
+        uint64_t cases = 0;
+        uint64_t errors = 0;
+
+        template<class T>
+        inline void compare(const T &value, const T &reference) {
+            ++cases;
+            if(std::memcmp(&value, &reference, sizeof(T)) == 0) return;
+            ++errors;
+        }
+
+        /** \brief Сравнить результат вызова с эталонным
+         * \return Вернет true, если результаты совпадают
+         */
+        bool compare_call(
+                const char *broker,
+                const char *path,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const uint32_t index,
+                const int err,
+                const double value,
+                const int reference_err,
+                const double reference_value) {
+            ++cases;
+            if(err == reference_err && std::memcmp(&value, &reference_value, sizeof(double)) == 0) return true;
+            if(errors++ < MAX_MESSAGES) {
+                std::printf("mismatch %s %s: %s duration %u pair %u: %d %.17g, reference %d %.17g\n",
+                    broker, path, xtime::get_str_date_time(timestamp).c_str(), duration, index,
+                    err, value, reference_err, reference_value);
+            }
+            return false;
+        }
+    };
+
+    /** \brief Метки времени для сверки
+     *
+     * Каждая минута полной недели (с понедельника), а также 25 декабря и 1 января.
+     * Секунда внутри минуты меняется от минуты к минуте и проходит все значения от 0 до 59.
+     */
+    std::vector<xtime::timestamp_t> get_check_timestamps() {
+        std::vector<xtime::timestamp_t> days;
+        const xtime::timestamp_t week_begin = xtime::get_timestamp(2, 3, 2020);
+        for(uint32_t d = 0; d < xtime::DAYS_IN_WEEK; ++d) {
+            days.push_back(week_begin + d * xtime::SECONDS_IN_DAY);
+        }
+        days.push_back(xtime::get_timestamp(25, 12, 2019));
+        days.push_back(xtime::get_timestamp(1, 1, 2020));
+        std::vector<xtime::timestamp_t> timestamps;
+        for(const xtime::timestamp_t day : days) {
+            for(uint32_t m = 0; m < xtime::MINUTES_IN_DAY; ++m) {
+                timestamps.push_back(day + m * xtime::SECONDS_IN_MINUTE + (m * 13) % xtime::SECONDS_IN_MINUTE);
+            }
+        }
+        return timestamps;
+    }
+
+    /** \brief Сверить быстрые пути модели с эталонной реализацией
+     * \param currency Валюта счета
+     * \param report Счетчик расхождений
+     */
+    template<class TRAITS>
+    void check_model(const uint32_t currency, CheckReport &report) {
+        typedef typename TRAITS::Model Model;
+        typedef typename TRAITS::Reference Reference;
+        const Model model(currency);
+        Reference reference(currency);
+        const std::vector<uint32_t> &durations = TRAITS::get_check_durations();
+        const std::vector<xtime::timestamp_t> timestamps = get_check_timestamps();
+
+        std::vector<std::string> names;
+        for(uint32_t p = 0; p < TRAITS::PAIRS; ++p) {
+            names.push_back(TRAITS::get_pair_name(p));
+        }
+        names.push_back("XXXYYY");
+
+        /* массивы пакетных вызовов для одной метки времени */
+        std::vector<xtime::timestamp_t> batch_timestamp;
+        std::vector<uint32_t> batch_duration, batch_index;
+        std::vector<double> batch_amount, batch_balance, batch_winrate, batch_attenuator;
+        std::vector<double> batch_payout_limiter, batch_winrate_limiter;
+        std::vector<double> batch_out_payout, batch_out_amount;
+        std::vector<int> batch_err;
+        std::vector<double> expected_payout, expected_amount;
+        std::vector<int> expected_err;
+
+        payout_model::CalendarCursor cursor;
+        cursor.reset(timestamps.front());
+        for(size_t t = 0; t < timestamps.size(); ++t) {
+            const xtime::timestamp_t timestamp = timestamps[t];
+            cursor.update(timestamp);
+
+            report.compare_call(TRAITS::NAME, "check_timestamp", timestamp, 0, 0,
+                Model::check_timestamp(timestamp), 0, Reference::check_timestamp(timestamp), 0);
+            report.compare_call(TRAITS::NAME, "check_timestamp(cursor)", timestamp, 0, 0,
+                Model::check_timestamp(cursor), 0, Reference::check_timestamp(timestamp), 0);
+
+            /* get_payout: индекс, курсор, пакет */
+            batch_timestamp.clear();
+            batch_duration.clear();
+            batch_index.clear();
+            batch_amount.clear();
+            expected_payout.clear();
+            expected_err.clear();
+            for(const uint32_t duration : durations)
+            for(uint32_t p = 0; p < TRAITS::PAIRS; ++p)
+            for(const double amount : check_amounts) {
+                double reference_payout = -1.0, payout = -1.0, cursor_payout = -1.0;
+                const int reference_err = reference.get_payout(reference_payout, timestamp, duration, p, amount);
+                const int err = model.get_payout(payout, timestamp, duration, p, amount);
+                const int cursor_err = model.get_payout(cursor_payout, cursor, duration, p, amount);
+                report.compare_call(TRAITS::NAME, "get_payout", timestamp, duration, p,
+                    err, payout, reference_err, reference_payout);
+                report.compare_call(TRAITS::NAME, "get_payout(cursor)", timestamp, duration, p,
+                    cursor_err, cursor_payout, reference_err, reference_payout);
+                batch_timestamp.push_back(timestamp);
+                batch_duration.push_back(duration);
+                batch_index.push_back(p);
+                batch_amount.push_back(amount);
+                expected_payout.push_back(reference_payout);
+                expected_err.push_back(reference_err);
+            }
+            batch_out_payout.assign(batch_timestamp.size(), -1.0);
+            batch_err.assign(batch_timestamp.size(), 1);
+            model.get_payout(batch_out_payout.data(), batch_err.data(), batch_timestamp.data(),
+                batch_duration.data(), batch_index.data(), batch_amount.data(), batch_timestamp.size());
+            for(size_t i = 0; i < batch_timestamp.size(); ++i) {
+                report.compare_call(TRAITS::NAME, "get_payout(batch)", timestamp, batch_duration[i], batch_index[i],
+                    batch_err[i], batch_out_payout[i], expected_err[i], expected_payout[i]);
+            }
+
+            /* get_payout по имени символа, одна длительность на метку времени */
+            const uint32_t name_duration = durations[t % durations.size()];
+            for(uint32_t p = 0; p < names.size(); ++p)
+            for(const double amount : check_amounts) {
+                double reference_payout = -1.0, payout = -1.0;
+                const int reference_err = reference.get_payout(reference_payout, names[p], timestamp, name_duration, amount);
+                const int err = model.get_payout(payout, names[p], timestamp, name_duration, amount);
+                report.compare_call(TRAITS::NAME, "get_payout(name)", timestamp, name_duration, p,
+                    err, payout, reference_err, reference_payout);
+            }
+
+            /* get_amount: индекс, курсор, имя, пакет */
+            batch_timestamp.clear();
+            batch_duration.clear();
+            batch_index.clear();
+            batch_balance.clear();
+            batch_winrate.clear();
+            batch_attenuator.clear();
+            batch_payout_limiter.clear();
+            batch_winrate_limiter.clear();
+            expected_amount.clear();
+            expected_payout.clear();
+            expected_err.clear();
+            const size_t limiter = t % 3;
+            const double payout_limiter = check_payout_limiters[limiter];
+            const double winrate_limiter = check_winrate_limiters[limiter];
+            const double balance = check_balances[(t / 3) % 2];
+            for(const uint32_t duration : durations)
+            for(uint32_t p = 0; p < TRAITS::PAIRS; ++p)
+            for(const double winrate : check_winrates) {
+                const double attenuator = 0.4;
+                double reference_amount = -1.0, reference_payout = -1.0;
+                const int reference_err = reference.get_amount(reference_amount, reference_payout, names[p],
+                    timestamp, duration, balance, winrate, attenuator, payout_limiter, winrate_limiter);
+
+                double amount = -1.0, payout = -1.0;
+                int err = model.get_amount(amount, payout, timestamp, duration, p,
+                    balance, winrate, attenuator, payout_limiter, winrate_limiter);
+                if(report.compare_call(TRAITS::NAME, "get_amount(payout)", timestamp, duration, p,
+                        err, payout, reference_err, reference_payout)) {
+                    report.compare_call(TRAITS::NAME, "get_amount", timestamp, duration, p,
+                        err, amount, reference_err, reference_amount);
+                }
+
+                amount = payout = -1.0;
+                err = model.get_amount(amount, payout, cursor, duration, p,
+                    balance, winrate, attenuator, payout_limiter, winrate_limiter);
+                report.compare_call(TRAITS::NAME, "get_amount(cursor)", timestamp, duration, p,
+                    err, amount, reference_err, reference_amount);
+
+                amount = payout = -1.0;
+                err = model.get_amount(amount, payout, names[p], timestamp, duration,
+                    balance, winrate, attenuator, payout_limiter, winrate_limiter);
+                report.compare_call(TRAITS::NAME, "get_amount(name)", timestamp, duration, p,
+                    err, amount, reference_err, reference_amount);
+
+                batch_timestamp.push_back(timestamp);
+                batch_duration.push_back(duration);
+                batch_index.push_back(p);
+                batch_balance.push_back(balance);
+                batch_winrate.push_back(winrate);
+                batch_attenuator.push_back(attenuator);
+                batch_payout_limiter.push_back(payout_limiter);
+                batch_winrate_limiter.push_back(winrate_limiter);
+                expected_amount.push_back(reference_amount);
+                expected_payout.push_back(reference_payout);
+                expected_err.push_back(reference_err);
+            }
+            batch_out_amount.assign(batch_timestamp.size(), -1.0);
+            batch_out_payout.assign(batch_timestamp.size(), -1.0);
+            batch_err.assign(batch_timestamp.size(), 1);
+            model.get_amount(batch_out_amount.data(), batch_out_payout.data(), batch_err.data(),
+                batch_timestamp.data(), batch_duration.data(), batch_index.data(),
+                batch_balance.data(), batch_winrate.data(), batch_attenuator.data(),
+                batch_payout_limiter.data(), batch_winrate_limiter.data(), batch_timestamp.size());
+            for(size_t i = 0; i < batch_timestamp.size(); ++i) {
+                if(report.compare_call(TRAITS::NAME, "get_amount(batch, payout)", timestamp, batch_duration[i], batch_index[i],
+                        batch_err[i], batch_out_payout[i], expected_err[i], expected_payout[i])) {
+                    report.compare_call(TRAITS::NAME, "get_amount(batch)", timestamp, batch_duration[i], batch_index[i],
+                        batch_err[i], batch_out_amount[i], expected_err[i], expected_amount[i]);
+                }
+            }
+        }
+
+        /* проверка имен символов, в том числе с суффиксами и неизвестных */
+        for(const std::string &name : names) {
+            const std::string variants[] = {name, name + "_OTC", name.substr(0, 5), ""};
+            for(const std::string &variant : variants) {
+                report.compare(Model::check_currecy_pair_name(variant), Reference::check_currecy_pair_name(variant));
+            }
+        }
+        for(uint32_t p = 0; p <= TRAITS::PAIRS; ++p) {
+            const std::string name(Model::get_currecy_pair_name(p));
+            report.compare_call(TRAITS::NAME, "get_currecy_pair_name", 0, 0, p,
+                name == Reference::get_currecy_pair_name(p), 0.0, 1, 0.0);
+        }
+    }
+
+    /** \brief Сверить модель с правилами времени компиляции с эталонной реализацией
+     * \param report Счетчик расхождений
+     */
+    template<class TRAITS, uint32_t CURRENCY>
+    void check_policy_model(CheckReport &report) {
+        typedef payout_model::PayoutModel<typename TRAITS::Policy, CURRENCY> Model;
+        typename TRAITS::Reference reference(CURRENCY);
+        const std::vector<uint32_t> &durations = TRAITS::get_check_durations();
+        const std::vector<xtime::timestamp_t> timestamps = get_check_timestamps();
+        payout_model::CalendarCursor cursor(timestamps.front());
+        for(size_t t = 0; t < timestamps.size(); ++t) {
+            const xtime::timestamp_t timestamp = timestamps[t];
+            cursor.update(timestamp);
+            for(const uint32_t duration : durations)
+            for(uint32_t p = 0; p < TRAITS::PAIRS; ++p) {
+                const std::string name = TRAITS::get_pair_name(p);
+                for(const double amount : check_amounts) {
+                    double reference_payout = -1.0, payout = -1.0, cursor_payout = -1.0;
+                    const int reference_err = reference.get_payout(reference_payout, timestamp, duration, p, amount);
+                    const int err = Model::get_payout(payout, timestamp, duration, p, amount);
+                    const int cursor_err = Model::get_payout(cursor_payout, cursor, duration, p, amount);
+                    report.compare_call(TRAITS::NAME, "PayoutModel::get_payout", timestamp, duration, p,
+                        err, payout, reference_err, reference_payout);
+                    report.compare_call(TRAITS::NAME, "PayoutModel::get_payout(cursor)", timestamp, duration, p,
+                        cursor_err, cursor_payout, reference_err, reference_payout);
+                }
+                const double winrate = check_winrates[(t + p) % (sizeof(check_winrates) / sizeof(check_winrates[0]))];
+                const double balance = check_balances[(t / 3) % 2];
+                double reference_amount = -1.0, reference_payout = -1.0, amount = -1.0, payout = -1.0;
+                const int reference_err = reference.get_amount(reference_amount, reference_payout, name,
+                    timestamp, duration, balance, winrate, 0.4);
+                const int err = Model::get_amount(amount, payout, cursor, duration, p, balance, winrate, 0.4);
+                if(report.compare_call(TRAITS::NAME, "PayoutModel::get_amount(payout)", timestamp, duration, p,
+                        err, payout, reference_err, reference_payout)) {
+                    report.compare_call(TRAITS::NAME, "PayoutModel::get_amount", timestamp, duration, p,
+                        err, amount, reference_err, reference_amount);
+                }
+            }
+        }
+    }
+
+    /** \brief Сверить табличную модель IntradeBar с эталонной реализацией
+     *
+     * Таблица с измененными правилами (отключенная эталонная пара, экспирация 1 минута,
+     * проценты выплат и пороги ставок) сверяется с моделью IntradeBar с теми же правилами.
+     * \param currency Валюта счета
+     * \param report Счетчик расхождений
+     */
+    void check_intrade_bar_table(const uint32_t currency, CheckReport &report) {
+        const payout_model::IntradeBarPayoutTable table(currency);
+        payout_model_reference::IntradeBar reference(currency);
+        const std::vector<uint32_t> &durations = IntradeBarTraits::get_check_durations();
+        const std::vector<xtime::timestamp_t> timestamps = get_check_timestamps();
+        for(const xtime::timestamp_t timestamp : timestamps)
+        for(const uint32_t duration : durations)
+        for(uint32_t p = 0; p < payout_model::INTRADE_BAR_CURRENCY_PAIRS; ++p)
+        for(const double amount : check_amounts) {
+            double reference_payout = -1.0, payout = -1.0;
+            const int reference_err = reference.get_payout(reference_payout, timestamp, duration, p, amount);
+            const int err = table.get_payout(payout, timestamp, duration, p, amount);
+            report.compare_call(IntradeBarTraits::NAME, "get_payout(table)", timestamp, duration, p,
+                err, payout, reference_err, reference_payout);
+        }
+
+        payout_model::IntradeBarRules rules;
+        rules.is_currency_pairs[0] = false;
+        rules.is_currency_pairs_1m_exp[1] = !rules.is_currency_pairs_1m_exp[1];
+        rules.high_payout = 0.9;
+        rules.low_payout_60 = 0.55;
+        rules.min_amount_rub = rules.min_amount_usd = check_amounts[1];
+        rules.threshold_amount_rub = rules.threshold_amount_usd = check_amounts[2];
+        payout_model::IntradeBarPayoutTable rules_table(currency);
+        const int rules_err = rules_table.set_rules(rules);
+        report.compare_call(IntradeBarTraits::NAME, "set_rules(table)", 0, 0, 0,
+            rules_err, 0.0, payout_model::ErrorType::OK, 0.0);
+        payout_model::IntradeBar model(currency);
+        model.set_rules(rules);
+        for(size_t t = 0; t < timestamps.size(); t += 3)
+        for(const uint32_t duration : durations)
+        for(uint32_t p = 0; p < payout_model::INTRADE_BAR_CURRENCY_PAIRS; ++p)
+        for(const double amount : check_amounts) {
+            double reference_payout = -1.0, payout = -1.0;
+            const int reference_err = model.get_payout(reference_payout, timestamps[t], duration, p, amount);
+            const int err = rules_table.get_payout(payout, timestamps[t], duration, p, amount);
+            report.compare_call(IntradeBarTraits::NAME, "get_payout(table, rules)", timestamps[t], duration, p,
+                err, payout, reference_err, reference_payout);
+        }
+    }
+
+    /** \brief Найти лучшую длительность эталонной реализацией
+     *
+     * Вызывает эталонный get_amount для каждой длительности из списка
+     * и выбирает длительность с наибольшим ростом депозита (первую при равенстве).
+     */
+    template<class REFERENCE>
+    int get_reference_best_duration(
+            uint32_t &best_duration, double &best_amount, double &best_payout,
+            REFERENCE &reference, const std::string &name, const xtime::timestamp_t timestamp,
+            const std::vector<uint32_t> &durations, const double balance, const double winrate, const double attenuator) {
+        best_duration = 0;
+        best_amount = best_payout = 0;
+        double best_growth = 0;
+        int first_err = 0;
+        for(size_t i = 0; i < durations.size(); ++i) {
+            double amount = 0, payout = 0;
+            const int err = reference.get_amount(amount, payout, name, timestamp, durations[i], balance, winrate, attenuator);
+            if(i == 0) first_err = err;
+            if(err != 0 || !(amount > 0)) continue;
+            const double growth = payout_model::get_log_growth(amount, payout, balance, winrate);
+            if(growth > best_growth) {
+                best_growth = growth;
+                best_duration = durations[i];
+                best_amount = amount;
+                best_payout = payout;
+            }
+        }
+        return best_duration != 0 ? 0 : first_err;
+    }
+
+    /** \brief Сверить поиск лучшей длительности с перебором эталонной реализацией
+     * \param currency Валюта счета
+     * \param report Счетчик расхождений
+     */
+    template<class TRAITS>
+    void check_best_duration(const uint32_t currency, CheckReport &report) {
+        const typename TRAITS::Model model(currency);
+        typename TRAITS::Reference reference(currency);
+        std::vector<std::vector<uint32_t>> lists = {TRAITS::get_check_durations(), TRAITS::get_check_durations()};
+        std::reverse(lists[1].begin(), lists[1].end());
+        const std::vector<xtime::timestamp_t> timestamps = get_check_timestamps();
+        const double attenuator = 0.4;
+        auto compare = [&](const char *method, const xtime::timestamp_t timestamp, const uint32_t p,
+                const int err, const uint32_t duration, const double amount, const double payout,
+                const int reference_err, const uint32_t reference_duration, const double reference_amount, const double reference_payout) {
+            if(report.compare_call(TRAITS::NAME, method, timestamp, duration, p, err, amount, reference_err, reference_amount)) {
+                report.compare_call(TRAITS::NAME, method, timestamp, duration, p,
+                    (int)duration, payout, (int)reference_duration, reference_payout);
+            }
+        };
+        payout_model::CalendarCursor cursor(timestamps.front());
+        for(size_t t = 0; t < timestamps.size(); ++t) {
+            const xtime::timestamp_t timestamp = timestamps[t];
+            cursor.update(timestamp);
+            const double balance = check_balances[(t / 3) % 2];
+            /* перебор эталонной реализацией медленный, поэтому проверяется только часть меток времени */
+            const bool is_all = t % 251 == 0;
+            if(t % 10 != 0 && !is_all) continue;
+            for(uint32_t p = 0; p < TRAITS::PAIRS; ++p)
+            for(const double winrate : check_winrates) {
+                const std::string name = TRAITS::get_pair_name(p);
+                uint32_t duration = 0, reference_duration = 0;
+                double amount = -1, payout = -1, reference_amount = 0, reference_payout = 0;
+                for(const std::vector<uint32_t> &list : lists) {
+                    const int reference_err = get_reference_best_duration(reference_duration, reference_amount, reference_payout,
+                        reference, name, timestamp, list, balance, winrate, attenuator);
+                    int err = model.get_best_duration(duration, amount, payout, timestamp, p,
+                        balance, winrate, attenuator, list.data(), list.size());
+                    compare("get_best_duration", timestamp, p, err, duration, amount, payout,
+                        reference_err, reference_duration, reference_amount, reference_payout);
+                    err = model.get_best_duration(duration, amount, payout, cursor, p,
+                        balance, winrate, attenuator, list.data(), list.size());
+                    compare("get_best_duration(cursor)", timestamp, p, err, duration, amount, payout,
+                        reference_err, reference_duration, reference_amount, reference_payout);
+                }
+                if(!is_all) continue;
+                const int reference_err = get_reference_best_duration(reference_duration, reference_amount, reference_payout,
+                    reference, name, timestamp, TRAITS::get_all_durations(), balance, winrate, attenuator);
+                int err = model.get_best_duration(duration, amount, payout, timestamp, p, balance, winrate, attenuator);
+                compare("get_best_duration(all)", timestamp, p, err, duration, amount, payout,
+                    reference_err, reference_duration, reference_amount, reference_payout);
+                err = model.get_best_duration(duration, amount, payout, cursor, p, balance, winrate, attenuator);
+                compare("get_best_duration(all, cursor)", timestamp, p, err, duration, amount, payout,
+                    reference_err, reference_duration, reference_amount, reference_payout);
+            }
+        }
+    }
+
+    /** \brief Проверить распределение ставок между сигналами
+     *
+     * Для одного сигнала ставка должна совпадать с эталонным get_amount, кроме случаев,
+     * когда распределитель поднимает ставку до минимальной или до порога повышенной выплаты
+     * и получает не меньший рост депозита. Для всех валютных пар в одну минуту
+     * проверяется, что сумма ставок меньше attenuator * balance и ставки не меньше минимальной.
+     * \param currency Валюта счета
+     * \param report Счетчик расхождений
+     */
+    template<class TRAITS>
+    void check_portfolio(const uint32_t currency, CheckReport &report) {
+        typedef typename TRAITS::Model Model;
+        const Model model(currency);
+        typename TRAITS::Reference reference(currency);
+        payout_model::PortfolioKellyAllocator allocator;
+        const std::vector<uint32_t> &durations = TRAITS::get_check_durations();
+        const std::vector<xtime::timestamp_t> timestamps = get_check_timestamps();
+        const double attenuator = 0.4;
+        auto is_model_err = [](const int err) {
+            return err != payout_model::ErrorType::OK &&
+                err != Model::PayoutCancelType::TOO_LITTLE_WINRATE &&
+                err != Model::PayoutCancelType::TOO_LITTLE_MONEY;
+        };
+        for(size_t t = 0; t < timestamps.size(); t += 3) {
+            const xtime::timestamp_t timestamp = timestamps[t];
+            const double balance = check_balances[(t / 3) % 2];
+            for(const uint32_t duration : durations)
+            for(uint32_t p = 0; p < TRAITS::PAIRS; ++p)
+            for(const double winrate : check_winrates) {
+                double reference_amount = 0, reference_payout = 0;
+                const int reference_err = reference.get_amount(reference_amount, reference_payout, TRAITS::get_pair_name(p),
+                    timestamp, duration, balance, winrate, attenuator);
+                double amount = -1, payout = -1;
+                int err = 1;
+                allocator.allocate(model, &amount, &payout, &err, &timestamp, &duration, &p, &winrate, 1, balance, attenuator);
+
+                int expected_err = reference_err;
+                double expected_amount = reference_amount;
+                if(is_model_err(reference_err)) {
+                    if(is_model_err(err)) expected_err = err;
+                } else
+                if(amount == 0.0 && reference_amount == 0.0) {
+                    if(!is_model_err(err)) expected_err = err;
+                } else
+                if(amount != reference_amount && err == payout_model::ErrorType::OK &&
+                    (amount == model.get_min_amount() || amount == model.get_threshold_amount())) {
+                    /* ставка поднята до границы уровня: рост должен быть не меньше эталонного */
+                    const double growth = payout_model::get_log_growth(amount / attenuator, payout, balance, winrate);
+                    const double reference_growth = reference_amount > 0.0 ?
+                        payout_model::get_log_growth(reference_amount / attenuator, reference_payout, balance, winrate) : 0.0;
+                    if(growth > 0.0 && growth >= reference_growth) {
+                        expected_err = err;
+                        expected_amount = amount;
+                    }
+                }
+                if(report.compare_call(TRAITS::NAME, "allocate", timestamp, duration, p,
+                        err, amount, expected_err, expected_amount) &&
+                    amount > 0.0 && amount == reference_amount) {
+                    report.compare_call(TRAITS::NAME, "allocate(payout)", timestamp, duration, p,
+                        err, payout, reference_err, reference_payout);
+                }
+            }
+
+            /* все валютные пары в одну минуту */
+            std::vector<xtime::timestamp_t> batch_timestamp(TRAITS::PAIRS, timestamp);
+            std::vector<uint32_t> batch_duration(TRAITS::PAIRS), batch_index(TRAITS::PAIRS);
+            std::vector<double> batch_winrate(TRAITS::PAIRS), batch_amount(TRAITS::PAIRS), batch_payout(TRAITS::PAIRS);
+            std::vector<int> batch_err(TRAITS::PAIRS);
+            for(uint32_t p = 0; p < TRAITS::PAIRS; ++p) {
+                batch_index[p] = p;
+                batch_duration[p] = TRAITS::get_bench_durations()[(p + t) % TRAITS::get_bench_durations().size()];
+                batch_winrate[p] = 0.56 + 0.01 * ((p + t) % 15);
+            }
+            allocator.allocate(model, batch_amount.data(), batch_payout.data(), batch_err.data(), batch_timestamp.data(),
+                batch_duration.data(), batch_index.data(), batch_winrate.data(), TRAITS::PAIRS, balance, attenuator);
+            double total = 0;
+            bool is_valid = true;
+            for(uint32_t p = 0; p < TRAITS::PAIRS; ++p) {
+                total += batch_amount[p];
+                if(batch_amount[p] != 0.0 && (batch_err[p] != 0 || batch_amount[p] < model.get_min_amount())) is_valid = false;
+            }
+            if(!(total < attenuator * balance)) is_valid = false;
+            report.compare_call(TRAITS::NAME, "allocate(batch)", timestamp, 0, 0, is_valid ? 0 : 1, total, 0, total);
+        }
+    }
+
+    /** \brief Поток сигналов для бэктеста
+     *
+     * Направление сделки случайное, цена движется в сторону сделки с вероятностью 0.56.
+     * Номер валютной пары иногда выходит за список валютных пар брокера.
+     * \param begin Время первого сигнала
+     * \param step Шаг между сигналами в секундах
+     * \param size Количество сигналов
+     */
+    template<class TRAITS>
+    std::vector<payout_model::BacktestSignal> make_backtest_signals(
+            const xtime::timestamp_t begin,
+            const uint32_t step,
+            const size_t size) {
+        std::mt19937_64 rng(777);
+        const std::vector<uint32_t> &durations = TRAITS::get_bench_durations();
+        std::vector<payout_model::BacktestSignal> signals(size);
+        for(size_t i = 0; i < size; ++i) {
+            payout_model::BacktestSignal &signal = signals[i];
+            signal.timestamp = begin + i * step;
+            signal.currency_pair_index = (uint32_t)(rng() % (TRAITS::PAIRS + 1));
+            signal.duration = durations[rng() % durations.size()];
+            signal.direction = rng() % 2 ? payout_model::BUY : payout_model::SELL;
+            const uint64_t outcome = rng() % 100;
+            signal.outcome = outcome < 56 ? signal.direction : (outcome < 98 ? -signal.direction : 0);
+            signal.winrate = 0.55 + (rng() % 100) * 0.002;
+        }
+        return signals;
+    }
+
+    /** \brief Сверить бэктест с простой моделью счета на эталонной реализации
+     *
+     * Эталон хранит открытые сделки в массиве и каждый раз ищет сделку с наименьшим временем экспирации.
+     * Сигналы идут с шагом 20 секунд через несколько торговых недель, включая 25 декабря и 1 января,
+     * поэтому у сделок разной длительности часто совпадает время экспирации.
+     * Поток подается бэктесту частями разного размера, сравниваются кривая баланса, итоговый баланс и счетчики состояний.
+     * \param currency Валюта счета
+     * \param report Счетчик расхождений
+     */
+    template<class TRAITS>
+    void check_backtest(const uint32_t currency, CheckReport &report) {
+        class ReferenceDeal {
+        public:
+            xtime::timestamp_t expiration;
+            double value;
+        };
+        const typename TRAITS::Model model(currency);
+        typename TRAITS::Reference reference(currency);
+        const double attenuator = 0.4;
+        const double initial_balance = currency == TRAITS::Model::CURRENCY_RUB ? 100000.0 : 1000.0;
+        const std::vector<payout_model::BacktestSignal> signals =
+            make_backtest_signals<TRAITS>(xtime::get_timestamp(16, 12, 2019), 20, 100000);
+
+        payout_model::PayoutBacktest backtest(initial_balance, attenuator);
+        for(size_t i = 0, chunk = 1; i < signals.size(); i += chunk, chunk = chunk * 2 + 1) {
+            backtest.run(model, signals.data() + i, std::min(chunk, signals.size() - i));
+        }
+        backtest.finish();
+
+        std::vector<ReferenceDeal> deals;
+        std::vector<payout_model::BacktestEquityPoint> equity_curve;
+        std::array<uint64_t, payout_model::PayoutBacktest::CANCEL_TYPES> cancels {};
+        double balance = initial_balance;
+        auto settle = [&](const xtime::timestamp_t timestamp) {
+            while(true) {
+                size_t best = deals.size();
+                for(size_t k = 0; k < deals.size(); ++k) {
+                    if(deals[k].expiration <= timestamp && (best == deals.size() || deals[k].expiration < deals[best].expiration)) best = k;
+                }
+                if(best == deals.size()) break;
+                balance += deals[best].value;
+                payout_model::BacktestEquityPoint point;
+                point.timestamp = deals[best].expiration;
+                point.balance = balance;
+                equity_curve.push_back(point);
+                deals.erase(deals.begin() + best);
+            }
+        };
+        for(const payout_model::BacktestSignal &signal : signals) {
+            settle(signal.timestamp);
+            const uint32_t p = signal.currency_pair_index;
+            double amount = 0, payout = 0;
+            const int err = reference.get_amount(amount, payout, p < TRAITS::PAIRS ? TRAITS::get_pair_name(p) : std::string("XXXXXX"),
+                signal.timestamp, signal.duration, balance, signal.winrate, attenuator);
+            if(err != payout_model::ErrorType::OK || amount <= 0.0) {
+                ++cancels[-err];
+                continue;
+            }
+            balance -= amount;
+            ReferenceDeal deal;
+            deal.expiration = signal.timestamp + signal.duration;
+            deal.value = signal.outcome == 0 ? amount : (signal.outcome == signal.direction ? amount * (1.0 + payout) : 0.0);
+            deals.push_back(deal);
+        }
+        settle(std::numeric_limits<xtime::timestamp_t>::max());
+
+        const std::vector<payout_model::BacktestEquityPoint> &curve = backtest.get_equity_curve();
+        report.compare_call(TRAITS::NAME, "backtest(points)", 0, 0, 0, 0, (double)curve.size(), 0, (double)equity_curve.size());
+        for(size_t i = 0; i < std::min(curve.size(), equity_curve.size()); ++i) {
+            if(!report.compare_call(TRAITS::NAME, "backtest(equity)", curve[i].timestamp, 0, (uint32_t)i,
+                0, curve[i].balance, (int)(curve[i].timestamp - equity_curve[i].timestamp), equity_curve[i].balance)) break;
+        }
+        report.compare_call(TRAITS::NAME, "backtest(balance)", 0, 0, 0, 0, backtest.get_balance(), 0, balance);
+        for(uint32_t type = 0; type < payout_model::PayoutBacktest::CANCEL_TYPES; ++type) {
+            report.compare_call(TRAITS::NAME, "backtest(cancels)", 0, 0, type,
+                -(int)type, (double)backtest.get_cancels(-(int)type), -(int)type, (double)cancels[type]);
+        }
+        report.compare_call(TRAITS::NAME, "backtest(trades)", 0, 0, 0,
+            0, (double)backtest.get_trades(), 0, (double)(backtest.get_wins() + backtest.get_losses() + backtest.get_draws()));
+    }
+
+    /** \brief История сделок для моделирования Монте-Карло
+     *
+     * Сделки открываются в случайное время внутри торговой сессии будних дней,
+     * исход совпадает с прогнозом с вероятностью 0.57.
+     */
+    template<class TRAITS>
+    std::vector<payout_model::MonteCarloTrade> make_monte_carlo_trades(const size_t size) {
+        std::mt19937_64 rng(4242);
+        const std::vector<uint32_t> &durations = TRAITS::get_bench_durations();
+        const xtime::timestamp_t begin = xtime::get_timestamp(1, 1, 2019);
+        std::vector<payout_model::MonteCarloTrade> trades(size);
+        for(size_t i = 0; i < size; ++i) {
+            payout_model::MonteCarloTrade &trade = trades[i];
+            do {
+                const xtime::timestamp_t day = begin + (rng() % 365) * xtime::SECONDS_IN_DAY;
+                trade.timestamp = day + 2 * xtime::SECONDS_IN_HOUR + rng() % (17 * xtime::SECONDS_IN_HOUR);
+            } while(xtime::get_weekday(trade.timestamp) == xtime::SAT || xtime::get_weekday(trade.timestamp) == xtime::SUN);
+            trade.currency_pair_index = (uint32_t)(rng() % TRAITS::PAIRS);
+            trade.duration = durations[rng() % durations.size()];
+            trade.winrate = 0.55 + (rng() % 100) * 0.002;
+            trade.outcome = rng() % 100 < 57 ? 1 : -1;
+        }
+        return trades;
+    }
+
+    /** \brief Сверить моделирование Монте-Карло с последовательным расчетом на эталонной реализации
+     *
+     * Распределения должны совпадать побитово при любом количестве потоков
+     * и с путями, посчитанными по одному через эталонную модель.
+     * \param currency Валюта счета
+     * \param report Счетчик расхождений
+     */
+    template<class TRAITS>
+    void check_monte_carlo(const uint32_t currency, CheckReport &report) {
+        const typename TRAITS::Model model(currency);
+        typename TRAITS::Reference reference(currency);
+        const std::vector<payout_model::MonteCarloTrade> trades = make_monte_carlo_trades<TRAITS>(4096);
+        payout_model::MonteCarloSimulator simulator;
+        payout_model::MonteCarloConfig config;
+        config.paths = 1000;
+        config.trades = 300;
+        config.balance = currency == TRAITS::Model::CURRENCY_RUB ? 50000.0 : 1000.0;
+        config.ruin_balance = 0.6 * config.balance;
+        config.payout_limiter = 0.85;
+        config.seed = 17 + currency;
+        for(const int mode : {payout_model::MONTE_CARLO_BOOTSTRAP, payout_model::MONTE_CARLO_BERNOULLI}) {
+            config.mode = mode;
+
+            /* эталон: пути по одному, ставка по эталонной модели */
+            std::vector<double> balances, drawdowns;
+            std::vector<uint64_t> ruins(config.trades + 2, 0);
+            for(uint64_t path = 0; path < config.paths; ++path) {
+                const uint64_t key = payout_model::CounterRandom::get_key(config.seed, path);
+                double balance = config.balance, peak = balance, drawdown = 0;
+                uint32_t ruin_step = config.trades + 1;
+                for(uint32_t k = 0; k < config.trades; ++k) {
+                    const size_t index = std::min((size_t)(payout_model::CounterRandom::get_uniform(key, 2 * k) * trades.size()), trades.size() - 1);
+                    const payout_model::MonteCarloTrade &trade = trades[index];
+                    double amount = 0, payout = 0;
+                    const int err = reference.get_amount(amount, payout, TRAITS::get_pair_name(trade.currency_pair_index),
+                        trade.timestamp, trade.duration, balance, trade.winrate, config.attenuator, config.payout_limiter, config.winrate_limiter);
+                    if(err != payout_model::ErrorType::OK || amount <= 0.0) continue;
+                    const int outcome = mode == payout_model::MONTE_CARLO_BERNOULLI ?
+                        (payout_model::CounterRandom::get_uniform(key, 2 * k + 1) < trade.winrate ? 1 : -1) : trade.outcome;
+                    if(outcome > 0) balance += amount * payout;
+                    else if(outcome < 0) balance -= amount;
+                    peak = std::max(peak, balance);
+                    drawdown = std::max(drawdown, 1.0 - balance / peak);
+                    if(balance < config.ruin_balance) {
+                        ruin_step = k + 1;
+                        break;
+                    }
+                }
+                balances.push_back(balance);
+                drawdowns.push_back(drawdown);
+                ++ruins[ruin_step];
+            }
+            std::sort(balances.begin(), balances.end());
+            std::sort(drawdowns.begin(), drawdowns.end());
+            const double ruin_probability = (double)std::accumulate(ruins.begin(), ruins.end() - 1, (uint64_t)0) / (double)config.paths;
+
+            for(const uint32_t threads : {1U, 3U, 0U}) {
+                config.threads = threads;
+                payout_model::MonteCarloResult result;
+                simulator.simulate(model, trades.data(), trades.size(), config, result);
+                bool is_equal = result.terminal_balance.size() == balances.size();
+                for(size_t i = 0; is_equal && i < balances.size(); ++i) {
+                    is_equal = std::memcmp(&result.terminal_balance[i], &balances[i], sizeof(double)) == 0 &&
+                        std::memcmp(&result.max_drawdown[i], &drawdowns[i], sizeof(double)) == 0;
+                }
+                report.compare_call(TRAITS::NAME, "monte_carlo(distributions)", 0, mode, threads,
+                    is_equal ? 0 : 1, result.get_quantile(result.terminal_balance, 0.5),
+                    0, payout_model::MonteCarloResult::get_quantile(balances, 0.5));
+                report.compare_call(TRAITS::NAME, "monte_carlo(ruin)", 0, mode, threads,
+                    0, result.ruin_probability, 0, ruin_probability);
+            }
+        }
+    }
+
+    /** \brief Сверить модель с календарем торговли
+     *
+     * В закрытые дни календаря модель должна вернуть DAY_OFF и нулевые значения,
+     * в остальные дни - то же, что модель без календаря. Пакетные вызовы смешивают
+     * открытые и закрытые дни, чтобы проверить и векторную часть. Также проверяется разбор текста календаря.
+     * \param currency Валюта счета
+     * \param report Счетчик расхождений
+     */
+    template<class TRAITS>
+    void check_trading_calendar(const uint32_t currency, CheckReport &report) {
+        typedef typename TRAITS::Model Model;
+        const int DAY_OFF = Model::PayoutCancelType::DAY_OFF;
+        const Model model(currency);
+        Model calendar_model(currency);
+        calendar_model.set_calendar(&Model::get_default_calendar());
+        const std::vector<uint32_t> &durations = TRAITS::get_check_durations();
+        const std::vector<xtime::timestamp_t> timestamps = get_check_timestamps();
+        const double balance = check_balances[1];
+        const double winrate = check_winrates[3];
+        const double attenuator = 0.4;
+
+        std::vector<xtime::timestamp_t> batch_timestamp;
+        std::vector<uint32_t> batch_duration, batch_index;
+        std::vector<double> batch_amount, batch_balance, batch_winrate, batch_attenuator, batch_limiter;
+        std::vector<double> expected_payout, expected_amount, expected_amount_payout;
+        std::vector<int> expected_err, expected_amount_err;
+
+        payout_model::CalendarCursor cursor(timestamps.front());
+        for(size_t t = 0; t < timestamps.size(); t += 7) {
+            const xtime::timestamp_t timestamp = timestamps[t];
+            cursor.update(timestamp);
+            const bool is_closed = Model::check_timestamp(timestamp) == DAY_OFF;
+            const uint32_t duration = durations[t % durations.size()];
+            for(uint32_t p = 0; p < TRAITS::PAIRS; ++p) {
+                const double amount = check_amounts[p % 4];
+                double reference_payout = -1.0, reference_amount = -1.0, amount_payout = -1.0;
+                int reference_err = model.get_payout(reference_payout, timestamp, duration, p, amount);
+                int amount_err = model.get_amount(reference_amount, amount_payout, timestamp, duration, p,
+                    balance, winrate, attenuator);
+                if(is_closed) {
+                    reference_err = amount_err = DAY_OFF;
+                    reference_payout = reference_amount = amount_payout = 0.0;
+                }
+
+                double payout = -1.0, out_amount = -1.0;
+                int err = calendar_model.get_payout(payout, timestamp, duration, p, amount);
+                report.compare_call(TRAITS::NAME, "calendar.get_payout", timestamp, duration, p,
+                    err, payout, reference_err, reference_payout);
+                payout = -1.0;
+                err = calendar_model.get_payout(payout, cursor, duration, p, amount);
+                report.compare_call(TRAITS::NAME, "calendar.get_payout(cursor)", timestamp, duration, p,
+                    err, payout, reference_err, reference_payout);
+                payout = -1.0;
+                err = calendar_model.get_amount(out_amount, payout, cursor, duration, p,
+                    balance, winrate, attenuator);
+                if(report.compare_call(TRAITS::NAME, "calendar.get_amount(cursor, payout)", timestamp, duration, p,
+                        err, payout, amount_err, amount_payout)) {
+                    report.compare_call(TRAITS::NAME, "calendar.get_amount(cursor)", timestamp, duration, p,
+                        err, out_amount, amount_err, reference_amount);
+                }
+
+                batch_timestamp.push_back(timestamp);
+                batch_duration.push_back(duration);
+                batch_index.push_back(p);
+                batch_amount.push_back(amount);
+                batch_balance.push_back(balance);
+                batch_winrate.push_back(winrate);
+                batch_attenuator.push_back(attenuator);
+                batch_limiter.push_back(1.0);
+                expected_payout.push_back(reference_payout);
+                expected_err.push_back(reference_err);
+                expected_amount.push_back(reference_amount);
+                expected_amount_payout.push_back(amount_payout);
+                expected_amount_err.push_back(amount_err);
+            }
+        }
+
+        const size_t size = batch_timestamp.size();
+        std::vector<double> out_payout(size, -1.0), out_amount(size, -1.0);
+        std::vector<int> out_err(size, 1);
+        calendar_model.get_payout(out_payout.data(), out_err.data(), batch_timestamp.data(),
+            batch_duration.data(), batch_index.data(), batch_amount.data(), size);
+        for(size_t i = 0; i < size; ++i) {
+            report.compare_call(TRAITS::NAME, "calendar.get_payout(batch)", batch_timestamp[i], batch_duration[i], batch_index[i],
+                out_err[i], out_payout[i], expected_err[i], expected_payout[i]);
+        }
+        out_err.assign(size, 1);
+        out_payout.assign(size, -1.0);
+        calendar_model.get_amount(out_amount.data(), out_payout.data(), out_err.data(),
+            batch_timestamp.data(), batch_duration.data(), batch_index.data(),
+            batch_balance.data(), batch_winrate.data(), batch_attenuator.data(),
+            batch_limiter.data(), batch_limiter.data(), size);
+        for(size_t i = 0; i < size; ++i) {
+            if(report.compare_call(TRAITS::NAME, "calendar.get_amount(batch, payout)", batch_timestamp[i], batch_duration[i], batch_index[i],
+                    out_err[i], out_payout[i], expected_amount_err[i], expected_amount_payout[i])) {
+                report.compare_call(TRAITS::NAME, "calendar.get_amount(batch)", batch_timestamp[i], batch_duration[i], batch_index[i],
+                    out_err[i], out_amount[i], expected_amount_err[i], expected_amount[i]);
+            }
+        }
+
+        /* разбор текста календаря: закрытая дата, открытый праздник, сессия и ошибка в строке 2 */
+        payout_model::TradingCalendar calendar = Model::get_default_calendar();
+        uint32_t error_line = 0;
+        const xtime::timestamp_t closed_day = xtime::get_timestamp(4, 3, 2020) + 3 * xtime::SECONDS_IN_HOUR;
+        const xtime::timestamp_t christmas = xtime::get_timestamp(25, 12, 2019) + 8 * xtime::SECONDS_IN_HOUR;
+        int err = payout_model::parse_trading_calendar(
+            "# календарь\nclosed = 2020-03-04\nopen_yearly = 12-25 # праздник отменен\nsession.wed = 04:00-10:00\n",
+            calendar, error_line);
+        report.compare_call(TRAITS::NAME, "parse_trading_calendar", closed_day, 0, error_line,
+            err, (double)calendar.is_closed_day(closed_day), payout_model::ErrorType::OK, 1.0);
+        report.compare_call(TRAITS::NAME, "parse_trading_calendar(open)", christmas, 0, 0,
+            Model::check_timestamp(payout_model::CalendarCursor(christmas), calendar), 0.0, payout_model::ErrorType::OK, 0.0);
+        report.compare_call(TRAITS::NAME, "parse_trading_calendar(session)", closed_day, 0, 0,
+            (int)calendar.get_session_begin(xtime::WED), (double)calendar.get_session_end(xtime::WED),
+            (int)(4 * xtime::SECONDS_IN_HOUR), (double)(10 * xtime::SECONDS_IN_HOUR));
+        err = payout_model::parse_trading_calendar("closed_yearly = 05-01\nclosed = 2020-02-30x\n", calendar, error_line);
+        report.compare_call(TRAITS::NAME, "parse_trading_calendar(error)", closed_day, 0, 0,
+            err, (double)error_line, payout_model::RulesErrorType::RULES_INVALID_VALUE, 2.0);
+        report.compare_call(TRAITS::NAME, "parse_trading_calendar(unchanged)", 0, 0, 0,
+            (int)calendar.is_closed_day(xtime::get_timestamp(1, 5, 2020)), 0.0, 0, 0.0);
+
+        /* несуществующие даты отклоняются с номером строки, 29 февраля каждого года закрывается только в високосные годы */
+        const char *invalid_dates[] = {
+            "closed = 2020-02-29\nclosed = 2021-02-29\n",
+            "closed = 2021-01-31\nclosed = 2021-02-30\n",
+            "open = 2021-04-30\nopen = 2021-04-31\n",
+            "closed_yearly = 12-31\nclosed_yearly = 04-31\n",
+            "open_yearly = 02-29\nopen_yearly = 02-30\n",
+            "closed = 2021-06-30\nclosed = 2021-13-01\n"};
+        for(const char *text : invalid_dates) {
+            payout_model::TradingCalendar open_calendar;
+            err = payout_model::parse_trading_calendar(text, open_calendar, error_line);
+            report.compare_call(TRAITS::NAME, "parse_trading_calendar(invalid date)", 0, 0, 0,
+                err, (double)error_line, payout_model::RulesErrorType::RULES_INVALID_VALUE, 2.0);
+            report.compare_call(TRAITS::NAME, "parse_trading_calendar(invalid date, unchanged)", 0, 0, 0,
+                (int)open_calendar.is_closed_day(xtime::get_timestamp(29, 2, 2020)) +
+                (int)open_calendar.is_closed_day(xtime::get_timestamp(1, 5, 2021)), 0.0, 0, 0.0);
+        }
+        payout_model::TradingCalendar leap_calendar;
+        err = payout_model::parse_trading_calendar("closed_yearly = 02-29\n", leap_calendar, error_line);
+        const xtime::timestamp_t leap_days[] = {
+            xtime::get_timestamp(29, 2, 2020), xtime::get_timestamp(1, 3, 2020),
+            xtime::get_timestamp(28, 2, 2021), xtime::get_timestamp(1, 3, 2021),
+            xtime::get_timestamp(1, 3, 2099), xtime::get_timestamp(29, 2, 2000)};
+        const int leap_closed[] = {1, 0, 0, 0, 0, 1};
+        for(size_t i = 0; i < sizeof(leap_days) / sizeof(leap_days[0]); ++i) {
+            report.compare_call(TRAITS::NAME, "parse_trading_calendar(02-29)", leap_days[i], 0, 0,
+                err, (double)leap_calendar.is_closed_day(leap_days[i]), payout_model::ErrorType::OK, (double)leap_closed[i]);
+        }
+    }
+
+    /** \brief Сверить модель с календарем, сессия которого уже встроенной
+     *
+     * Вне сессии календаря модель должна вернуть NIGHT_HOURS (у IntradeBar экспирация после конца сессии -
+     * EXIT_OVER_END_DAY), в остальное время - то же, что модель без календаря. Ошибки параметров сделки
+     * проверяются раньше сессии и не меняются. Пакетные методы должны обойти векторное ядро встроенной сессии.
+     * \param currency Валюта счета
+     * \param report Счетчик расхождений
+     */
+    template<class TRAITS>
+    void check_trading_session(const uint32_t currency, CheckReport &report) {
+        typedef typename TRAITS::Model Model;
+        const int NIGHT_HOURS = Model::PayoutCancelType::NIGHT_HOURS;
+        const uint32_t session_begin = 2 * xtime::SECONDS_IN_HOUR;
+        const uint32_t session_end = 19 * xtime::SECONDS_IN_HOUR;
+        const payout_model::TradingCalendar calendar =
+            payout_model::TradingCalendar::make_session_calendar(session_begin, session_end);
+        const Model model(currency);
+        Model session_model(currency);
+        session_model.set_calendar(&calendar);
+        const std::vector<uint32_t> &durations = TRAITS::get_check_durations();
+        const std::vector<xtime::timestamp_t> timestamps = get_check_timestamps();
+        const double balance = check_balances[1];
+        const double winrate = check_winrates[3];
+        const double attenuator = 0.4;
+
+        /* состояния, которые модель проверяет после сессии (у get_amount ставка проверяется после сессии) */
+        auto is_session_err = [&](const int err, const bool is_amount) {
+            return err == payout_model::ErrorType::OK || err == NIGHT_HOURS ||
+                err == Model::PayoutCancelType::EXPIRATION_ERROR ||
+                err == Model::PayoutCancelType::TOO_LITTLE_WINRATE ||
+                (is_amount && err == Model::PayoutCancelType::TOO_LITTLE_MONEY);
+        };
+
+        std::vector<xtime::timestamp_t> batch_timestamp;
+        std::vector<uint32_t> batch_duration, batch_index;
+        std::vector<double> batch_amount, batch_balance, batch_winrate, batch_attenuator, batch_limiter;
+        std::vector<double> expected_payout, expected_amount, expected_amount_payout;
+        std::vector<int> expected_err, expected_amount_err;
+
+        payout_model::CalendarCursor cursor(timestamps.front());
+        for(size_t t = 0; t < timestamps.size(); t += 3) {
+            const xtime::timestamp_t timestamp = timestamps[t];
+            cursor.update(timestamp);
+            const uint32_t weekday = xtime::get_weekday(timestamp);
+            const uint32_t second_day = (uint32_t)(timestamp % xtime::SECONDS_IN_DAY);
+            const bool is_weekend = weekday == xtime::SAT || weekday == xtime::SUN;
+            const bool is_night = second_day < session_begin || second_day >= session_end;
+            const uint32_t duration = durations[t % durations.size()];
+            const bool is_exit = TRAITS::IS_EXIT_IN_SESSION && second_day + duration > session_end;
+            for(uint32_t p = 0; p < TRAITS::PAIRS; ++p) {
+                const double amount = check_amounts[p % 4];
+                double reference_payout = -1.0, reference_amount = -1.0, amount_payout = -1.0;
+                int reference_err = model.get_payout(reference_payout, timestamp, duration, p, amount);
+                int amount_err = model.get_amount(reference_amount, amount_payout, timestamp, duration, p,
+                    balance, winrate, attenuator);
+                if(is_exit) {
+                    reference_err = amount_err = payout_model::IntradeBar::PayoutCancelType::EXIT_OVER_END_DAY;
+                    reference_payout = reference_amount = amount_payout = 0.0;
+                } else
+                if(!is_weekend && is_night) {
+                    if(is_session_err(reference_err, false)) {
+                        reference_err = NIGHT_HOURS;
+                        reference_payout = 0.0;
+                    }
+                    if(is_session_err(amount_err, true)) {
+                        amount_err = NIGHT_HOURS;
+                        reference_amount = amount_payout = 0.0;
+                    }
+                }
+
+                double payout = -1.0, out_amount = -1.0;
+                int err = session_model.get_payout(payout, timestamp, duration, p, amount);
+                report.compare_call(TRAITS::NAME, "session.get_payout", timestamp, duration, p,
+                    err, payout, reference_err, reference_payout);
+                payout = -1.0;
+                err = session_model.get_payout(payout, cursor, duration, p, amount);
+                report.compare_call(TRAITS::NAME, "session.get_payout(cursor)", timestamp, duration, p,
+                    err, payout, reference_err, reference_payout);
+                payout = -1.0;
+                err = session_model.get_amount(out_amount, payout, cursor, duration, p,
+                    balance, winrate, attenuator);
+                if(report.compare_call(TRAITS::NAME, "session.get_amount(cursor, payout)", timestamp, duration, p,
+                        err, payout, amount_err, amount_payout)) {
+                    report.compare_call(TRAITS::NAME, "session.get_amount(cursor)", timestamp, duration, p,
+                        err, out_amount, amount_err, reference_amount);
+                }
+
+                batch_timestamp.push_back(timestamp);
+                batch_duration.push_back(duration);
+                batch_index.push_back(p);
+                batch_amount.push_back(amount);
+                batch_balance.push_back(balance);
+                batch_winrate.push_back(winrate);
+                batch_attenuator.push_back(attenuator);
+                batch_limiter.push_back(1.0);
+                expected_payout.push_back(reference_payout);
+                expected_err.push_back(reference_err);
+                expected_amount.push_back(reference_amount);
+                expected_amount_payout.push_back(amount_payout);
+                expected_amount_err.push_back(amount_err);
+            }
+        }
+
+        const size_t size = batch_timestamp.size();
+        std::vector<double> out_payout(size, -1.0), out_amount(size, -1.0);
+        std::vector<int> out_err(size, 1);
+        session_model.get_payout(out_payout.data(), out_err.data(), batch_timestamp.data(),
+            batch_duration.data(), batch_index.data(), batch_amount.data(), size);
+        for(size_t i = 0; i < size; ++i) {
+            report.compare_call(TRAITS::NAME, "session.get_payout(batch)", batch_timestamp[i], batch_duration[i], batch_index[i],
+                out_err[i], out_payout[i], expected_err[i], expected_payout[i]);
+        }
+        out_err.assign(size, 1);
+        out_payout.assign(size, -1.0);
+        session_model.get_amount(out_amount.data(), out_payout.data(), out_err.data(),
+            batch_timestamp.data(), batch_duration.data(), batch_index.data(),
+            batch_balance.data(), batch_winrate.data(), batch_attenuator.data(),
+            batch_limiter.data(), batch_limiter.data(), size);
+        for(size_t i = 0; i < size; ++i) {
+            if(report.compare_call(TRAITS::NAME, "session.get_amount(batch, payout)", batch_timestamp[i], batch_duration[i], batch_index[i],
+                    out_err[i], out_payout[i], expected_amount_err[i], expected_amount_payout[i])) {
+                report.compare_call(TRAITS::NAME, "session.get_amount(batch)", batch_timestamp[i], batch_duration[i], batch_index[i],
+                    out_err[i], out_amount[i], expected_amount_err[i], expected_amount[i]);
+            }
+        }
+
+        /* выплата внутри отрезка постоянна, поэтому отрезки должны меняться и на границах сессии календаря */
+        const xtime::timestamp_t day = xtime::get_timestamp(15, 1, 2020);
+        payout_model::PayoutSegmentIterator<Model> segments(session_model, day, day + xtime::SECONDS_IN_DAY, 180, 0, 100.0);
+        payout_model::PayoutSegment segment;
+        auto check_segment = [&](const xtime::timestamp_t timestamp) {
+            double payout = -1.0;
+            const int err = session_model.get_payout(payout, timestamp, 180, 0, 100.0);
+            report.compare_call(TRAITS::NAME, "session.PayoutSegmentIterator", timestamp, 180, 0,
+                segment.err, segment.payout, err, payout);
+        };
+        while(segments.next(segment)) {
+            for(xtime::timestamp_t timestamp = segment.start; timestamp < segment.end; timestamp += 59) {
+                check_segment(timestamp);
+            }
+            check_segment(segment.end - 1);
+        }
+    }
+
+    /** \brief Сверить торговые окна и допустимые длительности с перебором get_payout
+     *
+     * Для меток времени недели, 25 декабря и 1 января торговое окно модели сверяется с get_payout
+     * на границах окна и отрезками постоянной выплаты от метки времени до конца окна,
+     * максимальная длительность - с get_payout для нее и для больших длительностей,
+     * check_duration - с состояниями get_payout за всю неделю.
+     * \param currency Валюта счета
+     * \param report Счетчик расхождений
+     */
+    template<class TRAITS>
+    void check_trade_window(const uint32_t currency, CheckReport &report) {
+        typedef typename TRAITS::Model Model;
+        const std::vector<uint32_t> &durations = TRAITS::get_check_durations();
+        const std::vector<xtime::timestamp_t> timestamps = get_check_timestamps();
+        const double amounts[] = {check_amounts[0], check_amounts[1], check_amounts[3]};
+        std::vector<payout_model::PayoutSegment> segments;
+        for(const bool is_calendar : {false, true}) {
+            Model model(currency);
+            if(is_calendar) model.set_calendar(&Model::get_default_calendar());
+            const payout_model::TradingCalendar open_calendar;
+            const payout_model::TradingCalendar &model_calendar = is_calendar ? Model::get_default_calendar() : open_calendar;
+            auto is_accepted = [&](const xtime::timestamp_t timestamp, const uint32_t duration,
+                    const uint32_t p, const double amount) {
+                double payout = 0;
+                return model.get_payout(payout, timestamp, duration, p, amount) == payout_model::ErrorType::OK && payout > 0;
+            };
+            const char *path = is_calendar ? "get_trade_window(calendar)" : "get_trade_window";
+            for(size_t t = 0; t < timestamps.size(); t += 7) {
+                const xtime::timestamp_t timestamp = timestamps[t];
+                const uint32_t p = (uint32_t)(t % (TRAITS::PAIRS + 1));
+                for(const uint32_t duration : durations)
+                for(const double amount : amounts) {
+                    xtime::timestamp_t window_begin = 0, window_end = 0;
+                    const int err = model.get_trade_window(window_begin, window_end, timestamp, duration, p, amount);
+                    if(err != payout_model::ErrorType::OK) {
+                        report.compare_call(TRAITS::NAME, path, timestamp, duration, p,
+                            err, (double)is_accepted(timestamp, duration, p, amount), err, 0.0);
+                        continue;
+                    }
+                    /* окно начинается не раньше метки времени, внутри окна выплата есть, до и после окна - нет */
+                    const bool is_window = window_begin >= timestamp && window_end > window_begin &&
+                        is_accepted(window_begin, duration, p, amount) &&
+                        is_accepted(window_end - 1, duration, p, amount) &&
+                        !is_accepted(window_end, duration, p, amount) &&
+                        (window_begin == timestamp || !is_accepted(window_begin - 1, duration, p, amount));
+                    if(!report.compare_call(TRAITS::NAME, path, timestamp, duration, p,
+                        err, (double)is_window, payout_model::ErrorType::OK, 1.0)) continue;
+                    payout_model::get_payout_segments(segments, model, timestamp, window_end, duration, p, amount);
+                    for(const payout_model::PayoutSegment &segment : segments) {
+                        const bool is_segment_accepted = segment.err == payout_model::ErrorType::OK && segment.payout > 0;
+                        report.compare_call(TRAITS::NAME, path, segment.start, duration, p,
+                            0, (double)is_segment_accepted, 0, (double)(segment.start >= window_begin));
+                    }
+                }
+
+                /* статическое окно - окно ставки ниже порога повышенной выплаты со встроенным календарем */
+                if(is_calendar) {
+                    const uint32_t duration = durations[t % durations.size()];
+                    xtime::timestamp_t window_begin = 0, window_end = 0, static_begin = 0, static_end = 0;
+                    const int err = model.get_trade_window(window_begin, window_end, timestamp, duration, p, model.get_min_amount());
+                    const int static_err = Model::get_trade_window(static_begin, static_end, timestamp, duration, p);
+                    report.compare_call(TRAITS::NAME, "get_trade_window(static)", timestamp, duration, p,
+                        static_err, (double)static_begin, err, (double)window_begin);
+                    report.compare_call(TRAITS::NAME, "get_trade_window(static end)", timestamp, duration, p,
+                        static_err, (double)static_end, err, (double)window_end);
+                }
+            }
+
+            /* максимальная длительность принимается, большие длительности - нет (в том числе перед концом дня) */
+            std::vector<xtime::timestamp_t> max_timestamps;
+            for(size_t t = 0; t < timestamps.size(); t += 7) max_timestamps.push_back(timestamps[t]);
+            const xtime::timestamp_t end_day = xtime::get_timestamp(4, 3, 2020, 21, 0, 0);
+            for(uint32_t s = 1; s <= 600; s += 3) max_timestamps.push_back(end_day - s);
+            for(size_t t = 0; t < max_timestamps.size(); ++t) {
+                const xtime::timestamp_t timestamp = max_timestamps[t];
+                const uint32_t p = (uint32_t)(t % (TRAITS::PAIRS + 1));
+                const uint32_t static_max_duration = Model::get_max_duration(timestamp, model_calendar);
+                for(const double amount : amounts) {
+                    const uint32_t max_duration = model.get_max_duration(timestamp, p, amount);
+                    report.compare_call(TRAITS::NAME, "get_max_duration", timestamp, max_duration, p,
+                        0, (double)(max_duration == 0 || is_accepted(timestamp, max_duration, p, amount)), 0, 1.0);
+                    report.compare_call(TRAITS::NAME, "get_max_duration(static)", timestamp, max_duration, p,
+                        0, (double)(max_duration <= static_max_duration), 0, 1.0);
+                    std::vector<uint32_t> longer = durations;
+                    longer.insert(longer.end(), {60U, 180U, max_duration + 1, static_max_duration});
+                    for(const uint32_t duration : longer) {
+                        if(duration <= max_duration) continue;
+                        report.compare_call(TRAITS::NAME, "get_max_duration(longer)", timestamp, duration, p,
+                            0, (double)is_accepted(timestamp, duration, p, amount), 0, 0.0);
+                    }
+                }
+            }
+        }
+
+        /* check_duration: OK, если за неделю есть выплата, иначе get_payout возвращает тот же код */
+        const Model model(currency);
+        const double amount = check_amounts[3];
+        for(const uint32_t duration : durations)
+        for(uint32_t p = 0; p <= TRAITS::PAIRS; ++p) {
+            const int err = Model::check_duration(duration, p);
+            bool is_any_accepted = false;
+            bool is_same_err = false;
+            for(const xtime::timestamp_t timestamp : timestamps) {
+                double payout = 0;
+                const int payout_err = model.get_payout(payout, timestamp, duration, p, amount);
+                if(payout_err == payout_model::ErrorType::OK && payout > 0) is_any_accepted = true;
+                if(payout_err == err) is_same_err = true;
+            }
+            report.compare_call(TRAITS::NAME, "check_duration", 0, duration, p,
+                err, (double)is_same_err, is_any_accepted ? payout_model::ErrorType::OK : err, 1.0);
+            report.compare_call(TRAITS::NAME, "check_duration(accepted)", 0, duration, p,
+                0, (double)(err == payout_model::ErrorType::OK), 0, (double)is_any_accepted);
+        }
+    }
+
+    /** \brief Сверить отрезки постоянной выплаты с посекундным перебором get_payout
+     *
+     * Интервалы начинаются и заканчиваются не на границе минуты и проходят вечер перед праздником 25 декабря,
+     * сам праздник и выходные с понедельником. Проверяется также, что отрезки идут подряд, соседние отрезки
+     * различаются, а PayoutModel дает те же отрезки, что и модель без календаря.
+     * \param report Счетчик расхождений
+     */
+    template<class TRAITS, uint32_t CURRENCY>
+    void check_payout_segments(CheckReport &report) {
+        typedef typename TRAITS::Model Model;
+        typedef payout_model::PayoutModel<typename TRAITS::Policy, CURRENCY> PolicyModel;
+        const std::vector<uint32_t> &durations = TRAITS::get_check_durations();
+        const xtime::timestamp_t intervals[][2] = {
+            {xtime::get_timestamp(24, 12, 2019, 18, 0, 17), xtime::get_timestamp(26, 12, 2019, 2, 30, 41)},
+            {xtime::get_timestamp(28, 12, 2019, 22, 10, 5), xtime::get_timestamp(30, 12, 2019, 3, 0, 0)}};
+        const double amounts[] = {check_amounts[1], check_amounts[3]};
+        std::vector<payout_model::PayoutSegment> segments, policy_segments;
+        for(const bool is_calendar : {false, true}) {
+            Model model(CURRENCY);
+            if(is_calendar) model.set_calendar(&Model::get_default_calendar());
+            const char *path = is_calendar ? "segments(calendar)" : "segments";
+            for(const auto &interval : intervals)
+            for(size_t d = 0; d < durations.size(); ++d)
+            for(const double amount : amounts) {
+                const xtime::timestamp_t t0 = interval[0], t1 = interval[1];
+                const uint32_t duration = durations[d];
+                const uint32_t p = (uint32_t)(d * 7 % TRAITS::PAIRS);
+                payout_model::get_payout_segments(segments, model, t0, t1, duration, p, amount);
+                if(!report.compare_call(TRAITS::NAME, path, t0, duration, p,
+                        0, (double)(!segments.empty() && segments.front().start == t0 && segments.back().end == t1), 0, 1.0)) continue;
+                for(size_t s = 1; s < segments.size(); ++s) {
+                    const payout_model::PayoutSegment &prev = segments[s - 1];
+                    const payout_model::PayoutSegment &segment = segments[s];
+                    report.compare_call(TRAITS::NAME, "segments.contiguous", segment.start, duration, p,
+                        0, (double)prev.end, 0, (double)segment.start);
+                    report.compare_call(TRAITS::NAME, "segments.merged", segment.start, duration, p,
+                        0, (double)(prev.err != segment.err || prev.payout != segment.payout), 0, 1.0);
+                }
+
+                /* каждая секунда интервала */
+                size_t s = 0;
+                for(xtime::timestamp_t t = t0; t < t1; ++t) {
+                    while(t >= segments[s].end) ++s;
+                    double payout = -1.0;
+                    const int err = model.get_payout(payout, t, duration, p, amount);
+                    report.compare_call(TRAITS::NAME, path, t, duration, p,
+                        segments[s].err, segments[s].payout, err, payout);
+                }
+
+                if(is_calendar) continue;
+                payout_model::get_payout_segments(policy_segments, PolicyModel(), t0, t1, duration, p, amount);
+                report.compare_call(TRAITS::NAME, "PayoutModel segments", t0, duration, p,
+                    0, (double)policy_segments.size(), 0, (double)segments.size());
+                for(size_t i = 0; i < std::min(segments.size(), policy_segments.size()); ++i) {
+                    report.compare_call(TRAITS::NAME, "PayoutModel segments", policy_segments[i].start, duration, p,
+                        policy_segments[i].err, policy_segments[i].payout, segments[i].err, segments[i].payout);
+                    report.compare_call(TRAITS::NAME, "PayoutModel segments.end", policy_segments[i].start, duration, p,
+                        0, (double)policy_segments[i].end, 0, (double)segments[i].end);
+                }
+            }
+        }
+    }
+
+    /** \brief Сверить маски торговых минут с перебором get_payout
+     *
+     * Проверяются три недели вокруг праздников 25 декабря и 1 января с календарем и без него:
+     * маски открытых пар в каждой минуте, количество минут в случайных интервалах (в том числе
+     * длиннее недели), общие маски набора пар и поиск следующей торговой минуты.
+     * \param currency Валюта счета
+     * \param report Счетчик расхождений
+     */
+    template<class TRAITS>
+    void check_tradability(const uint32_t currency, CheckReport &report) {
+        typedef typename TRAITS::Model Model;
+        const xtime::timestamp_t first_timestamp = xtime::get_timestamp(22, 12, 2019);
+        const uint64_t minutes = 3 * payout_model::MINUTES_IN_WEEK + 2 * xtime::MINUTES_IN_DAY;
+        const uint64_t first_minute = first_timestamp / xtime::SECONDS_IN_MINUTE;
+        const uint64_t common_set = 0x7;
+        std::mt19937_64 rng(2468);
+        for(const bool is_calendar : {false, true}) {
+            Model model(currency);
+            if(is_calendar) model.set_calendar(&Model::get_default_calendar());
+            const double amount = std::max(model.get_min_amount(), 0.0);
+            const payout_model::PayoutTradability tradability = model.make_tradability();
+            const std::vector<uint32_t> &durations = tradability.get_durations();
+            const std::string path = is_calendar ? "tradability(calendar)" : "tradability";
+            for(uint32_t d = 0; d < durations.size(); ++d) {
+                const uint32_t duration = durations[d];
+                report.compare_call(TRAITS::NAME, (path + ".get_duration_index").c_str(), 0, duration, 0,
+                    payout_model::ErrorType::OK, (double)tradability.get_duration_index(duration),
+                    payout_model::ErrorType::OK, (double)d);
+
+                /* перебор всех минут интервала */
+                std::vector<uint64_t> open_pairs(minutes, 0);
+                for(uint64_t m = 0; m < minutes; ++m) {
+                    const xtime::timestamp_t timestamp = (first_minute + m) * xtime::SECONDS_IN_MINUTE;
+                    for(uint32_t p = 0; p < TRAITS::PAIRS; ++p) {
+                        double payout = 0;
+                        const int err = model.get_payout(payout, timestamp, duration, p, amount);
+                        if(err == payout_model::ErrorType::OK && payout > 0) open_pairs[m] |= (uint64_t)1 << p;
+                    }
+                    const uint64_t pairs = tradability.get_open_pairs(d, timestamp + (m % xtime::SECONDS_IN_MINUTE));
+                    report.compare_call(TRAITS::NAME, (path + ".get_open_pairs").c_str(), timestamp, duration, 0,
+                        payout_model::ErrorType::OK, (double)pairs, payout_model::ErrorType::OK, (double)open_pairs[m]);
+                    const uint32_t p = (uint32_t)(m % TRAITS::PAIRS);
+                    report.compare_call(TRAITS::NAME, (path + ".is_tradable").c_str(), timestamp, duration, p,
+                        payout_model::ErrorType::OK, (double)tradability.is_tradable(p, d, timestamp),
+                        payout_model::ErrorType::OK, (double)((open_pairs[m] >> p) & 1));
+                }
+
+                /* количество минут в интервалах с произвольными секундами границ */
+                auto count_open = [&](const uint64_t pair_set, const xtime::timestamp_t t0, const xtime::timestamp_t t1) {
+                    uint64_t sum = 0;
+                    for(uint64_t m = 0; m < minutes; ++m) {
+                        const xtime::timestamp_t timestamp = (first_minute + m) * xtime::SECONDS_IN_MINUTE;
+                        if(timestamp >= t0 && timestamp < t1 && (open_pairs[m] & pair_set) == pair_set) ++sum;
+                    }
+                    return sum;
+                };
+                const payout_model::MinuteWeekMask common_mask = tradability.get_common_mask(common_set, d);
+                for(uint32_t i = 0; i < 64; ++i) {
+                    const xtime::timestamp_t t0 = first_timestamp + rng() % (minutes * xtime::SECONDS_IN_MINUTE);
+                    const xtime::timestamp_t end = first_timestamp + minutes * xtime::SECONDS_IN_MINUTE;
+                    const xtime::timestamp_t t1 = i % 4 == 0 ? end : t0 + rng() % (end - t0 + 1);
+                    const uint32_t p = (uint32_t)(rng() % TRAITS::PAIRS);
+                    report.compare_call(TRAITS::NAME, (path + ".count").c_str(), t0, duration, p,
+                        payout_model::ErrorType::OK, (double)tradability.count(p, d, t0, t1),
+                        payout_model::ErrorType::OK, (double)count_open((uint64_t)1 << p, t0, t1));
+                    report.compare_call(TRAITS::NAME, (path + ".count(common)").c_str(), t0, duration, 0,
+                        payout_model::ErrorType::OK, (double)tradability.count(common_mask, t0, t1),
+                        payout_model::ErrorType::OK, (double)count_open(common_set, t0, t1));
+                }
+
+                /* поиск следующей торговой минуты недели */
+                for(uint32_t p = 0; p < TRAITS::PAIRS; p += 5) {
+                    const payout_model::MinuteWeekMask &mask = tradability.get_mask(p, d);
+                    uint32_t expected = payout_model::MINUTES_IN_WEEK;
+                    for(uint32_t m = payout_model::MINUTES_IN_WEEK; m-- > 0;) {
+                        if(mask.get(m)) expected = m;
+                        if(m % 97 != 0 && m != payout_model::MINUTES_IN_WEEK - 1) continue;
+                        report.compare_call(TRAITS::NAME, (path + ".find_next").c_str(), m, duration, p,
+                            payout_model::ErrorType::OK, (double)mask.find_next(m),
+                            payout_model::ErrorType::OK, (double)expected);
+                    }
+                }
+            }
+        }
+    }
+
+    /** \brief Сверить поверхность выплат из файла с эталонной реализацией
+     * \param file Открытый файл поверхности выплат
+     * \param currency Валюта счета
+     * \param report Счетчик расхождений
+     */
+    template<class TRAITS, class SURFACE>
+    void check_surface(const payout_model::PayoutSurfaceFile &file, const uint32_t currency, CheckReport &report) {
+        const SURFACE surface(file, currency);
+        typename TRAITS::Reference reference(currency);
+        const std::vector<uint32_t> &durations = TRAITS::get_check_durations();
+        const std::vector<xtime::timestamp_t> timestamps = get_check_timestamps();
+        for(const xtime::timestamp_t timestamp : timestamps)
+        for(const uint32_t duration : durations)
+        for(uint32_t p = 0; p < TRAITS::PAIRS; ++p)
+        for(const double amount : check_amounts) {
+            double reference_payout = -1.0, payout = -1.0;
+            const int reference_err = reference.get_payout(reference_payout, timestamp, duration, p, amount);
+            const int err = surface.get_payout(payout, timestamp, duration, p, amount);
+            report.compare_call(TRAITS::NAME, "get_payout(surface)", timestamp, duration, p,
+                err, payout, reference_err, reference_payout);
+        }
+    }
+
+    /** \brief Сверить счетчики состояний выплат с результатами вызовов
+     *
+     * Вызовы идут из текущего и отдельного потока, часть - пакетом, чтобы проверить
+     * сложение блоков потоков, перенос счетчиков завершившегося потока и векторную часть.
+     * Без PAYOUT_MODEL_STATS снимок должен быть пустым.
+     * \param report Счетчик расхождений
+     */
+    template<class TRAITS>
+    void check_stats(CheckReport &report) {
+        typedef typename TRAITS::Model Model;
+        typedef typename Model::Stats Stats;
+        const Model model(Model::CURRENCY_USD);
+        const std::vector<uint32_t> &durations = TRAITS::get_check_durations();
+        const std::vector<xtime::timestamp_t> timestamps = get_check_timestamps();
+        std::vector<uint64_t> expected(Stats::SIZE, 0);
+        auto add_expected = [&](const uint32_t p, const xtime::timestamp_t timestamp, const int err) {
+            const uint32_t hour = (uint32_t)(timestamp % xtime::SECONDS_IN_DAY / xtime::SECONDS_IN_HOUR);
+            ++expected[((size_t)(p < TRAITS::PAIRS ? p : TRAITS::PAIRS) * Stats::HOURS + hour) * Stats::CANCEL_TYPES + (uint32_t)-err];
+        };
+
+        Stats::reset();
+        std::vector<xtime::timestamp_t> batch_timestamp;
+        std::vector<uint32_t> batch_duration, batch_index;
+        std::vector<double> batch_amount;
+        payout_model::CalendarCursor cursor(timestamps.front());
+        for(size_t t = 0; t < timestamps.size(); t += 5) {
+            const xtime::timestamp_t timestamp = timestamps[t];
+            cursor.update(timestamp);
+            const uint32_t duration = durations[t % durations.size()];
+            /* номер TRAITS::PAIRS учитывается строкой неизвестной пары */
+            const uint32_t p = t % (TRAITS::PAIRS + 1);
+            double payout = 0.0, amount = 0.0;
+            add_expected(p, timestamp, model.get_payout(payout, timestamp, duration, p, 100.0));
+            add_expected(p, timestamp, model.get_amount(amount, payout, cursor, duration, p, 1000.0, check_winrates[t % 5], 0.4));
+            batch_timestamp.push_back(timestamp);
+            batch_duration.push_back(duration);
+            batch_index.push_back(p);
+            batch_amount.push_back(check_amounts[t % 4]);
+        }
+        std::thread thread([&]() {
+            std::vector<double> payout(batch_timestamp.size());
+            std::vector<int> err(batch_timestamp.size());
+            model.get_payout(payout.data(), err.data(), batch_timestamp.data(), batch_duration.data(),
+                batch_index.data(), batch_amount.data(), batch_timestamp.size());
+            for(size_t i = 0; i < err.size(); ++i) add_expected(batch_index[i], batch_timestamp[i], err[i]);
+        });
+        thread.join();
+
+        const payout_model::PayoutStatsSnapshot snapshot = Stats::get_snapshot();
+        if(!Stats::is_enabled) std::fill(expected.begin(), expected.end(), 0);
+        report.compare_call(TRAITS::NAME, "stats.size", 0, 0, 0,
+            (int)snapshot.counts.size(), 0.0, (int)Stats::SIZE, 0.0);
+        for(uint32_t p = 0; p <= TRAITS::PAIRS; ++p)
+        for(uint32_t hour = 0; hour < Stats::HOURS; ++hour)
+        for(uint32_t type = 0; type < Stats::CANCEL_TYPES; ++type) {
+            const uint64_t value = expected[((size_t)p * Stats::HOURS + hour) * Stats::CANCEL_TYPES + type];
+            report.compare_call(TRAITS::NAME, "stats.get", 0, hour, p,
+                -(int)type, (double)snapshot.get(p, hour, -(int)type), -(int)type, (double)value);
+        }
+
+        /* текст содержит строку на каждый ненулевой счетчик */
+        const std::string text = snapshot.to_string(Model::get_currecy_pair_name);
+        const uint64_t lines = std::count(text.begin(), text.end(), '\n');
+        const uint64_t cells = snapshot.counts.size() - std::count(snapshot.counts.begin(), snapshot.counts.end(), 0);
+        report.compare_call(TRAITS::NAME, "stats.to_string", 0, 0, 0, 0, (double)lines, 0, (double)cells);
+        Stats::reset();
+        report.compare_call(TRAITS::NAME, "stats.reset", 0, 0, 0, 0, (double)Stats::get_snapshot().get_calls(), 0, 0.0);
+    }
+
+    /// Текст правил со всеми ключами (значения с точностью double)
+    std::string get_rules_text(const payout_model::PayoutRules &rules) {
+        std::string text;
+        auto add = [&](const std::string &key, const double value) {
+            char buffer[64];
+            std::snprintf(buffer, sizeof(buffer), " = %.17g\n", value);
+            text += key + buffer;
+        };
+        const payout_model::IntradeBarRules &ib = rules.intrade_bar;
+        const payout_model::GrandcapitalRules &gc = rules.grandcapital;
+        add("intrade_bar.min_amount_rub", ib.min_amount_rub);
+        add("intrade_bar.min_amount_usd", ib.min_amount_usd);
+        add("intrade_bar.threshold_amount_rub", ib.threshold_amount_rub);
+        add("intrade_bar.threshold_amount_usd", ib.threshold_amount_usd);
+        add("intrade_bar.payout.low_60", ib.low_payout_60);
+        add("intrade_bar.payout.high_60", ib.high_payout_60);
+        add("intrade_bar.payout.low_180", ib.low_payout_180);
+        add("intrade_bar.payout.low_240", ib.low_payout_240);
+        add("intrade_bar.payout.high", ib.high_payout);
+        for(uint32_t p = 0; p < payout_model::INTRADE_BAR_CURRENCY_PAIRS; ++p) {
+            const std::string name(payout_model::intrade_bar_currency_pairs[p]);
+            add("intrade_bar.pair." + name, ib.is_currency_pairs[p]);
+            add("intrade_bar.pair_1m." + name, ib.is_currency_pairs_1m_exp[p]);
+        }
+        add("grandcapital.min_amount_rub", gc.min_amount_rub);
+        add("grandcapital.min_amount_usd", gc.min_amount_usd);
+        for(uint32_t p = 0; p < payout_model::GRANDCAPITAL_CURRENCY_PAIRS; ++p) {
+            const std::string name(payout_model::grandcapital_currency_pairs[p]);
+            add("grandcapital.pair." + name, gc.is_currency_pairs[p]);
+            add("grandcapital.payout." + name, gc.currency_pairs_payout[p]);
+        }
+        return text;
+    }
+
+    /** \brief Сравнить правила
+     * \param winrate_tolerance Допуск винрейтов (1 / 1.82 и 1 / (1 + 0.82) отличаются в последнем бите)
+     * \return Вернет true, если все значения правил совпадают
+     */
+    bool is_equal_rules(const payout_model::PayoutRules &a, const payout_model::PayoutRules &b, const double winrate_tolerance = 0.0) {
+        const payout_model::IntradeBarRules &ia = a.intrade_bar, &ib = b.intrade_bar;
+        const payout_model::GrandcapitalRules &ga = a.grandcapital, &gb = b.grandcapital;
+        return ia.is_currency_pairs == ib.is_currency_pairs &&
+            ia.is_currency_pairs_1m_exp == ib.is_currency_pairs_1m_exp &&
+            ia.min_amount_rub == ib.min_amount_rub && ia.min_amount_usd == ib.min_amount_usd &&
+            ia.threshold_amount_rub == ib.threshold_amount_rub && ia.threshold_amount_usd == ib.threshold_amount_usd &&
+            ia.low_payout_60 == ib.low_payout_60 && ia.high_payout_60 == ib.high_payout_60 &&
+            ia.low_payout_180 == ib.low_payout_180 && ia.low_payout_240 == ib.low_payout_240 &&
+            ia.high_payout == ib.high_payout &&
+            std::abs(ia.low_winrate_60 - ib.low_winrate_60) <= winrate_tolerance &&
+            std::abs(ia.high_winrate_60 - ib.high_winrate_60) <= winrate_tolerance &&
+            std::abs(ia.low_winrate_180 - ib.low_winrate_180) <= winrate_tolerance &&
+            std::abs(ia.low_winrate_240 - ib.low_winrate_240) <= winrate_tolerance &&
+            std::abs(ia.high_winrate - ib.high_winrate) <= winrate_tolerance &&
+            ga.is_currency_pairs == gb.is_currency_pairs && ga.currency_pairs_payout == gb.currency_pairs_payout &&
+            ga.min_amount_rub == gb.min_amount_rub && ga.min_amount_usd == gb.min_amount_usd;
+    }
+
+    /** \brief Сверить разбор и загрузку правил выплат и публикацию правил через RcuPointer
+     *
+     * Текст со всеми ключами правил по умолчанию должен вернуть правила по умолчанию в измененные правила,
+     * ошибки должны возвращать код и номер строки без изменения правил, а измененная выплата - попадать в get_payout.
+     * \param report Счетчик расхождений
+     */
+    void check_payout_rules(CheckReport &report) {
+        const char *name = "rules";
+        const payout_model::PayoutRules default_rules;
+        const std::string default_text = get_rules_text(default_rules);
+
+        /* правила, в которых изменено каждое значение */
+        payout_model::PayoutRules changed;
+        const std::string changed_text = "intrade_bar.min_amount_rub = 60\nintrade_bar.min_amount_usd = 2\n"
+            "intrade_bar.threshold_amount_rub = 6000\nintrade_bar.threshold_amount_usd = 90\n"
+            "intrade_bar.payout.low_60 = 0.5\nintrade_bar.payout.high_60 = 0.55\nintrade_bar.payout.low_180 = 0.7\n"
+            "intrade_bar.payout.low_240 = 0.71\nintrade_bar.payout.high = 0.9\n"
+            "grandcapital.min_amount_rub = 70\ngrandcapital.min_amount_usd = 3\n";
+        uint32_t error_line = 1;
+        int err = payout_model::parse_payout_rules(changed_text, changed, error_line);
+        report.compare_call(name, "parse_payout_rules(changed)", 0, 0, 0, err, (double)error_line, payout_model::ErrorType::OK, 0.0);
+        for(uint32_t p = 0; p < payout_model::INTRADE_BAR_CURRENCY_PAIRS; ++p) {
+            changed.intrade_bar.is_currency_pairs[p] = !changed.intrade_bar.is_currency_pairs[p];
+            changed.intrade_bar.is_currency_pairs_1m_exp[p] = !changed.intrade_bar.is_currency_pairs_1m_exp[p];
+        }
+        for(uint32_t p = 0; p < payout_model::GRANDCAPITAL_CURRENCY_PAIRS; ++p) {
+            changed.grandcapital.is_currency_pairs[p] = !changed.grandcapital.is_currency_pairs[p];
+            changed.grandcapital.currency_pairs_payout[p] = 0.5;
+        }
+        report.compare_call(name, "parse_payout_rules(changed)", 0, 0, 0,
+            0, (double)is_equal_rules(changed, default_rules), 0, 0.0);
+        payout_model::PayoutRules round_trip = changed;
+        err = payout_model::parse_payout_rules(default_text, round_trip, error_line);
+        report.compare_call(name, "parse_payout_rules(round_trip)", 0, 0, error_line,
+            err, (double)is_equal_rules(round_trip, default_rules, 1e-15), payout_model::ErrorType::OK, 1.0);
+        /* прежние значения не меняют правила по умолчанию, в том числе винрейты */
+        round_trip = default_rules;
+        err = payout_model::parse_payout_rules(default_text, round_trip, error_line);
+        report.compare_call(name, "parse_payout_rules(default)", 0, 0, error_line,
+            err, (double)is_equal_rules(round_trip, default_rules), payout_model::ErrorType::OK, 1.0);
+
+        /* ошибки: номер строки и неизмененные правила */
+        struct BadRules {
+            const char *text;
+            int err;
+            uint32_t line;
+        };
+        const BadRules bad_rules[] = {
+            {"intrade_bar.min_amount_usd = 5\n# комментарий\n\nintrade_bar.payout.middle = 0.8\n", payout_model::RulesErrorType::RULES_UNKNOWN_KEY, 4},
+            {"intrade_bar.pair.EURUSD = 0\nintrade_bar.pair.XXXYYY = 1\n", payout_model::RulesErrorType::RULES_UNKNOWN_KEY, 2},
+            {"intrade_bar.min_amount_usd = 5\nintrade_bar.min_amount_rub = 10x\n", payout_model::RulesErrorType::RULES_INVALID_VALUE, 2},
+            {"intrade_bar.min_amount_usd = -1\n", payout_model::RulesErrorType::RULES_INVALID_VALUE, 1},
+            {"intrade_bar.pair.EURUSD = 0.5\n", payout_model::RulesErrorType::RULES_INVALID_VALUE, 1},
+            {"intrade_bar.payout.high = 0.9\nintrade_bar.payout.low_60 = 0\n", payout_model::RulesErrorType::RULES_INVALID_VALUE, 2},
+            {"grandcapital.min_amount_usd = 5\n\ngrandcapital.payout.EURUSD = 0\n", payout_model::RulesErrorType::RULES_INVALID_VALUE, 3},
+            {"grandcapital.payout.XXXYYY = 0.8\n", payout_model::RulesErrorType::RULES_UNKNOWN_KEY, 1},
+            {"intrade_bar.min_amount_usd 5\n", payout_model::RulesErrorType::RULES_SYNTAX_ERROR, 1},
+        };
+        for(const BadRules &bad : bad_rules) {
+            payout_model::PayoutRules rules = changed;
+            error_line = 0;
+            err = payout_model::parse_payout_rules(bad.text, rules, error_line);
+            report.compare_call(name, "parse_payout_rules(error)", 0, 0, 0, err, (double)error_line, bad.err, (double)bad.line);
+            report.compare_call(name, "parse_payout_rules(unchanged)", 0, 0, 0,
+                0, (double)is_equal_rules(rules, changed), 0, 1.0);
+        }
+
+        /* измененная выплата попадает в расчет */
+        const xtime::timestamp_t timestamp = xtime::get_timestamp(15, 1, 2020, 10, 30, 0);
+        payout_model::PayoutRules rules;
+        err = payout_model::parse_payout_rules("intrade_bar.payout.high = 0.9\ngrandcapital.payout.EURUSD = 0.55\n", rules, error_line);
+        report.compare_call(name, "parse_payout_rules(payout)", timestamp, 0, 0, err, (double)error_line, payout_model::ErrorType::OK, 0.0);
+        payout_model::IntradeBar intrade_bar(payout_model::IntradeBar::CURRENCY_USD);
+        payout_model::Grandcapital grandcapital(payout_model::Grandcapital::CURRENCY_USD);
+        double payout = -1.0;
+        err = intrade_bar.get_payout(payout, timestamp, 300, 0, 100.0);
+        report.compare_call(name, "get_payout(default rules)", timestamp, 300, 0, err, payout, payout_model::ErrorType::OK, 0.85);
+        intrade_bar.set_rules(rules.intrade_bar);
+        grandcapital.set_rules(rules.grandcapital);
+        err = intrade_bar.get_payout(payout, timestamp, 300, 0, 100.0);
+        report.compare_call(name, "get_payout(rules)", timestamp, 300, 0, err, payout, payout_model::ErrorType::OK, 0.9);
+        err = grandcapital.get_payout(payout, timestamp, 300, 0, 100.0);
+        report.compare_call(name, "get_payout(rules)", timestamp, 300, 0, err, payout, payout_model::ErrorType::OK, 0.55);
+
+        /* загрузка из файла */
+        const char *rules_file_name = "payout-rules-load-check.txt";
+        {
+            std::ofstream file(rules_file_name);
+            file << default_text << "grandcapital.payout.EURUSD = 0.55\n";
+        }
+        payout_model::PayoutRules loaded = changed;
+        err = payout_model::load_payout_rules(rules_file_name, loaded, error_line);
+        loaded.grandcapital.currency_pairs_payout[0] = default_rules.grandcapital.currency_pairs_payout[0];
+        report.compare_call(name, "load_payout_rules", 0, 0, error_line,
+            err, (double)is_equal_rules(loaded, default_rules, 1e-15), payout_model::ErrorType::OK, 1.0);
+        std::remove(rules_file_name);
+        err = payout_model::load_payout_rules(rules_file_name, loaded, error_line);
+        report.compare_call(name, "load_payout_rules(missing)", 0, 0, 0,
+            err, (double)error_line, payout_model::RulesErrorType::RULES_FILE_NOT_OPEN, 0.0);
+
+        /* публикация новой версии: открытая секция чтения видит старую, новая секция - новую */
+        typedef payout_model::RcuPointer<payout_model::PayoutRules, 2> RulesPointer;
+        RulesPointer pointer(std::make_unique<const payout_model::PayoutRules>(default_rules));
+        {
+            RulesPointer::Reader reader(pointer);
+            const RulesPointer::Guard old_guard = reader.lock();
+            report.compare_call(name, "rcu.lock", 0, 0, 0,
+                0, old_guard->intrade_bar.high_payout, 0, default_rules.intrade_bar.high_payout);
+            pointer.publish(std::make_unique<const payout_model::PayoutRules>(rules));
+            report.compare_call(name, "rcu.lock(old)", 0, 0, 0,
+                0, old_guard->intrade_bar.high_payout, 0, default_rules.intrade_bar.high_payout);
+            report.compare_call(name, "rcu.get_retired_size(locked)", 0, 0, 0, 0, (double)pointer.get_retired_size(), 0, 1.0);
+            {
+                RulesPointer::Reader other_reader(pointer);
+                RulesPointer::Reader extra_reader(pointer);
+                const RulesPointer::Guard guard = other_reader.lock();
+                report.compare_call(name, "rcu.lock(new)", 0, 0, 0, 0, guard->intrade_bar.high_payout, 0, 0.9);
+                /* слотов два, третий читатель получает пустую секцию чтения */
+                const RulesPointer::Guard empty_guard = extra_reader.lock();
+                report.compare_call(name, "rcu.lock(no slot)", 0, 0, 0,
+                    (int)extra_reader.is_valid(), (double)(empty_guard.get() == nullptr), 0, 1.0);
+            }
+        }
+        pointer.reclaim();
+        report.compare_call(name, "rcu.get_retired_size", 0, 0, 0, 0, (double)pointer.get_retired_size(), 0, 0.0);
+    }
+
+    /** \brief Сверить эпохи правил и поиск модели по метке времени
+     *
+     * Проверяются поиск точно на границе эпохи и до первой эпохи, курсор при движении вперед
+     * (с пропуском эпохи) и назад, календарь торговли эпохи, а также ошибки файла эпох:
+     * убывающие и повторяющиеся метки времени, ошибки правил и календаря.
+     * \param report Счетчик расхождений
+     */
+    void check_rules_timeline(CheckReport &report) {
+        typedef payout_model::IntradeBar Model;
+        const char *name = "timeline";
+        const xtime::timestamp_t day = xtime::get_timestamp(15, 1, 2020, 10, 30, 0);
+        const xtime::timestamp_t begins[] = {day + 1000, day + 2000, day + 3000, day + 4000};
+        const double payouts[] = {0.81, 0.82, 0.83, 0.84};
+
+        /* эпохи из файла: первая начинается с 0 и наследуется следующими */
+        std::string text = "intrade_bar.min_amount_usd = 2\n";
+        for(size_t i = 0; i < 4; ++i) {
+            text += "epoch = " + std::to_string(begins[i]) + " # эпоха\n";
+            text += "intrade_bar.payout.high = " + std::to_string(payouts[i]) + "\n";
+        }
+        std::vector<payout_model::PayoutRulesEpoch> epochs;
+        uint32_t error_line = 1;
+        int err = payout_model::parse_payout_rules_timeline(text, epochs, error_line);
+        report.compare_call(name, "parse_payout_rules_timeline", 0, 0, error_line,
+            err, (double)epochs.size(), payout_model::ErrorType::OK, 5.0);
+        if(epochs.size() != 5) return;
+        for(size_t i = 0; i < epochs.size(); ++i) {
+            report.compare_call(name, "parse_payout_rules_timeline(begin)", 0, 0, (uint32_t)i,
+                0, (double)epochs[i].begin, 0, i == 0 ? 0.0 : (double)begins[i - 1]);
+            report.compare_call(name, "parse_payout_rules_timeline(rules)", 0, 0, (uint32_t)i,
+                0, epochs[i].rules.intrade_bar.high_payout + epochs[i].rules.intrade_bar.min_amount_usd,
+                0, (i == 0 ? 0.85 : payouts[i - 1]) + 2.0);
+        }
+
+        const payout_model::ModelTimeline<Model> timeline =
+            payout_model::make_model_timeline<Model>(epochs, Model::CURRENCY_USD);
+        /* поиск на границе эпохи, на секунду раньше и внутри эпохи */
+        for(size_t i = 0; i < 4; ++i) {
+            const xtime::timestamp_t timestamps[] = {begins[i] - 1, begins[i], begins[i] + 500};
+            const size_t expected[] = {i, i + 1, i + 1};
+            for(size_t j = 0; j < 3; ++j) {
+                double payout = -1.0;
+                err = timeline.get(timestamps[j]).get_payout(payout, timestamps[j], 300, 0, 100.0);
+                report.compare_call(name, "ModelTimeline::get", timestamps[j], 300, 0,
+                    err, payout, payout_model::ErrorType::OK, expected[j] == 0 ? 0.85 : payouts[expected[j] - 1]);
+                report.compare_call(name, "ModelTimeline::find", timestamps[j], 0, 0,
+                    0, (double)timeline.find(timestamps[j]), 0, (double)expected[j]);
+            }
+        }
+
+        /* метки времени до первой эпохи относятся к первой эпохе */
+        payout_model::ModelTimeline<Model> late_timeline;
+        for(size_t i = 0; i < 4; ++i) {
+            late_timeline.add(begins[3 - i], Model::make_snapshot(Model::CURRENCY_USD,
+                std::make_shared<const payout_model::IntradeBarRules>(epochs[4 - i].rules.intrade_bar)));
+        }
+        report.compare_call(name, "ModelTimeline::add(order)", 0, 0, 0,
+            0, (double)(late_timeline.get_begin(0) == begins[0] && late_timeline.get_begin(3) == begins[3]), 0, 1.0);
+        for(const xtime::timestamp_t timestamp : {(xtime::timestamp_t)0, begins[0] - 1, begins[0]}) {
+            report.compare_call(name, "ModelTimeline::get(before first)", timestamp, 0, 0,
+                0, (double)late_timeline.find(timestamp), 0, 0.0);
+            double payout = -1.0;
+            err = late_timeline.get(timestamp).get_payout(payout, day, 300, 0, 100.0);
+            report.compare_call(name, "ModelTimeline::get(before first)", timestamp, 300, 0,
+                err, payout, payout_model::ErrorType::OK, payouts[0]);
+        }
+
+        /* курсор: вперед на соседнюю эпоху, с пропуском эпох, назад и до первой эпохи */
+        const xtime::timestamp_t path[] = {
+            begins[0] - 1, begins[0], begins[0] + 999, begins[1], begins[3] + 10, begins[3] + 100000,
+            begins[2], begins[2] - 1, begins[0] + 5, 10, begins[1] - 1, begins[2]};
+        payout_model::ModelTimeline<Model>::Cursor cursor = timeline.get_cursor();
+        payout_model::CalendarCursor calendar_cursor(path[0]);
+        for(const xtime::timestamp_t timestamp : path) {
+            const Model &model = cursor.update(timestamp);
+            report.compare_call(name, "ModelTimeline::Cursor", timestamp, 0, 0,
+                0, (double)cursor.get_index(), 0, (double)timeline.find(timestamp));
+            report.compare_call(name, "ModelTimeline::Cursor(model)", timestamp, 0, 0,
+                0, (double)(&model == &timeline.get(timestamp)), 0, 1.0);
+            calendar_cursor.update(timestamp);
+            report.compare_call(name, "ModelTimeline::Cursor(calendar)", timestamp, 0, 0,
+                0, (double)(&cursor.update(calendar_cursor) == &timeline.get(timestamp)), 0, 1.0);
+        }
+
+        /* пустой список эпох дает одну эпоху со встроенными правилами */
+        const payout_model::ModelTimeline<Model> default_timeline =
+            payout_model::make_model_timeline<Model>(std::vector<payout_model::PayoutRulesEpoch>(), Model::CURRENCY_USD);
+        if(report.compare_call(name, "make_model_timeline(empty)", 0, 0, 0,
+                0, (double)default_timeline.size(), 0, 1.0)) {
+            double payout = -1.0, reference_payout = -1.0;
+            err = default_timeline.get_cursor().update(day).get_payout(payout, day, 300, 0, 100.0);
+            const int reference_err = Model(Model::CURRENCY_USD).get_payout(reference_payout, day, 300, 0, 100.0);
+            report.compare_call(name, "make_model_timeline(empty)", day, 300, 0, err, payout, reference_err, reference_payout);
+        }
+
+        /* календарь эпохи: сессия Grandcapital в среду сокращается со второй эпохи и наследуется третьей */
+        typedef payout_model::Grandcapital SessionModel;
+        const xtime::timestamp_t wed = xtime::get_timestamp(15, 1, 2020);
+        const std::string calendar_text =
+            "epoch = " + std::to_string(wed) + "\n"
+            "grandcapital.calendar.session.wed = 00:00-19:00 # сессия до 19:00\n"
+            "epoch = " + std::to_string(wed + 7 * xtime::SECONDS_IN_DAY) + "\n";
+        std::vector<payout_model::PayoutRulesEpoch> calendar_epochs;
+        err = payout_model::parse_payout_rules_timeline(calendar_text, calendar_epochs, error_line);
+        report.compare_call(name, "parse_payout_rules_timeline(calendar)", 0, 0, error_line,
+            err, (double)calendar_epochs.size(), payout_model::ErrorType::OK, 3.0);
+        if(calendar_epochs.size() != 3) return;
+        report.compare_call(name, "parse_payout_rules_timeline(calendar inherited)", 0, 0, 0,
+            0, (double)(!calendar_epochs[0].grandcapital_calendar && !calendar_epochs[2].intrade_bar_calendar &&
+            calendar_epochs[1].grandcapital_calendar == calendar_epochs[2].grandcapital_calendar), 0, 1.0);
+        const payout_model::ModelTimeline<SessionModel> session_timeline =
+            payout_model::make_model_timeline<SessionModel>(calendar_epochs, SessionModel::CURRENCY_USD);
+        const SessionModel session_reference(SessionModel::CURRENCY_USD);
+        const xtime::timestamp_t session_timestamps[] = {
+            wed - 7 * xtime::SECONDS_IN_DAY + 19 * xtime::SECONDS_IN_HOUR + 1800,
+            wed + 18 * xtime::SECONDS_IN_HOUR + 1800,
+            wed + 19 * xtime::SECONDS_IN_HOUR + 1800,
+            wed + 7 * xtime::SECONDS_IN_DAY + 19 * xtime::SECONDS_IN_HOUR + 1800};
+        for(const xtime::timestamp_t timestamp : session_timestamps) {
+            const bool is_night = timestamp >= wed && timestamp % xtime::SECONDS_IN_DAY >= 19 * xtime::SECONDS_IN_HOUR;
+            double payout = -1.0, reference_payout = -1.0;
+            err = session_timeline.get(timestamp).get_payout(payout, timestamp, 300, 0, 100.0);
+            int reference_err = session_reference.get_payout(reference_payout, timestamp, 300, 0, 100.0);
+            if(is_night) {
+                reference_err = SessionModel::PayoutCancelType::NIGHT_HOURS;
+                reference_payout = 0.0;
+            }
+            report.compare_call(name, "ModelTimeline::get(calendar)", timestamp, 300, 0,
+                err, payout, reference_err, reference_payout);
+        }
+
+        /* ошибки: убывающая, повторяющаяся и нулевая метка времени, ошибка правил внутри эпохи */
+        struct BadTimeline {
+            std::string text;
+            int err;
+            uint32_t line;
+        };
+        const BadTimeline bad_timelines[] = {
+            {"epoch = 2000\nintrade_bar.payout.high = 0.9\nepoch = 1000\n", payout_model::RulesErrorType::RULES_INVALID_VALUE, 3},
+            {"epoch = 2000\n\nepoch = 2000\nintrade_bar.payout.high = 0.9\n", payout_model::RulesErrorType::RULES_INVALID_VALUE, 3},
+            {"# эпоха 0 задана без строки epoch\nepoch = 0\n", payout_model::RulesErrorType::RULES_INVALID_VALUE, 2},
+            {"epoch = 1000x\n", payout_model::RulesErrorType::RULES_INVALID_VALUE, 1},
+            {"epoch = 1000\nintrade_bar.payout.high = 0.9\nepoch = 2000\n\nintrade_bar.payout.low = 0.9\n", payout_model::RulesErrorType::RULES_UNKNOWN_KEY, 5},
+            {"epoch = 1000\nintrade_bar.calendar.closed = 2020-02-30\n", payout_model::RulesErrorType::RULES_INVALID_VALUE, 2},
+            {"intrade_bar.payout.high = 0.9\ngrandcapital.calendar.holiday = 2020-01-01\n", payout_model::RulesErrorType::RULES_UNKNOWN_KEY, 2},
+            {"grandcapital.calendar.session.wed = 01:00-02:00\nintrade_bar.payout.low = 0.9\n", payout_model::RulesErrorType::RULES_UNKNOWN_KEY, 2},
+        };
+        for(const BadTimeline &bad : bad_timelines) {
+            std::vector<payout_model::PayoutRulesEpoch> bad_epochs = epochs;
+            error_line = 0;
+            err = payout_model::parse_payout_rules_timeline(bad.text, bad_epochs, error_line);
+            report.compare_call(name, "parse_payout_rules_timeline(error)", 0, 0, 0, err, (double)error_line, bad.err, (double)bad.line);
+            report.compare_call(name, "parse_payout_rules_timeline(unchanged)", 0, 0, 0,
+                0, (double)bad_epochs.size(), 0, (double)epochs.size());
+        }
+    }
+
+    /** \brief Сверить трассировку расчета ставки IntradeBar с результатами вызовов
+     *
+     * Последняя запись буфера должна совпадать с результатом get_amount, ветвь - с временем и длительностью,
+     * ставка - с долей Келли из записи. Без PAYOUT_MODEL_TRACE буфер должен остаться пустым.
+     * \param report Счетчик расхождений
+     */
+    void check_amount_trace(CheckReport &report) {
+        typedef payout_model::IntradeBar Model;
+        const Model model(Model::CURRENCY_USD);
+        const std::vector<uint32_t> &durations = IntradeBarTraits::get_check_durations();
+        const std::vector<xtime::timestamp_t> timestamps = get_check_timestamps();
+        const size_t capacity = 64;
+        payout_model::AmountTraceRing ring(capacity);
+        payout_model::AmountTraceScope scope(ring);
+        uint64_t calls = 0;
+        for(size_t t = 0; t < timestamps.size(); t += 3)
+        for(const double winrate : check_winrates) {
+            const xtime::timestamp_t timestamp = timestamps[t];
+            const uint32_t duration = durations[t % durations.size()];
+            const uint32_t p = t % IntradeBarTraits::PAIRS;
+            const double balance = check_balances[t % 2] * 10.0;
+            const double payout_limiter = check_payout_limiters[t % 3];
+            const double winrate_limiter = check_winrate_limiters[t % 3];
+            double amount = 0.0, payout = 0.0;
+            const int err = model.get_amount(amount, payout, timestamp, duration, p,
+                balance, winrate, 0.4, payout_limiter, winrate_limiter);
+            ++calls;
+            if(!payout_model::AmountTracer::is_enabled) continue;
+
+            const payout_model::AmountTrace &record = ring.get(ring.size() - 1);
+            report.compare_call(IntradeBarTraits::NAME, "trace.amount", timestamp, duration, p,
+                record.err, record.amount, err, amount);
+            if(err != payout_model::ErrorType::OK || amount <= 0.0) continue;
+
+            const uint32_t hour = (uint32_t)(timestamp % xtime::SECONDS_IN_DAY / xtime::SECONDS_IN_HOUR);
+            const uint32_t minute = (uint32_t)(timestamp % xtime::SECONDS_IN_HOUR / xtime::SECONDS_IN_MINUTE);
+            const bool is_edge = (hour <= 6 || hour >= 14 || (hour == 13 && minute >= 57) || duration == 60) &&
+                (minute >= 57 || minute <= 2 || duration == 60);
+            const int branch = is_edge ? payout_model::TRACE_BRANCH_60 :
+                duration == 180 ? payout_model::TRACE_BRANCH_180 : payout_model::TRACE_BRANCH_240;
+            const uint32_t flags =
+                (payout_limiter < record.raw_payout ? payout_model::TRACE_PAYOUT_LIMITED : 0) |
+                (winrate_limiter < winrate ? payout_model::TRACE_WINRATE_LIMITED : 0) |
+                (payout == model.get_rules().high_payout || payout == model.get_rules().high_payout_60 ?
+                    payout_model::TRACE_HIGH_TIER : 0);
+            report.compare_call(IntradeBarTraits::NAME, "trace.branch", timestamp, duration, p,
+                record.branch, record.raw_payout, branch, payout);
+            report.compare_call(IntradeBarTraits::NAME, "trace.rate", timestamp, duration, p,
+                (int)record.flags, balance * record.rate, (int)flags, amount);
+        }
+        const uint64_t expected = payout_model::AmountTracer::is_enabled ? calls : 0;
+        report.compare_call(IntradeBarTraits::NAME, "trace.ring", 0, 0, 0,
+            (int)ring.size(), (double)ring.get_total(), (int)std::min<uint64_t>(expected, capacity), (double)expected);
+    }
+
+    /** \brief Сверить расчет файла сигналов с вызовами модели
+     * \param currency Валюта счета
+     * \param report Счетчик расхождений
+     */
+    template<class TRAITS>
+    void check_signal_file(const uint32_t currency, CheckReport &report) {
+        typedef typename TRAITS::Model Model;
+        const Model model(currency);
+        const std::vector<uint32_t> &durations = TRAITS::get_check_durations();
+        const std::vector<xtime::timestamp_t> timestamps = get_check_timestamps();
+        const size_t n = timestamps.size();
+        std::vector<payout_model::PayoutSignal> signals(n);
+        for(size_t i = 0; i < n; ++i) {
+            payout_model::PayoutSignal &signal = signals[i];
+            signal.timestamp = timestamps[i];
+            signal.duration = durations[i % durations.size()];
+            /* последний номер - отсутствующая валютная пара */
+            signal.currency_pair_index = (uint32_t)((i / 3) % (TRAITS::PAIRS + 1));
+            signal.amount = check_amounts[(i / 5) % 4];
+            signal.balance = check_balances[(i / 7) % 2];
+            signal.winrate = check_winrates[(i / 2) % 5];
+            signal.attenuator = 0.4;
+            signal.payout_limiter = check_payout_limiters[(i / 11) % 3];
+            signal.winrate_limiter = check_winrate_limiters[(i / 11) % 3];
+        }
+        const char *signal_file_name = "payout-signals-check.bin";
+        const char *result_file_name = "payout-results-check.bin";
+        report.compare_call(TRAITS::NAME, "signal_file.save", 0, 0, 0,
+            payout_model::save_payout_signals(signal_file_name, signals.data(), n), 0.0, payout_model::ErrorType::OK, 0.0);
+
+        /* часть не кратна размеру файла, потоков больше одного */
+        payout_model::PayoutSignalConfig config;
+        config.threads = 3;
+        config.chunk = 1000;
+        const int modes[] = {payout_model::SIGNAL_PAYOUT, payout_model::SIGNAL_AMOUNT};
+        for(const int mode : modes) {
+            config.mode = mode;
+            uint64_t records = 0;
+            const int err = payout_model::evaluate_payout_signals(model, signal_file_name, result_file_name, config, &records);
+            report.compare_call(TRAITS::NAME, "signal_file.evaluate", 0, 0, 0, err, (double)records, payout_model::ErrorType::OK, (double)n);
+            payout_model::PayoutSignalResultFile result_file;
+            const int open_err = result_file.open(result_file_name);
+            report.compare_call(TRAITS::NAME, "signal_file.result", 0, 0, 0,
+                open_err, (double)result_file.size(), payout_model::ErrorType::OK, (double)n);
+            if(result_file.size() != n || result_file.get_header()->mode != mode) {
+                report.compare_call(TRAITS::NAME, "signal_file.mode", 0, 0, 0,
+                    result_file.is_open() ? result_file.get_header()->mode : -1, 0.0, mode, 0.0);
+                continue;
+            }
+            const payout_model::PayoutSignalResult *result = result_file.get_records();
+            for(size_t i = 0; i < n; ++i) {
+                const payout_model::PayoutSignal &signal = signals[i];
+                double amount = signal.amount, payout = 0.0;
+                int reference_err = 0;
+                if(mode == payout_model::SIGNAL_PAYOUT) {
+                    reference_err = model.get_payout(payout, signal.timestamp, signal.duration,
+                        signal.currency_pair_index, signal.amount);
+                } else {
+                    reference_err = model.get_amount(amount, payout, signal.timestamp, signal.duration,
+                        signal.currency_pair_index, signal.balance, signal.winrate, signal.attenuator,
+                        signal.payout_limiter, signal.winrate_limiter);
+                }
+                if(!report.compare_call(TRAITS::NAME, "signal_file.payout", signal.timestamp, signal.duration,
+                    signal.currency_pair_index, result[i].err, result[i].payout, reference_err, payout)) continue;
+                report.compare_call(TRAITS::NAME, "signal_file.amount", signal.timestamp, signal.duration,
+                    signal.currency_pair_index, result[i].err, result[i].amount, reference_err, amount);
+            }
+        }
+
+        /* файл результатов не открывается как файл сигналов, отсутствующий файл не открывается */
+        report.compare_call(TRAITS::NAME, "signal_file.errors", 0, 0, 0,
+            payout_model::evaluate_payout_signals(model, result_file_name, signal_file_name, config), 0.0,
+            payout_model::SignalFileErrorType::SIGNAL_BAD_FORMAT, 0.0);
+        std::remove(result_file_name);
+        report.compare_call(TRAITS::NAME, "signal_file.errors", 0, 0, 0,
+            payout_model::evaluate_payout_signals(model, result_file_name, signal_file_name, config), 0.0,
+            payout_model::SignalFileErrorType::SIGNAL_FILE_NOT_OPEN, 0.0);
+        std::remove(signal_file_name);
+    }
+
+#   if defined(PAYOUT_MODEL_BENCHMARK_C_API)
+    /** \brief Сверить интерфейс C с пакетными методами модели
+     * \param broker Брокер интерфейса C
+     * \param currency Валюта счета
+     * \param report Счетчик расхождений
+     */
+    template<class TRAITS>
+    void check_c_api(const int32_t broker, const uint32_t currency, CheckReport &report) {
+        typedef typename TRAITS::Model Model;
+        const char *path = "c_api";
+        const std::vector<uint32_t> &durations = TRAITS::get_check_durations();
+        const std::vector<xtime::timestamp_t> timestamps = get_check_timestamps();
+        const size_t n = timestamps.size();
+#       if defined(PAYOUT_MODEL_BENCHMARK_C_API_PORTABLE)
+        /* переносимая библиотека C собрана без -march=native, поэтому ставки Келли
+         * могут отличаться от векторных ядер проверки в последних битах */
+        auto get_c_value = [](const double value, const double reference) {
+            return std::abs(value - reference) <= 1e-12 * std::abs(reference) ? reference : value;
+        };
+#       else
+        auto get_c_value = [](const double value, const double) {return value;};
+#       endif
+        std::vector<uint32_t> duration(n), index(n);
+        std::vector<double> amount(n), balance(n), winrate(n), attenuator(n, 0.4);
+        std::vector<double> payout_limiter(n), winrate_limiter(n);
+        for(size_t i = 0; i < n; ++i) {
+            duration[i] = durations[i % durations.size()];
+            /* последний номер - отсутствующая валютная пара */
+            index[i] = (uint32_t)((i / 3) % (TRAITS::PAIRS + 1));
+            amount[i] = check_amounts[(i / 5) % 4];
+            balance[i] = check_balances[(i / 7) % 2];
+            winrate[i] = check_winrates[(i / 2) % 5];
+            payout_limiter[i] = check_payout_limiters[(i / 11) % 3];
+            winrate_limiter[i] = check_winrate_limiters[(i / 11) % 3];
+        }
+
+        /* правила из файла должны попасть в расчет так же, как через set_rules */
+        const char *rules_file_name = "payout-rules-check.txt";
+        {
+            std::ofstream file(rules_file_name);
+            file << "intrade_bar.min_amount_usd = 20\nintrade_bar.min_amount_rub = 1000\n"
+                "grandcapital.min_amount_usd = 20\ngrandcapital.min_amount_rub = 1000\n";
+        }
+        payout_model::PayoutRules rules;
+        uint32_t line = 0;
+        payout_model::load_payout_rules(rules_file_name, rules, line);
+
+        for(int is_rules = 0; is_rules <= 1; ++is_rules) {
+            Model model(currency);
+            payout_model_c *c_model = payout_model_c_create(broker, (int32_t)currency);
+            if(is_rules) {
+                model.set_rules(TRAITS::get_rules(rules));
+                uint32_t error_line = 1;
+                const int32_t err = payout_model_c_load_rules(c_model, rules_file_name, &error_line);
+                report.compare_call(TRAITS::NAME, "c_api.load_rules", 0, 0, 0, err, (double)error_line, 0, 0.0);
+            }
+
+            std::vector<double> payout(n), c_payout(n), out_amount(n), c_amount(n);
+            std::vector<int> err(n);
+            std::vector<int32_t> c_err(n);
+            model.get_payout(payout.data(), err.data(), timestamps.data(), duration.data(), index.data(), amount.data(), n);
+            payout_model_c_get_payout(c_model, c_payout.data(), c_err.data(), timestamps.data(),
+                duration.data(), index.data(), amount.data(), n);
+            for(size_t i = 0; i < n; ++i) {
+                report.compare_call(TRAITS::NAME, "c_api.get_payout", timestamps[i], duration[i], index[i],
+                    c_err[i], c_payout[i], err[i], payout[i]);
+            }
+
+            const double *payout_limiters[] = {payout_limiter.data(), nullptr};
+            const double *winrate_limiters[] = {winrate_limiter.data(), nullptr};
+            for(int l = 0; l < 2; ++l) {
+                model.get_amount(out_amount.data(), payout.data(), err.data(), timestamps.data(), duration.data(),
+                    index.data(), balance.data(), winrate.data(), attenuator.data(), payout_limiters[l], winrate_limiters[l], n);
+                payout_model_c_get_amount(c_model, c_amount.data(), c_payout.data(), c_err.data(), timestamps.data(),
+                    duration.data(), index.data(), balance.data(), winrate.data(), attenuator.data(),
+                    payout_limiters[l], winrate_limiters[l], n);
+                for(size_t i = 0; i < n; ++i) {
+                    if(!report.compare_call(TRAITS::NAME, "c_api.get_amount", timestamps[i], duration[i], index[i],
+                        c_err[i], get_c_value(c_amount[i], out_amount[i]), err[i], out_amount[i])) continue;
+                    report.compare_call(TRAITS::NAME, "c_api.get_amount.payout", timestamps[i], duration[i], index[i],
+                        c_err[i], c_payout[i], err[i], payout[i]);
+                }
+            }
+            payout_model_c_destroy(c_model);
+        }
+        std::remove(rules_file_name);
+
+        /* ошибки правил и аргументов */
+        {
+            std::ofstream file(rules_file_name);
+            file << "# check\nintrade_bar.unknown = 1\n";
+        }
+        payout_model_c *c_model = payout_model_c_create(broker, (int32_t)currency);
+        uint32_t error_line = 0;
+        const int32_t rules_err = payout_model_c_load_rules(c_model, rules_file_name, &error_line);
+        report.compare_call(TRAITS::NAME, path, 0, 0, 0,
+            rules_err, (double)error_line, PAYOUT_MODEL_C_RULES_UNKNOWN_KEY, 2.0);
+        std::remove(rules_file_name);
+        report.compare_call(TRAITS::NAME, path, 0, 0, 0,
+            payout_model_c_load_rules(c_model, rules_file_name, nullptr), 0.0, PAYOUT_MODEL_C_RULES_FILE_NOT_OPEN, 0.0);
+        double value = 0;
+        int32_t value_err = 0;
+        report.compare_call(TRAITS::NAME, path, 0, 0, 0,
+            payout_model_c_get_payout(c_model, &value, &value_err, nullptr, duration.data(), index.data(), amount.data(), 1),
+            0.0, PAYOUT_MODEL_C_INVALID_ARGUMENT, 0.0);
+        report.compare_call(TRAITS::NAME, path, 0, 0, 0,
+            payout_model_c_get_amount(nullptr, &value, &value, &value_err, timestamps.data(), duration.data(),
+                index.data(), balance.data(), winrate.data(), attenuator.data(), nullptr, nullptr, 1),
+            0.0, PAYOUT_MODEL_C_INVALID_ARGUMENT, 0.0);
+        report.compare_call(TRAITS::NAME, path, 0, 0, 0,
+            payout_model_c_get_payout(c_model, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, 0),
+            0.0, PAYOUT_MODEL_C_OK, 0.0);
+        payout_model_c_destroy(c_model);
+        report.compare_call(TRAITS::NAME, path, 0, 0, 0,
+            payout_model_c_create(broker, 2) == nullptr, 0.0, 1, 0.0);
+
+        /* имена и номера валютных пар */
+        report.compare_call(TRAITS::NAME, "c_api.get_pairs", 0, 0, 0,
+            (int)payout_model_c_get_pairs(broker), 0.0, (int)TRAITS::PAIRS, 0.0);
+        for(uint32_t p = 0; p < TRAITS::PAIRS; ++p) {
+            const char *name = payout_model_c_get_pair_name(broker, p);
+            const bool is_name = name && TRAITS::get_pair_name(p) == name;
+            report.compare_call(TRAITS::NAME, "c_api.get_pair_name", 0, 0, p,
+                is_name ? payout_model_c_get_pair_index(broker, name) : -1, 0.0, (int)p, 0.0);
+        }
+        report.compare_call(TRAITS::NAME, "c_api.get_pair_name", 0, 0, TRAITS::PAIRS,
+            payout_model_c_get_pair_name(broker, TRAITS::PAIRS) == nullptr, 0.0,
+            payout_model_c_get_pair_index(broker, "XXXYYY") == -1, 0.0);
+    }
+#   endif
+
+    /** \brief Сверить выбор брокера маршрутизатором с эталонной реализацией
+     * \param currency Валюта счетов
+     * \param report Счетчик расхождений
+     */
+    void check_router(const uint32_t currency, CheckReport &report) {
+        const payout_model::BrokerRouter router(
+            payout_model::IntradeBar::make_snapshot(currency),
+            payout_model::Grandcapital::make_snapshot(currency));
+        payout_model_reference::IntradeBar reference_intrade_bar(currency);
+        payout_model_reference::Grandcapital reference_grandcapital(currency);
+        const uint32_t durations[] = {60, 180, 300, 3600};
+        const std::vector<xtime::timestamp_t> timestamps = get_check_timestamps();
+        const size_t n = timestamps.size();
+        std::vector<uint32_t> duration(n), symbol(n);
+        std::vector<double> winrate(n), attenuator(n, 0.4), intrade_bar_balance(n), grandcapital_balance(n);
+        std::vector<double> amount(n), payout(n);
+        std::vector<int> broker(n);
+        for(size_t i = 0; i < n; ++i) {
+            duration[i] = durations[i % 4];
+            symbol[i] = (uint32_t)((i / 4) % (payout_model::CROSS_BROKER_SYMBOLS + 1));
+            winrate[i] = check_winrates[(i / 3) % (sizeof(check_winrates) / sizeof(check_winrates[0]))];
+            intrade_bar_balance[i] = check_balances[(i / 5) % 2];
+            grandcapital_balance[i] = check_balances[(i / 7) % 2];
+        }
+        router.route(broker.data(), amount.data(), payout.data(), nullptr, timestamps.data(), duration.data(),
+            symbol.data(), winrate.data(), attenuator.data(), intrade_bar_balance.data(), grandcapital_balance.data(), n);
+
+        const std::string name_missing("XXXYYY");
+        for(size_t i = 0; i < n; ++i) {
+            const std::string name = symbol[i] < payout_model::CROSS_BROKER_SYMBOLS ?
+                std::string(payout_model::BrokerRouter::get_symbol_name(symbol[i])) : name_missing;
+            int best_broker = payout_model::BROKER_NONE;
+            double best_amount = 0, best_payout = 0, best_growth = 0;
+            for(int b = payout_model::BROKER_INTRADE_BAR; b <= payout_model::BROKER_GRANDCAPITAL; ++b) {
+                double reference_amount = 0, reference_payout = 0;
+                const double balance = b == payout_model::BROKER_INTRADE_BAR ? intrade_bar_balance[i] : grandcapital_balance[i];
+                const int err = b == payout_model::BROKER_INTRADE_BAR ?
+                    reference_intrade_bar.get_amount(reference_amount, reference_payout, name, timestamps[i],
+                        duration[i], balance, winrate[i], attenuator[i]) :
+                    reference_grandcapital.get_amount(reference_amount, reference_payout, name, timestamps[i],
+                        duration[i], balance, winrate[i], attenuator[i]);
+                if(err != 0 || !(reference_amount > 0)) continue;
+                const double growth = payout_model::get_log_growth(reference_amount, reference_payout, balance, winrate[i]);
+                if(growth > best_growth) {
+                    best_broker = b;
+                    best_amount = reference_amount;
+                    best_payout = reference_payout;
+                    best_growth = growth;
+                }
+            }
+            if(report.compare_call("router", "route(broker)", timestamps[i], duration[i], symbol[i],
+                    broker[i], amount[i], best_broker, best_amount)) {
+                report.compare_call("router", "route(payout)", timestamps[i], duration[i], symbol[i],
+                    broker[i], payout[i], best_broker, best_payout);
+            }
+        }
+    }
+
+    /// Результат измерения
+    class BenchResult {
+    public:
+        std::string name;
+        double ns_per_op = 0;
+    };
+
+    /** \brief Набор сделок для измерения
+     */
+    class BenchData {
+    public:
+        std::vector<xtime::timestamp_t> timestamp;
+        std::vector<uint32_t> duration;
+        std::vector<uint32_t> index;
+        std::vector<std::string> name;
+        std::vector<double> amount;
+        std::vector<double> balance;
+        std::vector<double> winrate;
+        std::vector<double> attenuator;
+
+        inline size_t size() const {return timestamp.size();}
+    };
+
+    /// Распределения меток времени
+    enum TimestampDistribution {
+        STREAM = 0,     ///< Поток минутных баров подряд, как при бэктесте
+        RANDOM = 1,     ///< Случайные метки времени за несколько лет
+        SESSION = 2,    ///< Случайные метки времени внутри торговой сессии будних дней
+    };
+
+    const char *distribution_names[] = {"stream", "random", "session"};
+
+    template<class TRAITS>
+    BenchData make_bench_data(const TimestampDistribution distribution, const size_t size) {
+        std::mt19937_64 rng(12345 + distribution);
+        const std::vector<uint32_t> &durations = TRAITS::get_bench_durations();
+        const xtime::timestamp_t begin = xtime::get_timestamp(1, 1, 2016);
+        const xtime::timestamp_t end = xtime::get_timestamp(1, 1, 2021);
+        const xtime::timestamp_t stream_begin = xtime::get_timestamp(2, 1, 2019);
+        BenchData data;
+        for(size_t i = 0; i < size; ++i) {
+            xtime::timestamp_t timestamp = 0;
+            switch(distribution) {
+            case STREAM:
+                timestamp = stream_begin + i * xtime::SECONDS_IN_MINUTE;
+                break;
+            case RANDOM:
+                timestamp = begin + rng() % (end - begin);
+                break;
+            case SESSION:
+                do {
+                    const xtime::timestamp_t day = xtime::get_first_timestamp_day(begin + rng() % (end - begin));
+                    timestamp = day + 2 * xtime::SECONDS_IN_HOUR + rng() % (17 * xtime::SECONDS_IN_HOUR);
+                } while(xtime::get_weekday(timestamp) == xtime::SAT || xtime::get_weekday(timestamp) == xtime::SUN);
+                break;
+            }
+            const uint32_t index = rng() % TRAITS::PAIRS;
+            data.timestamp.push_back(timestamp);
+            data.duration.push_back(durations[rng() % durations.size()]);
+            data.index.push_back(index);
+            data.name.push_back(TRAITS::get_pair_name(index));
+            data.amount.push_back(check_amounts[rng() % (sizeof(check_amounts) / sizeof(check_amounts[0]))]);
+            data.balance.push_back(check_balances[rng() % 2]);
+            data.winrate.push_back(0.55 + (rng() % 100) * 0.002);
+            data.attenuator.push_back(0.4);
+        }
+        return data;
+    }
+
+    /** \brief Параметры и результаты измерений
+     */
+    class Bench {
+    public:
+        std::string filter;
+        double min_time_ms = 100;
+        std::vector<BenchResult> results;
+
+        volatile double sink = 0;
+
+        /** \brief Измерить время вызовов
+         *
+         * Проход по всем сделкам повторяется, пока не истечет минимальное время,
+         * в результат попадает лучший проход.
+         * \param name Имя теста
+         * \param size Количество вызовов за проход
+         * \param pass Функция прохода, возвращает контрольную сумму
+         */
+        template<class F>
+        void run(const std::string &name, const size_t size, F &&pass) {
+            if(!filter.empty() && name.find(filter) == std::string::npos) return;
+            typedef std::chrono::steady_clock clock;
+            double best_ns = 0;
+            double total_ms = 0;
+            uint32_t passes = 0;
+            while(passes < 3 || total_ms < min_time_ms) {
+                const clock::time_point start = clock::now();
+                sink = sink + pass();
+                const double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+                if(passes == 0 || ns < best_ns) best_ns = ns;
+                total_ms += ns / 1e6;
+                ++passes;
+            }
+            BenchResult result;
+            result.name = name;
+            result.ns_per_op = best_ns / (double)size;
+            results.push_back(result);
+            std::printf("%-52s %10.2f ns/op %14.0f calls/s\n",
+                name.c_str(), result.ns_per_op, 1e9 / result.ns_per_op);
+        }
+    };
+
+    template<class TRAITS>
+    void bench_model(Bench &bench, const size_t size) {
+        typedef typename TRAITS::Model Model;
+        typedef typename TRAITS::Reference Reference;
+        typedef payout_model::PayoutModel<typename TRAITS::Policy, Model::CURRENCY_USD> PolicyModel;
+        const Model model(Model::CURRENCY_USD);
+        Reference reference(Model::CURRENCY_USD);
+        const std::string prefix = std::string(TRAITS::NAME) + ".";
+
+        for(int d = STREAM; d <= SESSION; ++d) {
+            const BenchData data = make_bench_data<TRAITS>((TimestampDistribution)d, size);
+            const std::string suffix = std::string(".") + distribution_names[d];
+            const size_t n = data.size();
+            std::vector<double> out_payout(n), out_amount(n);
+            std::vector<int> out_err(n);
+
+            bench.run(prefix + "get_payout.index" + suffix, n, [&]() {
+                double sum = 0;
+                for(size_t i = 0; i < n; ++i) {
+                    double payout = 0;
+                    sum += model.get_payout(payout, data.timestamp[i], data.duration[i], data.index[i], data.amount[i]) + payout;
+                }
+                return sum;
+            });
+            bench.run(prefix + "get_payout.cursor" + suffix, n, [&]() {
+                double sum = 0;
+                payout_model::CalendarCursor cursor(data.timestamp[0]);
+                for(size_t i = 0; i < n; ++i) {
+                    double payout = 0;
+                    cursor.update(data.timestamp[i]);
+                    sum += model.get_payout(payout, cursor, data.duration[i], data.index[i], data.amount[i]) + payout;
+                }
+                return sum;
+            });
+            bench.run(prefix + "get_payout.name" + suffix, n, [&]() {
+                double sum = 0;
+                for(size_t i = 0; i < n; ++i) {
+                    double payout = 0;
+                    sum += model.get_payout(payout, data.name[i], data.timestamp[i], data.duration[i], data.amount[i]) + payout;
+                }
+                return sum;
+            });
+            bench.run(prefix + "get_payout.policy" + suffix, n, [&]() {
+                double sum = 0;
+                for(size_t i = 0; i < n; ++i) {
+                    double payout = 0;
+                    sum += PolicyModel::get_payout(payout, data.timestamp[i], data.duration[i], data.index[i], data.amount[i]) + payout;
+                }
+                return sum;
+            });
+            bench.run(prefix + "get_payout.batch" + suffix, n, [&]() {
+                model.get_payout(out_payout.data(), out_err.data(), data.timestamp.data(),
+                    data.duration.data(), data.index.data(), data.amount.data(), n);
+                return out_payout[n / 2] + out_err[n - 1];
+            });
+            bench.run(prefix + "get_payout.reference" + suffix, n, [&]() {
+                double sum = 0;
+                for(size_t i = 0; i < n; ++i) {
+                    double payout = 0;
+                    sum += reference.get_payout(payout, data.timestamp[i], data.duration[i], data.index[i], data.amount[i]) + payout;
+                }
+                return sum;
+            });
+            bench.run(prefix + "get_amount.index" + suffix, n, [&]() {
+                double sum = 0;
+                for(size_t i = 0; i < n; ++i) {
+                    double amount = 0, payout = 0;
+                    sum += model.get_amount(amount, payout, data.timestamp[i], data.duration[i], data.index[i],
+                        data.balance[i], data.winrate[i], data.attenuator[i]) + amount;
+                }
+                return sum;
+            });
+            bench.run(prefix + "get_amount.policy" + suffix, n, [&]() {
+                double sum = 0;
+                for(size_t i = 0; i < n; ++i) {
+                    double amount = 0, payout = 0;
+                    sum += PolicyModel::get_amount(amount, payout, data.timestamp[i], data.duration[i], data.index[i],
+                        data.balance[i], data.winrate[i], data.attenuator[i]) + amount;
+                }
+                return sum;
+            });
+            bench.run(prefix + "get_amount.batch" + suffix, n, [&]() {
+                model.get_amount(out_amount.data(), out_payout.data(), out_err.data(),
+                    data.timestamp.data(), data.duration.data(), data.index.data(),
+                    data.balance.data(), data.winrate.data(), data.attenuator.data(), nullptr, nullptr, n);
+                return out_amount[n / 2] + out_err[n - 1];
+            });
+            bench.run(prefix + "get_amount.reference" + suffix, n, [&]() {
+                double sum = 0;
+                for(size_t i = 0; i < n; ++i) {
+                    double amount = 0, payout = 0;
+                    sum += reference.get_amount(amount, payout, data.name[i], data.timestamp[i], data.duration[i],
+                        data.balance[i], data.winrate[i], data.attenuator[i]) + amount;
+                }
+                return sum;
+            });
+            bench.run(prefix + "check_timestamp" + suffix, n, [&]() {
+                double sum = 0;
+                for(size_t i = 0; i < n; ++i) {
+                    sum += Model::check_timestamp(data.timestamp[i]);
+                }
+                return sum;
+            });
+            bench.run(prefix + "check_timestamp.cursor" + suffix, n, [&]() {
+                double sum = 0;
+                payout_model::CalendarCursor cursor(data.timestamp[0]);
+                for(size_t i = 0; i < n; ++i) {
+                    cursor.update(data.timestamp[i]);
+                    sum += Model::check_timestamp(cursor);
+                }
+                return sum;
+            });
+        }
+
+        const BenchData data = make_bench_data<TRAITS>(RANDOM, size);
+        bench.run(prefix + "check_currecy_pair_name", data.size(), [&]() {
+            double sum = 0;
+            for(size_t i = 0; i < data.size(); ++i) {
+                sum += Model::check_currecy_pair_name(data.name[i]);
+            }
+            return sum;
+        });
+        bench.run(prefix + "check_currecy_pair_name.reference", data.size(), [&]() {
+            double sum = 0;
+            for(size_t i = 0; i < data.size(); ++i) {
+                sum += Reference::check_currecy_pair_name(data.name[i]);
+            }
+            return sum;
+        });
+    }
+
+    void bench_intrade_bar_table(Bench &bench, const size_t size) {
+        const payout_model::IntradeBarPayoutTable table(payout_model::IntradeBar::CURRENCY_USD);
+        for(int d = STREAM; d <= SESSION; ++d) {
+            const BenchData data = make_bench_data<IntradeBarTraits>((TimestampDistribution)d, size);
+            bench.run(std::string("intrade_bar.get_payout.table.") + distribution_names[d], data.size(), [&]() {
+                double sum = 0;
+                for(size_t i = 0; i < data.size(); ++i) {
+                    double payout = 0;
+                    sum += table.get_payout(payout, data.timestamp[i], data.duration[i], data.index[i], data.amount[i]) + payout;
+                }
+                return sum;
+            });
+        }
+    }
+
+    template<class TRAITS, class SURFACE>
+    void bench_surface(Bench &bench, const payout_model::PayoutSurfaceFile &file, const size_t size) {
+        const SURFACE surface(file, TRAITS::Model::CURRENCY_USD);
+        for(int d = STREAM; d <= SESSION; ++d) {
+            const BenchData data = make_bench_data<TRAITS>((TimestampDistribution)d, size);
+            bench.run(std::string(TRAITS::NAME) + ".get_payout.surface." + distribution_names[d], data.size(), [&]() {
+                double sum = 0;
+                for(size_t i = 0; i < data.size(); ++i) {
+                    double payout = 0;
+                    sum += surface.get_payout(payout, data.timestamp[i], data.duration[i], data.index[i], data.amount[i]) + payout;
+                }
+                return sum;
+            });
+        }
+    }
+
+    /// Распределение ставок для 64 одновременных сигналов
+    template<class TRAITS>
+    void bench_portfolio(Bench &bench) {
+        typedef typename TRAITS::Model Model;
+        const Model model(Model::CURRENCY_USD);
+        payout_model::PortfolioKellyAllocator allocator;
+        const size_t n = 64;
+        /* вторник 3 марта 2020 года, 10:00 UTC */
+        std::vector<xtime::timestamp_t> timestamp(n, 1583229600);
+        std::vector<uint32_t> duration(n), index(n);
+        std::vector<double> winrate(n), amount(n), payout(n);
+        std::vector<int> err(n);
+        for(size_t i = 0; i < n; ++i) {
+            index[i] = (uint32_t)(i % TRAITS::PAIRS);
+            duration[i] = TRAITS::get_bench_durations()[i % TRAITS::get_bench_durations().size()];
+            winrate[i] = 0.56 + 0.01 * (i % 15);
+        }
+        bench.run(std::string(TRAITS::NAME) + ".portfolio.allocate64", 1, [&]() {
+            allocator.allocate(model, amount.data(), payout.data(), err.data(), timestamp.data(),
+                duration.data(), index.data(), winrate.data(), n, 1000.0, 0.4);
+            return amount[0] + amount[n - 1];
+        });
+    }
+
+    /// Бэктест потока сигналов с реинвестированием
+    template<class TRAITS>
+    void bench_backtest(Bench &bench, const size_t size) {
+        typedef typename TRAITS::Model Model;
+        const Model model(Model::CURRENCY_USD);
+        const std::vector<payout_model::BacktestSignal> signals =
+            make_backtest_signals<TRAITS>(xtime::get_timestamp(2, 1, 2019), 37, size);
+        payout_model::PayoutBacktest backtest(1000.0, 0.4);
+        bench.run(std::string(TRAITS::NAME) + ".backtest.stream", signals.size(), [&]() {
+            backtest.reset(1000.0, 0.4);
+            backtest.run(model, signals.data(), signals.size());
+            backtest.finish();
+            return backtest.get_balance();
+        });
+    }
+
+    /// Моделирование Монте-Карло: время одной сделки пути в одном потоке и во всех потоках
+    template<class TRAITS>
+    void bench_monte_carlo(Bench &bench) {
+        typedef typename TRAITS::Model Model;
+        const Model model(Model::CURRENCY_USD);
+        const std::vector<payout_model::MonteCarloTrade> trades = make_monte_carlo_trades<TRAITS>(4096);
+        payout_model::MonteCarloSimulator simulator;
+        payout_model::MonteCarloResult result;
+        payout_model::MonteCarloConfig config;
+        config.paths = 2048;
+        config.trades = 250;
+        config.ruin_balance = 500.0;
+        for(const uint32_t threads : {1U, 0U}) {
+            config.threads = threads;
+            bench.run(std::string(TRAITS::NAME) + ".monte_carlo." + (threads ? "thread" : "threads"), config.paths * config.trades, [&]() {
+                simulator.simulate(model, trades.data(), trades.size(), config, result);
+                return result.ruin_probability;
+            });
+        }
+    }
+
+    /// Расчет файла сигналов: отображение файла, расчет частей потоками и запись файла результатов
+    template<class TRAITS>
+    void bench_signal_file(Bench &bench, const size_t size) {
+        typedef typename TRAITS::Model Model;
+        const Model model(Model::CURRENCY_USD);
+        const BenchData data = make_bench_data<TRAITS>(STREAM, size);
+        const size_t n = data.size();
+        std::vector<payout_model::PayoutSignal> signals(n);
+        for(size_t i = 0; i < n; ++i) {
+            signals[i] = payout_model::PayoutSignal{data.timestamp[i], data.duration[i], data.index[i],
+                data.amount[i], data.balance[i], data.winrate[i], data.attenuator[i], 1.0, 1.0};
+        }
+        const char *signal_file_name = "payout-signals-bench.bin";
+        const char *result_file_name = "payout-results-bench.bin";
+        if(payout_model::save_payout_signals(signal_file_name, signals.data(), n) != payout_model::ErrorType::OK) return;
+        const char *mode_names[] = {"payout", "amount"};
+        for(int mode = payout_model::SIGNAL_PAYOUT; mode <= payout_model::SIGNAL_AMOUNT; ++mode) {
+            payout_model::PayoutSignalConfig config;
+            config.mode = mode;
+            bench.run(std::string(TRAITS::NAME) + ".signal_file." + mode_names[mode], n, [&]() {
+                uint64_t records = 0;
+                payout_model::evaluate_payout_signals(model, signal_file_name, result_file_name, config, &records);
+                return (double)records;
+            });
+        }
+        std::remove(result_file_name);
+        std::remove(signal_file_name);
+    }
+
+    /// Отрезки постоянной выплаты за год и перебор get_payout по минутам
+    template<class TRAITS>
+    void bench_payout_segments(Bench &bench) {
+        typedef typename TRAITS::Model Model;
+        Model model(Model::CURRENCY_USD);
+        model.set_calendar(&Model::get_default_calendar());
+        const uint32_t duration = 180;
+        const double amount = check_amounts[1];
+        const xtime::timestamp_t t0 = xtime::get_timestamp(1, 1, 2020);
+        const xtime::timestamp_t t1 = xtime::get_timestamp(1, 1, 2021);
+        const size_t n = (size_t)((t1 - t0) / xtime::SECONDS_IN_MINUTE);
+        bench.run(std::string(TRAITS::NAME) + ".segments.iterator", n, [&]() {
+            payout_model::PayoutSegmentIterator<Model> iterator(model, t0, t1, duration, 0, amount);
+            payout_model::PayoutSegment segment;
+            double sum = 0;
+            while(iterator.next(segment)) sum += segment.payout * (double)(segment.end - segment.start);
+            return sum;
+        });
+        bench.run(std::string(TRAITS::NAME) + ".segments.reference", n, [&]() {
+            double sum = 0;
+            for(xtime::timestamp_t t = t0; t < t1; t += xtime::SECONDS_IN_MINUTE) {
+                double payout = 0;
+                model.get_payout(payout, t, duration, 0, amount);
+                sum += payout * xtime::SECONDS_IN_MINUTE;
+            }
+            return sum;
+        });
+    }
+
+    /// Количество торговых минут валютной пары за год: маски минут недели и перебор get_payout
+    template<class TRAITS>
+    void bench_tradability(Bench &bench) {
+        typedef typename TRAITS::Model Model;
+        Model model(Model::CURRENCY_USD);
+        model.set_calendar(&Model::get_default_calendar());
+        const payout_model::PayoutTradability tradability = model.make_tradability();
+        const uint32_t duration = tradability.get_durations().front();
+        const xtime::timestamp_t t0 = xtime::get_timestamp(1, 1, 2020);
+        const xtime::timestamp_t t1 = xtime::get_timestamp(1, 1, 2021);
+        const size_t n = (size_t)((t1 - t0) / xtime::SECONDS_IN_MINUTE);
+        bench.run(std::string(TRAITS::NAME) + ".tradability.count", n, [&]() {
+            return (double)tradability.count(0, 0, t0, t1);
+        });
+        bench.run(std::string(TRAITS::NAME) + ".tradability.reference", n, [&]() {
+            const double amount = model.get_min_amount();
+            uint64_t sum = 0;
+            for(xtime::timestamp_t t = t0; t < t1; t += xtime::SECONDS_IN_MINUTE) {
+                double payout = 0;
+                if(model.get_payout(payout, t, duration, 0, amount) == payout_model::ErrorType::OK && payout > 0) ++sum;
+            }
+            return (double)sum;
+        });
+    }
+
+#   if defined(PAYOUT_MODEL_BENCHMARK_C_API)
+    /// Пакетные вызовы через интерфейс C (для сравнения с get_amount.batch модели)
+    template<class TRAITS>
+    void bench_c_api(Bench &bench, const int32_t broker, const size_t size) {
+        const BenchData data = make_bench_data<TRAITS>(STREAM, size);
+        const size_t n = data.size();
+        std::vector<double> out_payout(n), out_amount(n);
+        std::vector<int32_t> out_err(n);
+        payout_model_c *model = payout_model_c_create(broker, PAYOUT_MODEL_C_CURRENCY_USD);
+        bench.run(std::string("c_api.") + TRAITS::NAME + ".get_payout.batch", n, [&]() {
+            payout_model_c_get_payout(model, out_payout.data(), out_err.data(), data.timestamp.data(),
+                data.duration.data(), data.index.data(), data.amount.data(), n);
+            return out_payout[n / 2] + out_err[n - 1];
+        });
+        bench.run(std::string("c_api.") + TRAITS::NAME + ".get_amount.batch", n, [&]() {
+            payout_model_c_get_amount(model, out_amount.data(), out_payout.data(), out_err.data(),
+                data.timestamp.data(), data.duration.data(), data.index.data(),
+                data.balance.data(), data.winrate.data(), data.attenuator.data(), nullptr, nullptr, n);
+            return out_amount[n / 2] + out_err[n - 1];
+        });
+        payout_model_c_destroy(model);
+    }
+#   endif
+
+    void bench_router(Bench &bench, const size_t size) {
+        const payout_model::BrokerRouter router(
+            payout_model::IntradeBar::make_snapshot(payout_model::IntradeBar::CURRENCY_USD),
+            payout_model::Grandcapital::make_snapshot(payout_model::Grandcapital::CURRENCY_USD));
+        for(int d = STREAM; d <= SESSION; ++d) {
+            const BenchData data = make_bench_data<IntradeBarTraits>((TimestampDistribution)d, size);
+            const size_t n = data.size();
+            std::vector<uint32_t> symbol(n);
+            for(size_t i = 0; i < n; ++i) {
+                symbol[i] = payout_model::BrokerRouter::find_symbol(data.name[i]);
+            }
+            std::vector<int> broker(n);
+            std::vector<double> amount(n), payout(n);
+            bench.run(std::string("router.route.") + distribution_names[d], n, [&]() {
+                router.route(broker.data(), amount.data(), payout.data(), nullptr, data.timestamp.data(),
+                    data.duration.data(), symbol.data(), data.winrate.data(), data.attenuator.data(),
+                    data.balance.data(), data.balance.data(), n);
+                return amount[n / 2] + broker[n - 1];
+            });
+        }
+    }
+
+    /** \brief Загрузить базовые результаты
+     * \param file_name Имя файла
+     * \param baseline Пары имя теста - время вызова в наносекундах
+     * \return Вернет true в случае успеха
+     */
+    bool load_baseline(const std::string &file_name, std::map<std::string, double> &baseline) {
+        std::ifstream file(file_name);
+        if(!file) return false;
+        std::string name;
+        double ns_per_op = 0;
+        while(file >> name >> ns_per_op) {
+            baseline[name] = ns_per_op;
+        }
+        return true;
+    }
+
+    bool save_baseline(const std::string &file_name, const std::vector<BenchResult> &results) {
+        std::ofstream file(file_name);
+        if(!file) return false;
+        for(const BenchResult &result : results) {
+            file << result.name << " " << result.ns_per_op << "\n";
+        }
+        return static_cast<bool>(file);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    bool is_check = true;
+    bool is_bench = true;
+    std::string baseline_file;
+    std::string save_file;
+    double threshold = 10.0;
+    size_t size = 1 << 16;
+    /* файл поверхности выплат создается в рабочем каталоге */
+    const char *surface_file_name = "payout-surface-check.bin";
+    Bench bench;
+
+    for(int i = 1; i < argc; ++i) {
+        const std::string arg(argv[i]);
+        const bool has_value = i + 1 < argc;
+        if(arg == "--check-only") is_bench = false;
+        else if(arg == "--bench-only") is_check = false;
+        else if(arg == "--filter" && has_value) bench.filter = argv[++i];
+        else if(arg == "--min-time-ms" && has_value) bench.min_time_ms = std::atof(argv[++i]);
+        else if(arg == "--size" && has_value) size = std::max(1, std::atoi(argv[++i]));
+        else if(arg == "--baseline" && has_value) baseline_file = argv[++i];
+        else if(arg == "--save-baseline" && has_value) save_file = argv[++i];
+        else if(arg == "--threshold" && has_value) threshold = std::atof(argv[++i]);
+        else {
+            std::printf("unknown argument: %s\n", arg.c_str());
+            return 3;
+        }
+    }
+
+    if(is_check) {
+        CheckReport report;
+        const uint32_t currencies[] = {payout_model::IntradeBar::CURRENCY_RUB, payout_model::IntradeBar::CURRENCY_USD};
+        for(const uint32_t currency : currencies) {
+            check_model<IntradeBarTraits>(currency, report);
+            check_intrade_bar_table(currency, report);
+            check_model<GrandcapitalTraits>(currency, report);
+            check_best_duration<IntradeBarTraits>(currency, report);
+            check_best_duration<GrandcapitalTraits>(currency, report);
+            check_portfolio<IntradeBarTraits>(currency, report);
+            check_portfolio<GrandcapitalTraits>(currency, report);
+            check_backtest<IntradeBarTraits>(currency, report);
+            check_backtest<GrandcapitalTraits>(currency, report);
+            check_monte_carlo<IntradeBarTraits>(currency, report);
+            check_monte_carlo<GrandcapitalTraits>(currency, report);
+            check_trading_calendar<IntradeBarTraits>(currency, report);
+            check_trading_calendar<GrandcapitalTraits>(currency, report);
+            check_trading_session<IntradeBarTraits>(currency, report);
+            check_trading_session<GrandcapitalTraits>(currency, report);
+            check_tradability<IntradeBarTraits>(currency, report);
+            check_tradability<GrandcapitalTraits>(currency, report);
+            check_trade_window<IntradeBarTraits>(currency, report);
+            check_trade_window<GrandcapitalTraits>(currency, report);
+            check_signal_file<IntradeBarTraits>(currency, report);
+            check_signal_file<GrandcapitalTraits>(currency, report);
+        }
+        payout_model::PayoutSurfaceFile surface_file;
+        if(payout_model::save_payout_surface(surface_file_name) != payout_model::ErrorType::OK ||
+            surface_file.open(surface_file_name) != payout_model::ErrorType::OK) {
+            std::printf("failed to create payout surface file: %s\n", surface_file_name);
+            return 3;
+        }
+        for(const uint32_t currency : currencies) {
+            check_surface<IntradeBarTraits, payout_model::IntradeBarSurface>(surface_file, currency, report);
+            check_surface<GrandcapitalTraits, payout_model::GrandcapitalSurface>(surface_file, currency, report);
+        }
+        check_router(payout_model::IntradeBar::CURRENCY_RUB, report);
+        check_router(payout_model::IntradeBar::CURRENCY_USD, report);
+        check_policy_model<IntradeBarTraits, payout_model::IntradeBar::CURRENCY_RUB>(report);
+        check_policy_model<IntradeBarTraits, payout_model::IntradeBar::CURRENCY_USD>(report);
+        check_policy_model<GrandcapitalTraits, payout_model::Grandcapital::CURRENCY_RUB>(report);
+        check_policy_model<GrandcapitalTraits, payout_model::Grandcapital::CURRENCY_USD>(report);
+        check_payout_segments<IntradeBarTraits, payout_model::IntradeBar::CURRENCY_RUB>(report);
+        check_payout_segments<IntradeBarTraits, payout_model::IntradeBar::CURRENCY_USD>(report);
+        check_payout_segments<GrandcapitalTraits, payout_model::Grandcapital::CURRENCY_RUB>(report);
+        check_payout_segments<GrandcapitalTraits, payout_model::Grandcapital::CURRENCY_USD>(report);
+        check_stats<IntradeBarTraits>(report);
+        check_stats<GrandcapitalTraits>(report);
+        check_amount_trace(report);
+        check_payout_rules(report);
+        check_rules_timeline(report);
+#       if defined(PAYOUT_MODEL_BENCHMARK_C_API)
+        for(const uint32_t currency : currencies) {
+            check_c_api<IntradeBarTraits>(PAYOUT_MODEL_C_INTRADE_BAR, currency, report);
+            check_c_api<GrandcapitalTraits>(PAYOUT_MODEL_C_GRANDCAPITAL, currency, report);
+        }
+#       endif
+        std::printf("reference check: %llu cases, %llu mismatches\n",
+            (unsigned long long)report.cases, (unsigned long long)report.errors);
+        if(report.errors) return 1;
+    }
+
+    if(!is_bench) return 0;
+
+    bench_model<IntradeBarTraits>(bench, size);
+    bench_intrade_bar_table(bench, size);
+    bench_model<GrandcapitalTraits>(bench, size);
+    bench_router(bench, size);
+#   if defined(PAYOUT_MODEL_BENCHMARK_C_API)
+    bench_c_api<IntradeBarTraits>(bench, PAYOUT_MODEL_C_INTRADE_BAR, size);
+    bench_c_api<GrandcapitalTraits>(bench, PAYOUT_MODEL_C_GRANDCAPITAL, size);
+#   endif
+    bench_portfolio<IntradeBarTraits>(bench);
+    bench_portfolio<GrandcapitalTraits>(bench);
+    bench_backtest<IntradeBarTraits>(bench, size);
+    bench_backtest<GrandcapitalTraits>(bench, size);
+    bench_monte_carlo<IntradeBarTraits>(bench);
+    bench_monte_carlo<GrandcapitalTraits>(bench);
+    bench_signal_file<IntradeBarTraits>(bench, size);
+    bench_signal_file<GrandcapitalTraits>(bench, size);
+    bench_tradability<IntradeBarTraits>(bench);
+    bench_tradability<GrandcapitalTraits>(bench);
+    bench_payout_segments<IntradeBarTraits>(bench);
+    bench_payout_segments<GrandcapitalTraits>(bench);
+    {
+        payout_model::PayoutSurfaceFile surface_file;
+        if(payout_model::save_payout_surface(surface_file_name) != payout_model::ErrorType::OK ||
+            surface_file.open(surface_file_name) != payout_model::ErrorType::OK) {
+            std::printf("failed to create payout surface file: %s\n", surface_file_name);
+            return 3;
+        }
+        bench_surface<IntradeBarTraits, payout_model::IntradeBarSurface>(bench, surface_file, size);
+        bench_surface<GrandcapitalTraits, payout_model::GrandcapitalSurface>(bench, surface_file, size);
+    }
+
+    if(!save_file.empty() && !save_baseline(save_file, bench.results)) {
+        std::printf("failed to save baseline: %s\n", save_file.c_str());
+        return 3;
+    }
+
+    if(baseline_file.empty()) return 0;
+    std::map<std::string, double> baseline;
+    if(!load_baseline(baseline_file, baseline)) {
+        std::printf("failed to load baseline: %s\n", baseline_file.c_str());
+        return 3;
+    }
+    uint32_t regressions = 0;
+    for(const BenchResult &result : bench.results) {
+        auto it = baseline.find(result.name);
+        if(it == baseline.end() || it->second <= 0) continue;
+        const double change = (result.ns_per_op / it->second - 1.0) * 100.0;
+        if(change > threshold) {
+            std::printf("regression %s: %.2f ns/op, baseline %.2f ns/op (%+.1f%%)\n",
+                result.name.c_str(), result.ns_per_op, it->second, change);
+            ++regressions;
+        }
+    }
+    std::printf("perf gate: %u regressions beyond %.1f%%\n", regressions, threshold);
+    return regressions ? 2 : 0;
+}
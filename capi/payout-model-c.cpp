@@ -0,0 +1,202 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* Библиотека с интерфейсом C для пакетного расчета выплат и ставок
+ *
+ * Функции передают массивы вызывающей стороны пакетным методам моделей без копирования.
+ * Исключения C++ не выходят за границу интерфейса: функции, которые могут их получить
+ * (например, при выделении памяти счетчиками PAYOUT_MODEL_STATS), возвращают PAYOUT_MODEL_C_INTERNAL_ERROR.
+ */
+#include "payout-model-c.h"
+#include "intrade-bar-payout-model.hpp"
+#include "grandcapital-payout-model.hpp"
+#include "payout-model-rules.hpp"
+#include <memory>
+
+/* массивы состояний передаются в пакетные методы без преобразования */
+static_assert(sizeof(int) == sizeof(int32_t), "int must be 32-bit");
+static_assert(sizeof(xtime::timestamp_t) == sizeof(uint64_t), "timestamp_t must be 64-bit");
+
+/// Константы интерфейса C сравниваются с перечислениями C++ как числа
+static constexpr bool is_same_code(const int c_code, const int code) {
+    return c_code == code;
+}
+
+static_assert(is_same_code(PAYOUT_MODEL_C_CURRENCY_RUB, payout_model::IntradeBar::CURRENCY_RUB) &&
+    is_same_code(PAYOUT_MODEL_C_CURRENCY_USD, payout_model::IntradeBar::CURRENCY_USD) &&
+    is_same_code(PAYOUT_MODEL_C_CURRENCY_RUB, payout_model::Grandcapital::CURRENCY_RUB) &&
+    is_same_code(PAYOUT_MODEL_C_CURRENCY_USD, payout_model::Grandcapital::CURRENCY_USD), "account currency mismatch");
+static_assert(is_same_code(PAYOUT_MODEL_C_DAY_OFF, payout_model::IntradeBar::DAY_OFF) &&
+    is_same_code(PAYOUT_MODEL_C_NIGHT_HOURS, payout_model::IntradeBar::NIGHT_HOURS) &&
+    is_same_code(PAYOUT_MODEL_C_BEGIN_EVENING_HOUR, payout_model::IntradeBar::BEGIN_EVENING_HOUR) &&
+    is_same_code(PAYOUT_MODEL_C_TOO_LITTLE_TIME, payout_model::IntradeBar::TOO_LITTLE_TIME) &&
+    is_same_code(PAYOUT_MODEL_C_TOO_MUCH_TIME, payout_model::IntradeBar::TOO_MUCH_TIME) &&
+    is_same_code(PAYOUT_MODEL_C_CURRENCY_PAIR_IS_MISSING, payout_model::IntradeBar::CURRENCY_PAIR_IS_MISSING) &&
+    is_same_code(PAYOUT_MODEL_C_TOO_LITTLE_MONEY, payout_model::IntradeBar::TOO_LITTLE_MONEY) &&
+    is_same_code(PAYOUT_MODEL_C_FXCM_MON, payout_model::IntradeBar::FXCM_MON) &&
+    is_same_code(PAYOUT_MODEL_C_EXPIRATION_ERROR, payout_model::IntradeBar::EXPIRATION_ERROR) &&
+    is_same_code(PAYOUT_MODEL_C_TOO_LITTLE_WINRATE, payout_model::IntradeBar::TOO_LITTLE_WINRATE) &&
+    is_same_code(PAYOUT_MODEL_C_EXIT_OVER_END_DAY, payout_model::IntradeBar::EXIT_OVER_END_DAY), "payout state mismatch");
+static_assert(is_same_code(PAYOUT_MODEL_C_RULES_FILE_NOT_OPEN, PAYOUT_MODEL_C_RULES_ERROR_BASE + payout_model::RulesErrorType::RULES_FILE_NOT_OPEN) &&
+    is_same_code(PAYOUT_MODEL_C_RULES_SYNTAX_ERROR, PAYOUT_MODEL_C_RULES_ERROR_BASE + payout_model::RulesErrorType::RULES_SYNTAX_ERROR) &&
+    is_same_code(PAYOUT_MODEL_C_RULES_UNKNOWN_KEY, PAYOUT_MODEL_C_RULES_ERROR_BASE + payout_model::RulesErrorType::RULES_UNKNOWN_KEY) &&
+    is_same_code(PAYOUT_MODEL_C_RULES_INVALID_VALUE, PAYOUT_MODEL_C_RULES_ERROR_BASE + payout_model::RulesErrorType::RULES_INVALID_VALUE), "rules error mismatch");
+/* ошибки правил не пересекаются с состояниями выплат и ошибками аргументов */
+static_assert(PAYOUT_MODEL_C_RULES_FILE_NOT_OPEN < PAYOUT_MODEL_C_INTERNAL_ERROR &&
+    PAYOUT_MODEL_C_INTERNAL_ERROR < PAYOUT_MODEL_C_EXIT_OVER_END_DAY, "error code ranges overlap");
+
+/// Модель брокера с правилами, которыми она владеет
+struct payout_model_c {
+    int32_t broker;
+    std::shared_ptr<const payout_model::PayoutRules> rules;
+    payout_model::IntradeBar intrade_bar;
+    payout_model::Grandcapital grandcapital;
+
+    payout_model_c(const int32_t user_broker, const uint32_t currency) :
+        broker(user_broker), intrade_bar(currency), grandcapital(currency) {}
+};
+
+uint32_t payout_model_c_get_api_version(void) {
+    return PAYOUT_MODEL_C_API_VERSION;
+}
+
+payout_model_c *payout_model_c_create(int32_t broker, int32_t currency) {
+    if(broker != PAYOUT_MODEL_C_INTRADE_BAR && broker != PAYOUT_MODEL_C_GRANDCAPITAL) return nullptr;
+    if(currency != PAYOUT_MODEL_C_CURRENCY_RUB && currency != PAYOUT_MODEL_C_CURRENCY_USD) return nullptr;
+    try {
+        return new payout_model_c(broker, (uint32_t)currency);
+    } catch(...) {
+        return nullptr;
+    }
+}
+
+void payout_model_c_destroy(payout_model_c *model) {
+    delete model;
+}
+
+int32_t payout_model_c_load_rules(payout_model_c *model, const char *file_name, uint32_t *error_line) {
+    uint32_t line = 0;
+    if(error_line) *error_line = 0;
+    if(!model || !file_name) return PAYOUT_MODEL_C_INVALID_ARGUMENT;
+    try {
+        std::shared_ptr<payout_model::PayoutRules> rules = std::make_shared<payout_model::PayoutRules>();
+        const int err = payout_model::load_payout_rules(file_name, *rules, line);
+        if(error_line) *error_line = line;
+        if(err != payout_model::ErrorType::OK) return PAYOUT_MODEL_C_RULES_ERROR_BASE + err;
+        model->intrade_bar.set_rules(rules->intrade_bar);
+        model->grandcapital.set_rules(rules->grandcapital);
+        model->rules = std::move(rules);
+    } catch(...) {
+        return PAYOUT_MODEL_C_INTERNAL_ERROR;
+    }
+    return PAYOUT_MODEL_C_OK;
+}
+
+uint32_t payout_model_c_get_pairs(int32_t broker) {
+    if(broker == PAYOUT_MODEL_C_INTRADE_BAR) return payout_model::INTRADE_BAR_CURRENCY_PAIRS;
+    if(broker == PAYOUT_MODEL_C_GRANDCAPITAL) return payout_model::GRANDCAPITAL_CURRENCY_PAIRS;
+    return 0;
+}
+
+int32_t payout_model_c_get_pair_index(int32_t broker, const char *name) {
+    if(!name) return -1;
+    uint32_t index = 0;
+    if(broker == PAYOUT_MODEL_C_INTRADE_BAR) {
+        index = payout_model::intrade_bar_currency_pairs_hash.find(name);
+    } else
+    if(broker == PAYOUT_MODEL_C_GRANDCAPITAL) {
+        index = payout_model::grandcapital_currency_pairs_hash.find(name, true);
+    } else return -1;
+    return index < payout_model_c_get_pairs(broker) ? (int32_t)index : -1;
+}
+
+const char *payout_model_c_get_pair_name(int32_t broker, uint32_t index) {
+    /* имена в таблицах - строковые литералы, поэтому заканчиваются нулем */
+    if(broker == PAYOUT_MODEL_C_INTRADE_BAR && index < payout_model::INTRADE_BAR_CURRENCY_PAIRS)
+        return payout_model::intrade_bar_currency_pairs[index].data();
+    if(broker == PAYOUT_MODEL_C_GRANDCAPITAL && index < payout_model::GRANDCAPITAL_CURRENCY_PAIRS)
+        return payout_model::grandcapital_currency_pairs[index].data();
+    return nullptr;
+}
+
+int32_t payout_model_c_get_payout(
+        const payout_model_c *model,
+        double *payout,
+        int32_t *err,
+        const uint64_t *timestamp,
+        const uint32_t *duration,
+        const uint32_t *currency_pair_index,
+        const double *amount,
+        size_t size) {
+    if(!model) return PAYOUT_MODEL_C_INVALID_ARGUMENT;
+    if(size == 0) return PAYOUT_MODEL_C_OK;
+    if(!payout || !err || !timestamp || !duration || !currency_pair_index || !amount)
+        return PAYOUT_MODEL_C_INVALID_ARGUMENT;
+    int *out_err = reinterpret_cast<int*>(err);
+    const xtime::timestamp_t *in_timestamp = reinterpret_cast<const xtime::timestamp_t*>(timestamp);
+    try {
+        if(model->broker == PAYOUT_MODEL_C_INTRADE_BAR) {
+            model->intrade_bar.get_payout(payout, out_err, in_timestamp, duration, currency_pair_index, amount, size);
+        } else {
+            model->grandcapital.get_payout(payout, out_err, in_timestamp, duration, currency_pair_index, amount, size);
+        }
+    } catch(...) {
+        return PAYOUT_MODEL_C_INTERNAL_ERROR;
+    }
+    return PAYOUT_MODEL_C_OK;
+}
+
+int32_t payout_model_c_get_amount(
+        const payout_model_c *model,
+        double *amount,
+        double *payout,
+        int32_t *err,
+        const uint64_t *timestamp,
+        const uint32_t *duration,
+        const uint32_t *currency_pair_index,
+        const double *balance,
+        const double *winrate,
+        const double *attenuator,
+        const double *payout_limiter,
+        const double *winrate_limiter,
+        size_t size) {
+    if(!model) return PAYOUT_MODEL_C_INVALID_ARGUMENT;
+    if(size == 0) return PAYOUT_MODEL_C_OK;
+    if(!amount || !payout || !err || !timestamp || !duration || !currency_pair_index ||
+        !balance || !winrate || !attenuator) return PAYOUT_MODEL_C_INVALID_ARGUMENT;
+    int *out_err = reinterpret_cast<int*>(err);
+    const xtime::timestamp_t *in_timestamp = reinterpret_cast<const xtime::timestamp_t*>(timestamp);
+    try {
+        if(model->broker == PAYOUT_MODEL_C_INTRADE_BAR) {
+            model->intrade_bar.get_amount(amount, payout, out_err, in_timestamp, duration, currency_pair_index,
+                balance, winrate, attenuator, payout_limiter, winrate_limiter, size);
+        } else {
+            model->grandcapital.get_amount(amount, payout, out_err, in_timestamp, duration, currency_pair_index,
+                balance, winrate, attenuator, payout_limiter, winrate_limiter, size);
+        }
+    } catch(...) {
+        return PAYOUT_MODEL_C_INTERNAL_ERROR;
+    }
+    return PAYOUT_MODEL_C_OK;
+}
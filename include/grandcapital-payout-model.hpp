@@ -25,16 +25,222 @@
 #define GRANDCAPITAL_PAYOUT_MODEL_HPP_INCLUDED
 
 #include "payout-model-common.hpp"
+#include "payout-model-simd.hpp"
+#include "payout-model-calendar-cursor.hpp"
+#include "payout-model-rules.hpp"
+#include "payout-model-trading-calendar.hpp"
+#include "payout-model-stats.hpp"
+#include "payout-model-tradability.hpp"
 #include <vector>
+#include <algorithm>
+#include <memory>
+#include <limits>
 #include "xtime.hpp"
 
 namespace payout_model {
 
+    class GrandcapitalPolicy;
+
     /** \brief Класс модели процентов выплат брокера Intrade.bar
      */
 	class Grandcapital {
     private:
+        friend class GrandcapitalPolicy;
+
         uint32_t currency_name;         ///< Наименование валюты счета. Как правило, USD или RUB
+        const GrandcapitalRules *rules; ///< Правила выплат
+        std::shared_ptr<const GrandcapitalRules> rules_owner; ///< Правила, которыми владеет снимок модели
+        const TradingCalendar *calendar = nullptr;  ///< Календарь торговли для закрытых дней или nullptr
+        std::shared_ptr<const TradingCalendar> calendar_owner; ///< Календарь, которым владеет снимок модели
+        const TradingCalendar *sessions = &get_session_calendar(); ///< Календарь торговых сессий (календарь модели или встроенная сессия)
+        double min_amount;              ///< Минимальная ставка для валюты счета
+
+        /// Вычислить пороги ставок для валюты счета
+        inline void update_amount_limits() {
+            if(currency_name == CURRENCY_USD) {
+                min_amount = rules->min_amount_usd;
+            } else
+            if(currency_name == CURRENCY_RUB) {
+                min_amount = rules->min_amount_rub;
+            } else {
+                /* для других валют ограничения ставки не проверяются */
+                min_amount = -std::numeric_limits<double>::infinity();
+            }
+        }
+
+        /// Вернет true, если задан календарь торговли и день закрыт
+        inline const bool is_closed_day(const xtime::timestamp_t timestamp) const {
+            return calendar && calendar->is_closed_day(timestamp);
+        }
+
+        static const uint32_t MAX_TRADE_WINDOW_DAYS = 366; ///< Наибольшее количество дней поиска торгового окна
+
+        /// Вернет true, если сессии модели совпадают со встроенной сессией (векторные ядра проверяют только ее)
+        inline const bool is_default_session() const {
+            return sessions->is_uniform_session(0, SESSION_END_HOUR * xtime::SECONDS_IN_HOUR);
+        }
+
+        /// Учесть состояние выплаты в счетчиках (только с PAYOUT_MODEL_STATS)
+        inline static const int count_call(const int err, const uint32_t currency_pair_index, const xtime::timestamp_t timestamp) {
+#           if defined(PAYOUT_MODEL_STATS)
+            Stats::add(currency_pair_index, (uint32_t)(timestamp % xtime::SECONDS_IN_DAY / xtime::SECONDS_IN_HOUR), err);
+#           else
+            (void)currency_pair_index;
+            (void)timestamp;
+#           endif
+            return err;
+        }
+
+        inline static const int count_call(const int err, const uint32_t currency_pair_index, const CalendarCursor &cursor) {
+#           if defined(PAYOUT_MODEL_STATS)
+            Stats::add(currency_pair_index, cursor.get_hour_day(), err);
+#           else
+            (void)currency_pair_index;
+            (void)cursor;
+#           endif
+            return err;
+        }
+
+        /* Расчет выплаты и ставки вынесен в статические методы, чтобы их могла
+         * использовать модель с правилами времени компиляции (см. PayoutModel)
+         */
+        template<class CALENDAR>
+        inline static const int calc_payout(
+                double &payout,
+                const GrandcapitalRules *rules,
+                const double min_amount,
+                const TradingCalendar &sessions,
+                const CALENDAR &calendar,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double amount) {
+            payout = 0.0;
+            /* Если продолжительность экспирации меньше 1 минуты (60 секунд) */
+            if(duration < 60) return PayoutCancelType::TOO_LITTLE_TIME;
+            /* Если продолжительность экспирации больше 2880 минут (172800 секунд) */
+            if(duration > 172800) return PayoutCancelType::TOO_MUCH_TIME;
+            if(currency_pair_index >= grandcapital_currency_pairs.size() ||
+                !rules->is_currency_pairs[currency_pair_index])
+                return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
+
+            if(amount < min_amount)
+                return PayoutCancelType::TOO_LITTLE_MONEY;
+
+            const uint32_t weekday = calendar.get_weekday();
+            /* пропускаем выходные дни */
+            if(weekday == xtime::SAT || weekday == xtime::SUN)
+                return ErrorType::OK;
+            if(!sessions.is_session(weekday, calendar.get_second_day())) return PayoutCancelType::NIGHT_HOURS;
+            payout = rules->currency_pairs_payout[currency_pair_index];
+            return ErrorType::OK;
+        };
+
+        template<class CALENDAR>
+        inline static const int calc_amount(
+                double &amount,
+                double &payout,
+                const GrandcapitalRules *rules,
+                const double min_amount,
+                const TradingCalendar &sessions,
+                const CALENDAR &calendar,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter,
+                const double winrate_limiter) {
+            amount = 0;
+            payout = 0;
+            /* Если продолжительность экспирации меньше 1 минуты (60 секунд) */
+            if(duration < 60) return PayoutCancelType::TOO_LITTLE_TIME;
+            /* Если продолжительность экспирации больше 2880 минут (172800 секунд) */
+            if(duration > 172800) return PayoutCancelType::TOO_MUCH_TIME;
+
+            /* проверка символа на выплату */
+            if(currency_pair_index >= grandcapital_currency_pairs.size() ||
+                !rules->is_currency_pairs[currency_pair_index])
+                return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
+
+            const uint32_t weekday = calendar.get_weekday();
+            /* пропускаем выходные дни */
+            if(weekday == xtime::SAT || weekday == xtime::SUN)  return ErrorType::OK;
+            if(!sessions.is_session(weekday, calendar.get_second_day())) return PayoutCancelType::NIGHT_HOURS;
+            payout = rules->currency_pairs_payout[currency_pair_index];
+            if(winrate <= (1.0 / (1.0 + payout))) return PayoutCancelType::TOO_LITTLE_WINRATE;
+            const double calc_payout = std::min(payout_limiter, payout);
+            const double calc_winrate = std::min(winrate_limiter, winrate);
+            if(calc_winrate <= (1.0 / (1.0 + payout))) return PayoutCancelType::TOO_LITTLE_WINRATE;
+            const double rate = (((1.0 + calc_payout) * calc_winrate - 1.0) / calc_payout) * attenuator;
+            amount = balance * rate;
+            if(amount < min_amount) {
+                amount = 0;
+                return PayoutCancelType::TOO_LITTLE_MONEY;
+            }
+            return ErrorType::OK;
+        }
+
+        /* Внутри класса длительности (меньше 1 минуты, от 1 до 2880 минут, больше 2880 минут)
+         * ставка и выплата не зависят от длительности, поэтому calc_amount вызывается
+         * не больше одного раза на класс
+         */
+        template<class CALENDAR>
+        inline static const int calc_best_duration(
+                uint32_t &best_duration,
+                double &best_amount,
+                double &best_payout,
+                const GrandcapitalRules *rules,
+                const double min_amount,
+                const TradingCalendar &sessions,
+                const CALENDAR &calendar,
+                const uint32_t *durations,
+                const size_t durations_size,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter,
+                const double winrate_limiter) {
+            const uint32_t CLASSES = 3;
+            bool is_class[CLASSES] = {};
+            int class_err[CLASSES];
+            double class_amount[CLASSES];
+            double class_payout[CLASSES];
+            double class_growth[CLASSES];
+            double best_growth = 0.0;
+            int first_err = PayoutCancelType::EXPIRATION_ERROR;
+            best_duration = 0;
+            best_amount = 0;
+            best_payout = 0;
+            for(size_t i = 0; i < durations_size; ++i) {
+                const uint32_t duration = durations[i];
+                const uint32_t c = duration < 60 ? 0 : duration <= MAX_DURATION ? 1 : 2;
+                if(!is_class[c]) {
+                    is_class[c] = true;
+                    class_err[c] = calc_amount(class_amount[c], class_payout[c], rules, min_amount,
+                        sessions, calendar, duration, currency_pair_index, balance, winrate, attenuator, payout_limiter, winrate_limiter);
+                    class_growth[c] = class_err[c] == ErrorType::OK && class_amount[c] > 0 ?
+                        get_log_growth(class_amount[c], class_payout[c], balance, winrate) : 0.0;
+                }
+                if(i == 0) first_err = class_err[c];
+                if(class_growth[c] > best_growth) {
+                    best_growth = class_growth[c];
+                    best_duration = duration;
+                    best_amount = class_amount[c];
+                    best_payout = class_payout[c];
+                }
+            }
+            return best_duration != 0 ? ErrorType::OK : first_err;
+        }
+
+        /* Ставка не зависит от длительности от 1 до 2880 минут,
+         * при равном росте выбирается более короткая длительность
+         */
+        inline static const uint32_t *get_best_duration_candidates(size_t &size) {
+            static const uint32_t candidates[] = {60};
+            size = sizeof(candidates) / sizeof(candidates[0]);
+            return candidates;
+        }
 
     public:
 
@@ -52,25 +258,30 @@ namespace payout_model {
             TOO_LITTLE_WINRATE = -10,		///< Слишком низкий винрейт
         };
 
+        /// Счетчики состояний выплат по валютной паре и часу (см. PAYOUT_MODEL_STATS)
+        typedef PayoutStats<Grandcapital, GRANDCAPITAL_CURRENCY_PAIRS> Stats;
+
         /// Список валют счета
         enum AccountCurrencyName {
             CURRENCY_RUB = 0,       ///< Рублевая валюта счета
             CURRENCY_USD = 1,       ///< Долларовый счет
         };
 
+        static const uint32_t SESSION_END_HOUR = 20;    ///< Час окончания торговли (UTC)
+        static const uint32_t MAX_DURATION = 172800;    ///< Максимальная длительность опциона в секундах
+
         /** \brief Проверить имя валютной пары
          * \param currency_pair Имя валютной пары
+         * \param user_rules Правила выплат (по умолчанию встроенные)
          * \return Вернет true, если указанная валютная пара поддерживается брокером
          */
-        inline static const bool check_currecy_pair_name(const std::string &currency_pair) {
-            std::string temp(currency_pair);
-            if(temp.length() > 6) temp = temp.substr(0,6);
-            auto it = grandcapital_currency_pairs_index.find(temp);
-            if(it == grandcapital_currency_pairs_index.end()) {
-                return false;
-            }
-            uint32_t index = it->second;
-            if(is_grandcapital_currency_pairs[index]) return true;
+        inline static const bool check_currecy_pair_name(
+                const std::string_view currency_pair,
+                const GrandcapitalRules &user_rules = GrandcapitalRules::get_default()) {
+            /* суффиксы после 6 символов имени не учитываются */
+            const uint32_t index = grandcapital_currency_pairs_hash.find(currency_pair, true);
+            if(index >= GRANDCAPITAL_CURRENCY_PAIRS) return false;
+            if(user_rules.is_currency_pairs[index]) return true;
             return false;
         }
 
@@ -80,9 +291,7 @@ namespace payout_model {
          * \param minute_day Минута дня
          * \return Вернет PayoutCancelType::OK если торговать можно, иначе код ошибки
          */
-        inline static const int check_minute_day(
-                const uint32_t &minute_day,
-                const bool is_old_version = false) {
+        inline static const int check_minute_day(const uint32_t &minute_day) {
             uint32_t hour = minute_day/xtime::MINUTES_IN_HOUR;
             /* С 22 февраля 2019 торговля доступна с 22:00 до 2:00 по терминальному времени (GMT+2)
              * Это с 20:00 до 0:00 по UTC
@@ -91,30 +300,156 @@ namespace payout_model {
             return ErrorType::OK;
         }
 
+        /** \brief Получить встроенный календарь торговли
+         *
+         * Суббота, воскресенье, 1 января и 25 декабря закрыты, сессия с 0:00 до SESSION_END_HOUR UTC.
+         * \return Календарь торговли
+         */
+        inline static const TradingCalendar &get_default_calendar() {
+            static const TradingCalendar default_calendar(0, SESSION_END_HOUR * xtime::SECONDS_IN_HOUR);
+            return default_calendar;
+        }
+
+        /** \brief Получить календарь встроенной сессии
+         *
+         * Сессия с 0:00 до SESSION_END_HOUR UTC, закрытых дней нет.
+         * Модель без календаря торговли считает выплаты по этому календарю.
+         * \return Календарь торговли
+         */
+        inline static const TradingCalendar &get_session_calendar() {
+            static const TradingCalendar session_calendar = TradingCalendar::make_session_calendar(
+                0, SESSION_END_HOUR * xtime::SECONDS_IN_HOUR);
+            return session_calendar;
+        }
+
         /** \brief Проверить метку времени
          * Данный метод проверяет, разрешает ли брокер торговлю в данное время
          * \param timestamp Метка времени
+         * \param user_calendar Календарь торговли (по умолчанию встроенный)
          * \return Вернет PayoutCancelType::OK если торговать можно, иначе код ошибки
          */
-        inline static const int check_timestamp(const xtime::timestamp_t &timestamp) {
-            xtime::DateTime iDateTime(timestamp);
-            const int weekday = iDateTime.get_weekday();
-
-            /* Если операция выполнена в субботу, воскресенье,
-			 * 1 января или 25 августа
-			 */
-            if(	weekday == xtime::SUN || weekday == xtime::SAT ||
-				(iDateTime.day == 1 && iDateTime.month == xtime::JAN) ||
-				(iDateTime.day == 25 && iDateTime.month == xtime::DEC))
-                return PayoutCancelType::DAY_OFF;
+        inline static const int check_timestamp(
+                const xtime::timestamp_t &timestamp,
+                const TradingCalendar &user_calendar = get_default_calendar()) {
+            /* выходные и праздники берутся из битовой маски календаря */
+            if(user_calendar.is_closed_day(timestamp)) return PayoutCancelType::DAY_OFF;
 
             /* С 22 февраля 2019 торговля доступна с 22:00 до 2:00 по терминальному времени (GMT+2)
              * Это с 20:00 до 0:00 по UTC
              */
-            if(iDateTime.hour >= 20) return PayoutCancelType::NIGHT_HOURS;
+            const uint32_t second_day = (uint32_t)(timestamp % xtime::SECONDS_IN_DAY);
+            if(!user_calendar.is_session(xtime::get_weekday(timestamp), second_day))
+                return PayoutCancelType::NIGHT_HOURS;
+            return ErrorType::OK;
+        }
+
+        /** \brief Проверить метку времени курсора календаря
+         * Данный метод проверяет, разрешает ли брокер торговлю в данное время
+         * \param cursor Курсор календаря
+         * \param user_calendar Календарь торговли (по умолчанию встроенный)
+         * \return Вернет PayoutCancelType::OK если торговать можно, иначе код ошибки
+         */
+        inline static const int check_timestamp(
+                const CalendarCursor &cursor,
+                const TradingCalendar &user_calendar = get_default_calendar()) {
+            if(user_calendar.is_closed_day(cursor.get_timestamp())) return PayoutCancelType::DAY_OFF;
+            if(!user_calendar.is_session(cursor.get_weekday(), cursor.get_second_day()))
+                return PayoutCancelType::NIGHT_HOURS;
+            return ErrorType::OK;
+        }
+
+        /** \brief Проверить длительность опциона для валютной пары
+         * \param duration Длительность опциона в секундах
+         * \param currency_pair_index Номер валютной пары из списка валютных пар брокера
+         * \param user_rules Правила выплат (по умолчанию встроенные)
+         * \return Вернет PayoutCancelType::OK если брокер принимает опцион такой длительности, иначе код ошибки
+         */
+        inline static const int check_duration(
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const GrandcapitalRules &user_rules = GrandcapitalRules::get_default()) {
+            if(duration < 60) return PayoutCancelType::TOO_LITTLE_TIME;
+            if(duration > MAX_DURATION) return PayoutCancelType::TOO_MUCH_TIME;
+            if(currency_pair_index >= GRANDCAPITAL_CURRENCY_PAIRS ||
+                !user_rules.is_currency_pairs[currency_pair_index])
+                return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
+            return ErrorType::OK;
+        }
+
+        /** \brief Получить торговое окно
+         *
+         * Находит ближайший промежуток времени [window_begin, window_end), в течение которого
+         * брокер принимает сделку: день не закрыт в календаре и время внутри сессии календаря (см. check_timestamp).
+         * Экспирация может выходить за конец торгового дня, поэтому окно не зависит от длительности.
+         * Если метка времени уже внутри окна, window_begin равен timestamp.
+         * Для ставки и календаря модели используйте метод get_trade_window экземпляра модели.
+         * \param[out] window_begin Первая метка времени, в которую сделка будет принята
+         * \param[out] window_end Конец окна (первая метка времени после окна, в которую сделка не принимается)
+         * \param[in] timestamp Метка времени, с которой начинается поиск
+         * \param[in] duration Длительность опциона в секундах
+         * \param[in] currency_pair_index Номер валютной пары из списка валютных пар брокера
+         * \param[in] user_rules Правила выплат (по умолчанию встроенные)
+         * \param[in] user_calendar Календарь торговли (по умолчанию встроенный)
+         * \return Вернет PayoutCancelType::OK или код ошибки, если сделка не будет принята никогда
+         */
+        inline static const int get_trade_window(
+                xtime::timestamp_t &window_begin,
+                xtime::timestamp_t &window_end,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const GrandcapitalRules &user_rules = GrandcapitalRules::get_default(),
+                const TradingCalendar &user_calendar = get_default_calendar()) {
+            const int err = check_duration(duration, currency_pair_index, user_rules);
+            if(err != ErrorType::OK) return err;
+            CalendarCursor cursor(timestamp);
+            /* выходные (выплата 0 и без календаря), праздники и дни после конца сессии
+             * пропускаются по дням, но не дольше MAX_TRADE_WINDOW_DAYS
+             */
+            for(uint32_t day = 0; check_timestamp(cursor, user_calendar) == PayoutCancelType::DAY_OFF ||
+                    cursor.get_weekday() == xtime::SAT || cursor.get_weekday() == xtime::SUN ||
+                    cursor.get_second_day() >= user_calendar.get_session_end(cursor.get_weekday()); ++day) {
+                if(day >= MAX_TRADE_WINDOW_DAYS) return PayoutCancelType::DAY_OFF;
+                cursor.update(cursor.get_first_timestamp_day() + xtime::SECONDS_IN_DAY);
+            }
+            const xtime::timestamp_t first_timestamp_day = cursor.get_first_timestamp_day();
+            const uint32_t weekday = cursor.get_weekday();
+            window_begin = std::max(cursor.get_timestamp(), first_timestamp_day + user_calendar.get_session_begin(weekday));
+            window_end = first_timestamp_day + user_calendar.get_session_end(weekday);
             return ErrorType::OK;
         }
 
+        /** \brief Получить максимальную длительность опциона
+         * \param timestamp Метка времени
+         * \param user_calendar Календарь торговли (по умолчанию встроенный)
+         * \return Максимальная длительность опциона в секундах, которую брокер примет в данное время, или 0, если торговля закрыта
+         */
+        inline static const uint32_t get_max_duration(
+                const xtime::timestamp_t timestamp,
+                const TradingCalendar &user_calendar = get_default_calendar()) {
+            if(check_timestamp(CalendarCursor(timestamp), user_calendar) != ErrorType::OK) return 0;
+            return MAX_DURATION;
+        }
+
+        /** \brief Получить следующую границу, на которой может измениться выплата
+         *
+         * Выплата постоянна между началом дня, началом и концом сессии, длительность опциона
+         * на границы не влияет и принимается для совместимости с IntradeBar.
+         * \param timestamp Метка времени
+         * \param user_calendar Календарь сессий (по умолчанию встроенная сессия, см. get_model_calendar)
+         * \return Ближайшая граница больше timestamp
+         */
+        inline static const xtime::timestamp_t get_next_payout_boundary(
+                const xtime::timestamp_t timestamp,
+                const uint32_t /*duration*/,
+                const TradingCalendar &user_calendar = get_session_calendar()) {
+            const xtime::timestamp_t first_timestamp_day = timestamp - timestamp % xtime::SECONDS_IN_DAY;
+            const uint32_t weekday = xtime::get_weekday(timestamp);
+            const xtime::timestamp_t begin = first_timestamp_day + user_calendar.get_session_begin(weekday);
+            const xtime::timestamp_t end = first_timestamp_day + user_calendar.get_session_end(weekday);
+            return timestamp < begin ? begin : timestamp < end ? end : first_timestamp_day + xtime::SECONDS_IN_DAY;
+        }
+
         /** \brief Получить процент выплат
          * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
          * \param[out] payout процент выплат
@@ -129,29 +464,37 @@ namespace payout_model {
                 const xtime::timestamp_t timestamp,
                 const uint32_t duration,
                 const uint32_t currency_pair_index,
-                const double amount) {
-            payout = 0.0;
-            /* Если продолжительность экспирации меньше 1 минуты (60 секунд) */
-            if(duration < 60) return PayoutCancelType::TOO_LITTLE_TIME;
-            /* Если продолжительность экспирации больше 2880 минут (172800 секунд) */
-            if(duration > 172800) return PayoutCancelType::TOO_MUCH_TIME;
-            if(currency_pair_index > grandcapital_currency_pairs.size() ||
-                !is_grandcapital_currency_pairs[currency_pair_index])
-                return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
-
-            if((currency_name == CURRENCY_USD && amount < 1)||
-                (currency_name == CURRENCY_RUB && amount < 50))
-                return PayoutCancelType::TOO_LITTLE_MONEY;
+                const double amount) const {
+            if(is_closed_day(timestamp)) {
+                payout = 0.0;
+                return count_call(PayoutCancelType::DAY_OFF, currency_pair_index, timestamp);
+            }
+            return count_call(calc_payout(payout, rules, min_amount, *sessions, TimestampCalendar(timestamp), duration, currency_pair_index, amount),
+                currency_pair_index, timestamp);
+        }
 
-            const uint32_t hour = xtime::get_hour_day(timestamp);
-            const uint32_t weekday = xtime::get_weekday(timestamp);
-            /* пропускаем выходные дни */
-            if(weekday == xtime::SAT || weekday == xtime::SUN)
-                return ErrorType::OK;
-            if(hour >= 20) return PayoutCancelType::NIGHT_HOURS;
-            payout = grandcapital_currency_pairs_payout[currency_pair_index];
-            return ErrorType::OK;
-        };
+        /** \brief Получить процент выплат
+         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
+         * \param[out] payout процент выплат
+         * \param[in] cursor курсор календаря, установленный на время сделки
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] amount размер ставки бинарного опциона
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline const int get_payout(
+                double &payout,
+                const CalendarCursor &cursor,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double amount) const {
+            if(is_closed_day(cursor.get_timestamp())) {
+                payout = 0.0;
+                return count_call(PayoutCancelType::DAY_OFF, currency_pair_index, cursor);
+            }
+            return count_call(calc_payout(payout, rules, min_amount, *sessions, cursor, duration, currency_pair_index, amount),
+                currency_pair_index, cursor);
+        }
 
         /** \brief Получить процент выплат
          *
@@ -165,21 +508,171 @@ namespace payout_model {
          */
         inline const int get_payout(
                 double &payout,
-                const std::string &currency_pair,
+                const std::string_view currency_pair,
                 const xtime::timestamp_t timestamp,
                 const uint32_t duration,
-                const double amount) {
-            std::string temp(currency_pair);
-            if(temp.length() > 6) temp = temp.substr(0,6);
-            auto it = grandcapital_currency_pairs_index.find(temp);
-            if(it == grandcapital_currency_pairs_index.end()) {
-                return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
-            }
-            uint32_t index = it->second;
-            if(!is_grandcapital_currency_pairs[index]) return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
+                const double amount) const {
+            const uint32_t index = grandcapital_currency_pairs_hash.find(currency_pair, true);
+            if(index >= GRANDCAPITAL_CURRENCY_PAIRS) return count_call(PayoutCancelType::CURRENCY_PAIR_IS_MISSING, index, timestamp);
+            if(!rules->is_currency_pairs[index]) return count_call(PayoutCancelType::CURRENCY_PAIR_IS_MISSING, index, timestamp);
             return get_payout(payout, timestamp, duration, index, amount);
         }
 
+        /** \brief Получить проценты выплат для массива сделок
+         *
+         * Пакетная версия get_payout для массивов структуры SoA.
+         * При наличии AVX2 или SSE4.1 основная часть массива обрабатывается векторно,
+         * остаток - скалярным методом get_payout. Результаты совпадают со скалярным методом.
+         * Метки времени должны быть меньше 2^52.
+         * \param[out] payout Массив процентов выплат
+         * \param[out] err Массив состояний выплат (0 в случае успеха, иначе см. PayoutCancelType)
+         * \param[in] timestamp Массив временных меток unix времени (GMT)
+         * \param[in] duration Массив длительностей опционов в секундах
+         * \param[in] currency_pair_index Массив номеров валютных пар из списка валютных пар брокера
+         * \param[in] amount Массив размеров ставок
+         * \param[in] size Количество сделок
+         */
+        inline void get_payout(
+                double *payout,
+                int *err,
+                const xtime::timestamp_t *timestamp,
+                const uint32_t *duration,
+                const uint32_t *currency_pair_index,
+                const double *amount,
+                const size_t size) const {
+            size_t i = 0;
+#           if defined(PAYOUT_MODEL_SIMD)
+            if(is_default_session() && (currency_name == CURRENCY_USD || currency_name == CURRENCY_RUB)) {
+                typedef simd::VDouble V;
+                const V v_min_amount = V::set1(min_amount);
+                const V zero = V::set1(0.0);
+                for(; i + V::size <= size; i += V::size) {
+                    /* проценты выплат валютных пар загружаются поэлементно */
+                    uint32_t pair_enabled[V::size];
+                    double pair_payout[V::size];
+                    for(size_t k = 0; k < V::size; ++k) {
+                        const uint32_t index = currency_pair_index[i + k];
+                        const bool is_enabled = index < GRANDCAPITAL_CURRENCY_PAIRS && rules->is_currency_pairs[index];
+                        pair_enabled[k] = is_enabled ? 1 : 0;
+                        pair_payout[k] = is_enabled ? rules->currency_pairs_payout[index] : 0.0;
+                    }
+                    const V v_timestamp = V::load_u64(timestamp + i);
+                    const V v_duration = V::load_u32(duration + i);
+                    const V v_amount = V::load(amount + i);
+                    const V is_missing = V::load_u32(pair_enabled) == zero;
+
+                    const V day = simd::floor_div(v_timestamp, xtime::SECONDS_IN_DAY);
+                    const V second_day = v_timestamp - day * V::set1(xtime::SECONDS_IN_DAY);
+                    const V hour = simd::floor_div(second_day, xtime::SECONDS_IN_HOUR);
+                    const V week_day = day + V::set1(xtime::THU);
+                    const V weekday = week_day - simd::floor_div(week_day, xtime::DAYS_IN_WEEK) * V::set1(xtime::DAYS_IN_WEEK);
+
+                    const V is_little_time = v_duration < V::set1(60);
+                    const V is_much_time = v_duration > V::set1(172800);
+                    const V is_little_money = v_amount < v_min_amount;
+                    const V is_day_off = (weekday == V::set1(xtime::SAT)) | (weekday == V::set1(xtime::SUN));
+                    const V is_night = hour >= V::set1(20);
+
+                    /* коды ошибок назначаются от младшего приоритета к старшему */
+                    V code = select(is_night, V::set1(PayoutCancelType::NIGHT_HOURS), zero);
+                    code = select(is_day_off, zero, code);
+                    code = select(is_little_money, V::set1(PayoutCancelType::TOO_LITTLE_MONEY), code);
+                    code = select(is_missing, V::set1(PayoutCancelType::CURRENCY_PAIR_IS_MISSING), code);
+                    code = select(is_much_time, V::set1(PayoutCancelType::TOO_MUCH_TIME), code);
+                    code = select(is_little_time, V::set1(PayoutCancelType::TOO_LITTLE_TIME), code);
+
+                    const V is_zero = (code != zero) | is_day_off;
+                    andnot(is_zero, V::load(pair_payout)).store(payout + i);
+                    code.store_i32(err + i);
+                }
+            }
+#           endif
+            /* векторная часть не проверяет календарь торговли */
+            if(calendar) {
+                for(size_t k = 0; k < i; ++k) {
+                    if(!calendar->is_closed_day(timestamp[k])) continue;
+                    payout[k] = 0.0;
+                    err[k] = PayoutCancelType::DAY_OFF;
+                }
+            }
+#           if defined(PAYOUT_MODEL_STATS)
+            for(size_t k = 0; k < i; ++k) count_call(err[k], currency_pair_index[k], timestamp[k]);
+#           endif
+            for(; i < size; ++i) {
+                err[i] = get_payout(payout[i], timestamp[i], duration[i], currency_pair_index[i], amount[i]);
+            }
+        }
+
+        /** \brief Получить абсолютный размер ставки и процент выплат
+         *
+         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
+         * \param[out] amount размер ставки бинарного опциона
+		 * \param[out] payout процент выплат
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] balance Размер депозита
+		 * \param[in] winrate Винрейт
+		 * \param[in] attenuator Коэффициент ослабления Келли
+		 * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+		 * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline const int get_amount(
+                double &amount,
+                double &payout,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter = 1.0,
+                const double winrate_limiter = 1.0) const {
+            if(is_closed_day(timestamp)) {
+                amount = payout = 0.0;
+                return count_call(PayoutCancelType::DAY_OFF, currency_pair_index, timestamp);
+            }
+            return count_call(calc_amount(amount, payout, rules, min_amount, *sessions, TimestampCalendar(timestamp), duration, currency_pair_index, balance,
+                winrate, attenuator, payout_limiter, winrate_limiter),
+                currency_pair_index, timestamp);
+        }
+
+        /** \brief Получить абсолютный размер ставки и процент выплат
+         *
+         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
+         * \param[out] amount размер ставки бинарного опциона
+		 * \param[out] payout процент выплат
+         * \param[in] cursor курсор календаря, установленный на время сделки
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] balance Размер депозита
+		 * \param[in] winrate Винрейт
+		 * \param[in] attenuator Коэффициент ослабления Келли
+		 * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+		 * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline const int get_amount(
+                double &amount,
+                double &payout,
+                const CalendarCursor &cursor,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter = 1.0,
+                const double winrate_limiter = 1.0) const {
+            if(is_closed_day(cursor.get_timestamp())) {
+                amount = payout = 0.0;
+                return count_call(PayoutCancelType::DAY_OFF, currency_pair_index, cursor);
+            }
+            return count_call(calc_amount(amount, payout, rules, min_amount, *sessions, cursor, duration, currency_pair_index, balance,
+                winrate, attenuator, payout_limiter, winrate_limiter),
+                currency_pair_index, cursor);
+        }
+
         /** \brief Получить абсолютный размер ставки и процент выплат
          *
          * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
@@ -198,60 +691,302 @@ namespace payout_model {
         inline const int get_amount(
                 double &amount,
                 double &payout,
-                const std::string &currency_pair,
+                const std::string_view currency_pair,
                 const xtime::timestamp_t timestamp,
                 const uint32_t duration,
                 const double balance,
                 const double winrate,
                 const double attenuator,
                 const double payout_limiter = 1.0,
-                const double winrate_limiter = 1.0) {
-            amount = 0;
-            payout = 0;
-            /* Если продолжительность экспирации меньше 1 минуты (60 секунд) */
-            if(duration < 60) return PayoutCancelType::TOO_LITTLE_TIME;
-            /* Если продолжительность экспирации больше 2880 минут (172800 секунд) */
-            if(duration > 172800) return PayoutCancelType::TOO_MUCH_TIME;
+                const double winrate_limiter = 1.0) const {
+            /* отсутствующий символ передается неверным индексом,
+             * чтобы сохранить порядок проверок
+             */
+            const uint32_t index = grandcapital_currency_pairs_hash.find(currency_pair, true);
+            return get_amount(amount, payout, timestamp, duration, index, balance,
+                winrate, attenuator, payout_limiter, winrate_limiter);
+        }
 
-            std::string temp(currency_pair);
-            if(temp.length() > 6) temp = temp.substr(0,6);
+        /** \brief Получить размеры ставок и проценты выплат для массива сигналов
+         *
+         * Пакетная версия get_amount для массивов структуры SoA.
+         * Проверки винрейта и размера ставки вычисляются без переходов для всех элементов вектора,
+         * остаток массива обрабатывается скалярным методом get_amount.
+         * Результаты совпадают со скалярным методом. Метки времени должны быть меньше 2^52.
+         * \param[out] amount Массив размеров ставок
+         * \param[out] payout Массив процентов выплат
+         * \param[out] err Массив состояний выплат (0 в случае успеха, иначе см. PayoutCancelType)
+         * \param[in] timestamp Массив временных меток unix времени (GMT)
+         * \param[in] duration Массив длительностей опционов в секундах
+         * \param[in] currency_pair_index Массив номеров валютных пар из списка валютных пар брокера
+         * \param[in] balance Массив размеров депозита
+         * \param[in] winrate Массив винрейтов
+         * \param[in] attenuator Массив коэффициентов ослабления Келли
+         * \param[in] payout_limiter Массив ограничителей процента выплат (nullptr - не используется)
+         * \param[in] winrate_limiter Массив ограничителей винрейта (nullptr - не используется)
+         * \param[in] size Количество сигналов
+         */
+        inline void get_amount(
+                double *amount,
+                double *payout,
+                int *err,
+                const xtime::timestamp_t *timestamp,
+                const uint32_t *duration,
+                const uint32_t *currency_pair_index,
+                const double *balance,
+                const double *winrate,
+                const double *attenuator,
+                const double *payout_limiter,
+                const double *winrate_limiter,
+                const size_t size) const {
+            size_t i = 0;
+#           if defined(PAYOUT_MODEL_SIMD)
+            if(is_default_session() && (currency_name == CURRENCY_USD || currency_name == CURRENCY_RUB)) {
+                typedef simd::VDouble V;
+                const V v_min_amount = V::set1(min_amount);
+                const V zero = V::set1(0.0);
+                const V one = V::set1(1.0);
+                for(; i + V::size <= size; i += V::size) {
+                    /* проценты выплат валютных пар загружаются поэлементно */
+                    uint32_t pair_enabled[V::size];
+                    double pair_payout[V::size];
+                    for(size_t k = 0; k < V::size; ++k) {
+                        const uint32_t index = currency_pair_index[i + k];
+                        const bool is_enabled = index < GRANDCAPITAL_CURRENCY_PAIRS && rules->is_currency_pairs[index];
+                        pair_enabled[k] = is_enabled ? 1 : 0;
+                        pair_payout[k] = is_enabled ? rules->currency_pairs_payout[index] : 0.0;
+                    }
+                    const V v_timestamp = V::load_u64(timestamp + i);
+                    const V v_duration = V::load_u32(duration + i);
+                    const V v_balance = V::load(balance + i);
+                    const V v_winrate = V::load(winrate + i);
+                    const V v_attenuator = V::load(attenuator + i);
+                    const V v_payout_limiter = payout_limiter ? V::load(payout_limiter + i) : one;
+                    const V v_winrate_limiter = winrate_limiter ? V::load(winrate_limiter + i) : one;
+                    const V v_payout = V::load(pair_payout);
+                    const V is_missing = V::load_u32(pair_enabled) == zero;
 
-            /* получение индекса валютной пары и проверка символа на выплату */
-            auto it = grandcapital_currency_pairs_index.find(temp);
-            if(it == grandcapital_currency_pairs_index.end()) {
-                return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
+                    const V day = simd::floor_div(v_timestamp, xtime::SECONDS_IN_DAY);
+                    const V second_day = v_timestamp - day * V::set1(xtime::SECONDS_IN_DAY);
+                    const V hour = simd::floor_div(second_day, xtime::SECONDS_IN_HOUR);
+                    const V week_day = day + V::set1(xtime::THU);
+                    const V weekday = week_day - simd::floor_div(week_day, xtime::DAYS_IN_WEEK) * V::set1(xtime::DAYS_IN_WEEK);
+
+                    const V min_winrate = one / (one + v_payout);
+                    const V calc_payout = select(v_payout < v_payout_limiter, v_payout, v_payout_limiter);
+                    const V calc_winrate = select(v_winrate < v_winrate_limiter, v_winrate, v_winrate_limiter);
+                    const V rate = (((one + calc_payout) * calc_winrate - one) / calc_payout) * v_attenuator;
+                    const V size_value = v_balance * rate;
+
+                    const V is_little_time = v_duration < V::set1(60);
+                    const V is_much_time = v_duration > V::set1(172800);
+                    const V is_day_off = (weekday == V::set1(xtime::SAT)) | (weekday == V::set1(xtime::SUN));
+                    const V is_night = hour >= V::set1(20);
+                    const V is_winrate = (v_winrate <= min_winrate) | (calc_winrate <= min_winrate);
+                    const V is_little_money = size_value < v_min_amount;
+
+                    /* коды ошибок назначаются от младшего приоритета к старшему */
+                    V code = select(is_little_money, V::set1(PayoutCancelType::TOO_LITTLE_MONEY), zero);
+                    code = select(is_winrate, V::set1(PayoutCancelType::TOO_LITTLE_WINRATE), code);
+                    code = select(is_night, V::set1(PayoutCancelType::NIGHT_HOURS), code);
+                    code = select(is_day_off, zero, code);
+                    code = select(is_missing, V::set1(PayoutCancelType::CURRENCY_PAIR_IS_MISSING), code);
+                    code = select(is_much_time, V::set1(PayoutCancelType::TOO_MUCH_TIME), code);
+                    code = select(is_little_time, V::set1(PayoutCancelType::TOO_LITTLE_TIME), code);
+                    const V is_rejected = is_little_time | is_much_time | is_missing | is_day_off | is_night;
+
+                    andnot(is_rejected | is_winrate | is_little_money, size_value).store(amount + i);
+                    andnot(is_rejected, v_payout).store(payout + i);
+                    code.store_i32(err + i);
+                }
+            }
+#           endif
+            /* векторная часть не проверяет календарь торговли */
+            if(calendar) {
+                for(size_t k = 0; k < i; ++k) {
+                    if(!calendar->is_closed_day(timestamp[k])) continue;
+                    amount[k] = payout[k] = 0.0;
+                    err[k] = PayoutCancelType::DAY_OFF;
+                }
+            }
+#           if defined(PAYOUT_MODEL_STATS)
+            for(size_t k = 0; k < i; ++k) count_call(err[k], currency_pair_index[k], timestamp[k]);
+#           endif
+            for(; i < size; ++i) {
+                err[i] = get_amount(amount[i], payout[i], timestamp[i], duration[i], currency_pair_index[i],
+                    balance[i], winrate[i], attenuator[i],
+                    payout_limiter ? payout_limiter[i] : 1.0,
+                    winrate_limiter ? winrate_limiter[i] : 1.0);
             }
-            uint32_t index = it->second;
-            if(!is_grandcapital_currency_pairs[index]) return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
+        }
 
-            const uint32_t hour = xtime::get_hour_day(timestamp);
-            const uint32_t weekday = xtime::get_weekday(timestamp);
-            /* пропускаем выходные дни */
-            if(weekday == xtime::SAT || weekday == xtime::SUN)  return ErrorType::OK;
-            if(hour >= 20) return PayoutCancelType::NIGHT_HOURS;
-            payout = grandcapital_currency_pairs_payout[index];
-            if(winrate <= (1.0 / (1.0 + payout))) return PayoutCancelType::TOO_LITTLE_WINRATE;
-            const double calc_payout = std::min(payout_limiter, payout);
-            const double calc_winrate = std::min(winrate_limiter, winrate);
-            if(calc_winrate <= (1.0 / (1.0 + payout))) return PayoutCancelType::TOO_LITTLE_WINRATE;
-            const double rate = (((1.0 + calc_payout) * calc_winrate - 1.0) / calc_payout) * attenuator;
-            amount = balance * rate;
-            if((currency_name == CURRENCY_USD && amount < 1)||
-            (currency_name == CURRENCY_RUB && amount < 50)) {
-                amount = 0;
-                return PayoutCancelType::TOO_LITTLE_MONEY;
+        /** \brief Найти длительность опциона с наибольшим ростом депозита
+         *
+         * Рассчитывает ставку для всех длительностей из списка за один проход
+         * и выбирает длительность с наибольшим ожидаемым логарифмическим ростом депозита
+         * (см. get_log_growth). Учитываются TOO_LITTLE_TIME и TOO_MUCH_TIME.
+         * При равном росте выбирается длительность, которая идет раньше в списке.
+         * \param[out] duration Длительность опциона в секундах (0, если сделку открывать не нужно)
+         * \param[out] amount размер ставки бинарного опциона
+         * \param[out] payout процент выплат
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] balance Размер депозита
+         * \param[in] winrate Винрейт
+         * \param[in] attenuator Коэффициент ослабления Келли
+         * \param[in] durations Список длительностей опциона в секундах
+         * \param[in] durations_size Количество длительностей
+         * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+         * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         * \return 0, если длительность найдена, иначе состояние выплаты для первой длительности из списка (см. PayoutCancelType)
+         */
+        inline const int get_best_duration(
+                uint32_t &duration,
+                double &amount,
+                double &payout,
+                const xtime::timestamp_t timestamp,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const uint32_t *durations,
+                const size_t durations_size,
+                const double payout_limiter = 1.0,
+                const double winrate_limiter = 1.0) const {
+            if(is_closed_day(timestamp)) {
+                duration = 0;
+                amount = payout = 0.0;
+                return count_call(PayoutCancelType::DAY_OFF, currency_pair_index, timestamp);
             }
-            return ErrorType::OK;
+            return count_call(calc_best_duration(duration, amount, payout, rules, min_amount, *sessions, TimestampCalendar(timestamp),
+                durations, durations_size, currency_pair_index, balance, winrate, attenuator, payout_limiter, winrate_limiter),
+                currency_pair_index, timestamp);
+        }
+
+        /** \brief Найти длительность опциона с наибольшим ростом депозита
+         *
+         * Версия get_best_duration для курсора календаря
+         * \param[out] duration Длительность опциона в секундах (0, если сделку открывать не нужно)
+         * \param[out] amount размер ставки бинарного опциона
+         * \param[out] payout процент выплат
+         * \param[in] cursor курсор календаря, установленный на время сделки
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] balance Размер депозита
+         * \param[in] winrate Винрейт
+         * \param[in] attenuator Коэффициент ослабления Келли
+         * \param[in] durations Список длительностей опциона в секундах
+         * \param[in] durations_size Количество длительностей
+         * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+         * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         * \return 0, если длительность найдена, иначе состояние выплаты для первой длительности из списка (см. PayoutCancelType)
+         */
+        inline const int get_best_duration(
+                uint32_t &duration,
+                double &amount,
+                double &payout,
+                const CalendarCursor &cursor,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const uint32_t *durations,
+                const size_t durations_size,
+                const double payout_limiter = 1.0,
+                const double winrate_limiter = 1.0) const {
+            if(is_closed_day(cursor.get_timestamp())) {
+                duration = 0;
+                amount = payout = 0.0;
+                return count_call(PayoutCancelType::DAY_OFF, currency_pair_index, cursor);
+            }
+            return count_call(calc_best_duration(duration, amount, payout, rules, min_amount, *sessions, cursor,
+                durations, durations_size, currency_pair_index, balance, winrate, attenuator, payout_limiter, winrate_limiter),
+                currency_pair_index, cursor);
+        }
+
+        /** \brief Найти длительность опциона с наибольшим ростом депозита
+         *
+         * Ищет среди всех длительностей, которые принимает брокер: от 60 до 172800 секунд.
+         * \param[out] duration Длительность опциона в секундах (0, если сделку открывать не нужно)
+         * \param[out] amount размер ставки бинарного опциона
+         * \param[out] payout процент выплат
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] balance Размер депозита
+         * \param[in] winrate Винрейт
+         * \param[in] attenuator Коэффициент ослабления Келли
+         * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+         * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         * \return 0, если длительность найдена, иначе состояние выплаты для длительности 1 минута (см. PayoutCancelType)
+         */
+        inline const int get_best_duration(
+                uint32_t &duration,
+                double &amount,
+                double &payout,
+                const xtime::timestamp_t timestamp,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter = 1.0,
+                const double winrate_limiter = 1.0) const {
+            size_t size = 0;
+            const uint32_t *candidates = get_best_duration_candidates(size);
+            if(is_closed_day(timestamp)) {
+                duration = 0;
+                amount = payout = 0.0;
+                return count_call(PayoutCancelType::DAY_OFF, currency_pair_index, timestamp);
+            }
+            return count_call(calc_best_duration(duration, amount, payout, rules, min_amount, *sessions, TimestampCalendar(timestamp),
+                candidates, size, currency_pair_index, balance, winrate, attenuator, payout_limiter, winrate_limiter),
+                currency_pair_index, timestamp);
+        }
+
+        /** \brief Найти длительность опциона с наибольшим ростом депозита
+         *
+         * Версия get_best_duration для курсора календаря и всех длительностей, которые принимает брокер
+         * \param[out] duration Длительность опциона в секундах (0, если сделку открывать не нужно)
+         * \param[out] amount размер ставки бинарного опциона
+         * \param[out] payout процент выплат
+         * \param[in] cursor курсор календаря, установленный на время сделки
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] balance Размер депозита
+         * \param[in] winrate Винрейт
+         * \param[in] attenuator Коэффициент ослабления Келли
+         * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+         * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         * \return 0, если длительность найдена, иначе состояние выплаты для длительности 1 минута (см. PayoutCancelType)
+         */
+        inline const int get_best_duration(
+                uint32_t &duration,
+                double &amount,
+                double &payout,
+                const CalendarCursor &cursor,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter = 1.0,
+                const double winrate_limiter = 1.0) const {
+            size_t size = 0;
+            const uint32_t *candidates = get_best_duration_candidates(size);
+            if(is_closed_day(cursor.get_timestamp())) {
+                duration = 0;
+                amount = payout = 0.0;
+                return count_call(PayoutCancelType::DAY_OFF, currency_pair_index, cursor);
+            }
+            return count_call(calc_best_duration(duration, amount, payout, rules, min_amount, *sessions, cursor,
+                candidates, size, currency_pair_index, balance, winrate, attenuator, payout_limiter, winrate_limiter),
+                currency_pair_index, cursor);
         }
 
         /** \brief Получить имя валютной пары по ее номеру
          * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
          * \return имя валютной пары либо пустую строку, если указанный индекс отсутствует в списке валютных пар
          */
-        inline const static std::string get_currecy_pair_name(const uint32_t currency_pair_index) {
+        inline const static std::string_view get_currecy_pair_name(const uint32_t currency_pair_index) {
             if(currency_pair_index < grandcapital_currency_pairs.size())
                 return grandcapital_currency_pairs[currency_pair_index];
-            return std::string();//Возврат пустой строки
+            return std::string_view();//Возврат пустой строки
         };
 
         /** \brief Установить рублевый счет или долларовый
@@ -260,13 +995,153 @@ namespace payout_model {
         void set_rub_account_currency(const bool is_rub) {
             if(is_rub) currency_name = CURRENCY_RUB;
             else currency_name = CURRENCY_USD;
+            update_amount_limits();
+        }
+
+        /** \brief Установить правила выплат
+         *
+         * Модель хранит указатель на правила, поэтому они должны существовать,
+         * пока модель их использует (например, пока открыта секция чтения RcuPointer).
+         * \param user_rules Правила выплат
+         */
+        inline void set_rules(const GrandcapitalRules &user_rules) {
+            rules = &user_rules;
+            update_amount_limits();
+        }
+
+        /// Получить правила выплат
+        inline const GrandcapitalRules &get_rules() const {
+            return *rules;
+        }
+
+        /** \brief Установить календарь торговли
+         *
+         * Если календарь задан, get_payout, get_amount и get_best_duration возвращают DAY_OFF
+         * для закрытых дней календаря без разбора даты, а ночное время (NIGHT_HOURS) берется из сессий календаря.
+         * Без календаря поведение прежнее, сессия встроенная (см. get_session_calendar).
+         * Модель хранит указатель на календарь, поэтому он должен существовать, пока модель его использует.
+         * \param user_calendar Календарь торговли или nullptr
+         */
+        inline void set_calendar(const TradingCalendar *user_calendar) {
+            calendar = user_calendar;
+            sessions = calendar ? calendar : &get_session_calendar();
+        }
+
+        /// Получить календарь торговли или nullptr
+        inline const TradingCalendar *get_calendar() const {
+            return calendar;
+        }
+
+        /// Получить календарь модели или календарь встроенной сессии, если календарь не задан (как в get_payout)
+        inline const TradingCalendar &get_model_calendar() const {
+            return *sessions;
+        }
+
+        /// Получить минимальную ставку для валюты счета
+        inline const double get_min_amount() const {
+            return min_amount;
+        }
+
+        /// Получить порог повышенной выплаты (у брокера нет повышенной выплаты, поэтому +infinity)
+        inline const double get_threshold_amount() const {
+            return std::numeric_limits<double>::infinity();
+        }
+
+        /** \brief Получить торговое окно для ставки
+         *
+         * В отличие от статического метода учитывает правила, календарь и минимальную ставку модели,
+         * поэтому внутри окна get_payout вернет ненулевую выплату без ошибки.
+         * Без календаря модели праздники не пропускаются, как и в get_payout.
+         * \param[out] window_begin Первая метка времени, в которую сделка будет принята
+         * \param[out] window_end Конец окна (первая метка времени после окна, в которую сделка не принимается)
+         * \param[in] timestamp Метка времени, с которой начинается поиск
+         * \param[in] duration Длительность опциона в секундах
+         * \param[in] currency_pair_index Номер валютной пары из списка валютных пар брокера
+         * \param[in] amount Размер ставки
+         * \return Вернет PayoutCancelType::OK или код ошибки, если сделка не будет принята никогда
+         */
+        inline const int get_trade_window(
+                xtime::timestamp_t &window_begin,
+                xtime::timestamp_t &window_end,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double amount) const {
+            const int err = check_duration(duration, currency_pair_index, *rules);
+            if(err != ErrorType::OK) return err;
+            if(amount < min_amount) return PayoutCancelType::TOO_LITTLE_MONEY;
+            return get_trade_window(window_begin, window_end, timestamp, duration, currency_pair_index,
+                *rules, get_model_calendar());
+        }
+
+        /** \brief Получить максимальную длительность опциона для ставки
+         * \param timestamp Метка времени
+         * \param currency_pair_index Номер валютной пары из списка валютных пар брокера
+         * \param amount Размер ставки
+         * \return Максимальная длительность опциона в секундах, для которой get_payout вернет ненулевую выплату, или 0
+         */
+        inline const uint32_t get_max_duration(
+                const xtime::timestamp_t timestamp,
+                const uint32_t currency_pair_index,
+                const double amount) const {
+            const TradingCalendar &user_calendar = get_model_calendar();
+            if(user_calendar.is_closed_day(timestamp)) return 0;
+            double payout = 0;
+            if(calc_payout(payout, rules, min_amount, *sessions, TimestampCalendar(timestamp), MAX_DURATION,
+                currency_pair_index, amount) != ErrorType::OK || payout <= 0) return 0;
+            return MAX_DURATION;
         }
 
         /** \brief Конструктор класса модели процентов выплат брокера intrade.bar
          * \param user_currency_name Валюта счета, по умолчанию RUB
          */
         Grandcapital(const uint32_t user_currency_name = CURRENCY_RUB) :
-            currency_name(user_currency_name) {
+            currency_name(user_currency_name), rules(&GrandcapitalRules::get_default()) {
+            update_amount_limits();
+        }
+
+        /** \brief Создать неизменяемый снимок модели для счета
+         *
+         * Снимок хранит валюту счета, правила выплат и вычисленные пороги ставок.
+         * Методы расчета выплат константные, поэтому один снимок можно
+         * использовать из нескольких потоков без блокировок.
+         * \param user_currency_name Валюта счета
+         * \param user_rules Правила выплат (по умолчанию встроенные)
+         * \param user_calendar Календарь торговли (по умолчанию закрытые дни не проверяются, см. set_calendar)
+         * \return Указатель на снимок модели
+         */
+        inline static std::shared_ptr<const Grandcapital> make_snapshot(
+                const uint32_t user_currency_name,
+                std::shared_ptr<const GrandcapitalRules> user_rules = nullptr,
+                std::shared_ptr<const TradingCalendar> user_calendar = nullptr) {
+            std::shared_ptr<Grandcapital> model = std::make_shared<Grandcapital>(user_currency_name);
+            if(user_rules) {
+                model->rules_owner = std::move(user_rules);
+                model->set_rules(*model->rules_owner);
+            }
+            if(user_calendar) {
+                model->calendar_owner = std::move(user_calendar);
+                model->set_calendar(model->calendar_owner.get());
+            }
+            return model;
+        }
+
+        /** \brief Построить маски торговых минут недели
+         *
+         * Минута недели входит в маску, если сделка минимальной ставкой, открытая в начале минуты,
+         * имеет ненулевую выплату без ошибки. Закрытые дни календаря модели учитываются при запросах.
+         * Вызовы не попадают в счетчики статистики.
+         * \param durations Длительности опционов в секундах
+         * \return Маски торговых минут
+         */
+        PayoutTradability make_tradability(const std::vector<uint32_t> &durations = {60}) const {
+            const double amount = std::max(min_amount, 0.0);
+            return PayoutTradability(GRANDCAPITAL_CURRENCY_PAIRS, durations, calendar,
+                    [&](const xtime::timestamp_t timestamp, const uint32_t duration, const uint32_t currency_pair_index) {
+                double payout = 0;
+                const int err = calc_payout(payout, rules, min_amount, *sessions, TimestampCalendar(timestamp), duration, currency_pair_index, amount);
+                return err == ErrorType::OK && payout > 0;
+            });
         }
 
         ~Grandcapital() {}
@@ -25,133 +25,168 @@
 #define INTRADE_BAR_PAYOUT_MODEL_H_INCLUDED
 
 #include "payout-model-common.hpp"
+#include "payout-model-simd.hpp"
+#include "payout-model-calendar-cursor.hpp"
+#include "payout-model-rules.hpp"
+#include "payout-model-trading-calendar.hpp"
+#include "payout-model-stats.hpp"
+#include "payout-model-tradability.hpp"
+#include "payout-model-trace.hpp"
 #include <vector>
+#include <algorithm>
+#include <memory>
+#include <limits>
 #include "xtime.hpp"
 
 namespace payout_model {
 
+    class IntradeBarPolicy;
+
     /** \brief Класс модели процентов выплат брокера Intrade.bar
      */
 	class IntradeBar {
     private:
+        friend class IntradeBarPolicy;
+
         uint32_t currency_name;         ///< Наименование валюты счета. Как правило, USD или RUB
+        const IntradeBarRules *rules;   ///< Правила выплат
+        std::shared_ptr<const IntradeBarRules> rules_owner; ///< Правила, которыми владеет снимок модели
+        const TradingCalendar *calendar = nullptr;  ///< Календарь торговли для закрытых дней или nullptr
+        std::shared_ptr<const TradingCalendar> calendar_owner; ///< Календарь, которым владеет снимок модели
+        const TradingCalendar *sessions = &get_session_calendar(); ///< Календарь торговых сессий (календарь модели или встроенная сессия)
+        double min_amount;              ///< Минимальная ставка для валюты счета
+        double threshold_amount;        ///< Порог повышенной выплаты для валюты счета
 
-    public:
+        /// Вычислить пороги ставок для валюты счета
+        inline void update_amount_limits() {
+            if(currency_name == CURRENCY_USD) {
+                min_amount = rules->min_amount_usd;
+                threshold_amount = rules->threshold_amount_usd;
+            } else
+            if(currency_name == CURRENCY_RUB) {
+                min_amount = rules->min_amount_rub;
+                threshold_amount = rules->threshold_amount_rub;
+            } else {
+                /* для других валют ограничения ставки не проверяются */
+                min_amount = -std::numeric_limits<double>::infinity();
+                threshold_amount = std::numeric_limits<double>::infinity();
+            }
+        }
 
-        /// Список типов причин отсутствия выплат
-        enum PayoutCancelType {
-            DAY_OFF = -1,				    ///< Выходной день или праздник
-            NIGHT_HOURS = -2, 			    ///< Ночное время, когда брокер не принмает ставки
-            BEGIN_EVENING_HOUR = -3, 		///< Первые минуты в начале часа вечером (либо последняя минута в конце часа)
-            TOO_LITTLE_TIME = -4, 		    ///< Слишком короткое время экспирации
-            TOO_MUCH_TIME = -5,             ///< Слишком длинное время экспирации
-            CURRENCY_PAIR_IS_MISSING = -6,  ///< Отсутствует валютная пара с указанным индексом
-            TOO_LITTLE_MONEY = -7,		    ///< Слишком низкая ставка
-            FXCM_MON = -8,                  ///< Нет котировок от FXCM в понедельник в 0 час UTC
-            EXPIRATION_ERROR = -9, 		    ///< Ошибка экспирации
-            TOO_LITTLE_WINRATE = -10,		///< Слишком низкий винрейт
-            EXIT_OVER_END_DAY = -11,        ///< Выход за конец дня
-        };
+        /// Вернет true, если задан календарь торговли и день закрыт
+        inline const bool is_closed_day(const xtime::timestamp_t timestamp) const {
+            return calendar && calendar->is_closed_day(timestamp);
+        }
 
-        /// Список валют счета
-        enum AccountCurrencyName {
-            CURRENCY_RUB = 0,       ///< Рублевая валюта счета
-            CURRENCY_USD = 1,       ///< Долларовый счет
-        };
+        static const uint32_t MAX_TRADE_WINDOW_DAYS = 366; ///< Наибольшее количество дней поиска торгового окна
 
-        constexpr static const double THRESHOLD_AMOUNT_RUB = 5000.0d;
-        constexpr static const double THRESHOLD_AMOUNT_USD = 80.0d;
-        constexpr static const double MIN_AMOUNT_RUB = 50.0d;
-        constexpr static const double MIN_AMOUNT_USD = 1.0d;
-        constexpr static const double MAX_AMOUNT_RUB = 25000.0d;
-        constexpr static const double MAX_AMOUNT_USD = 500.0d;
+        /// Вернет true, если сессии модели совпадают со встроенной сессией (векторные ядра проверяют только ее)
+        inline const bool is_default_session() const {
+            return sessions->is_uniform_session(
+                SESSION_BEGIN_HOUR * xtime::SECONDS_IN_HOUR, SESSION_END_HOUR * xtime::SECONDS_IN_HOUR);
+        }
 
-        /** \brief Проверить имя валютной пары
-         * \param currency_pair Имя валютной пары
-         * \return Вернет true, если указанная валютная пара поддерживается брокером
-         */
-        inline static const bool check_currecy_pair_name(const std::string &currency_pair) {
-            auto it = intrade_bar_currency_pairs_index.find(currency_pair);
-            if(it == intrade_bar_currency_pairs_index.end()) {
-                return false;
-            }
-            uint32_t index = it->second;
-            if(is_intrade_bar_currency_pairs[index]) return true;
-            return false;
+        /// Вернет true, если сделка в момент курсора имеет ненулевую выплату без ошибки
+        inline static const bool is_trade_accepted(
+                const CalendarCursor &cursor,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double amount,
+                const IntradeBarRules *user_rules,
+                const double user_min_amount,
+                const double user_threshold_amount,
+                const TradingCalendar &user_calendar) {
+            if(user_calendar.is_closed_day(cursor.get_timestamp())) return false;
+            double payout = 0;
+            return calc_payout(payout, user_rules, user_min_amount, user_threshold_amount, user_calendar, cursor,
+                duration, currency_pair_index, amount) == ErrorType::OK && payout > 0;
         }
 
-        /** \brief Проверить минуту дня
+        /** \brief Найти торговое окно
          *
-         * Данный метод проверяет, разрешает ли брокер торговлю в данное время
-         * \param minute_day Минута дня
-         * \return Вернет PayoutCancelType::OK если торговать можно, иначе код ошибки
+         * Выплата постоянна между границами get_next_payout_boundary, поэтому поиск проверяет
+         * расчетом выплаты только границы, а закрытые дни календаря пропускает целиком.
          */
-        inline static const int check_minute_day(
-                const uint32_t &minute_day,
-                const bool is_old_version = false) {
-            uint32_t hour = minute_day/xtime::MINUTES_IN_HOUR;
-            /* нельзя открывать сделки с 0 часов по МСК до 4
-             * или 1 по UTC
-             */
-            if(hour >= 21 || hour < 1) return PayoutCancelType::NIGHT_HOURS;
+        static const int find_trade_window(
+                xtime::timestamp_t &window_begin,
+                xtime::timestamp_t &window_end,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double amount,
+                const IntradeBarRules *user_rules,
+                const double user_min_amount,
+                const double user_threshold_amount,
+                const TradingCalendar &user_calendar) {
+            const int err = check_duration(duration, currency_pair_index, *user_rules);
+            if(err != ErrorType::OK) return err;
+            if(amount < user_min_amount) return PayoutCancelType::TOO_LITTLE_MONEY;
+            const xtime::timestamp_t last_timestamp = timestamp + (xtime::timestamp_t)MAX_TRADE_WINDOW_DAYS * xtime::SECONDS_IN_DAY;
+            xtime::timestamp_t t = timestamp;
+            CalendarCursor cursor(t);
+            while(!is_trade_accepted(cursor, duration, currency_pair_index, amount,
+                    user_rules, user_min_amount, user_threshold_amount, user_calendar)) {
+                t = user_calendar.is_closed_day(t) ?
+                    cursor.get_first_timestamp_day() + xtime::SECONDS_IN_DAY : get_next_payout_boundary(t, duration, user_calendar);
+                if(t >= last_timestamp) return PayoutCancelType::DAY_OFF;
+                cursor.update(t);
+            }
+            window_begin = t;
+            do {
+                t = get_next_payout_boundary(t, duration, user_calendar);
+                cursor.update(t);
+            } while(is_trade_accepted(cursor, duration, currency_pair_index, amount,
+                user_rules, user_min_amount, user_threshold_amount, user_calendar));
+            window_end = t;
             return ErrorType::OK;
         }
 
-        /** \brief Проверить метку времени
-         * Данный метод проверяет, разрешает ли брокер торговлю в данное время
-         * \param timestamp Метка времени
-         * \param is_old_version Использовать старую версию процентов выплат
-         * \return Вернет PayoutCancelType::OK если торговать можно, иначе код ошибки
-         */
-        inline static const int check_timestamp(
-                const xtime::timestamp_t &timestamp,
-                const bool is_old_version = false) {
-            xtime::DateTime iDateTime(timestamp);
-            const int weekday = iDateTime.get_weekday();
-
-            /* Если операция выполнена в субботу, воскресенье,
-			 * 1 января или 25 августа
-			 */
-            if(	weekday == xtime::SUN || weekday == xtime::SAT ||
-				(iDateTime.day == 1 && iDateTime.month == xtime::JAN) ||
-				(iDateTime.day == 25 && iDateTime.month == xtime::DEC))
-                return PayoutCancelType::DAY_OFF;
-
-            /* пропускаем 0 час по UTC в понедельник */
-            if(weekday == xtime::MON && iDateTime.hour == 0)
-                return PayoutCancelType::FXCM_MON;
+        /// Учесть состояние выплаты в счетчиках (только с PAYOUT_MODEL_STATS)
+        inline static const int count_call(const int err, const uint32_t currency_pair_index, const xtime::timestamp_t timestamp) {
+#           if defined(PAYOUT_MODEL_STATS)
+            Stats::add(currency_pair_index, (uint32_t)(timestamp % xtime::SECONDS_IN_DAY / xtime::SECONDS_IN_HOUR), err);
+#           else
+            (void)currency_pair_index;
+            (void)timestamp;
+#           endif
+            return err;
+        }
 
-            /* Если операция выполнена после 21:00 по Гринвичу до 00:00 */
-            if(iDateTime.hour >= 21 || iDateTime.hour < 1) return PayoutCancelType::NIGHT_HOURS;
-            return ErrorType::OK;
+        inline static const int count_call(const int err, const uint32_t currency_pair_index, const CalendarCursor &cursor) {
+#           if defined(PAYOUT_MODEL_STATS)
+            Stats::add(currency_pair_index, cursor.get_hour_day(), err);
+#           else
+            (void)currency_pair_index;
+            (void)cursor;
+#           endif
+            return err;
         }
 
-        /** \brief Получить процент выплат
-         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
-         * \param[out] payout процент выплат
-         * \param[in] timestamp временную метку unix времени (GMT)
-         * \param[in] duration длительность опциона в секундах
-         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
-         * \param[in] amount размер ставки бинарного опциона
-         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+        /* Расчет выплаты и ставки вынесен в статические методы, чтобы их могла
+         * использовать модель с правилами времени компиляции (см. PayoutModel)
          */
-        inline const int get_payout(
+        template<class CALENDAR>
+        inline static const int calc_payout(
                 double &payout,
-                const xtime::timestamp_t timestamp,
+                const IntradeBarRules *rules,
+                const double min_amount,
+                const double threshold_amount,
+                const TradingCalendar &sessions,
+                const CALENDAR &calendar,
                 const uint32_t duration,
                 const uint32_t currency_pair_index,
                 const double amount) {
             payout = 0.0;
+            const uint32_t weekday = calendar.get_weekday();
+            const uint32_t second_day = calendar.get_second_day();
 
-            /* обрабатываем выход экспирации за конец дня */
-            const xtime::timestamp_t last_time =
-                21 * xtime::SECONDS_IN_HOUR +
-                xtime::get_first_timestamp_day(timestamp);
-            if ((timestamp + duration) > last_time)
+            /* обрабатываем выход экспирации за конец торговой сессии */
+            if(((uint64_t)second_day + duration) > sessions.get_session_end(weekday))
                 return PayoutCancelType::EXIT_OVER_END_DAY;
 
             /* Если продолжительность экспирации меньше 3 минут (180 секунд) или иногда 60 сек. */
-            if(duration == 60 && !is_intrade_bar_currency_pairs_1m_exp[currency_pair_index])
+            if(duration == 60 && (currency_pair_index >= INTRADE_BAR_CURRENCY_PAIRS ||
+                !rules->is_currency_pairs_1m_exp[currency_pair_index]))
                 return PayoutCancelType::TOO_LITTLE_TIME;
             else
             if(duration < 180 && duration != 60)
@@ -160,24 +195,22 @@ namespace payout_model {
             /* Если продолжительность экспирации больше 500 минут (30000 секунд) */
             if (duration > 30000) return PayoutCancelType::TOO_MUCH_TIME;
 
-            if (currency_pair_index > intrade_bar_currency_pairs.size() ||
-                !is_intrade_bar_currency_pairs[currency_pair_index])
+            if (currency_pair_index >= intrade_bar_currency_pairs.size() ||
+                !rules->is_currency_pairs[currency_pair_index])
                 return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
 
-            if ((currency_name == CURRENCY_USD && amount < MIN_AMOUNT_USD)||
-                (currency_name == CURRENCY_RUB && amount < MIN_AMOUNT_RUB))
+            if (amount < min_amount)
                 return PayoutCancelType::TOO_LITTLE_MONEY;
 
-            const uint32_t hour = xtime::get_hour_day(timestamp);
-            const uint32_t minute = xtime::get_minute_hour(timestamp);
-            const uint32_t weekday = xtime::get_weekday(timestamp);
+            const uint32_t hour = calendar.get_hour_day();
+            const uint32_t minute = calendar.get_minute_hour();
             /* пропускаем выходные дни */
             if(weekday == xtime::SAT || weekday == xtime::SUN)
                 return ErrorType::OK;
             /* пропускаем 0 час по UTC в понедельник */
             if(weekday == xtime::MON && hour == 0)
                 return PayoutCancelType::FXCM_MON;
-            if(hour >= 21 || hour < 1) return PayoutCancelType::NIGHT_HOURS;
+            if(!sessions.is_session(weekday, second_day)) return PayoutCancelType::NIGHT_HOURS;
             /* с 4 часа по МСК до 9 утра по МСК процент выполат 60%
              * с 17 часов по МСК  процент выплат в течении 3 минут в начале часа и конце часа также составляет 60%
              */
@@ -186,34 +219,31 @@ namespace payout_model {
                  * с 17 часов по МСК  процент выплат в течении 3 минут в начале часа и конце часа также составляет 60% или 63%
                  */
                 if(minute >= 57 || minute <= 2) {
-                    if ((currency_name == CURRENCY_USD && amount >= THRESHOLD_AMOUNT_USD)||
-                        (currency_name == CURRENCY_RUB && amount >= THRESHOLD_AMOUNT_RUB)) {
-                        payout = 0.63;
+                    if (amount >= threshold_amount) {
+                        payout = rules->high_payout_60;
                     } else {
-                        payout = 0.6;
+                        payout = rules->low_payout_60;
                     }
                     return ErrorType::OK;
                 }
             }
             if(hour == 13 && minute >= 57) {
-                if ((currency_name == CURRENCY_USD && amount >= THRESHOLD_AMOUNT_USD)||
-                    (currency_name == CURRENCY_RUB && amount >= THRESHOLD_AMOUNT_RUB)) {
-                    payout = 0.63;
+                if (amount >= threshold_amount) {
+                    payout = rules->high_payout_60;
                 } else {
-                    payout = 0.6;
+                    payout = rules->low_payout_60;
                 }
                 return ErrorType::OK;
             }
             /* Если счет в долларах и ставка больше 80 долларов или счет в рублях и ставка больше THRESHOLD_AMOUNT_RUB рублей */
-            if((currency_name == CURRENCY_USD && amount >= THRESHOLD_AMOUNT_USD)||
-                (currency_name == CURRENCY_RUB && amount >= THRESHOLD_AMOUNT_RUB)) {
+            if(amount >= threshold_amount) {
                 if(duration == 60) {
                     /* Если продолжительность экспирации 1 минута
                      * Процент выплат составит 63 (0,63)
                      */
-                    payout = 0.63;
+                    payout = rules->high_payout_60;
                 } else {
-                    payout = 0.85; // Процент выплат составит 85 (0,85)
+                    payout = rules->high_payout; // Процент выплат составит 85 (0,85)
                 }
             } else {
                 /* Если счет в долларах и ставка меньше 80 долларов или счет в рублях и ставка меньше THRESHOLD_AMOUNT_RUB рублей */
@@ -222,206 +252,170 @@ namespace payout_model {
                     /* Если продолжительность экспирации 1 минута
                      * Процент выплат составит 60 (0,6)
                      */
-                    payout = 0.6;
+                    payout = rules->low_payout_60;
                 } else
                 if(duration == 180) {
                     /* Если продолжительность экспирации 3 минуты
                      * Процент выплат составит 82 (0,82)
                      */
-                    payout = 0.82;
+                    payout = rules->low_payout_180;
                 } else {
                     /* Если продолжительность экспирации от 4 до 500 минут */
                     if(duration >= 240 && duration <= 30000) {
-                        payout = 0.79; // Процент выплат составит 79 (0,79)
+                        payout = rules->low_payout_240; // Процент выплат составит 79 (0,79)
                     } else return PayoutCancelType::EXPIRATION_ERROR;
                 }
             }
             return ErrorType::OK;
         };
 
-        /** \brief Получить процент выплат
-         *
-         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
-         * \param[out] payout процент выплат
-         * \param[in] currency_pair Имя валютной пары
-         * \param[in] timestamp временную метку unix времени (GMT)
-         * \param[in] duration длительность опциона в секундах
-         * \param[in] amount размер ставки бинарного опциона
-         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
-         */
-        inline const int get_payout(
-                double &payout,
-                const std::string &currency_pair,
-                const xtime::timestamp_t timestamp,
-                const uint32_t duration,
-                const double amount) {
-            auto it = intrade_bar_currency_pairs_index.find(currency_pair);
-            if(it == intrade_bar_currency_pairs_index.end()) {
-                return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
-            }
-            uint32_t index = it->second;
-            if(!is_intrade_bar_currency_pairs[index]) return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
-            return get_payout(payout, timestamp, duration, index, amount);
-        }
-
-        /** \brief Получить абсолютный размер ставки и процент выплат
-         *
-         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
-         * \param[out] amount размер ставки бинарного опциона
-		 * \param[out] payout процент выплат
-         * \param[in] currency_pair Имя валютной пары
-         * \param[in] timestamp временную метку unix времени (GMT)
-         * \param[in] duration длительность опциона в секундах
-         * \param[in] balance Размер депозита
-		 * \param[in] winrate Винрейт
-		 * \param[in] attenuator Коэффициент ослабления Келли
-		 * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
-		 * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
-         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
-         */
-        inline const int get_amount(
+        template<class CALENDAR>
+        inline static const int calc_amount(
                 double &amount,
                 double &payout,
-                const std::string &currency_pair,
-                const xtime::timestamp_t timestamp,
+                const IntradeBarRules *rules,
+                const double min_amount,
+                const double threshold_amount,
+                const TradingCalendar &sessions,
+                const CALENDAR &calendar,
                 const uint32_t duration,
+                const uint32_t currency_pair_index,
                 const double balance,
                 const double winrate,
                 const double attenuator,
-                const double payout_limiter = 1.0,
-                const double winrate_limiter = 1.0) {
+                const double payout_limiter,
+                const double winrate_limiter) {
             amount = 0;
             payout = 0;
+            PAYOUT_MODEL_AMOUNT_TRACE(AmountTracer::begin());
+            const uint32_t weekday = calendar.get_weekday();
+            const uint32_t second_day = calendar.get_second_day();
 
-            /* обрабатываем выход экспирации за конец дня */
-            const xtime::timestamp_t last_time =
-                21 * xtime::SECONDS_IN_HOUR +
-                xtime::get_first_timestamp_day(timestamp);
-            if ((timestamp + duration) > last_time)
+            /* обрабатываем выход экспирации за конец торговой сессии */
+            if(((uint64_t)second_day + duration) > sessions.get_session_end(weekday))
                 return PayoutCancelType::EXIT_OVER_END_DAY;
 
             /* Если продолжительность экспирации больше 500 минут (30000 секунд) */
             if(duration > 30000) return PayoutCancelType::TOO_MUCH_TIME;
 
-            /* получение индекса валютной пары и проверка символа на выплату */
-            auto it = intrade_bar_currency_pairs_index.find(currency_pair);
-            if(it == intrade_bar_currency_pairs_index.end()) {
+            /* проверка символа на выплату */
+            if(currency_pair_index >= intrade_bar_currency_pairs.size() ||
+                !rules->is_currency_pairs[currency_pair_index])
                 return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
-            }
-            uint32_t index = it->second;
-            if(!is_intrade_bar_currency_pairs[index]) return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
 
             /* Если продолжительность экспирации меньше 3 минут (180 секунд) или иногда 60 сек. */
-            if(duration == 60 && !is_intrade_bar_currency_pairs_1m_exp[index])
+            if(duration == 60 && !rules->is_currency_pairs_1m_exp[currency_pair_index])
                 return PayoutCancelType::TOO_LITTLE_TIME;
             else
             if(duration < 180 && duration != 60)
                 return PayoutCancelType::TOO_LITTLE_TIME;
 
-            const uint32_t hour = xtime::get_hour_day(timestamp);
-            const uint32_t minute = xtime::get_minute_hour(timestamp);
-            const uint32_t weekday = xtime::get_weekday(timestamp);
+            const uint32_t hour = calendar.get_hour_day();
+            const uint32_t minute = calendar.get_minute_hour();
 
             /* пропускаем выходные дни */
             if(weekday == xtime::SAT || weekday == xtime::SUN)  return ErrorType::OK;
             /* пропускаем 0 час по UTC в понедельник */
             if(weekday == xtime::MON && hour == 0) return PayoutCancelType::FXCM_MON;
-            if(hour >= 21 || hour < 1) return PayoutCancelType::NIGHT_HOURS;
+            if(!sessions.is_session(weekday, second_day)) return PayoutCancelType::NIGHT_HOURS;
             if(hour <= 6 || hour >= 14 || (hour == 13 && minute >= 57) || duration == 60) {
                 /* с 1 часа по МСК до 8 утра по МСК процент выполат 60% - 63%
                  * с 17 часов по МСК  процент выплат в течении 3 минут в начале часа и конце часа также составляет 60% - 63%
                  * для экспирации 1 минута выплата 60% - 63%
                  */
                 if (minute >= 57 || minute <= 2 || duration == 60) {
-                    payout = 0.6;
-                    if(winrate <= (1.0 / 1.6)) return PayoutCancelType::TOO_LITTLE_WINRATE;
-					const double calc_payout = std::min(payout_limiter, 0.6);
+                    PAYOUT_MODEL_AMOUNT_TRACE(AmountTracer::set_branch(TRACE_BRANCH_60));
+                    payout = rules->low_payout_60;
+                    if(winrate <= rules->low_winrate_60) return PayoutCancelType::TOO_LITTLE_WINRATE;
+					const double calc_payout = std::min(payout_limiter, rules->low_payout_60);
 					const double calc_winrate = std::min(winrate_limiter, winrate);
-					if(calc_winrate <= (1.0 / 1.6)) return PayoutCancelType::TOO_LITTLE_WINRATE;
+					if(calc_winrate <= rules->low_winrate_60) return PayoutCancelType::TOO_LITTLE_WINRATE;
                     const double rate = (((1.0 + calc_payout) * calc_winrate - 1.0) / calc_payout) * attenuator;
                     amount = balance * rate;
+                    PAYOUT_MODEL_AMOUNT_TRACE(AmountTracer::set_tier(false, rules->low_payout_60, calc_payout, winrate, calc_winrate, rate));
 
-                    if((currency_name == CURRENCY_USD && amount < MIN_AMOUNT_USD)||
-                    (currency_name == CURRENCY_RUB && amount < MIN_AMOUNT_RUB)) {
+                    if(amount < min_amount) {
                         amount = 0;
                         return PayoutCancelType::TOO_LITTLE_MONEY;
                     }
 
-                    if ((currency_name == CURRENCY_USD && amount >= THRESHOLD_AMOUNT_USD)||
-                        (currency_name == CURRENCY_RUB && amount >= THRESHOLD_AMOUNT_RUB)) {
-                        payout = 0.63;
-                        if(winrate <= (1.0 / 1.63)) return PayoutCancelType::TOO_LITTLE_WINRATE;
-                        const double calc_payout = std::min(payout_limiter, 0.63);
+                    if (amount >= threshold_amount) {
+                        payout = rules->high_payout_60;
+                        if(winrate <= rules->high_winrate_60) return PayoutCancelType::TOO_LITTLE_WINRATE;
+                        const double calc_payout = std::min(payout_limiter, rules->high_payout_60);
                         const double calc_winrate = std::min(winrate_limiter, winrate);
-                        if(calc_winrate <= (1.0 / 1.63)) return PayoutCancelType::TOO_LITTLE_WINRATE;
+                        if(calc_winrate <= rules->high_winrate_60) return PayoutCancelType::TOO_LITTLE_WINRATE;
                         const double rate = (((1.0 + calc_payout) * calc_winrate - 1.0) / calc_payout) * attenuator;
                         amount = balance * rate;
+                        PAYOUT_MODEL_AMOUNT_TRACE(AmountTracer::set_tier(true, rules->high_payout_60, calc_payout, winrate, calc_winrate, rate));
                     }
                     return ErrorType::OK;
                 }
             }
             if(duration == 180) {
-                if(winrate <= (1.0 / 1.85)) return PayoutCancelType::TOO_LITTLE_WINRATE;
+                PAYOUT_MODEL_AMOUNT_TRACE(AmountTracer::set_branch(TRACE_BRANCH_180));
+                if(winrate <= rules->high_winrate) return PayoutCancelType::TOO_LITTLE_WINRATE;
 
-                const double calc_high_payout = std::min(payout_limiter, 0.85);
+                const double calc_high_payout = std::min(payout_limiter, rules->high_payout);
                 const double calc_winrate = std::min(winrate_limiter, winrate);
 
-                if(calc_winrate <= (1.0 / 1.85)) return PayoutCancelType::TOO_LITTLE_WINRATE;
+                if(calc_winrate <= rules->high_winrate) return PayoutCancelType::TOO_LITTLE_WINRATE;
 
                 const double high_rate = (((1.0 + calc_high_payout) * calc_winrate - 1.0) / calc_high_payout) * attenuator;
                 const double high_amount = balance * high_rate;
-                if((currency_name == CURRENCY_USD && high_amount >= THRESHOLD_AMOUNT_USD)||
-                    (currency_name == CURRENCY_RUB && high_amount >= THRESHOLD_AMOUNT_RUB)) {
-                    payout = 0.85;
+                PAYOUT_MODEL_AMOUNT_TRACE(AmountTracer::set_tier(high_amount >= threshold_amount,
+                    rules->high_payout, calc_high_payout, winrate, calc_winrate, high_rate));
+                if(high_amount >= threshold_amount) {
+                    payout = rules->high_payout;
                     amount = high_amount;
-                    if((currency_name == CURRENCY_USD && amount < MIN_AMOUNT_USD)||
-                    (currency_name == CURRENCY_RUB && amount < MIN_AMOUNT_RUB)) {
+                    if(amount < min_amount) {
                         amount = 0;
                         return PayoutCancelType::TOO_LITTLE_MONEY;
                     }
                     return ErrorType::OK;
                 }
-                if(winrate <= (1.0 / 1.82)) return PayoutCancelType::TOO_LITTLE_WINRATE;
-                if(calc_winrate <= (1.0 / 1.82)) return PayoutCancelType::TOO_LITTLE_WINRATE;
-                payout = 0.82;
+                if(winrate <= rules->low_winrate_180) return PayoutCancelType::TOO_LITTLE_WINRATE;
+                if(calc_winrate <= rules->low_winrate_180) return PayoutCancelType::TOO_LITTLE_WINRATE;
+                payout = rules->low_payout_180;
 
-                const double calc_low_payout = std::min(payout_limiter, 0.82);
+                const double calc_low_payout = std::min(payout_limiter, rules->low_payout_180);
                 const double low_rate = (((1.0 + calc_low_payout) * calc_winrate - 1.0) / calc_low_payout) * attenuator;
                 amount = balance * low_rate;
-                if((currency_name == CURRENCY_USD && amount < MIN_AMOUNT_USD)||
-                (currency_name == CURRENCY_RUB && amount < MIN_AMOUNT_RUB)) {
+                PAYOUT_MODEL_AMOUNT_TRACE(AmountTracer::set_tier(false, rules->low_payout_180, calc_low_payout, winrate, calc_winrate, low_rate));
+                if(amount < min_amount) {
                     amount = 0;
                     return PayoutCancelType::TOO_LITTLE_MONEY;
                 }
                 return ErrorType::OK;
             } else
             if(duration >= 240 && duration <= 30000) {
-                if(winrate <= (1.0 / 1.85)) return PayoutCancelType::TOO_LITTLE_WINRATE;
+                PAYOUT_MODEL_AMOUNT_TRACE(AmountTracer::set_branch(TRACE_BRANCH_240));
+                if(winrate <= rules->high_winrate) return PayoutCancelType::TOO_LITTLE_WINRATE;
                 const double calc_winrate = std::min(winrate_limiter, winrate);
-                if(calc_winrate <= (1.0 / 1.82)) return PayoutCancelType::TOO_LITTLE_WINRATE;
-                const double calc_high_payout = std::min(payout_limiter, 0.85);
+                if(calc_winrate <= rules->low_winrate_180) return PayoutCancelType::TOO_LITTLE_WINRATE;
+                const double calc_high_payout = std::min(payout_limiter, rules->high_payout);
                 const double high_rate = (((1.0 + calc_high_payout) * calc_winrate - 1.0) / calc_high_payout) * attenuator;
                 const double high_amount = balance * high_rate;
-                if((currency_name == CURRENCY_USD && high_amount >= THRESHOLD_AMOUNT_USD)||
-                    (currency_name == CURRENCY_RUB && high_amount >= THRESHOLD_AMOUNT_RUB)) {
-                    payout = 0.85;
+                PAYOUT_MODEL_AMOUNT_TRACE(AmountTracer::set_tier(high_amount >= threshold_amount,
+                    rules->high_payout, calc_high_payout, winrate, calc_winrate, high_rate));
+                if(high_amount >= threshold_amount) {
+                    payout = rules->high_payout;
                     amount = high_amount;
-                    if((currency_name == CURRENCY_USD && amount < MIN_AMOUNT_USD)||
-                    (currency_name == CURRENCY_RUB && amount < MIN_AMOUNT_RUB)) {
+                    if(amount < min_amount) {
                         amount = 0;
                         return PayoutCancelType::TOO_LITTLE_MONEY;
                     }
                     return ErrorType::OK;
                 }
-                if(winrate <= (1.0 / 1.79)) return PayoutCancelType::TOO_LITTLE_WINRATE;
-                payout = 0.79;
+                if(winrate <= rules->low_winrate_240) return PayoutCancelType::TOO_LITTLE_WINRATE;
+                payout = rules->low_payout_240;
                 //const double calc_winrate = std::min(winrate_limiter, winrate);
-                if(calc_winrate <= (1.0 / 1.82)) return PayoutCancelType::TOO_LITTLE_WINRATE;
-                const double calc_low_payout = std::min(payout_limiter, 0.79);
+                if(calc_winrate <= rules->low_winrate_180) return PayoutCancelType::TOO_LITTLE_WINRATE;
+                const double calc_low_payout = std::min(payout_limiter, rules->low_payout_240);
                 const double low_rate = (((1.0 + calc_low_payout)* calc_winrate - 1.0) / calc_low_payout) * attenuator;
                 amount = balance * low_rate;
-                if((currency_name == CURRENCY_USD && amount < MIN_AMOUNT_USD)||
-                (currency_name == CURRENCY_RUB && amount < MIN_AMOUNT_RUB)) {
+                PAYOUT_MODEL_AMOUNT_TRACE(AmountTracer::set_tier(false, rules->low_payout_240, calc_low_payout, winrate, calc_winrate, low_rate));
+                if(amount < min_amount) {
                     amount = 0;
                     return PayoutCancelType::TOO_LITTLE_MONEY;
                 }
@@ -430,29 +424,1096 @@ namespace payout_model {
             return ErrorType::OK;
         }
 
-        /** \brief Получить имя валютной пары по ее номеру
-         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
-         * \return имя валютной пары либо пустую строку, если указанный индекс отсутствует в списке валютных пар
+        /* Внутри класса длительности (1 минута, меньше 3 минут, 3 минуты, от 181 до 239 секунд,
+         * от 4 до 500 минут, больше 500 минут) ставка и выплата не зависят от длительности,
+         * если экспирация не выходит за конец дня. Поэтому calc_amount вызывается
+         * не больше одного раза на класс, а для остальных длительностей проверяется только конец дня
          */
-        inline const static std::string get_currecy_pair_name(const uint32_t currency_pair_index) {
-            if(currency_pair_index < intrade_bar_currency_pairs.size())
-                return intrade_bar_currency_pairs[currency_pair_index];
-            return std::string();//Возврат пустой строки
+        template<class CALENDAR>
+        inline static const int calc_best_duration(
+                uint32_t &best_duration,
+                double &best_amount,
+                double &best_payout,
+                const IntradeBarRules *rules,
+                const double min_amount,
+                const double threshold_amount,
+                const TradingCalendar &sessions,
+                const CALENDAR &calendar,
+                const uint32_t *durations,
+                const size_t durations_size,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter,
+                const double winrate_limiter) {
+            const uint32_t CLASSES = 6;
+            bool is_class[CLASSES] = {};
+            int class_err[CLASSES];
+            double class_amount[CLASSES];
+            double class_payout[CLASSES];
+            double class_growth[CLASSES];
+            const uint64_t second_day = calendar.get_second_day();
+            const uint64_t session_end = sessions.get_session_end(calendar.get_weekday());
+            double best_growth = 0.0;
+            int first_err = PayoutCancelType::EXPIRATION_ERROR;
+            best_duration = 0;
+            best_amount = 0;
+            best_payout = 0;
+            for(size_t i = 0; i < durations_size; ++i) {
+                const uint32_t duration = durations[i];
+                int err = PayoutCancelType::EXIT_OVER_END_DAY;
+                if((second_day + duration) <= session_end) {
+                    const uint32_t c =
+                        duration == 60 ? 0 :
+                        duration < 180 ? 1 :
+                        duration == 180 ? 2 :
+                        duration < 240 ? 3 :
+                        duration <= 30000 ? 4 : 5;
+                    if(!is_class[c]) {
+                        is_class[c] = true;
+                        class_err[c] = calc_amount(class_amount[c], class_payout[c], rules, min_amount, threshold_amount,
+                            sessions, calendar, duration, currency_pair_index, balance, winrate, attenuator, payout_limiter, winrate_limiter);
+                        class_growth[c] = class_err[c] == ErrorType::OK && class_amount[c] > 0 ?
+                            get_log_growth(class_amount[c], class_payout[c], balance, winrate) : 0.0;
+                    }
+                    err = class_err[c];
+                    if(class_growth[c] > best_growth) {
+                        best_growth = class_growth[c];
+                        best_duration = duration;
+                        best_amount = class_amount[c];
+                        best_payout = class_payout[c];
+                    }
+                }
+                if(i == 0) first_err = err;
+            }
+            return best_duration != 0 ? ErrorType::OK : first_err;
+        }
+
+        /* Для длительностей 60, 180, 240, 300, ..., 30000 с шагом в минуту достаточно
+         * проверить 60, 180 и 240: от 4 до 500 минут ставка одинаковая, при равном росте
+         * выбирается более короткая длительность, а если 240 выходит за конец дня, то и все длиннее
+         */
+        inline static const uint32_t *get_best_duration_candidates(size_t &size) {
+            static const uint32_t candidates[] = {60, 180, 240};
+            size = sizeof(candidates) / sizeof(candidates[0]);
+            return candidates;
+        }
+
+    public:
+
+        /// Список типов причин отсутствия выплат
+        enum PayoutCancelType {
+            DAY_OFF = -1,				    ///< Выходной день или праздник
+            NIGHT_HOURS = -2, 			    ///< Ночное время, когда брокер не принмает ставки
+            BEGIN_EVENING_HOUR = -3, 		///< Первые минуты в начале часа вечером (либо последняя минута в конце часа)
+            TOO_LITTLE_TIME = -4, 		    ///< Слишком короткое время экспирации
+            TOO_MUCH_TIME = -5,             ///< Слишком длинное время экспирации
+            CURRENCY_PAIR_IS_MISSING = -6,  ///< Отсутствует валютная пара с указанным индексом
+            TOO_LITTLE_MONEY = -7,		    ///< Слишком низкая ставка
+            FXCM_MON = -8,                  ///< Нет котировок от FXCM в понедельник в 0 час UTC
+            EXPIRATION_ERROR = -9, 		    ///< Ошибка экспирации
+            TOO_LITTLE_WINRATE = -10,		///< Слишком низкий винрейт
+            EXIT_OVER_END_DAY = -11,        ///< Выход за конец дня
         };
 
-        /** \brief Установить рублевый счет или долларовый
-         * \param is_rub Рубли, если true. Иначе USD
+        /// Счетчики состояний выплат по валютной паре и часу (см. PAYOUT_MODEL_STATS)
+        typedef PayoutStats<IntradeBar, INTRADE_BAR_CURRENCY_PAIRS> Stats;
+
+        /// Список валют счета
+        enum AccountCurrencyName {
+            CURRENCY_RUB = 0,       ///< Рублевая валюта счета
+            CURRENCY_USD = 1,       ///< Долларовый счет
+        };
+
+        constexpr static const double THRESHOLD_AMOUNT_RUB = 5000.0d;
+        constexpr static const double THRESHOLD_AMOUNT_USD = 80.0d;
+        constexpr static const double MIN_AMOUNT_RUB = 50.0d;
+        constexpr static const double MIN_AMOUNT_USD = 1.0d;
+        constexpr static const double MAX_AMOUNT_RUB = 25000.0d;
+        constexpr static const double MAX_AMOUNT_USD = 500.0d;
+
+        static const uint32_t SESSION_BEGIN_HOUR = 1;   ///< Час начала торговли (UTC)
+        static const uint32_t SESSION_END_HOUR = 21;    ///< Час окончания торговли и крайний срок экспирации (UTC)
+        static const uint32_t MAX_DURATION = 30000;     ///< Максимальная длительность опциона в секундах
+
+        /** \brief Проверить имя валютной пары
+         * \param currency_pair Имя валютной пары
+         * \param user_rules Правила выплат (по умолчанию встроенные)
+         * \return Вернет true, если указанная валютная пара поддерживается брокером
          */
-        void set_rub_account_currency(const bool is_rub) {
-            if(is_rub) currency_name = CURRENCY_RUB;
-            else currency_name = CURRENCY_USD;
+        inline static const bool check_currecy_pair_name(
+                const std::string_view currency_pair,
+                const IntradeBarRules &user_rules = IntradeBarRules::get_default()) {
+            const uint32_t index = intrade_bar_currency_pairs_hash.find(currency_pair);
+            if(index >= INTRADE_BAR_CURRENCY_PAIRS) return false;
+            if(user_rules.is_currency_pairs[index]) return true;
+            return false;
         }
 
-        /** \brief Конструктор класса модели процентов выплат брокера intrade.bar
-         * \param user_currency_name Валюта счета, по умолчанию RUB
+        /** \brief Проверить минуту дня
+         *
+         * Данный метод проверяет, разрешает ли брокер торговлю в данное время
+         * \param minute_day Минута дня
+         * \return Вернет PayoutCancelType::OK если торговать можно, иначе код ошибки
          */
-        IntradeBar(const uint32_t user_currency_name = CURRENCY_RUB) :
-            currency_name(user_currency_name) {
+        inline static const int check_minute_day(const uint32_t &minute_day) {
+            uint32_t hour = minute_day/xtime::MINUTES_IN_HOUR;
+            /* нельзя открывать сделки с 0 часов по МСК до 4
+             * или 1 по UTC
+             */
+            if(hour >= 21 || hour < 1) return PayoutCancelType::NIGHT_HOURS;
+            return ErrorType::OK;
+        }
+
+        /** \brief Получить встроенный календарь торговли
+         *
+         * Суббота, воскресенье, 1 января и 25 декабря закрыты, сессия с SESSION_BEGIN_HOUR до SESSION_END_HOUR UTC.
+         * \return Календарь торговли
+         */
+        inline static const TradingCalendar &get_default_calendar() {
+            static const TradingCalendar default_calendar(
+                SESSION_BEGIN_HOUR * xtime::SECONDS_IN_HOUR, SESSION_END_HOUR * xtime::SECONDS_IN_HOUR);
+            return default_calendar;
+        }
+
+        /** \brief Получить календарь встроенной сессии
+         *
+         * Сессия с SESSION_BEGIN_HOUR до SESSION_END_HOUR UTC, закрытых дней нет.
+         * Модель без календаря торговли считает выплаты по этому календарю.
+         * \return Календарь торговли
+         */
+        inline static const TradingCalendar &get_session_calendar() {
+            static const TradingCalendar session_calendar = TradingCalendar::make_session_calendar(
+                SESSION_BEGIN_HOUR * xtime::SECONDS_IN_HOUR, SESSION_END_HOUR * xtime::SECONDS_IN_HOUR);
+            return session_calendar;
+        }
+
+        /** \brief Проверить метку времени
+         * Данный метод проверяет, разрешает ли брокер торговлю в данное время
+         * \param timestamp Метка времени
+         * \param user_calendar Календарь торговли (по умолчанию встроенный)
+         * \return Вернет PayoutCancelType::OK если торговать можно, иначе код ошибки
+         */
+        inline static const int check_timestamp(
+                const xtime::timestamp_t &timestamp,
+                const TradingCalendar &user_calendar = get_default_calendar()) {
+            /* выходные и праздники берутся из битовой маски календаря */
+            if(user_calendar.is_closed_day(timestamp)) return PayoutCancelType::DAY_OFF;
+
+            const uint32_t weekday = xtime::get_weekday(timestamp);
+            const uint32_t second_day = (uint32_t)(timestamp % xtime::SECONDS_IN_DAY);
+
+            /* пропускаем 0 час по UTC в понедельник */
+            if(weekday == xtime::MON && second_day < xtime::SECONDS_IN_HOUR)
+                return PayoutCancelType::FXCM_MON;
+
+            /* Если операция выполнена вне торговой сессии (по умолчанию после 21:00 по Гринвичу до 01:00) */
+            if(!user_calendar.is_session(weekday, second_day)) return PayoutCancelType::NIGHT_HOURS;
+            return ErrorType::OK;
+        }
+
+        /** \brief Проверить метку времени курсора календаря
+         * Данный метод проверяет, разрешает ли брокер торговлю в данное время
+         * \param cursor Курсор календаря
+         * \param user_calendar Календарь торговли (по умолчанию встроенный)
+         * \return Вернет PayoutCancelType::OK если торговать можно, иначе код ошибки
+         */
+        inline static const int check_timestamp(
+                const CalendarCursor &cursor,
+                const TradingCalendar &user_calendar = get_default_calendar()) {
+            if(user_calendar.is_closed_day(cursor.get_timestamp())) return PayoutCancelType::DAY_OFF;
+            const uint32_t weekday = cursor.get_weekday();
+            const uint32_t second_day = cursor.get_second_day();
+            if(weekday == xtime::MON && second_day < xtime::SECONDS_IN_HOUR) return PayoutCancelType::FXCM_MON;
+            if(!user_calendar.is_session(weekday, second_day)) return PayoutCancelType::NIGHT_HOURS;
+            return ErrorType::OK;
+        }
+
+        /** \brief Проверить длительность опциона для валютной пары
+         * \param duration Длительность опциона в секундах
+         * \param currency_pair_index Номер валютной пары из списка валютных пар брокера
+         * \param user_rules Правила выплат (по умолчанию встроенные)
+         * \return Вернет PayoutCancelType::OK если брокер принимает опцион такой длительности, иначе код ошибки
+         */
+        inline static const int check_duration(
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const IntradeBarRules &user_rules = IntradeBarRules::get_default()) {
+            if(duration == 60) {
+                if(currency_pair_index >= INTRADE_BAR_CURRENCY_PAIRS ||
+                    !user_rules.is_currency_pairs_1m_exp[currency_pair_index])
+                    return PayoutCancelType::TOO_LITTLE_TIME;
+            } else
+            if(duration < 180) return PayoutCancelType::TOO_LITTLE_TIME;
+            if(duration > MAX_DURATION) return PayoutCancelType::TOO_MUCH_TIME;
+            if(currency_pair_index >= INTRADE_BAR_CURRENCY_PAIRS ||
+                !user_rules.is_currency_pairs[currency_pair_index])
+                return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
+            return ErrorType::OK;
+        }
+
+        /** \brief Получить торговое окно
+         *
+         * Находит ближайший промежуток времени [window_begin, window_end), в течение которого
+         * брокер принимает сделку указанной длительности с ненулевой выплатой: день не закрыт в календаре,
+         * время внутри сессии календаря и экспирация не позже конца сессии (см. check_timestamp и EXIT_OVER_END_DAY).
+         * Ставка считается ниже порога повышенной выплаты, поэтому для длительностей 181-239 секунд
+         * окна - минуты выплаты 60% в начале и конце часа (см. calc_payout). Для ставки и календаря модели
+         * используйте метод get_trade_window экземпляра модели.
+         * Если метка времени уже внутри окна, window_begin равен timestamp.
+         * Закрытые дни пропускаются целиком, без перебора минут.
+         * \param[out] window_begin Первая метка времени, в которую сделка будет принята
+         * \param[out] window_end Конец окна (первая метка времени после окна, в которую сделка не принимается)
+         * \param[in] timestamp Метка времени, с которой начинается поиск
+         * \param[in] duration Длительность опциона в секундах
+         * \param[in] currency_pair_index Номер валютной пары из списка валютных пар брокера
+         * \param[in] user_rules Правила выплат (по умолчанию встроенные)
+         * \param[in] user_calendar Календарь торговли (по умолчанию встроенный)
+         * \return Вернет PayoutCancelType::OK или код ошибки, если сделка не будет принята никогда
+         */
+        inline static const int get_trade_window(
+                xtime::timestamp_t &window_begin,
+                xtime::timestamp_t &window_end,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const IntradeBarRules &user_rules = IntradeBarRules::get_default(),
+                const TradingCalendar &user_calendar = get_default_calendar()) {
+            return find_trade_window(window_begin, window_end, timestamp, duration, currency_pair_index, 0.0,
+                &user_rules, -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity(), user_calendar);
+        }
+
+        /** \brief Получить максимальную длительность опциона
+         *
+         * Учитывает только время до конца сессии календаря, без валютной пары и ставки
+         * (см. get_max_duration экземпляра модели).
+         * \param timestamp Метка времени
+         * \param user_calendar Календарь торговли (по умолчанию встроенный)
+         * \return Максимальная длительность опциона в секундах, которую брокер примет в данное время, или 0, если торговля закрыта
+         */
+        inline static const uint32_t get_max_duration(
+                const xtime::timestamp_t timestamp,
+                const TradingCalendar &user_calendar = get_default_calendar()) {
+            const CalendarCursor cursor(timestamp);
+            if(check_timestamp(cursor, user_calendar) != ErrorType::OK) return 0;
+            return std::min(MAX_DURATION, user_calendar.get_session_end(cursor.get_weekday()) - cursor.get_second_day());
+        }
+
+        /** \brief Получить следующую границу, на которой может измениться выплата
+         *
+         * Выплата постоянна между началом часа, 3-й и 57-й минутой часа, началом и концом сессии
+         * и секундой, начиная с которой экспирация выходит за конец сессии. Не на каждой границе выплата меняется,
+         * соседние отрезки с одинаковой выплатой объединяет PayoutSegmentIterator.
+         * \param timestamp Метка времени
+         * \param duration Длительность опциона в секундах
+         * \param user_calendar Календарь сессий (по умолчанию встроенная сессия, см. get_model_calendar)
+         * \return Ближайшая граница больше timestamp
+         */
+        inline static const xtime::timestamp_t get_next_payout_boundary(
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const TradingCalendar &user_calendar = get_session_calendar()) {
+            const uint32_t second_hour = (uint32_t)(timestamp % xtime::SECONDS_IN_HOUR);
+            const uint32_t next_second_hour =
+                second_hour < 3 * xtime::SECONDS_IN_MINUTE ? 3 * xtime::SECONDS_IN_MINUTE :
+                second_hour < 57 * xtime::SECONDS_IN_MINUTE ? 57 * xtime::SECONDS_IN_MINUTE : xtime::SECONDS_IN_HOUR;
+            xtime::timestamp_t next = timestamp - second_hour + next_second_hour;
+            const xtime::timestamp_t first_timestamp_day = timestamp - timestamp % xtime::SECONDS_IN_DAY;
+            const uint32_t weekday = xtime::get_weekday(timestamp);
+            const uint32_t end = user_calendar.get_session_end(weekday);
+            const xtime::timestamp_t bounds[] = {
+                first_timestamp_day + user_calendar.get_session_begin(weekday),
+                first_timestamp_day + end,
+                duration <= end ? first_timestamp_day + end - duration + 1 : 0};
+            for(const xtime::timestamp_t bound : bounds) {
+                if(bound > timestamp && bound < next) next = bound;
+            }
+            return next;
+        }
+
+        /** \brief Получить процент выплат
+         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
+         * \param[out] payout процент выплат
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] amount размер ставки бинарного опциона
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline const int get_payout(
+                double &payout,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double amount) const {
+            if(is_closed_day(timestamp)) {
+                payout = 0.0;
+                return count_call(PayoutCancelType::DAY_OFF, currency_pair_index, timestamp);
+            }
+            return count_call(calc_payout(payout, rules, min_amount, threshold_amount, *sessions, TimestampCalendar(timestamp), duration, currency_pair_index, amount),
+                currency_pair_index, timestamp);
+        }
+
+        /** \brief Получить процент выплат
+         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
+         * \param[out] payout процент выплат
+         * \param[in] cursor курсор календаря, установленный на время сделки
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] amount размер ставки бинарного опциона
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline const int get_payout(
+                double &payout,
+                const CalendarCursor &cursor,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double amount) const {
+            if(is_closed_day(cursor.get_timestamp())) {
+                payout = 0.0;
+                return count_call(PayoutCancelType::DAY_OFF, currency_pair_index, cursor);
+            }
+            return count_call(calc_payout(payout, rules, min_amount, threshold_amount, *sessions, cursor, duration, currency_pair_index, amount),
+                currency_pair_index, cursor);
+        }
+
+        /** \brief Получить процент выплат
+         *
+         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
+         * \param[out] payout процент выплат
+         * \param[in] currency_pair Имя валютной пары
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] amount размер ставки бинарного опциона
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline const int get_payout(
+                double &payout,
+                const std::string_view currency_pair,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const double amount) const {
+            const uint32_t index = intrade_bar_currency_pairs_hash.find(currency_pair);
+            if(index >= INTRADE_BAR_CURRENCY_PAIRS) return count_call(PayoutCancelType::CURRENCY_PAIR_IS_MISSING, index, timestamp);
+            if(!rules->is_currency_pairs[index]) return count_call(PayoutCancelType::CURRENCY_PAIR_IS_MISSING, index, timestamp);
+            return get_payout(payout, timestamp, duration, index, amount);
+        }
+
+        /** \brief Получить проценты выплат для массива сделок
+         *
+         * Пакетная версия get_payout для массивов структуры SoA.
+         * При наличии AVX2 или SSE4.1 основная часть массива обрабатывается векторно,
+         * остаток - скалярным методом get_payout. Результаты совпадают со скалярным методом.
+         * Метки времени должны быть меньше 2^52.
+         * \param[out] payout Массив процентов выплат
+         * \param[out] err Массив состояний выплат (0 в случае успеха, иначе см. PayoutCancelType)
+         * \param[in] timestamp Массив временных меток unix времени (GMT)
+         * \param[in] duration Массив длительностей опционов в секундах
+         * \param[in] currency_pair_index Массив номеров валютных пар из списка валютных пар брокера
+         * \param[in] amount Массив размеров ставок
+         * \param[in] size Количество сделок
+         */
+        inline void get_payout(
+                double *payout,
+                int *err,
+                const xtime::timestamp_t *timestamp,
+                const uint32_t *duration,
+                const uint32_t *currency_pair_index,
+                const double *amount,
+                const size_t size) const {
+            size_t i = 0;
+#           if defined(PAYOUT_MODEL_SIMD)
+            if(is_default_session() && (currency_name == CURRENCY_USD || currency_name == CURRENCY_RUB)) {
+                typedef simd::VDouble V;
+                const V v_min_amount = V::set1(min_amount);
+                const V v_threshold_amount = V::set1(threshold_amount);
+                const V zero = V::set1(0.0);
+                for(; i + V::size <= size; i += V::size) {
+                    /* флаги валютных пар загружаются поэлементно */
+                    uint32_t pair_enabled[V::size];
+                    uint32_t pair_1m_exp[V::size];
+                    for(size_t k = 0; k < V::size; ++k) {
+                        const uint32_t index = currency_pair_index[i + k];
+                        pair_enabled[k] = index < INTRADE_BAR_CURRENCY_PAIRS && rules->is_currency_pairs[index] ? 1 : 0;
+                        pair_1m_exp[k] = index < INTRADE_BAR_CURRENCY_PAIRS && rules->is_currency_pairs_1m_exp[index] ? 1 : 0;
+                    }
+                    const V v_timestamp = V::load_u64(timestamp + i);
+                    const V v_duration = V::load_u32(duration + i);
+                    const V v_amount = V::load(amount + i);
+                    const V is_missing = V::load_u32(pair_enabled) == zero;
+                    const V is_no_1m_exp = V::load_u32(pair_1m_exp) == zero;
+
+                    const V day = simd::floor_div(v_timestamp, xtime::SECONDS_IN_DAY);
+                    const V second_day = v_timestamp - day * V::set1(xtime::SECONDS_IN_DAY);
+                    const V hour = simd::floor_div(second_day, xtime::SECONDS_IN_HOUR);
+                    const V minute = simd::floor_div(second_day, xtime::SECONDS_IN_MINUTE) - hour * V::set1(xtime::MINUTES_IN_HOUR);
+                    const V week_day = day + V::set1(xtime::THU);
+                    const V weekday = week_day - simd::floor_div(week_day, xtime::DAYS_IN_WEEK) * V::set1(xtime::DAYS_IN_WEEK);
+
+                    const V is_60 = v_duration == V::set1(60);
+                    const V is_180 = v_duration == V::set1(180);
+                    const V is_long = (v_duration >= V::set1(240)) & (v_duration <= V::set1(30000));
+                    const V is_high = v_amount >= v_threshold_amount;
+
+                    const V is_exit = (second_day + v_duration) > V::set1(21 * xtime::SECONDS_IN_HOUR);
+                    const V is_little_time = (is_60 & is_no_1m_exp) | andnot(is_60, v_duration < V::set1(180));
+                    const V is_much_time = v_duration > V::set1(30000);
+                    const V is_little_money = v_amount < v_min_amount;
+                    const V is_day_off = (weekday == V::set1(xtime::SAT)) | (weekday == V::set1(xtime::SUN));
+                    const V is_fxcm = (weekday == V::set1(xtime::MON)) & (hour == zero);
+                    const V is_night = (hour >= V::set1(21)) | (hour < V::set1(1));
+                    const V is_edge =
+                        (((hour <= V::set1(6)) | (hour >= V::set1(14))) &
+                        ((minute >= V::set1(57)) | (minute <= V::set1(2)))) |
+                        ((hour == V::set1(13)) & (minute >= V::set1(57)));
+                    const V is_valid_expiration = is_edge | is_high | is_60 | is_180 | is_long;
+
+                    /* коды ошибок назначаются от младшего приоритета к старшему */
+                    V code = select(is_valid_expiration, zero, V::set1(PayoutCancelType::EXPIRATION_ERROR));
+                    code = select(is_night, V::set1(PayoutCancelType::NIGHT_HOURS), code);
+                    code = select(is_fxcm, V::set1(PayoutCancelType::FXCM_MON), code);
+                    code = select(is_day_off, zero, code);
+                    code = select(is_little_money, V::set1(PayoutCancelType::TOO_LITTLE_MONEY), code);
+                    code = select(is_missing, V::set1(PayoutCancelType::CURRENCY_PAIR_IS_MISSING), code);
+                    code = select(is_much_time, V::set1(PayoutCancelType::TOO_MUCH_TIME), code);
+                    code = select(is_little_time, V::set1(PayoutCancelType::TOO_LITTLE_TIME), code);
+                    code = select(is_exit, V::set1(PayoutCancelType::EXIT_OVER_END_DAY), code);
+
+                    const V value = select(is_edge,
+                        select(is_high, V::set1(rules->high_payout_60), V::set1(rules->low_payout_60)),
+                        select(is_high,
+                            select(is_60, V::set1(rules->high_payout_60), V::set1(rules->high_payout)),
+                            select(is_60, V::set1(rules->low_payout_60), select(is_180, V::set1(rules->low_payout_180), V::set1(rules->low_payout_240)))));
+                    const V is_zero = (code != zero) | is_day_off;
+                    andnot(is_zero, value).store(payout + i);
+                    code.store_i32(err + i);
+                }
+            }
+#           endif
+            /* векторная часть не проверяет календарь торговли */
+            if(calendar) {
+                for(size_t k = 0; k < i; ++k) {
+                    if(!calendar->is_closed_day(timestamp[k])) continue;
+                    payout[k] = 0.0;
+                    err[k] = PayoutCancelType::DAY_OFF;
+                }
+            }
+#           if defined(PAYOUT_MODEL_STATS)
+            for(size_t k = 0; k < i; ++k) count_call(err[k], currency_pair_index[k], timestamp[k]);
+#           endif
+            for(; i < size; ++i) {
+                err[i] = get_payout(payout[i], timestamp[i], duration[i], currency_pair_index[i], amount[i]);
+            }
+        }
+
+        /** \brief Получить абсолютный размер ставки и процент выплат
+         *
+         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
+         * \param[out] amount размер ставки бинарного опциона
+		 * \param[out] payout процент выплат
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] balance Размер депозита
+		 * \param[in] winrate Винрейт
+		 * \param[in] attenuator Коэффициент ослабления Келли
+		 * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+		 * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline const int get_amount(
+                double &amount,
+                double &payout,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter = 1.0,
+                const double winrate_limiter = 1.0) const {
+            if(is_closed_day(timestamp)) {
+                amount = payout = 0.0;
+                PAYOUT_MODEL_AMOUNT_TRACE(AmountTracer::begin();
+                    AmountTracer::push(PayoutCancelType::DAY_OFF, timestamp, duration, currency_pair_index, amount));
+                return count_call(PayoutCancelType::DAY_OFF, currency_pair_index, timestamp);
+            }
+            const int err = calc_amount(amount, payout, rules, min_amount, threshold_amount, *sessions, TimestampCalendar(timestamp), duration, currency_pair_index, balance,
+                winrate, attenuator, payout_limiter, winrate_limiter);
+            PAYOUT_MODEL_AMOUNT_TRACE(AmountTracer::push(err, timestamp, duration, currency_pair_index, amount));
+            return count_call(err, currency_pair_index, timestamp);
+        }
+
+        /** \brief Получить абсолютный размер ставки и процент выплат
+         *
+         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
+         * \param[out] amount размер ставки бинарного опциона
+		 * \param[out] payout процент выплат
+         * \param[in] cursor курсор календаря, установленный на время сделки
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] balance Размер депозита
+		 * \param[in] winrate Винрейт
+		 * \param[in] attenuator Коэффициент ослабления Келли
+		 * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+		 * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline const int get_amount(
+                double &amount,
+                double &payout,
+                const CalendarCursor &cursor,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter = 1.0,
+                const double winrate_limiter = 1.0) const {
+            if(is_closed_day(cursor.get_timestamp())) {
+                amount = payout = 0.0;
+                PAYOUT_MODEL_AMOUNT_TRACE(AmountTracer::begin();
+                    AmountTracer::push(PayoutCancelType::DAY_OFF, cursor.get_timestamp(), duration, currency_pair_index, amount));
+                return count_call(PayoutCancelType::DAY_OFF, currency_pair_index, cursor);
+            }
+            const int err = calc_amount(amount, payout, rules, min_amount, threshold_amount, *sessions, cursor, duration, currency_pair_index, balance,
+                winrate, attenuator, payout_limiter, winrate_limiter);
+            PAYOUT_MODEL_AMOUNT_TRACE(AmountTracer::push(err, cursor.get_timestamp(), duration, currency_pair_index, amount));
+            return count_call(err, currency_pair_index, cursor);
+        }
+
+        /** \brief Получить абсолютный размер ставки и процент выплат
+         *
+         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
+         * \param[out] amount размер ставки бинарного опциона
+		 * \param[out] payout процент выплат
+         * \param[in] currency_pair Имя валютной пары
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] balance Размер депозита
+		 * \param[in] winrate Винрейт
+		 * \param[in] attenuator Коэффициент ослабления Келли
+		 * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+		 * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline const int get_amount(
+                double &amount,
+                double &payout,
+                const std::string_view currency_pair,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter = 1.0,
+                const double winrate_limiter = 1.0) const {
+            /* отсутствующий символ передается неверным индексом,
+             * чтобы сохранить порядок проверок
+             */
+            const uint32_t index = intrade_bar_currency_pairs_hash.find(currency_pair);
+            return get_amount(amount, payout, timestamp, duration, index, balance,
+                winrate, attenuator, payout_limiter, winrate_limiter);
+        }
+
+        /** \brief Получить размеры ставок и проценты выплат для массива сигналов
+         *
+         * Пакетная версия get_amount для массивов структуры SoA.
+         * Ветви выбора уровня выплат вычисляются без переходов для всех элементов вектора,
+         * остаток массива обрабатывается скалярным методом get_amount (с PAYOUT_MODEL_TRACE - весь массив).
+         * Результаты совпадают со скалярным методом. Метки времени должны быть меньше 2^52.
+         * \param[out] amount Массив размеров ставок
+         * \param[out] payout Массив процентов выплат
+         * \param[out] err Массив состояний выплат (0 в случае успеха, иначе см. PayoutCancelType)
+         * \param[in] timestamp Массив временных меток unix времени (GMT)
+         * \param[in] duration Массив длительностей опционов в секундах
+         * \param[in] currency_pair_index Массив номеров валютных пар из списка валютных пар брокера
+         * \param[in] balance Массив размеров депозита
+         * \param[in] winrate Массив винрейтов
+         * \param[in] attenuator Массив коэффициентов ослабления Келли
+         * \param[in] payout_limiter Массив ограничителей процента выплат (nullptr - не используется)
+         * \param[in] winrate_limiter Массив ограничителей винрейта (nullptr - не используется)
+         * \param[in] size Количество сигналов
+         */
+        inline void get_amount(
+                double *amount,
+                double *payout,
+                int *err,
+                const xtime::timestamp_t *timestamp,
+                const uint32_t *duration,
+                const uint32_t *currency_pair_index,
+                const double *balance,
+                const double *winrate,
+                const double *attenuator,
+                const double *payout_limiter,
+                const double *winrate_limiter,
+                const size_t size) const {
+            size_t i = 0;
+            /* с трассировкой все элементы рассчитываются скалярным методом, чтобы каждая ставка попала в буфер */
+#           if defined(PAYOUT_MODEL_SIMD) && !defined(PAYOUT_MODEL_TRACE)
+            if(is_default_session() && (currency_name == CURRENCY_USD || currency_name == CURRENCY_RUB)) {
+                typedef simd::VDouble V;
+                const V v_min_amount = V::set1(min_amount);
+                const V v_threshold_amount = V::set1(threshold_amount);
+                const V zero = V::set1(0.0);
+                const V one = V::set1(1.0);
+                const V code_winrate = V::set1(PayoutCancelType::TOO_LITTLE_WINRATE);
+                const V code_money = V::set1(PayoutCancelType::TOO_LITTLE_MONEY);
+                for(; i + V::size <= size; i += V::size) {
+                    /* флаги валютных пар загружаются поэлементно */
+                    uint32_t pair_enabled[V::size];
+                    uint32_t pair_1m_exp[V::size];
+                    for(size_t k = 0; k < V::size; ++k) {
+                        const uint32_t index = currency_pair_index[i + k];
+                        pair_enabled[k] = index < INTRADE_BAR_CURRENCY_PAIRS && rules->is_currency_pairs[index] ? 1 : 0;
+                        pair_1m_exp[k] = index < INTRADE_BAR_CURRENCY_PAIRS && rules->is_currency_pairs_1m_exp[index] ? 1 : 0;
+                    }
+                    const V v_timestamp = V::load_u64(timestamp + i);
+                    const V v_duration = V::load_u32(duration + i);
+                    const V v_balance = V::load(balance + i);
+                    const V v_winrate = V::load(winrate + i);
+                    const V v_attenuator = V::load(attenuator + i);
+                    const V v_payout_limiter = payout_limiter ? V::load(payout_limiter + i) : one;
+                    const V v_winrate_limiter = winrate_limiter ? V::load(winrate_limiter + i) : one;
+                    const V is_missing = V::load_u32(pair_enabled) == zero;
+                    const V is_no_1m_exp = V::load_u32(pair_1m_exp) == zero;
+
+                    const V day = simd::floor_div(v_timestamp, xtime::SECONDS_IN_DAY);
+                    const V second_day = v_timestamp - day * V::set1(xtime::SECONDS_IN_DAY);
+                    const V hour = simd::floor_div(second_day, xtime::SECONDS_IN_HOUR);
+                    const V minute = simd::floor_div(second_day, xtime::SECONDS_IN_MINUTE) - hour * V::set1(xtime::MINUTES_IN_HOUR);
+                    const V week_day = day + V::set1(xtime::THU);
+                    const V weekday = week_day - simd::floor_div(week_day, xtime::DAYS_IN_WEEK) * V::set1(xtime::DAYS_IN_WEEK);
+
+                    const V is_60 = v_duration == V::set1(60);
+                    const V is_180 = v_duration == V::set1(180);
+                    const V is_long = (v_duration >= V::set1(240)) & (v_duration <= V::set1(30000));
+                    const V is_edge = is_60 |
+                        (((hour <= V::set1(6)) | (hour >= V::set1(14))) &
+                        ((minute >= V::set1(57)) | (minute <= V::set1(2)))) |
+                        ((hour == V::set1(13)) & (minute >= V::set1(57)));
+
+                    /* выплаты нижнего и верхнего уровня для ветви каждого элемента */
+                    const V low_payout = select(is_edge, V::set1(rules->low_payout_60), select(is_180, V::set1(rules->low_payout_180), V::set1(rules->low_payout_240)));
+                    const V high_payout = select(is_edge, V::set1(rules->high_payout_60), V::set1(rules->high_payout));
+                    const V calc_winrate = select(v_winrate < v_winrate_limiter, v_winrate, v_winrate_limiter);
+                    const V calc_low_payout = select(low_payout < v_payout_limiter, low_payout, v_payout_limiter);
+                    const V calc_high_payout = select(high_payout < v_payout_limiter, high_payout, v_payout_limiter);
+                    const V low_rate = (((one + calc_low_payout) * calc_winrate - one) / calc_low_payout) * v_attenuator;
+                    const V high_rate = (((one + calc_high_payout) * calc_winrate - one) / calc_high_payout) * v_attenuator;
+                    const V low_amount = v_balance * low_rate;
+                    const V high_amount = v_balance * high_rate;
+                    const V is_low_little_money = low_amount < v_min_amount;
+                    const V is_high_little_money = high_amount < v_min_amount;
+
+                    /* ветвь 60% - 63%: сначала расчет по нижнему уровню */
+                    const V is_edge_winrate = (v_winrate <= V::set1(rules->low_winrate_60)) | (calc_winrate <= V::set1(rules->low_winrate_60));
+                    const V is_edge_high = low_amount >= v_threshold_amount;
+                    const V is_edge_high_winrate = (v_winrate <= V::set1(rules->high_winrate_60)) | (calc_winrate <= V::set1(rules->high_winrate_60));
+                    V edge_code = select(is_edge_high & is_edge_high_winrate, code_winrate, zero);
+                    V edge_payout = select(is_edge_high, high_payout, low_payout);
+                    V edge_amount = select(is_edge_high & ~is_edge_high_winrate, high_amount, low_amount);
+                    edge_code = select(is_low_little_money, code_money, edge_code);
+                    edge_payout = select(is_low_little_money, low_payout, edge_payout);
+                    edge_amount = andnot(is_low_little_money, edge_amount);
+                    edge_code = select(is_edge_winrate, code_winrate, edge_code);
+                    edge_payout = select(is_edge_winrate, low_payout, edge_payout);
+                    edge_amount = andnot(is_edge_winrate, edge_amount);
+
+                    /* ветви 82% / 79% - 85%: сначала расчет по верхнему уровню */
+                    const V is_first_winrate = (v_winrate <= V::set1(rules->high_winrate)) |
+                        (calc_winrate <= select(is_180, V::set1(rules->high_winrate), V::set1(rules->low_winrate_180)));
+                    const V is_high = high_amount >= v_threshold_amount;
+                    const V is_second_winrate = (v_winrate <= select(is_180, V::set1(rules->low_winrate_180), V::set1(rules->low_winrate_240))) |
+                        (calc_winrate <= V::set1(rules->low_winrate_180));
+                    V main_code = select(is_low_little_money, code_money, zero);
+                    V main_payout = low_payout;
+                    V main_amount = andnot(is_low_little_money, low_amount);
+                    main_code = select(is_second_winrate, code_winrate, main_code);
+                    main_payout = andnot(is_second_winrate, main_payout);
+                    main_amount = andnot(is_second_winrate, main_amount);
+                    main_code = select(is_high, select(is_high_little_money, code_money, zero), main_code);
+                    main_payout = select(is_high, high_payout, main_payout);
+                    main_amount = select(is_high, andnot(is_high_little_money, high_amount), main_amount);
+                    main_code = select(is_first_winrate, code_winrate, main_code);
+                    main_payout = andnot(is_first_winrate, main_payout);
+                    main_amount = andnot(is_first_winrate, main_amount);
+
+                    const V is_expiration_error = ~(is_edge | is_180 | is_long);
+                    V code = select(is_edge, edge_code, main_code);
+                    V value = select(is_edge, edge_payout, main_payout);
+                    V size_value = select(is_edge, edge_amount, main_amount);
+
+                    /* проверки до расчета ставки назначаются от младшего приоритета к старшему */
+                    const V is_exit = (second_day + v_duration) > V::set1(21 * xtime::SECONDS_IN_HOUR);
+                    const V is_much_time = v_duration > V::set1(30000);
+                    const V is_little_time = (is_60 & is_no_1m_exp) | andnot(is_60, v_duration < V::set1(180));
+                    const V is_day_off = (weekday == V::set1(xtime::SAT)) | (weekday == V::set1(xtime::SUN));
+                    const V is_fxcm = (weekday == V::set1(xtime::MON)) & (hour == zero);
+                    const V is_night = (hour >= V::set1(21)) | (hour < V::set1(1));
+                    code = select(is_expiration_error, V::set1(PayoutCancelType::EXPIRATION_ERROR), code);
+                    code = select(is_night, V::set1(PayoutCancelType::NIGHT_HOURS), code);
+                    code = select(is_fxcm, V::set1(PayoutCancelType::FXCM_MON), code);
+                    code = select(is_day_off, zero, code);
+                    code = select(is_little_time, V::set1(PayoutCancelType::TOO_LITTLE_TIME), code);
+                    code = select(is_missing, V::set1(PayoutCancelType::CURRENCY_PAIR_IS_MISSING), code);
+                    code = select(is_much_time, V::set1(PayoutCancelType::TOO_MUCH_TIME), code);
+                    code = select(is_exit, V::set1(PayoutCancelType::EXIT_OVER_END_DAY), code);
+                    const V is_rejected = is_exit | is_much_time | is_missing | is_little_time |
+                        is_day_off | is_fxcm | is_night | is_expiration_error;
+
+                    andnot(is_rejected, size_value).store(amount + i);
+                    andnot(is_rejected, value).store(payout + i);
+                    code.store_i32(err + i);
+                }
+            }
+#           endif
+            /* векторная часть не проверяет календарь торговли */
+            if(calendar) {
+                for(size_t k = 0; k < i; ++k) {
+                    if(!calendar->is_closed_day(timestamp[k])) continue;
+                    amount[k] = payout[k] = 0.0;
+                    err[k] = PayoutCancelType::DAY_OFF;
+                }
+            }
+#           if defined(PAYOUT_MODEL_STATS)
+            for(size_t k = 0; k < i; ++k) count_call(err[k], currency_pair_index[k], timestamp[k]);
+#           endif
+            for(; i < size; ++i) {
+                err[i] = get_amount(amount[i], payout[i], timestamp[i], duration[i], currency_pair_index[i],
+                    balance[i], winrate[i], attenuator[i],
+                    payout_limiter ? payout_limiter[i] : 1.0,
+                    winrate_limiter ? winrate_limiter[i] : 1.0);
+            }
+        }
+
+        /** \brief Найти длительность опциона с наибольшим ростом депозита
+         *
+         * Рассчитывает ставку для всех длительностей из списка за один проход
+         * и выбирает длительность с наибольшим ожидаемым логарифмическим ростом депозита
+         * (см. get_log_growth). Учитываются TOO_LITTLE_TIME, EXIT_OVER_END_DAY и список
+         * валютных пар с экспирацией 1 минута. При равном росте выбирается длительность, которая идет раньше в списке.
+         * \param[out] duration Длительность опциона в секундах (0, если сделку открывать не нужно)
+         * \param[out] amount размер ставки бинарного опциона
+         * \param[out] payout процент выплат
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] balance Размер депозита
+         * \param[in] winrate Винрейт
+         * \param[in] attenuator Коэффициент ослабления Келли
+         * \param[in] durations Список длительностей опциона в секундах
+         * \param[in] durations_size Количество длительностей
+         * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+         * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         * \return 0, если длительность найдена, иначе состояние выплаты для первой длительности из списка (см. PayoutCancelType)
+         */
+        inline const int get_best_duration(
+                uint32_t &duration,
+                double &amount,
+                double &payout,
+                const xtime::timestamp_t timestamp,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const uint32_t *durations,
+                const size_t durations_size,
+                const double payout_limiter = 1.0,
+                const double winrate_limiter = 1.0) const {
+            if(is_closed_day(timestamp)) {
+                duration = 0;
+                amount = payout = 0.0;
+                return count_call(PayoutCancelType::DAY_OFF, currency_pair_index, timestamp);
+            }
+            return count_call(calc_best_duration(duration, amount, payout, rules, min_amount, threshold_amount, *sessions, TimestampCalendar(timestamp),
+                durations, durations_size, currency_pair_index, balance, winrate, attenuator, payout_limiter, winrate_limiter),
+                currency_pair_index, timestamp);
+        }
+
+        /** \brief Найти длительность опциона с наибольшим ростом депозита
+         *
+         * Версия get_best_duration для курсора календаря
+         * \param[out] duration Длительность опциона в секундах (0, если сделку открывать не нужно)
+         * \param[out] amount размер ставки бинарного опциона
+         * \param[out] payout процент выплат
+         * \param[in] cursor курсор календаря, установленный на время сделки
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] balance Размер депозита
+         * \param[in] winrate Винрейт
+         * \param[in] attenuator Коэффициент ослабления Келли
+         * \param[in] durations Список длительностей опциона в секундах
+         * \param[in] durations_size Количество длительностей
+         * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+         * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         * \return 0, если длительность найдена, иначе состояние выплаты для первой длительности из списка (см. PayoutCancelType)
+         */
+        inline const int get_best_duration(
+                uint32_t &duration,
+                double &amount,
+                double &payout,
+                const CalendarCursor &cursor,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const uint32_t *durations,
+                const size_t durations_size,
+                const double payout_limiter = 1.0,
+                const double winrate_limiter = 1.0) const {
+            if(is_closed_day(cursor.get_timestamp())) {
+                duration = 0;
+                amount = payout = 0.0;
+                return count_call(PayoutCancelType::DAY_OFF, currency_pair_index, cursor);
+            }
+            return count_call(calc_best_duration(duration, amount, payout, rules, min_amount, threshold_amount, *sessions, cursor,
+                durations, durations_size, currency_pair_index, balance, winrate, attenuator, payout_limiter, winrate_limiter),
+                currency_pair_index, cursor);
+        }
+
+        /** \brief Найти длительность опциона с наибольшим ростом депозита
+         *
+         * Ищет среди всех длительностей, которые принимает брокер: 60, 180, 240, 300, ..., 30000 секунд с шагом в минуту.
+         * \param[out] duration Длительность опциона в секундах (0, если сделку открывать не нужно)
+         * \param[out] amount размер ставки бинарного опциона
+         * \param[out] payout процент выплат
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] balance Размер депозита
+         * \param[in] winrate Винрейт
+         * \param[in] attenuator Коэффициент ослабления Келли
+         * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+         * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         * \return 0, если длительность найдена, иначе состояние выплаты для длительности 1 минута (см. PayoutCancelType)
+         */
+        inline const int get_best_duration(
+                uint32_t &duration,
+                double &amount,
+                double &payout,
+                const xtime::timestamp_t timestamp,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter = 1.0,
+                const double winrate_limiter = 1.0) const {
+            size_t size = 0;
+            const uint32_t *candidates = get_best_duration_candidates(size);
+            if(is_closed_day(timestamp)) {
+                duration = 0;
+                amount = payout = 0.0;
+                return count_call(PayoutCancelType::DAY_OFF, currency_pair_index, timestamp);
+            }
+            return count_call(calc_best_duration(duration, amount, payout, rules, min_amount, threshold_amount, *sessions, TimestampCalendar(timestamp),
+                candidates, size, currency_pair_index, balance, winrate, attenuator, payout_limiter, winrate_limiter),
+                currency_pair_index, timestamp);
+        }
+
+        /** \brief Найти длительность опциона с наибольшим ростом депозита
+         *
+         * Версия get_best_duration для курсора календаря и всех длительностей, которые принимает брокер
+         * \param[out] duration Длительность опциона в секундах (0, если сделку открывать не нужно)
+         * \param[out] amount размер ставки бинарного опциона
+         * \param[out] payout процент выплат
+         * \param[in] cursor курсор календаря, установленный на время сделки
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] balance Размер депозита
+         * \param[in] winrate Винрейт
+         * \param[in] attenuator Коэффициент ослабления Келли
+         * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+         * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         * \return 0, если длительность найдена, иначе состояние выплаты для длительности 1 минута (см. PayoutCancelType)
+         */
+        inline const int get_best_duration(
+                uint32_t &duration,
+                double &amount,
+                double &payout,
+                const CalendarCursor &cursor,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter = 1.0,
+                const double winrate_limiter = 1.0) const {
+            size_t size = 0;
+            const uint32_t *candidates = get_best_duration_candidates(size);
+            if(is_closed_day(cursor.get_timestamp())) {
+                duration = 0;
+                amount = payout = 0.0;
+                return count_call(PayoutCancelType::DAY_OFF, currency_pair_index, cursor);
+            }
+            return count_call(calc_best_duration(duration, amount, payout, rules, min_amount, threshold_amount, *sessions, cursor,
+                candidates, size, currency_pair_index, balance, winrate, attenuator, payout_limiter, winrate_limiter),
+                currency_pair_index, cursor);
+        }
+
+        /** \brief Получить имя валютной пары по ее номеру
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \return имя валютной пары либо пустую строку, если указанный индекс отсутствует в списке валютных пар
+         */
+        inline const static std::string_view get_currecy_pair_name(const uint32_t currency_pair_index) {
+            if(currency_pair_index < intrade_bar_currency_pairs.size())
+                return intrade_bar_currency_pairs[currency_pair_index];
+            return std::string_view();//Возврат пустой строки
+        };
+
+        /** \brief Установить рублевый счет или долларовый
+         * \param is_rub Рубли, если true. Иначе USD
+         */
+        void set_rub_account_currency(const bool is_rub) {
+            if(is_rub) currency_name = CURRENCY_RUB;
+            else currency_name = CURRENCY_USD;
+            update_amount_limits();
+        }
+
+        /** \brief Установить правила выплат
+         *
+         * Модель хранит указатель на правила, поэтому они должны существовать,
+         * пока модель их использует (например, пока открыта секция чтения RcuPointer).
+         * \param user_rules Правила выплат
+         */
+        inline void set_rules(const IntradeBarRules &user_rules) {
+            rules = &user_rules;
+            update_amount_limits();
+        }
+
+        /// Получить правила выплат
+        inline const IntradeBarRules &get_rules() const {
+            return *rules;
+        }
+
+        /** \brief Установить календарь торговли
+         *
+         * Если календарь задан, get_payout, get_amount и get_best_duration возвращают DAY_OFF
+         * для закрытых дней календаря (выходных и праздников) без разбора даты,
+         * а ночное время и конец экспирации (NIGHT_HOURS и EXIT_OVER_END_DAY) берутся из сессий календаря.
+         * Без календаря поведение прежнее: праздники не проверяются, в выходные выплата равна 0 без ошибки,
+         * сессия встроенная (см. get_session_calendar).
+         * Модель хранит указатель на календарь, поэтому он должен существовать, пока модель его использует.
+         * \param user_calendar Календарь торговли или nullptr
+         */
+        inline void set_calendar(const TradingCalendar *user_calendar) {
+            calendar = user_calendar;
+            sessions = calendar ? calendar : &get_session_calendar();
+        }
+
+        /// Получить календарь торговли или nullptr
+        inline const TradingCalendar *get_calendar() const {
+            return calendar;
+        }
+
+        /// Получить календарь модели или календарь встроенной сессии, если календарь не задан (как в get_payout)
+        inline const TradingCalendar &get_model_calendar() const {
+            return *sessions;
+        }
+
+        /// Получить минимальную ставку для валюты счета
+        inline const double get_min_amount() const {
+            return min_amount;
+        }
+
+        /// Получить порог повышенной выплаты для валюты счета
+        inline const double get_threshold_amount() const {
+            return threshold_amount;
+        }
+
+        /** \brief Получить торговое окно для ставки
+         *
+         * В отличие от статического метода учитывает правила, календарь и пороги ставок модели,
+         * поэтому внутри окна get_payout вернет ненулевую выплату без ошибки.
+         * Без календаря модели праздники не пропускаются, как и в get_payout.
+         * \param[out] window_begin Первая метка времени, в которую сделка будет принята
+         * \param[out] window_end Конец окна (первая метка времени после окна, в которую сделка не принимается)
+         * \param[in] timestamp Метка времени, с которой начинается поиск
+         * \param[in] duration Длительность опциона в секундах
+         * \param[in] currency_pair_index Номер валютной пары из списка валютных пар брокера
+         * \param[in] amount Размер ставки
+         * \return Вернет PayoutCancelType::OK или код ошибки, если сделка не будет принята никогда
+         */
+        inline const int get_trade_window(
+                xtime::timestamp_t &window_begin,
+                xtime::timestamp_t &window_end,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double amount) const {
+            return find_trade_window(window_begin, window_end, timestamp, duration, currency_pair_index, amount,
+                rules, min_amount, threshold_amount, get_model_calendar());
+        }
+
+        /** \brief Получить максимальную длительность опциона для ставки
+         * \param timestamp Метка времени
+         * \param currency_pair_index Номер валютной пары из списка валютных пар брокера
+         * \param amount Размер ставки
+         * \return Максимальная длительность опциона в секундах, для которой get_payout вернет ненулевую выплату, или 0
+         */
+        inline const uint32_t get_max_duration(
+                const xtime::timestamp_t timestamp,
+                const uint32_t currency_pair_index,
+                const double amount) const {
+            const TradingCalendar &user_calendar = get_model_calendar();
+            const CalendarCursor cursor(timestamp);
+            const uint32_t max_duration = get_max_duration(timestamp, user_calendar);
+            /* выплата не зависит от длительности, кроме 60, 180 и 181-239 секунд (см. calc_payout) */
+            const uint32_t durations[] = {max_duration, 180, 60};
+            for(const uint32_t duration : durations) {
+                if(duration > max_duration) continue;
+                if(is_trade_accepted(cursor, duration, currency_pair_index, amount,
+                    rules, min_amount, threshold_amount, user_calendar)) return duration;
+            }
+            return 0;
+        }
+
+        /** \brief Конструктор класса модели процентов выплат брокера intrade.bar
+         * \param user_currency_name Валюта счета, по умолчанию RUB
+         */
+        IntradeBar(const uint32_t user_currency_name = CURRENCY_RUB) :
+            currency_name(user_currency_name), rules(&IntradeBarRules::get_default()) {
+            update_amount_limits();
+        }
+
+        /** \brief Создать неизменяемый снимок модели для счета
+         *
+         * Снимок хранит валюту счета, правила выплат и вычисленные пороги ставок.
+         * Методы расчета выплат константные, поэтому один снимок можно
+         * использовать из нескольких потоков без блокировок.
+         * \param user_currency_name Валюта счета
+         * \param user_rules Правила выплат (по умолчанию встроенные)
+         * \param user_calendar Календарь торговли (по умолчанию закрытые дни не проверяются, см. set_calendar)
+         * \return Указатель на снимок модели
+         */
+        inline static std::shared_ptr<const IntradeBar> make_snapshot(
+                const uint32_t user_currency_name,
+                std::shared_ptr<const IntradeBarRules> user_rules = nullptr,
+                std::shared_ptr<const TradingCalendar> user_calendar = nullptr) {
+            std::shared_ptr<IntradeBar> model = std::make_shared<IntradeBar>(user_currency_name);
+            if(user_rules) {
+                model->rules_owner = std::move(user_rules);
+                model->set_rules(*model->rules_owner);
+            }
+            if(user_calendar) {
+                model->calendar_owner = std::move(user_calendar);
+                model->set_calendar(model->calendar_owner.get());
+            }
+            return model;
+        }
+
+        /** \brief Построить маски торговых минут недели
+         *
+         * Минута недели входит в маску, если сделка минимальной ставкой, открытая в начале минуты,
+         * имеет ненулевую выплату без ошибки. Закрытые дни календаря модели учитываются при запросах.
+         * Вызовы не попадают в счетчики статистики.
+         * \param durations Длительности опционов в секундах
+         * \return Маски торговых минут
+         */
+        PayoutTradability make_tradability(const std::vector<uint32_t> &durations = {60, 180, 300}) const {
+            const double amount = std::max(min_amount, 0.0);
+            return PayoutTradability(INTRADE_BAR_CURRENCY_PAIRS, durations, calendar,
+                    [&](const xtime::timestamp_t timestamp, const uint32_t duration, const uint32_t currency_pair_index) {
+                double payout = 0;
+                const int err = calc_payout(payout, rules, min_amount, threshold_amount, *sessions, TimestampCalendar(timestamp), duration, currency_pair_index, amount);
+                return err == ErrorType::OK && payout > 0;
+            });
         }
 
         ~IntradeBar() {}
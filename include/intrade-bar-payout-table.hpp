@@ -0,0 +1,296 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef INTRADE_BAR_PAYOUT_TABLE_HPP_INCLUDED
+#define INTRADE_BAR_PAYOUT_TABLE_HPP_INCLUDED
+
+#include "intrade-bar-payout-model.hpp"
+
+namespace payout_model {
+
+    /** \brief Табличная модель процентов выплат брокера Intrade.bar
+     *
+     * Таблица строится по эталонной модели IntradeBar и индексируется
+     * минутой недели, классом длительности опциона и уровнем ставки.
+     * Доступность валютной пары и экспирации 1 минута проверяются по
+     * отдельной таблице флагов пар, так как от пары зависит только допуск к торговле.
+     * Результаты побитово совпадают с IntradeBar::get_payout модели с теми же правилами (см. set_rules)
+     * и без календаря торговли.
+     */
+    class IntradeBarPayoutTable {
+    public:
+        typedef IntradeBar::PayoutCancelType PayoutCancelType;
+
+        /// Классы длительности опциона
+        enum DurationClass {
+            DURATION_60 = 0,            ///< Экспирация 1 минута
+            DURATION_180 = 1,           ///< Экспирация 3 минуты
+            DURATION_240_30000 = 2,     ///< Экспирация от 4 до 500 минут
+            DURATION_181_239 = 3,       ///< Экспирация между 3 и 4 минутами
+        };
+
+        /// Уровни размера ставки
+        enum AmountTier {
+            AMOUNT_BELOW_MIN = 0,       ///< Ставка меньше минимальной
+            AMOUNT_LOW = 1,             ///< Ставка меньше порога повышенной выплаты
+            AMOUNT_HIGH = 2,            ///< Ставка не меньше порога повышенной выплаты
+        };
+
+        static const uint32_t DURATION_CLASSES = 4;     ///< Количество классов длительности
+        static const uint32_t AMOUNT_TIERS = 3;         ///< Количество уровней ставки
+        static const uint32_t CELLS = DURATION_CLASSES * AMOUNT_TIERS;
+        static const uint32_t PAYOUT_VALUES = 8;        ///< Максимальное количество различных процентов выплат
+        static const uint32_t PAIR_FLAG_ENABLED = 0x01; ///< Валютная пара поддерживается брокером
+        static const uint32_t PAIR_FLAG_1M_EXP = 0x02;  ///< Валютная пара доступна для экспирации 1 минута
+
+        /// Коды ошибок построения таблицы
+        enum TableErrorType {
+            TABLE_TOO_MANY_PAYOUTS = -1,    ///< Различных процентов выплат больше PAYOUT_VALUES
+        };
+
+        /** \brief Данные таблицы
+         *
+         * Ячейка таблицы упакована в один байт: младшие 3 бита - номер процента выплат
+         * в массиве payouts, старшие 5 бит - код ошибки со знаком минус.
+         * Одинаковые строки минут недели хранятся один раз.
+         */
+        class Data {
+        public:
+            std::array<uint8_t, MINUTES_IN_WEEK> minute_row = {};   ///< Номер строки для каждой минуты недели
+            std::vector<std::array<uint8_t, CELLS>> rows;           ///< Уникальные строки таблицы (пусто, пока не вызван build)
+            std::array<double, PAYOUT_VALUES> payouts = {};         ///< Проценты выплат
+            std::array<uint8_t, INTRADE_BAR_CURRENCY_PAIRS + 1> pair_flags = {}; ///< Флаги валютных пар (последний элемент для неверного индекса)
+            IntradeBarRules rules;                              ///< Правила выплат, по которым построена таблица
+
+            /** \brief Построить таблицу по правилам выплат
+             *
+             * Номер процента выплат хранится в 3 битах ячейки, поэтому правила,
+             * дающие больше PAYOUT_VALUES различных процентов выплат, не поддерживаются.
+             * \param user_rules Правила выплат
+             * \return Вернет ErrorType::OK или TableErrorType::TABLE_TOO_MANY_PAYOUTS (данные таблицы не определены)
+             */
+            const int build(const IntradeBarRules &user_rules) {
+                rules = user_rules;
+                rows.clear();
+                payouts.fill(0.0);
+                uint32_t payouts_size = 1;
+                for(uint32_t i = 0; i < INTRADE_BAR_CURRENCY_PAIRS; ++i) {
+                    pair_flags[i] = (rules.is_currency_pairs[i] ? PAIR_FLAG_ENABLED : 0) |
+                        (rules.is_currency_pairs_1m_exp[i] ? PAIR_FLAG_1M_EXP : 0);
+                }
+                pair_flags[INTRADE_BAR_CURRENCY_PAIRS] = 0;
+
+                /* Минимальные длительности классов. Если запрос с длительностью класса
+                 * не выходит за конец дня, то и эталонный запрос с минимальной длительностью
+                 * в начале той же минуты тоже не выходит за конец дня
+                 */
+                const uint32_t class_duration[DURATION_CLASSES] = {60, 180, 240, 181};
+                /* Эталонная пара поддерживает все классы длительности, а уровни ставки
+                 * задаются собственными порогами, так как выплата от пары и порогов не зависит
+                 */
+                const uint32_t reference_pair = 0;
+                IntradeBarRules reference_rules = rules;
+                reference_rules.is_currency_pairs[reference_pair] = true;
+                reference_rules.is_currency_pairs_1m_exp[reference_pair] = true;
+                reference_rules.min_amount_rub = 1.0;
+                reference_rules.threshold_amount_rub = 2.0;
+                const double tier_amount[AMOUNT_TIERS] = {0.5, 1.0, 2.0};
+                /* 4 января 1970 года - воскресенье */
+                const xtime::timestamp_t first_timestamp_week = 3 * xtime::SECONDS_IN_DAY;
+
+                IntradeBar model(IntradeBar::CURRENCY_RUB);
+                model.set_rules(reference_rules);
+                for(uint32_t m = 0; m < MINUTES_IN_WEEK; ++m) {
+                    const xtime::timestamp_t timestamp = first_timestamp_week + m * xtime::SECONDS_IN_MINUTE;
+                    std::array<uint8_t, CELLS> row;
+                    for(uint32_t c = 0; c < DURATION_CLASSES; ++c) {
+                        for(uint32_t t = 0; t < AMOUNT_TIERS; ++t) {
+                            double payout = 0.0;
+                            const int err = model.get_payout(payout, timestamp, class_duration[c], reference_pair, tier_amount[t]);
+                            uint32_t p = 0;
+                            while(p < payouts_size && payouts[p] != payout) ++p;
+                            if(p == payouts_size) {
+                                /* номер процента выплат не должен попасть в биты кода ошибки */
+                                if(payouts_size == PAYOUT_VALUES) return TableErrorType::TABLE_TOO_MANY_PAYOUTS;
+                                payouts[payouts_size++] = payout;
+                            }
+                            row[c * AMOUNT_TIERS + t] = (uint8_t)(((-err) << 3) | p);
+                        }
+                    }
+                    uint32_t r = 0;
+                    while(r < rows.size() && rows[r] != row) ++r;
+                    if(r == rows.size()) rows.push_back(row);
+                    minute_row[m] = (uint8_t)r;
+                }
+                return ErrorType::OK;
+            }
+        };
+
+    private:
+        std::shared_ptr<const Data> data_owner; ///< Таблица, построенная по правилам set_rules
+        const Data *data;
+        bool is_rub = true;         ///< Рублевый счет
+        double min_amount;          ///< Минимальная ставка для валюты счета
+        double threshold_amount;    ///< Порог повышенной выплаты для валюты счета
+
+        /// Таблица по встроенным правилам, общая для всех объектов
+        inline static const Data &get_data() {
+            static const Data table_data = [](){
+                Data temp;
+                temp.build(IntradeBarRules::get_default());
+                return temp;
+            }();
+            return table_data;
+        }
+
+        /// Вычислить пороги ставок для валюты счета
+        inline void update_amount_limits() {
+            min_amount = is_rub ? data->rules.min_amount_rub : data->rules.min_amount_usd;
+            threshold_amount = is_rub ? data->rules.threshold_amount_rub : data->rules.threshold_amount_usd;
+        }
+
+    public:
+
+        /** \brief Получить минуту недели
+         * \param timestamp Метка времени
+         * \return Минута недели, начиная с воскресенья
+         */
+        inline static const uint32_t get_minute_week(const xtime::timestamp_t timestamp) {
+            return (uint32_t)((timestamp / xtime::SECONDS_IN_MINUTE +
+                xtime::THU * xtime::MINUTES_IN_DAY) % MINUTES_IN_WEEK);
+        }
+
+        /** \brief Получить процент выплат
+         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
+         * \param[out] payout процент выплат
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] amount размер ставки бинарного опциона
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline const int get_payout(
+                double &payout,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double amount) const {
+            payout = 0.0;
+            /* обрабатываем выход экспирации за конец дня */
+            if((timestamp % xtime::SECONDS_IN_DAY) + duration > 21 * xtime::SECONDS_IN_HOUR)
+                return PayoutCancelType::EXIT_OVER_END_DAY;
+
+            const uint32_t pair_flags = data->pair_flags[
+                currency_pair_index < INTRADE_BAR_CURRENCY_PAIRS ?
+                currency_pair_index : INTRADE_BAR_CURRENCY_PAIRS];
+
+            uint32_t duration_class = DURATION_60;
+            if(duration == 60) {
+                if(!(pair_flags & PAIR_FLAG_1M_EXP)) return PayoutCancelType::TOO_LITTLE_TIME;
+            } else
+            if(duration < 180) return PayoutCancelType::TOO_LITTLE_TIME;
+            else
+            if(duration > 30000) return PayoutCancelType::TOO_MUCH_TIME;
+            else
+            if(duration == 180) duration_class = DURATION_180;
+            else
+            if(duration >= 240) duration_class = DURATION_240_30000;
+            else duration_class = DURATION_181_239;
+
+            if(!(pair_flags & PAIR_FLAG_ENABLED)) return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
+
+            const uint32_t amount_tier =
+                amount < min_amount ? AMOUNT_BELOW_MIN :
+                amount < threshold_amount ? AMOUNT_LOW : AMOUNT_HIGH;
+
+            const uint8_t cell = data->rows[data->minute_row[get_minute_week(timestamp)]]
+                [duration_class * AMOUNT_TIERS + amount_tier];
+            payout = data->payouts[cell & 0x07];
+            return -(int)(cell >> 3);
+        }
+
+        /** \brief Получить процент выплат
+         *
+         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
+         * \param[out] payout процент выплат
+         * \param[in] currency_pair Имя валютной пары
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] amount размер ставки бинарного опциона
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline const int get_payout(
+                double &payout,
+                const std::string_view currency_pair,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const double amount) const {
+            const uint32_t index = intrade_bar_currency_pairs_hash.find(currency_pair);
+            if(index >= INTRADE_BAR_CURRENCY_PAIRS) return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
+            if(!(data->pair_flags[index] & PAIR_FLAG_ENABLED)) return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
+            return get_payout(payout, timestamp, duration, index, amount);
+        }
+
+        /** \brief Установить рублевый счет или долларовый
+         * \param is_rub Рубли, если true. Иначе USD
+         */
+        void set_rub_account_currency(const bool user_is_rub) {
+            is_rub = user_is_rub;
+            update_amount_limits();
+        }
+
+        /** \brief Установить правила выплат
+         *
+         * Таблица перестраивается по правилам (около 10 тысяч расчетов выплаты),
+         * поэтому правила не следует менять на каждом вызове get_payout.
+         * \param user_rules Правила выплат
+         * \return Вернет ErrorType::OK или TableErrorType::TABLE_TOO_MANY_PAYOUTS, в случае ошибки таблица не изменяется
+         */
+        const int set_rules(const IntradeBarRules &user_rules) {
+            std::shared_ptr<Data> temp = std::make_shared<Data>();
+            const int err = temp->build(user_rules);
+            if(err != ErrorType::OK) return err;
+            data_owner = std::move(temp);
+            data = data_owner.get();
+            update_amount_limits();
+            return ErrorType::OK;
+        }
+
+        /// Получить правила выплат, по которым построена таблица
+        inline const IntradeBarRules &get_rules() const {
+            return data->rules;
+        }
+
+        /** \brief Конструктор табличной модели процентов выплат брокера intrade.bar
+         *
+         * Таблица строится при создании первого объекта и общая для всех объектов
+         * \param user_currency_name Валюта счета, по умолчанию RUB
+         */
+        IntradeBarPayoutTable(const uint32_t user_currency_name = IntradeBar::CURRENCY_RUB) :
+                data(&get_data()) {
+            set_rub_account_currency(user_currency_name == IntradeBar::CURRENCY_RUB);
+        }
+    };
+}
+
+#endif // INTRADE_BAR_PAYOUT_TABLE_HPP_INCLUDED
@@ -0,0 +1,306 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_BACKTEST_HPP_INCLUDED
+#define PAYOUT_MODEL_BACKTEST_HPP_INCLUDED
+
+#include "payout-model-calendar-cursor.hpp"
+#include "intrade-bar-payout-model.hpp"
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include "xtime.hpp"
+
+namespace payout_model {
+
+    /// Направление сделки
+    enum BacktestDirection {
+        SELL = -1,  ///< Ставка на понижение цены
+        BUY = 1,    ///< Ставка на повышение цены
+    };
+
+    /// Сигнал потока бэктеста
+    class BacktestSignal {
+    public:
+        xtime::timestamp_t timestamp = 0;   ///< Время открытия сделки (unix время, GMT)
+        uint32_t currency_pair_index = 0;   ///< Номер валютной пары из списка валютных пар брокера
+        uint32_t duration = 0;              ///< Длительность опциона в секундах
+        int32_t direction = 0;              ///< Направление сделки (BUY или SELL)
+        int32_t outcome = 0;                ///< Фактическое движение цены к экспирации: 1 вверх, -1 вниз, 0 без изменений
+        double winrate = 0.0;               ///< Винрейт сигнала
+    };
+
+    /// Точка кривой баланса
+    class BacktestEquityPoint {
+    public:
+        xtime::timestamp_t timestamp = 0;   ///< Время экспирации сделки
+        double balance = 0.0;               ///< Баланс после расчета сделки
+    };
+
+    /** \brief Потоковый бэктест с реинвестированием
+     *
+     * Сигналы обрабатываются по порядку времени. Перед каждым сигналом рассчитываются сделки,
+     * у которых наступила экспирация, затем ставка определяется методом get_amount модели брокера
+     * от текущего баланса, и ставка списывается с баланса до экспирации, как у брокера.
+     * При выигрыше на баланс возвращается ставка и выплата, при неизменной цене - только ставка.
+     * Сделки с одинаковым временем экспирации рассчитываются в порядке открытия.
+     *
+     * Поток можно подавать частями: состояние сохраняется между вызовами run,
+     * а finish рассчитывает оставшиеся открытые сделки. Дата разбирается курсором календаря.
+     * Сделки одной длительности открываются по порядку времени и в том же порядке закрываются,
+     * поэтому открытые сделки хранятся в очередях по длительности, а ближайшая экспирация
+     * ищется среди первых сделок нескольких очередей. Память выделяется только при росте
+     * очередей и кривой баланса.
+     */
+    class PayoutBacktest {
+    public:
+        typedef IntradeBar::PayoutCancelType PayoutCancelType;  ///< Коды состояний выплат совпадают у всех брокеров
+
+        static const uint32_t CANCEL_TYPES = 12;    ///< Количество счетчиков состояний (0 и коды от -1 до -11)
+
+    private:
+
+        /// Открытая сделка
+        class Deal {
+        public:
+            xtime::timestamp_t expiration;  ///< Время экспирации
+            uint64_t sequence;              ///< Порядковый номер сделки
+            double value;                   ///< Сумма, которая вернется на баланс
+        };
+
+        /// Очередь открытых сделок одной длительности
+        class DealQueue {
+        public:
+            uint32_t duration = 0;
+            size_t head = 0;                ///< Первая открытая сделка
+            std::vector<Deal> deals;
+
+            inline bool empty() const {return head == deals.size();}
+            inline const Deal &front() const {return deals[head];}
+
+            inline void pop() {
+                ++head;
+                /* закрытые сделки удаляются, когда их не меньше половины очереди */
+                if(head == deals.size()) {
+                    head = 0;
+                    deals.clear();
+                } else
+                if(head >= 1024 && 2 * head >= deals.size()) {
+                    deals.erase(deals.begin(), deals.begin() + head);
+                    head = 0;
+                }
+            }
+        };
+
+        std::vector<DealQueue> queues;                  ///< Очереди открытых сделок по длительности
+        std::vector<BacktestEquityPoint> equity_curve;  ///< Кривая баланса
+        std::array<uint64_t, CANCEL_TYPES> cancels {};  ///< Счетчики состояний
+        CalendarCursor cursor;
+        xtime::timestamp_t next_expiration = std::numeric_limits<xtime::timestamp_t>::max(); ///< Ближайшая экспирация
+        size_t next_queue = 0;                          ///< Очередь с ближайшей экспирацией
+        size_t last_queue = 0;                          ///< Очередь последней открытой сделки
+        size_t open_deals = 0;                          ///< Количество открытых сделок
+        double balance = 0.0;
+        double attenuator = 0.0;
+        double payout_limiter = 1.0;
+        double winrate_limiter = 1.0;
+        uint64_t sequence = 0;
+        uint64_t wins = 0;
+        uint64_t losses = 0;
+        uint64_t draws = 0;
+
+        /// Найти очередь с ближайшей экспирацией
+        inline void update_next_expiration() {
+            /* при равной экспирации первой закрывается сделка, открытая раньше */
+            next_queue = queues.size();
+            next_expiration = std::numeric_limits<xtime::timestamp_t>::max();
+            uint64_t next_sequence = 0;
+            for(size_t q = 0; q < queues.size(); ++q) {
+                if(queues[q].empty()) continue;
+                const Deal &deal = queues[q].front();
+                if(deal.expiration < next_expiration ||
+                    (deal.expiration == next_expiration && deal.sequence < next_sequence)) {
+                    next_queue = q;
+                    next_expiration = deal.expiration;
+                    next_sequence = deal.sequence;
+                }
+            }
+        }
+
+        inline void settle(const xtime::timestamp_t timestamp) {
+            while(open_deals != 0 && next_expiration <= timestamp) {
+                DealQueue &queue = queues[next_queue];
+                balance += queue.front().value;
+                BacktestEquityPoint point;
+                point.timestamp = next_expiration;
+                point.balance = balance;
+                equity_curve.push_back(point);
+                queue.pop();
+                --open_deals;
+                update_next_expiration();
+            }
+        }
+
+        inline DealQueue &get_queue(const uint32_t duration) {
+            if(last_queue < queues.size() && queues[last_queue].duration == duration) return queues[last_queue];
+            for(size_t q = 0; q < queues.size(); ++q) {
+                if(queues[q].duration != duration) continue;
+                last_queue = q;
+                return queues[q];
+            }
+            last_queue = queues.size();
+            queues.emplace_back();
+            queues.back().duration = duration;
+            return queues.back();
+        }
+
+    public:
+
+        /** \brief Инициализировать бэктест
+         * \param user_balance Начальный баланс
+         * \param user_attenuator Коэффициент ослабления Келли
+         * \param user_payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+         * \param user_winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         */
+        PayoutBacktest(
+                const double user_balance,
+                const double user_attenuator,
+                const double user_payout_limiter = 1.0,
+                const double user_winrate_limiter = 1.0) {
+            reset(user_balance, user_attenuator, user_payout_limiter, user_winrate_limiter);
+        }
+
+        /** \brief Начать бэктест заново
+         *
+         * Память очередей сделок и кривой баланса сохраняется для следующего прохода.
+         * \param user_balance Начальный баланс
+         * \param user_attenuator Коэффициент ослабления Келли
+         * \param user_payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+         * \param user_winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         */
+        inline void reset(
+                const double user_balance,
+                const double user_attenuator,
+                const double user_payout_limiter = 1.0,
+                const double user_winrate_limiter = 1.0) {
+            for(DealQueue &queue : queues) {
+                queue.head = 0;
+                queue.deals.clear();
+            }
+            equity_curve.clear();
+            next_expiration = std::numeric_limits<xtime::timestamp_t>::max();
+            open_deals = 0;
+            cancels.fill(0);
+            balance = user_balance;
+            attenuator = user_attenuator;
+            payout_limiter = user_payout_limiter;
+            winrate_limiter = user_winrate_limiter;
+            sequence = 0;
+            wins = losses = draws = 0;
+        }
+
+        /** \brief Обработать часть потока сигналов
+         *
+         * Сигналы должны идти по возрастанию времени, в том числе между вызовами.
+         * \param model Модель брокера (IntradeBar, Grandcapital, их снимок или PayoutModel)
+         * \param signal Массив сигналов
+         * \param size Количество сигналов
+         */
+        template<class MODEL>
+        void run(const MODEL &model, const BacktestSignal *signal, const size_t size) {
+            for(size_t i = 0; i < size; ++i) {
+                const BacktestSignal &s = signal[i];
+                settle(s.timestamp);
+                cursor.update(s.timestamp);
+                double amount = 0.0, payout = 0.0;
+                const int err = model.get_amount(amount, payout, cursor, s.duration, s.currency_pair_index,
+                    balance, s.winrate, attenuator, payout_limiter, winrate_limiter);
+                if(err != ErrorType::OK || amount <= 0.0) {
+                    const uint32_t type = (uint32_t)-err;
+                    if(type < CANCEL_TYPES) ++cancels[type];
+                    continue;
+                }
+                balance -= amount;
+                Deal deal;
+                deal.expiration = s.timestamp + s.duration;
+                deal.sequence = sequence++;
+                if(s.outcome == 0) {
+                    deal.value = amount;
+                    ++draws;
+                } else
+                if(s.outcome == s.direction) {
+                    deal.value = amount * (1.0 + payout);
+                    ++wins;
+                } else {
+                    deal.value = 0.0;
+                    ++losses;
+                }
+                get_queue(s.duration).deals.push_back(deal);
+                ++open_deals;
+                if(deal.expiration < next_expiration) {
+                    next_queue = last_queue;
+                    next_expiration = deal.expiration;
+                }
+            }
+        }
+
+        /** \brief Рассчитать все открытые сделки
+         */
+        inline void finish() {
+            settle(std::numeric_limits<xtime::timestamp_t>::max());
+        }
+
+        /// Текущий баланс без открытых ставок
+        inline const double get_balance() const {return balance;}
+
+        /// Кривая баланса: одна точка на каждую рассчитанную сделку
+        inline const std::vector<BacktestEquityPoint> &get_equity_curve() const {return equity_curve;}
+
+        /** \brief Получить количество сигналов с указанным состоянием
+         *
+         * Для состояния 0 возвращается количество сигналов, которые брокер принимает без ставки
+         * (выходные дни у Intrade.bar).
+         * \param err Состояние выплаты (0 или PayoutCancelType)
+         * \return Количество сигналов без сделки
+         */
+        inline const uint64_t get_cancels(const int err) const {
+            const uint32_t type = (uint32_t)-err;
+            return type < CANCEL_TYPES ? cancels[type] : 0;
+        }
+
+        /// Количество открытых сделок
+        inline const uint64_t get_trades() const {return wins + losses + draws;}
+
+        /// Количество выигрышных сделок
+        inline const uint64_t get_wins() const {return wins;}
+
+        /// Количество проигрышных сделок
+        inline const uint64_t get_losses() const {return losses;}
+
+        /// Количество сделок, по которым вернулась ставка
+        inline const uint64_t get_draws() const {return draws;}
+    };
+}
+
+#endif // PAYOUT_MODEL_BACKTEST_HPP_INCLUDED
@@ -0,0 +1,208 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_C_H_INCLUDED
+#define PAYOUT_MODEL_C_H_INCLUDED
+
+/* Интерфейс C библиотеки bo-payout-model-c для привязок (numpy, Julia и т.д.)
+ *
+ * Пакетные функции читают массивы вызывающей стороны и записывают результаты в ее массивы,
+ * память не выделяется, поэтому расчет миллиона сделок - один вызов через границу FFI.
+ * Результаты совпадают с пакетными методами get_payout и get_amount моделей C++.
+ * Функции расчета не изменяют модель и могут вызываться из нескольких потоков одновременно.
+ * Исключения C++ не выходят за границу интерфейса, вместо них функции возвращают код ошибки.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#   if defined(PAYOUT_MODEL_C_BUILD)
+#       define PAYOUT_MODEL_C_API __declspec(dllexport)
+#   else
+#       define PAYOUT_MODEL_C_API __declspec(dllimport)
+#   endif
+#else
+#   define PAYOUT_MODEL_C_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief Версия интерфейса C
+ *
+ * Меняется при несовместимом изменении функций или констант.
+ */
+#define PAYOUT_MODEL_C_API_VERSION 2
+
+/// Брокеры
+enum {
+    PAYOUT_MODEL_C_INTRADE_BAR = 0,     ///< Intrade.bar
+    PAYOUT_MODEL_C_GRANDCAPITAL = 1,    ///< Grandcapital
+};
+
+/// Валюты счета
+enum {
+    PAYOUT_MODEL_C_CURRENCY_RUB = 0,    ///< Рублевый счет
+    PAYOUT_MODEL_C_CURRENCY_USD = 1,    ///< Долларовый счет
+};
+
+/** \brief Коды возврата функций и состояния выплат
+ *
+ * Состояния выплат совпадают с ErrorType и PayoutCancelType.
+ * Ошибки правил имеют свой диапазон: PAYOUT_MODEL_C_RULES_ERROR_BASE плюс код RulesErrorType.
+ */
+enum {
+    PAYOUT_MODEL_C_OK = 0,                          ///< Успех
+    PAYOUT_MODEL_C_DAY_OFF = -1,                    ///< Выходной день или праздник
+    PAYOUT_MODEL_C_NIGHT_HOURS = -2,                ///< Ночное время
+    PAYOUT_MODEL_C_BEGIN_EVENING_HOUR = -3,         ///< Первые минуты в начале часа вечером
+    PAYOUT_MODEL_C_TOO_LITTLE_TIME = -4,            ///< Слишком короткое время экспирации
+    PAYOUT_MODEL_C_TOO_MUCH_TIME = -5,              ///< Слишком длинное время экспирации
+    PAYOUT_MODEL_C_CURRENCY_PAIR_IS_MISSING = -6,   ///< Отсутствует валютная пара
+    PAYOUT_MODEL_C_TOO_LITTLE_MONEY = -7,           ///< Слишком низкая ставка
+    PAYOUT_MODEL_C_FXCM_MON = -8,                   ///< Нет котировок FXCM в понедельник в 0 час UTC
+    PAYOUT_MODEL_C_EXPIRATION_ERROR = -9,           ///< Ошибка экспирации
+    PAYOUT_MODEL_C_TOO_LITTLE_WINRATE = -10,        ///< Слишком низкий винрейт
+    PAYOUT_MODEL_C_EXIT_OVER_END_DAY = -11,         ///< Выход за конец дня
+
+    PAYOUT_MODEL_C_INVALID_ARGUMENT = -100,         ///< Неверный аргумент функции
+    PAYOUT_MODEL_C_INTERNAL_ERROR = -101,           ///< Внутренняя ошибка библиотеки (например, нехватка памяти)
+
+    PAYOUT_MODEL_C_RULES_ERROR_BASE = -200,         ///< Начало диапазона ошибок правил
+    PAYOUT_MODEL_C_RULES_FILE_NOT_OPEN = -201,      ///< Файл правил не открыт
+    PAYOUT_MODEL_C_RULES_SYNTAX_ERROR = -202,       ///< Строка правил без '='
+    PAYOUT_MODEL_C_RULES_UNKNOWN_KEY = -203,        ///< Неизвестный ключ правил
+    PAYOUT_MODEL_C_RULES_INVALID_VALUE = -204,      ///< Неверное значение правил
+};
+
+/// Модель брокера с валютой счета и правилами выплат
+typedef struct payout_model_c payout_model_c;
+
+/// Получить версию интерфейса библиотеки (PAYOUT_MODEL_C_API_VERSION, с которой она собрана)
+PAYOUT_MODEL_C_API uint32_t payout_model_c_get_api_version(void);
+
+/** \brief Создать модель
+ * \param broker Брокер (PAYOUT_MODEL_C_INTRADE_BAR или PAYOUT_MODEL_C_GRANDCAPITAL)
+ * \param currency Валюта счета (PAYOUT_MODEL_C_CURRENCY_RUB или PAYOUT_MODEL_C_CURRENCY_USD)
+ * \return Модель со встроенными правилами или NULL при неверных аргументах или нехватке памяти
+ */
+PAYOUT_MODEL_C_API payout_model_c *payout_model_c_create(int32_t broker, int32_t currency);
+
+/// Удалить модель (NULL допускается)
+PAYOUT_MODEL_C_API void payout_model_c_destroy(payout_model_c *model);
+
+/** \brief Загрузить правила выплат из файла
+ *
+ * Формат файла описан у parse_payout_rules. Нельзя вызывать одновременно с расчетом на этой модели.
+ * \param model Модель
+ * \param file_name Имя файла правил
+ * \param error_line Номер строки с ошибкой или 0 (может быть NULL)
+ * \return PAYOUT_MODEL_C_OK, код ошибки правил (PAYOUT_MODEL_C_RULES_*), PAYOUT_MODEL_C_INVALID_ARGUMENT
+ * или PAYOUT_MODEL_C_INTERNAL_ERROR. В случае ошибки правила модели не меняются
+ */
+PAYOUT_MODEL_C_API int32_t payout_model_c_load_rules(payout_model_c *model, const char *file_name, uint32_t *error_line);
+
+/** \brief Получить количество валютных пар брокера
+ * \param broker Брокер
+ * \return Количество валютных пар или 0 для неизвестного брокера
+ */
+PAYOUT_MODEL_C_API uint32_t payout_model_c_get_pairs(int32_t broker);
+
+/** \brief Получить номер валютной пары по имени
+ * \param broker Брокер
+ * \param name Имя валютной пары
+ * \return Номер валютной пары или -1
+ */
+PAYOUT_MODEL_C_API int32_t payout_model_c_get_pair_index(int32_t broker, const char *name);
+
+/** \brief Получить имя валютной пары по номеру
+ * \param broker Брокер
+ * \param index Номер валютной пары
+ * \return Имя валютной пары (строка библиотеки) или NULL
+ */
+PAYOUT_MODEL_C_API const char *payout_model_c_get_pair_name(int32_t broker, uint32_t index);
+
+/** \brief Получить проценты выплат для массива сделок
+ *
+ * Метки времени должны быть меньше 2^52 (векторные ядра переводят их в double без потери точности),
+ * для больших меток результат не определен.
+ * \param model Модель
+ * \param[out] payout Массив процентов выплат
+ * \param[out] err Массив состояний выплат
+ * \param timestamp Массив меток времени unix (GMT), каждая метка должна быть меньше 2^52
+ * \param duration Массив длительностей опционов в секундах
+ * \param currency_pair_index Массив номеров валютных пар
+ * \param amount Массив размеров ставок
+ * \param size Количество сделок
+ * \return PAYOUT_MODEL_C_OK, PAYOUT_MODEL_C_INVALID_ARGUMENT или PAYOUT_MODEL_C_INTERNAL_ERROR
+ */
+PAYOUT_MODEL_C_API int32_t payout_model_c_get_payout(
+    const payout_model_c *model,
+    double *payout,
+    int32_t *err,
+    const uint64_t *timestamp,
+    const uint32_t *duration,
+    const uint32_t *currency_pair_index,
+    const double *amount,
+    size_t size);
+
+/** \brief Получить размеры ставок и проценты выплат для массива сделок
+ *
+ * Метки времени должны быть меньше 2^52, как у payout_model_c_get_payout.
+ * \param model Модель
+ * \param[out] amount Массив размеров ставок
+ * \param[out] payout Массив процентов выплат
+ * \param[out] err Массив состояний выплат
+ * \param timestamp Массив меток времени unix (GMT), каждая метка должна быть меньше 2^52
+ * \param duration Массив длительностей опционов в секундах
+ * \param currency_pair_index Массив номеров валютных пар
+ * \param balance Массив размеров депозита
+ * \param winrate Массив винрейтов
+ * \param attenuator Массив коэффициентов ослабления Келли
+ * \param payout_limiter Массив ограничителей процента выплат или NULL (не используется)
+ * \param winrate_limiter Массив ограничителей винрейта или NULL (не используется)
+ * \param size Количество сделок
+ * \return PAYOUT_MODEL_C_OK, PAYOUT_MODEL_C_INVALID_ARGUMENT или PAYOUT_MODEL_C_INTERNAL_ERROR
+ */
+PAYOUT_MODEL_C_API int32_t payout_model_c_get_amount(
+    const payout_model_c *model,
+    double *amount,
+    double *payout,
+    int32_t *err,
+    const uint64_t *timestamp,
+    const uint32_t *duration,
+    const uint32_t *currency_pair_index,
+    const double *balance,
+    const double *winrate,
+    const double *attenuator,
+    const double *payout_limiter,
+    const double *winrate_limiter,
+    size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PAYOUT_MODEL_C_H_INCLUDED
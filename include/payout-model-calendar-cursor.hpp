@@ -0,0 +1,169 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_CALENDAR_CURSOR_HPP_INCLUDED
+#define PAYOUT_MODEL_CALENDAR_CURSOR_HPP_INCLUDED
+
+#include "xtime.hpp"
+#include <cstdint>
+
+namespace payout_model {
+
+    /** \brief Календарь одной метки времени
+     *
+     * Разбирает метку времени на составляющие по запросу.
+     * Используется моделями, когда курсор календаря не передан.
+     */
+    class TimestampCalendar {
+    private:
+        const xtime::timestamp_t timestamp;
+
+    public:
+
+        TimestampCalendar(const xtime::timestamp_t user_timestamp) :
+            timestamp(user_timestamp) {
+        }
+
+        inline const xtime::timestamp_t get_timestamp() const {return timestamp;}
+        inline const uint32_t get_second_day() const {return (uint32_t)(timestamp % xtime::SECONDS_IN_DAY);}
+        inline const uint32_t get_hour_day() const {return xtime::get_hour_day(timestamp);}
+        inline const uint32_t get_minute_hour() const {return xtime::get_minute_hour(timestamp);}
+        inline const uint32_t get_weekday() const {return xtime::get_weekday(timestamp);}
+    };
+
+    /** \brief Курсор календаря для возрастающих меток времени
+     *
+     * Запоминает начало текущего дня, день недели, дату и признак праздника.
+     * Если новая метка времени попадает в тот же день, обновление курсора
+     * сводится к одному вычитанию. Переход на следующие дни выполняется
+     * приращением даты, без повторного разбора метки времени.
+     * Метка времени в прошлом или далеко в будущем разбирается заново.
+     */
+    class CalendarCursor {
+    public:
+        static const uint32_t MAX_STEP_DAYS = 31;   ///< Максимальный шаг в днях, при котором дата увеличивается приращением
+
+    private:
+        xtime::timestamp_t timestamp = 0;           ///< Текущая метка времени
+        xtime::timestamp_t first_timestamp_day = 0; ///< Метка времени начала текущего дня
+        uint32_t second_day = 0;                    ///< Секунда дня
+        uint32_t weekday = xtime::THU;              ///< День недели
+        uint32_t day = 1;                           ///< День месяца
+        uint32_t month = xtime::JAN;                ///< Месяц
+        uint32_t year = 1970;                       ///< Год
+        bool holiday = true;                        ///< Праздничный день
+
+        inline void update_holiday() {
+            /* 1 января или 25 декабря */
+            holiday = (day == 1 && month == xtime::JAN) || (day == 25 && month == xtime::DEC);
+        }
+
+        inline void step_days(const uint32_t days) {
+            for(uint32_t i = 0; i < days; ++i) {
+                if(++day > get_days_in_month(month, year)) {
+                    day = 1;
+                    if(++month > xtime::DEC) {
+                        month = xtime::JAN;
+                        ++year;
+                    }
+                }
+            }
+            weekday = (weekday + days) % xtime::DAYS_IN_WEEK;
+            first_timestamp_day += (xtime::timestamp_t)days * xtime::SECONDS_IN_DAY;
+            update_holiday();
+        }
+
+    public:
+
+        /** \brief Получить количество дней в месяце
+         * \param m Месяц
+         * \param y Год
+         * \return Количество дней в месяце с учетом високосного года
+         */
+        inline static const uint32_t get_days_in_month(const uint32_t m, const uint32_t y) {
+            if(m == xtime::FEB) {
+                const bool is_leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+                return is_leap ? 29 : 28;
+            }
+            if(m == xtime::APR || m == xtime::JUN || m == xtime::SEP || m == xtime::NOV) return 30;
+            return 31;
+        }
+
+        CalendarCursor() {}
+
+        explicit CalendarCursor(const xtime::timestamp_t user_timestamp) {
+            reset(user_timestamp);
+        }
+
+        /** \brief Установить курсор на метку времени с полным разбором даты
+         * \param user_timestamp Метка времени
+         */
+        inline void reset(const xtime::timestamp_t user_timestamp) {
+            xtime::DateTime iDateTime(user_timestamp);
+            timestamp = user_timestamp;
+            first_timestamp_day = xtime::get_first_timestamp_day(user_timestamp);
+            second_day = (uint32_t)(user_timestamp - first_timestamp_day);
+            weekday = xtime::get_weekday(user_timestamp);
+            day = iDateTime.day;
+            month = iDateTime.month;
+            year = iDateTime.year;
+            update_holiday();
+        }
+
+        /** \brief Передвинуть курсор на метку времени
+         * \param user_timestamp Метка времени
+         */
+        inline void update(const xtime::timestamp_t user_timestamp) {
+            /* метка времени в прошлом дает переполнение и попадает в полный разбор */
+            const xtime::timestamp_t offset = user_timestamp - first_timestamp_day;
+            if(offset < xtime::SECONDS_IN_DAY) {
+                timestamp = user_timestamp;
+                second_day = (uint32_t)offset;
+                return;
+            }
+            if(offset < (xtime::timestamp_t)MAX_STEP_DAYS * xtime::SECONDS_IN_DAY) {
+                step_days((uint32_t)(offset / xtime::SECONDS_IN_DAY));
+                timestamp = user_timestamp;
+                second_day = (uint32_t)(user_timestamp - first_timestamp_day);
+                return;
+            }
+            reset(user_timestamp);
+        }
+
+        inline const xtime::timestamp_t get_timestamp() const {return timestamp;}
+        inline const xtime::timestamp_t get_first_timestamp_day() const {return first_timestamp_day;}
+        inline const uint32_t get_second_day() const {return second_day;}
+        inline const uint32_t get_minute_day() const {return second_day / xtime::SECONDS_IN_MINUTE;}
+        inline const uint32_t get_hour_day() const {return second_day / xtime::SECONDS_IN_HOUR;}
+        inline const uint32_t get_minute_hour() const {return (second_day / xtime::SECONDS_IN_MINUTE) % xtime::MINUTES_IN_HOUR;}
+        inline const uint32_t get_weekday() const {return weekday;}
+        inline const uint32_t get_day() const {return day;}
+        inline const uint32_t get_month() const {return month;}
+        inline const uint32_t get_year() const {return year;}
+
+        /// Вернет true, если текущий день - праздник (1 января или 25 декабря)
+        inline const bool is_holiday() const {return holiday;}
+    };
+}
+
+#endif // PAYOUT_MODEL_CALENDAR_CURSOR_HPP_INCLUDED
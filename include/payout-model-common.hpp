@@ -25,8 +25,11 @@
 #define PAYOUT_MODEL_COMMON_HPP_INCLUDED
 
 #include <string>
+#include <string_view>
 #include <array>
-#include <map>
+#include <cstdint>
+#include <cmath>
+#include <limits>
 
 namespace payout_model {
 
@@ -35,10 +38,28 @@ namespace payout_model {
         OK = 0, ///< Ошибки нет
     };
 
+    /** \brief Ожидаемый логарифмический рост депозита
+     * \param amount Размер ставки
+     * \param payout Процент выплат
+     * \param balance Размер депозита
+     * \param winrate Винрейт
+     * \return Ожидаемый логарифмический рост депозита или -infinity, если ставка не меньше депозита
+     */
+    inline const double get_log_growth(
+            const double amount,
+            const double payout,
+            const double balance,
+            const double winrate) {
+        const double fraction = amount / balance;
+        if(!(fraction < 1.0)) return -std::numeric_limits<double>::infinity();
+        return winrate * std::log1p(fraction * payout) + (1.0 - winrate) * std::log1p(-fraction);
+    }
+
+    static const uint32_t MINUTES_IN_WEEK = 10080;          /**< Количество минут в неделе */
     static const uint32_t INTRADE_BAR_CURRENCY_PAIRS = 26;  /**< Количество торговых символов у брокера Intrade.bar */
     static const uint32_t GRANDCAPITAL_CURRENCY_PAIRS = 27;  /**< Количество торговых символов у брокера Grandcapital */
 
-    const std::array<std::string, INTRADE_BAR_CURRENCY_PAIRS>
+    constexpr std::array<std::string_view, INTRADE_BAR_CURRENCY_PAIRS>
             intrade_bar_currency_pairs = {
         "EURUSD","USDJPY","GBPUSD","USDCHF",
         "USDCAD","EURJPY","AUDUSD","NZDUSD",
@@ -47,7 +68,7 @@ namespace payout_model {
         "NZDJPY","AUDNZD","GBPAUD","EURAUD",
         "GBPCHF","EURNZD","AUDCHF","GBPNZD",
         "GBPCAD","XAUUSD",
-    }; ///< Список доступных валютных пар брокера IntradeBar
+    }; ///< Список доступных валютных пар брокера IntradeBar (таблица времени компиляции, не создается при запуске)
 
     /*
 
@@ -57,7 +78,7 @@ namespace payout_model {
     60% платят на следующих валютных парах: EURCHF, XAGUSD
 
     */
-    const std::array<std::string, GRANDCAPITAL_CURRENCY_PAIRS>
+    constexpr std::array<std::string_view, GRANDCAPITAL_CURRENCY_PAIRS>
             grandcapital_currency_pairs = {
         "EURUSD","USDJPY","GBPUSD","USDCHF",
         "USDCAD","EURJPY","AUDUSD","NZDUSD",
@@ -66,32 +87,101 @@ namespace payout_model {
         "NZDJPY","AUDNZD","GBPAUD","EURAUD",
         "GBPCHF","EURNZD","AUDCHF","CADCHF",
         "GBPCAD","XAUUSD","XAGUSD"
-    }; ///< Список доступных валютных пар брокера Grandcapital
+    }; ///< Список доступных валютных пар брокера Grandcapital (таблица времени компиляции, не создается при запуске)
+
+    /** \brief Упаковать первые 6 символов имени валютной пары в целое число
+     * \param name Имя валютной пары длиной не менее 6 символов
+     * \return Ключ валютной пары
+     */
+    constexpr inline uint64_t pack_currency_pair_name(const char *name) {
+        return (uint64_t)(uint8_t)name[0] |
+            ((uint64_t)(uint8_t)name[1] << 8) |
+            ((uint64_t)(uint8_t)name[2] << 16) |
+            ((uint64_t)(uint8_t)name[3] << 24) |
+            ((uint64_t)(uint8_t)name[4] << 32) |
+            ((uint64_t)(uint8_t)name[5] << 40);
+    }
+
+    /** \brief Совершенная хеш-функция имен валютных пар
+     *
+     * Множитель хеш-функции подбирается при компиляции так, чтобы все имена
+     * попали в разные ячейки таблицы из 64 элементов. Поиск не выделяет память
+     * и выполняет одно умножение и одно сравнение ключа.
+     */
+    template<size_t N>
+    class CurrencyPairHash {
+    public:
+        static const uint32_t SLOTS_BITS = 6;
+        static const uint32_t SLOTS = 1 << SLOTS_BITS;
+        static const uint8_t EMPTY_SLOT = 0xFF;
+
+        std::array<uint64_t, N> keys {};        ///< Ключи имен валютных пар
+        std::array<uint8_t, SLOTS> slots {};    ///< Номера валютных пар в ячейках таблицы
+        uint64_t multiplier = 0;                ///< Множитель хеш-функции, 0 если подобрать не удалось
+
+        constexpr uint32_t get_slot(const uint64_t key) const {
+            return (uint32_t)((key * multiplier) >> (64 - SLOTS_BITS));
+        }
+
+        constexpr CurrencyPairHash(const std::array<std::string_view, N> &names) {
+            static_assert(N <= SLOTS, "Too many currency pairs");
+            for(size_t i = 0; i < N; ++i) {
+                keys[i] = pack_currency_pair_name(names[i].data());
+            }
+            /* перебираем нечетные множители из генератора splitmix64 */
+            uint64_t state = 0;
+            for(uint32_t attempt = 0; attempt < 100000 && multiplier == 0; ++attempt) {
+                state += 0x9E3779B97F4A7C15ULL;
+                uint64_t z = state;
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                const uint64_t candidate = (z ^ (z >> 31)) | 1;
+                uint64_t used = 0;
+                bool is_perfect = true;
+                for(size_t i = 0; i < N; ++i) {
+                    const uint32_t slot = (uint32_t)((keys[i] * candidate) >> (64 - SLOTS_BITS));
+                    if(used & ((uint64_t)1 << slot)) {
+                        is_perfect = false;
+                        break;
+                    }
+                    used |= (uint64_t)1 << slot;
+                }
+                if(is_perfect) multiplier = candidate;
+            }
+            for(size_t i = 0; i < SLOTS; ++i) {
+                slots[i] = EMPTY_SLOT;
+            }
+            for(size_t i = 0; i < N; ++i) {
+                slots[get_slot(keys[i])] = (uint8_t)i;
+            }
+        }
+
+        /** \brief Найти номер валютной пары
+         * \param name Имя валютной пары
+         * \param is_prefix Сравнивать только первые 6 символов имени
+         * \return Номер валютной пары или N, если валютная пара не найдена
+         */
+        constexpr uint32_t find(const std::string_view name, const bool is_prefix = false) const {
+            if(name.size() < 6 || (!is_prefix && name.size() != 6)) return N;
+            const uint64_t key = pack_currency_pair_name(name.data());
+            const uint32_t index = slots[get_slot(key)];
+            if(index >= N || keys[index] != key) return N;
+            return index;
+        }
+    };
+
+    constexpr CurrencyPairHash<INTRADE_BAR_CURRENCY_PAIRS>
+        intrade_bar_currency_pairs_hash(intrade_bar_currency_pairs); ///< Хеш-таблица валютных пар брокера IntradeBar
+    constexpr CurrencyPairHash<GRANDCAPITAL_CURRENCY_PAIRS>
+        grandcapital_currency_pairs_hash(grandcapital_currency_pairs); ///< Хеш-таблица валютных пар брокера Grandcapital
 
-    static const std::map<std::string, uint32_t> intrade_bar_currency_pairs_index = {
-        {"EURUSD",0},{"USDJPY",1},{"GBPUSD",2},{"USDCHF",3},
-        {"USDCAD",4},{"EURJPY",5},{"AUDUSD",6},{"NZDUSD",7},
-        {"EURGBP",8},{"EURCHF",9},{"AUDJPY",10},{"GBPJPY",11},
-        {"CHFJPY",12},{"EURCAD",13},{"AUDCAD",14},{"CADJPY",15},
-        {"NZDJPY",16},{"AUDNZD",17},{"GBPAUD",18},{"EURAUD",19},
-        {"GBPCHF",20},{"EURNZD",21},{"AUDCHF",22},{"GBPNZD",23},
-        {"GBPCAD",24},{"XAUUSD",25}
-    };  /**< Пары ключ-значение для имен символов и их порядкового номера */
-
-    static const std::map<std::string, uint32_t> grandcapital_currency_pairs_index = {
-        {"EURUSD",0},{"USDJPY",1},{"GBPUSD",2},{"USDCHF",3},
-        {"USDCAD",4},{"EURJPY",5},{"AUDUSD",6},{"NZDUSD",7},
-        {"EURGBP",8},{"EURCHF",9},{"AUDJPY",10},{"GBPJPY",11},
-        {"CHFJPY",12},{"EURCAD",13},{"AUDCAD",14},{"CADJPY",15},
-        {"NZDJPY",16},{"AUDNZD",17},{"GBPAUD",18},{"EURAUD",19},
-        {"GBPCHF",20},{"EURNZD",21},{"AUDCHF",22},{"CADCHF",23},
-        {"GBPCAD",24},{"XAUUSD",25},{"XAGUSD",26}
-    };  /**< Пары ключ-значение для имен символов и их порядкового номера */
+    static_assert(intrade_bar_currency_pairs_hash.multiplier != 0, "No perfect hash for IntradeBar currency pairs");
+    static_assert(grandcapital_currency_pairs_hash.multiplier != 0, "No perfect hash for Grandcapital currency pairs");
 
     static const uint32_t INTRADE_BAR_CURRENCY_PAIRS_REAL = 22; /**< Количество реально используемых торговых символов */
     static const uint32_t GRANDCAPITAL_CURRENCY_PAIRS_REAL = 27; /**< Количество реально используемых торговых символов */
 
-    const std::array<bool, INTRADE_BAR_CURRENCY_PAIRS>
+    constexpr std::array<bool, INTRADE_BAR_CURRENCY_PAIRS>
             is_intrade_bar_currency_pairs = {
         true,true,false,true,
         true,true,true,true,
@@ -107,7 +197,7 @@ namespace payout_model {
      * GBP/AUD, GBP/JPY, GBP/USD, USD/CAD,
      * USD/CHF, USD/JPY
      */
-    const std::array<bool, INTRADE_BAR_CURRENCY_PAIRS>
+    constexpr std::array<bool, INTRADE_BAR_CURRENCY_PAIRS>
             is_intrade_bar_currency_pairs_1m_exp = {
         true,true,true,true,
         true,true,true,false,
@@ -118,7 +208,7 @@ namespace payout_model {
         false,false,
     }; ///< Список доступных для торговли экспирацией 1 мин. валютных пар брокера IntradeBar
 
-    const std::array<bool, GRANDCAPITAL_CURRENCY_PAIRS>
+    constexpr std::array<bool, GRANDCAPITAL_CURRENCY_PAIRS>
             is_grandcapital_currency_pairs = {
         true,true,true,true,
         true,true,true,true,
@@ -146,7 +236,7 @@ namespace payout_model {
         "GBPCAD","XAUUSD","XAGUSD"
     }; ///< Список доступных валютных пар брокера Grandcapital
     */
-    const std::array<double, GRANDCAPITAL_CURRENCY_PAIRS>
+    constexpr std::array<double, GRANDCAPITAL_CURRENCY_PAIRS>
             grandcapital_currency_pairs_payout = {
         0.86,0.80,0.85,0.80,
         0.85,0.85,0.85,0.85,
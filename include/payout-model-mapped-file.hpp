@@ -0,0 +1,157 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_MAPPED_FILE_HPP_INCLUDED
+#define PAYOUT_MODEL_MAPPED_FILE_HPP_INCLUDED
+
+#include "payout-model-common.hpp"
+#include <string>
+#include <cstdint>
+
+#if defined(_WIN32)
+/* windows.h без NOMINMAX определяет макросы min и max, которые ломают std::min, std::max
+ * и std::numeric_limits<>::max() во всех файлах, подключающих этот заголовок */
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace payout_model {
+
+    /// Список кодов ошибок отображения файла в память
+    enum MappedFileErrorType {
+        MAPPED_FILE_NOT_OPEN = -1,  ///< Не удалось открыть или отобразить файл
+        MAPPED_FILE_EMPTY = -2,     ///< Файл пустой
+    };
+
+    /** \brief Файл, отображенный в память только для чтения
+     *
+     * Процессы, открывшие один файл, разделяют его страницы через страничный кэш,
+     * файл не читается в память процесса целиком. Объект нельзя копировать.
+     */
+    class MappedFile {
+    private:
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+#if defined(_WIN32)
+        HANDLE file_handle = INVALID_HANDLE_VALUE;
+        HANDLE mapping_handle = NULL;
+#endif
+
+    public:
+
+        MappedFile() {}
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile &operator=(const MappedFile&) = delete;
+
+        ~MappedFile() {
+            close();
+        }
+
+        /** \brief Отобразить файл в память
+         * \param file_name Имя файла
+         * \return Вернет ErrorType::OK или код ошибки, см. MappedFileErrorType
+         */
+        const int open(const std::string &file_name) {
+            close();
+#if defined(_WIN32)
+            file_handle = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            if(file_handle == INVALID_HANDLE_VALUE) return MappedFileErrorType::MAPPED_FILE_NOT_OPEN;
+            LARGE_INTEGER file_size;
+            if(!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0) {
+                close();
+                return MappedFileErrorType::MAPPED_FILE_EMPTY;
+            }
+            mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+            if(mapping_handle == NULL) {
+                close();
+                return MappedFileErrorType::MAPPED_FILE_NOT_OPEN;
+            }
+            void *view = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+            if(view == NULL) {
+                close();
+                return MappedFileErrorType::MAPPED_FILE_NOT_OPEN;
+            }
+            data = static_cast<const uint8_t*>(view);
+            size = (size_t)file_size.QuadPart;
+#else
+            const int fd = ::open(file_name.c_str(), O_RDONLY);
+            if(fd < 0) return MappedFileErrorType::MAPPED_FILE_NOT_OPEN;
+            struct stat file_stat;
+            if(fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+                ::close(fd);
+                return MappedFileErrorType::MAPPED_FILE_EMPTY;
+            }
+            void *view = mmap(nullptr, (size_t)file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            /* отображение остается действительным после закрытия дескриптора */
+            ::close(fd);
+            if(view == MAP_FAILED) return MappedFileErrorType::MAPPED_FILE_NOT_OPEN;
+            data = static_cast<const uint8_t*>(view);
+            size = (size_t)file_stat.st_size;
+#endif
+            return ErrorType::OK;
+        }
+
+        /** \brief Сообщить системе, что файл читается последовательно
+         *
+         * Система читает страницы с опережением и раньше освобождает прочитанные.
+         */
+        void advise_sequential() const {
+#if !defined(_WIN32)
+            if(data) madvise(const_cast<uint8_t*>(data), size, MADV_SEQUENTIAL);
+#endif
+        }
+
+        /// Закрыть файл
+        void close() {
+#if defined(_WIN32)
+            if(data) UnmapViewOfFile(data);
+            if(mapping_handle != NULL) CloseHandle(mapping_handle);
+            if(file_handle != INVALID_HANDLE_VALUE) CloseHandle(file_handle);
+            mapping_handle = NULL;
+            file_handle = INVALID_HANDLE_VALUE;
+#else
+            if(data) munmap(const_cast<uint8_t*>(data), size);
+#endif
+            data = nullptr;
+            size = 0;
+        }
+
+        inline const bool is_open() const {return data != nullptr;}
+        inline const uint8_t *get_data() const {return data;}
+        inline const size_t get_size() const {return size;}
+    };
+}
+
+#endif // PAYOUT_MODEL_MAPPED_FILE_HPP_INCLUDED
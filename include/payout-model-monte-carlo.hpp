@@ -0,0 +1,307 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_MONTE_CARLO_HPP_INCLUDED
+#define PAYOUT_MODEL_MONTE_CARLO_HPP_INCLUDED
+
+#include "payout-model-common.hpp"
+#include "payout-model-calendar-cursor.hpp"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include "xtime.hpp"
+
+namespace payout_model {
+
+    /** \brief Генератор случайных чисел со счетчиком
+     *
+     * Число зависит только от ключа и номера в последовательности, поэтому последовательность
+     * каждого пути не зависит от того, какой поток и в каком порядке ее считает.
+     * Ключ и счетчик перемешиваются двумя раундами финализатора splitmix64.
+     */
+    class CounterRandom {
+    private:
+
+        inline static uint64_t mix(uint64_t z) {
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+    public:
+
+        /** \brief Получить ключ последовательности
+         * \param seed Начальное значение
+         * \param stream Номер последовательности
+         * \return Ключ последовательности
+         */
+        inline static uint64_t get_key(const uint64_t seed, const uint64_t stream) {
+            return mix(mix(seed + 0x9E3779B97F4A7C15ULL) ^ (stream * 0xD1B54A32D192ED03ULL));
+        }
+
+        /** \brief Получить случайное число
+         * \param key Ключ последовательности
+         * \param counter Номер числа в последовательности
+         * \return Случайное 64-битное число
+         */
+        inline static uint64_t get(const uint64_t key, const uint64_t counter) {
+            return mix(key ^ mix(counter * 0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E019ULL));
+        }
+
+        /** \brief Получить случайное число от 0 до 1 (1 не включается)
+         * \param key Ключ последовательности
+         * \param counter Номер числа в последовательности
+         * \return Случайное число от 0 до 1
+         */
+        inline static double get_uniform(const uint64_t key, const uint64_t counter) {
+            return (double)(get(key, counter) >> 11) * (1.0 / 9007199254740992.0);
+        }
+    };
+
+    /// Способ построения последовательности сделок
+    enum MonteCarloMode {
+        MONTE_CARLO_BOOTSTRAP = 0,  ///< Сделки и их исходы выбираются из истории с возвращением
+        MONTE_CARLO_BERNOULLI = 1,  ///< Сделки выбираются из истории, исход разыгрывается по винрейту сделки
+    };
+
+    /// Сделка из истории для моделирования
+    class MonteCarloTrade {
+    public:
+        xtime::timestamp_t timestamp = 0;   ///< Время открытия сделки (unix время, GMT)
+        uint32_t currency_pair_index = 0;   ///< Номер валютной пары из списка валютных пар брокера
+        uint32_t duration = 0;              ///< Длительность опциона в секундах
+        double winrate = 0.0;               ///< Винрейт сигнала для расчета ставки
+        int32_t outcome = 0;                ///< Исход сделки для бутстрепа: 1 выигрыш, -1 проигрыш, 0 возврат ставки
+    };
+
+    /// Параметры моделирования
+    class MonteCarloConfig {
+    public:
+        uint64_t paths = 100000;        ///< Количество путей
+        uint32_t trades = 1000;         ///< Количество сделок в пути
+        double balance = 1000.0;        ///< Начальный баланс
+        double attenuator = 0.4;        ///< Коэффициент ослабления Келли
+        double payout_limiter = 1.0;    ///< Ограничитель процента выплат
+        double winrate_limiter = 1.0;   ///< Ограничитель винрейта
+        double ruin_balance = 0.0;      ///< Баланс разорения (0 - минимальная ставка брокера)
+        uint64_t seed = 0;              ///< Начальное значение генератора
+        uint32_t threads = 0;           ///< Количество потоков (0 - по количеству ядер)
+        int mode = MONTE_CARLO_BOOTSTRAP; ///< Способ построения последовательности сделок
+    };
+
+    /** \brief Результаты моделирования
+     *
+     * Распределения хранятся отсортированными по возрастанию.
+     */
+    class MonteCarloResult {
+    public:
+        std::vector<double> terminal_balance;   ///< Конечный баланс путей
+        std::vector<double> max_drawdown;       ///< Наибольшая просадка путей (доля от максимума баланса)
+        std::vector<double> ruin_curve;         ///< Вероятность разорения до сделки с номером i (размер trades + 1)
+        double ruin_probability = 0.0;          ///< Вероятность разорения за все сделки
+
+        /** \brief Получить квантиль распределения
+         * \param sorted Отсортированное распределение
+         * \param q Уровень квантиля от 0 до 1
+         * \return Значение квантиля (ближайший ранг) или 0 для пустого распределения
+         */
+        inline static const double get_quantile(const std::vector<double> &sorted, const double q) {
+            if(sorted.empty()) return 0.0;
+            const double rank = std::min(std::max(q, 0.0), 1.0) * (double)(sorted.size() - 1);
+            return sorted[(size_t)(rank + 0.5)];
+        }
+    };
+
+    /** \brief Моделирование разорения методом Монте-Карло
+     *
+     * Каждый путь - последовательность сделок, выбранных из истории с возвращением.
+     * Ставка рассчитывается методом get_amount модели брокера от текущего баланса,
+     * поэтому учитываются уровни выплат, минимальная ставка и время торговли.
+     * Время сделок из истории разбирается курсором календаря один раз до моделирования.
+     * Путь заканчивается разорением, когда баланс падает ниже баланса разорения.
+     *
+     * Пути делятся на блоки, блоки распределяются между потоками поровну, а поток,
+     * закончивший свои блоки, забирает половину оставшихся блоков у другого потока.
+     * Случайные числа пути зависят только от начального значения и номера пути,
+     * поэтому результат не зависит от количества потоков.
+     */
+    class MonteCarloSimulator {
+    public:
+        static const uint64_t BLOCK_PATHS = 64;     ///< Количество путей в блоке
+
+    private:
+
+        /// Блоки потока: свои берутся с начала, чужие потоки забирают с конца
+        class WorkerRange {
+        public:
+            std::mutex mutex;
+            uint64_t begin = 0;
+            uint64_t end = 0;
+        };
+
+        std::vector<CalendarCursor> cursors;    ///< Разобранное время сделок из истории
+        std::vector<double> balances;
+        std::vector<double> drawdowns;
+        std::vector<uint32_t> ruin_steps;
+
+        inline static bool pop_block(WorkerRange &range, uint64_t &block) {
+            std::lock_guard<std::mutex> lock(range.mutex);
+            if(range.begin == range.end) return false;
+            block = range.begin++;
+            return true;
+        }
+
+        inline static bool steal_blocks(std::vector<std::unique_ptr<WorkerRange>> &ranges, const size_t worker) {
+            for(size_t k = 1; k < ranges.size(); ++k) {
+                WorkerRange &victim = *ranges[(worker + k) % ranges.size()];
+                uint64_t begin = 0, end = 0;
+                {
+                    std::lock_guard<std::mutex> lock(victim.mutex);
+                    if(victim.begin == victim.end) continue;
+                    end = victim.end;
+                    begin = victim.begin + (victim.end - victim.begin) / 2;
+                    victim.end = begin;
+                }
+                std::lock_guard<std::mutex> lock(ranges[worker]->mutex);
+                ranges[worker]->begin = begin;
+                ranges[worker]->end = end;
+                return true;
+            }
+            return false;
+        }
+
+        template<class MODEL>
+        void run_path(
+                const MODEL &model,
+                const MonteCarloTrade *trade,
+                const size_t size,
+                const MonteCarloConfig &config,
+                const double ruin_balance,
+                const uint64_t path) {
+            const uint64_t key = CounterRandom::get_key(config.seed, path);
+            double balance = config.balance;
+            double peak = balance;
+            double drawdown = 0.0;
+            uint32_t ruin_step = config.trades + 1;
+            for(uint32_t k = 0; k < config.trades; ++k) {
+                const uint64_t index = std::min((uint64_t)(CounterRandom::get_uniform(key, 2 * (uint64_t)k) * (double)size), (uint64_t)size - 1);
+                const MonteCarloTrade &t = trade[index];
+                double amount = 0.0, payout = 0.0;
+                const int err = model.get_amount(amount, payout, cursors[index], t.duration, t.currency_pair_index,
+                    balance, t.winrate, config.attenuator, config.payout_limiter, config.winrate_limiter);
+                if(err != ErrorType::OK || amount <= 0.0) continue;
+                const int32_t outcome = config.mode == MONTE_CARLO_BERNOULLI ?
+                    (CounterRandom::get_uniform(key, 2 * (uint64_t)k + 1) < t.winrate ? 1 : -1) : t.outcome;
+                if(outcome > 0) balance += amount * payout;
+                else if(outcome < 0) balance -= amount;
+                if(balance > peak) peak = balance;
+                else drawdown = std::max(drawdown, 1.0 - balance / peak);
+                if(balance < ruin_balance) {
+                    ruin_step = k + 1;
+                    break;
+                }
+            }
+            balances[path] = balance;
+            drawdowns[path] = drawdown;
+            ruin_steps[path] = ruin_step;
+        }
+
+    public:
+
+        /** \brief Смоделировать пути
+         *
+         * Модель брокера должна допускать вызов get_amount из нескольких потоков
+         * (IntradeBar, Grandcapital и их снимки это допускают).
+         * \param model Модель брокера
+         * \param trade Массив сделок из истории
+         * \param size Количество сделок из истории
+         * \param config Параметры моделирования
+         * \param result Результаты моделирования
+         */
+        template<class MODEL>
+        void simulate(
+                const MODEL &model,
+                const MonteCarloTrade *trade,
+                const size_t size,
+                const MonteCarloConfig &config,
+                MonteCarloResult &result) {
+            const uint64_t paths = size == 0 ? 0 : config.paths;
+            const double ruin_balance = config.ruin_balance > 0.0 ? config.ruin_balance : model.get_min_amount();
+            cursors.resize(size);
+            for(size_t i = 0; i < size; ++i) {
+                cursors[i].reset(trade[i].timestamp);
+            }
+            balances.resize(paths);
+            drawdowns.resize(paths);
+            ruin_steps.resize(paths);
+
+            const uint64_t blocks = (paths + BLOCK_PATHS - 1) / BLOCK_PATHS;
+            uint64_t threads = config.threads ? config.threads : std::max(1U, std::thread::hardware_concurrency());
+            threads = std::max(std::min(threads, blocks), (uint64_t)1);
+            std::vector<std::unique_ptr<WorkerRange>> ranges(threads);
+            for(uint64_t w = 0; w < threads; ++w) {
+                ranges[w].reset(new WorkerRange());
+                ranges[w]->begin = blocks * w / threads;
+                ranges[w]->end = blocks * (w + 1) / threads;
+            }
+            auto work = [&](const size_t worker) {
+                uint64_t block = 0;
+                while(pop_block(*ranges[worker], block) || (steal_blocks(ranges, worker) && pop_block(*ranges[worker], block))) {
+                    const uint64_t end = std::min((block + 1) * BLOCK_PATHS, paths);
+                    for(uint64_t path = block * BLOCK_PATHS; path < end; ++path) {
+                        run_path(model, trade, size, config, ruin_balance, path);
+                    }
+                }
+            };
+            std::vector<std::thread> workers;
+            for(uint64_t w = 1; w < threads; ++w) {
+                workers.emplace_back(work, (size_t)w);
+            }
+            work(0);
+            for(std::thread &worker : workers) {
+                worker.join();
+            }
+
+            result.terminal_balance.assign(balances.begin(), balances.end());
+            result.max_drawdown.assign(drawdowns.begin(), drawdowns.end());
+            std::sort(result.terminal_balance.begin(), result.terminal_balance.end());
+            std::sort(result.max_drawdown.begin(), result.max_drawdown.end());
+            result.ruin_curve.assign((size_t)config.trades + 1, 0.0);
+            std::vector<uint64_t> ruins((size_t)config.trades + 2, 0);
+            for(uint64_t path = 0; path < paths; ++path) {
+                ++ruins[ruin_steps[path]];
+            }
+            uint64_t ruined = 0;
+            for(uint32_t k = 0; k <= config.trades; ++k) {
+                ruined += ruins[k];
+                result.ruin_curve[k] = paths ? (double)ruined / (double)paths : 0.0;
+            }
+            result.ruin_probability = result.ruin_curve.back();
+        }
+    };
+}
+
+#endif // PAYOUT_MODEL_MONTE_CARLO_HPP_INCLUDED
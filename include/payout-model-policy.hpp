@@ -0,0 +1,387 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_POLICY_HPP_INCLUDED
+#define PAYOUT_MODEL_POLICY_HPP_INCLUDED
+
+#include "intrade-bar-payout-model.hpp"
+#include "grandcapital-payout-model.hpp"
+#include <string_view>
+#include <limits>
+#include "xtime.hpp"
+
+namespace payout_model {
+
+    /** \brief Политика брокера Intrade.bar для PayoutModel
+     *
+     * Правила выплат - встроенные правила, известные во время компиляции.
+     * Расчет выполняет тот же код, что и у класса IntradeBar.
+     */
+    class IntradeBarPolicy {
+    public:
+        typedef IntradeBar Model;
+        typedef IntradeBarRules Rules;
+
+        static constexpr Rules RULES = Rules(); ///< Правила выплат
+        static const uint32_t CURRENCY_PAIRS = INTRADE_BAR_CURRENCY_PAIRS;
+
+        /** \brief Минимальная ставка для валюты счета
+         * \tparam CURRENCY Валюта счета
+         */
+        template<uint32_t CURRENCY>
+        constexpr static double get_min_amount() {
+            return CURRENCY == IntradeBar::CURRENCY_USD ? RULES.min_amount_usd :
+                CURRENCY == IntradeBar::CURRENCY_RUB ? RULES.min_amount_rub :
+                -std::numeric_limits<double>::infinity();
+        }
+
+        /** \brief Порог повышенной выплаты для валюты счета
+         * \tparam CURRENCY Валюта счета
+         */
+        template<uint32_t CURRENCY>
+        constexpr static double get_threshold_amount() {
+            return CURRENCY == IntradeBar::CURRENCY_USD ? RULES.threshold_amount_usd :
+                CURRENCY == IntradeBar::CURRENCY_RUB ? RULES.threshold_amount_rub :
+                std::numeric_limits<double>::infinity();
+        }
+
+        inline static const uint32_t find_currency_pair(const std::string_view currency_pair) {
+            return intrade_bar_currency_pairs_hash.find(currency_pair);
+        }
+
+        template<uint32_t CURRENCY, class CALENDAR>
+        inline static const int calc_payout(
+                double &payout,
+                const CALENDAR &calendar,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double amount) {
+            return IntradeBar::calc_payout(payout, &RULES,
+                get_min_amount<CURRENCY>(), get_threshold_amount<CURRENCY>(),
+                IntradeBar::get_session_calendar(), calendar, duration, currency_pair_index, amount);
+        }
+
+        template<uint32_t CURRENCY, class CALENDAR>
+        inline static const int calc_amount(
+                double &amount,
+                double &payout,
+                const CALENDAR &calendar,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter,
+                const double winrate_limiter) {
+            return IntradeBar::calc_amount(amount, payout, &RULES,
+                get_min_amount<CURRENCY>(), get_threshold_amount<CURRENCY>(),
+                IntradeBar::get_session_calendar(), calendar, duration, currency_pair_index, balance,
+                winrate, attenuator, payout_limiter, winrate_limiter);
+        }
+    };
+
+    /** \brief Политика брокера Grandcapital для PayoutModel
+     *
+     * Правила выплат - встроенные правила, известные во время компиляции.
+     * Расчет выполняет тот же код, что и у класса Grandcapital.
+     */
+    class GrandcapitalPolicy {
+    public:
+        typedef Grandcapital Model;
+        typedef GrandcapitalRules Rules;
+
+        static constexpr Rules RULES = Rules(); ///< Правила выплат
+        static const uint32_t CURRENCY_PAIRS = GRANDCAPITAL_CURRENCY_PAIRS;
+
+        /** \brief Минимальная ставка для валюты счета
+         * \tparam CURRENCY Валюта счета
+         */
+        template<uint32_t CURRENCY>
+        constexpr static double get_min_amount() {
+            return CURRENCY == Grandcapital::CURRENCY_USD ? RULES.min_amount_usd :
+                CURRENCY == Grandcapital::CURRENCY_RUB ? RULES.min_amount_rub :
+                -std::numeric_limits<double>::infinity();
+        }
+
+        /// У брокера Grandcapital нет повышенной выплаты
+        template<uint32_t CURRENCY>
+        constexpr static double get_threshold_amount() {
+            return std::numeric_limits<double>::infinity();
+        }
+
+        inline static const uint32_t find_currency_pair(const std::string_view currency_pair) {
+            return grandcapital_currency_pairs_hash.find(currency_pair, true);
+        }
+
+        template<uint32_t CURRENCY, class CALENDAR>
+        inline static const int calc_payout(
+                double &payout,
+                const CALENDAR &calendar,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double amount) {
+            return Grandcapital::calc_payout(payout, &RULES, get_min_amount<CURRENCY>(),
+                Grandcapital::get_session_calendar(), calendar, duration, currency_pair_index, amount);
+        }
+
+        template<uint32_t CURRENCY, class CALENDAR>
+        inline static const int calc_amount(
+                double &amount,
+                double &payout,
+                const CALENDAR &calendar,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter,
+                const double winrate_limiter) {
+            return Grandcapital::calc_amount(amount, payout, &RULES, get_min_amount<CURRENCY>(),
+                Grandcapital::get_session_calendar(), calendar, duration, currency_pair_index, balance,
+                winrate, attenuator, payout_limiter, winrate_limiter);
+        }
+    };
+
+    /** \brief Модель процентов выплат с брокером и валютой счета, известными во время компиляции
+     *
+     * Пороги ставок и правила выплат - константы времени компиляции, поэтому проверки
+     * валюты счета сворачиваются компилятором, а весь расчет встраивается в цикл вызывающего кода.
+     * Модель не имеет состояния, все методы статические.
+     * Результаты совпадают с классом брокера (IntradeBar или Grandcapital) со встроенными правилами.
+     * Для правил, загружаемых во время работы, используйте классы брокеров.
+     * \tparam BROKER_POLICY Политика брокера (IntradeBarPolicy или GrandcapitalPolicy)
+     * \tparam ACCOUNT_CURRENCY Валюта счета (CURRENCY_RUB или CURRENCY_USD класса брокера)
+     */
+    template<class BROKER_POLICY, uint32_t ACCOUNT_CURRENCY>
+    class PayoutModel {
+    public:
+        typedef typename BROKER_POLICY::Model Model;
+        typedef typename Model::PayoutCancelType PayoutCancelType;
+
+        static constexpr uint32_t CURRENCY = ACCOUNT_CURRENCY;  ///< Валюта счета
+        static constexpr double MIN_AMOUNT = BROKER_POLICY::template get_min_amount<ACCOUNT_CURRENCY>();             ///< Минимальная ставка
+        static constexpr double THRESHOLD_AMOUNT = BROKER_POLICY::template get_threshold_amount<ACCOUNT_CURRENCY>(); ///< Порог повышенной выплаты
+
+        /** \brief Получить процент выплат
+         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
+         * \param[out] payout процент выплат
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] amount размер ставки бинарного опциона
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline static const int get_payout(
+                double &payout,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double amount) {
+            return BROKER_POLICY::template calc_payout<ACCOUNT_CURRENCY>(
+                payout, TimestampCalendar(timestamp), duration, currency_pair_index, amount);
+        }
+
+        /** \brief Получить процент выплат
+         * \param[out] payout процент выплат
+         * \param[in] cursor курсор календаря, установленный на время сделки
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] amount размер ставки бинарного опциона
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline static const int get_payout(
+                double &payout,
+                const CalendarCursor &cursor,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double amount) {
+            return BROKER_POLICY::template calc_payout<ACCOUNT_CURRENCY>(
+                payout, cursor, duration, currency_pair_index, amount);
+        }
+
+        /** \brief Получить процент выплат
+         * \param[out] payout процент выплат
+         * \param[in] currency_pair Имя валютной пары
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] amount размер ставки бинарного опциона
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline static const int get_payout(
+                double &payout,
+                const std::string_view currency_pair,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const double amount) {
+            const uint32_t index = BROKER_POLICY::find_currency_pair(currency_pair);
+            if(index >= BROKER_POLICY::CURRENCY_PAIRS) return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
+            if(!BROKER_POLICY::RULES.is_currency_pairs[index]) return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
+            return get_payout(payout, timestamp, duration, index, amount);
+        }
+
+        /** \brief Получить абсолютный размер ставки и процент выплат
+         * \param[out] amount размер ставки бинарного опциона
+         * \param[out] payout процент выплат
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] balance Размер депозита
+         * \param[in] winrate Винрейт
+         * \param[in] attenuator Коэффициент ослабления Келли
+         * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+         * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline static const int get_amount(
+                double &amount,
+                double &payout,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter = 1.0,
+                const double winrate_limiter = 1.0) {
+            return BROKER_POLICY::template calc_amount<ACCOUNT_CURRENCY>(
+                amount, payout, TimestampCalendar(timestamp), duration, currency_pair_index,
+                balance, winrate, attenuator, payout_limiter, winrate_limiter);
+        }
+
+        /** \brief Получить абсолютный размер ставки и процент выплат
+         * \param[out] amount размер ставки бинарного опциона
+         * \param[out] payout процент выплат
+         * \param[in] cursor курсор календаря, установленный на время сделки
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] balance Размер депозита
+         * \param[in] winrate Винрейт
+         * \param[in] attenuator Коэффициент ослабления Келли
+         * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+         * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline static const int get_amount(
+                double &amount,
+                double &payout,
+                const CalendarCursor &cursor,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter = 1.0,
+                const double winrate_limiter = 1.0) {
+            return BROKER_POLICY::template calc_amount<ACCOUNT_CURRENCY>(
+                amount, payout, cursor, duration, currency_pair_index,
+                balance, winrate, attenuator, payout_limiter, winrate_limiter);
+        }
+
+        /** \brief Получить абсолютный размер ставки и процент выплат
+         * \param[out] amount размер ставки бинарного опциона
+         * \param[out] payout процент выплат
+         * \param[in] currency_pair Имя валютной пары
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] balance Размер депозита
+         * \param[in] winrate Винрейт
+         * \param[in] attenuator Коэффициент ослабления Келли
+         * \param[in] payout_limiter Ограничитель процента выплат (по умолчанию не используется)
+         * \param[in] winrate_limiter Ограничитель винрейта (по умолчанию не используется)
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline static const int get_amount(
+                double &amount,
+                double &payout,
+                const std::string_view currency_pair,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const double balance,
+                const double winrate,
+                const double attenuator,
+                const double payout_limiter = 1.0,
+                const double winrate_limiter = 1.0) {
+            /* отсутствующий символ передается неверным индексом,
+             * чтобы сохранить порядок проверок
+             */
+            const uint32_t index = BROKER_POLICY::find_currency_pair(currency_pair);
+            return get_amount(amount, payout, timestamp, duration, index,
+                balance, winrate, attenuator, payout_limiter, winrate_limiter);
+        }
+
+        /** \brief Проверить имя валютной пары
+         * \param currency_pair Имя валютной пары
+         * \return Вернет true, если указанная валютная пара поддерживается брокером
+         */
+        inline static const bool check_currecy_pair_name(const std::string_view currency_pair) {
+            return Model::check_currecy_pair_name(currency_pair, BROKER_POLICY::RULES);
+        }
+
+        inline static const int check_timestamp(const xtime::timestamp_t timestamp) {
+            return Model::check_timestamp(timestamp);
+        }
+
+        inline static const int check_timestamp(const CalendarCursor &cursor) {
+            return Model::check_timestamp(cursor);
+        }
+
+        inline static const int check_duration(
+                const uint32_t duration,
+                const uint32_t currency_pair_index) {
+            return Model::check_duration(duration, currency_pair_index, BROKER_POLICY::RULES);
+        }
+
+        inline static const int get_trade_window(
+                xtime::timestamp_t &window_begin,
+                xtime::timestamp_t &window_end,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const uint32_t currency_pair_index) {
+            return Model::get_trade_window(window_begin, window_end, timestamp,
+                duration, currency_pair_index, BROKER_POLICY::RULES);
+        }
+
+        inline static const uint32_t get_max_duration(const xtime::timestamp_t timestamp) {
+            return Model::get_max_duration(timestamp);
+        }
+
+        /// Календарь встроенной сессии брокера, по которому считаются выплаты
+        inline static const TradingCalendar &get_model_calendar() {
+            return Model::get_session_calendar();
+        }
+
+        inline static const xtime::timestamp_t get_next_payout_boundary(
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const TradingCalendar &user_calendar = Model::get_session_calendar()) {
+            return Model::get_next_payout_boundary(timestamp, duration, user_calendar);
+        }
+    };
+
+    typedef PayoutModel<IntradeBarPolicy, IntradeBar::CURRENCY_RUB> IntradeBarRub;       ///< Модель Intrade.bar, рублевый счет
+    typedef PayoutModel<IntradeBarPolicy, IntradeBar::CURRENCY_USD> IntradeBarUsd;       ///< Модель Intrade.bar, долларовый счет
+    typedef PayoutModel<GrandcapitalPolicy, Grandcapital::CURRENCY_RUB> GrandcapitalRub; ///< Модель Grandcapital, рублевый счет
+    typedef PayoutModel<GrandcapitalPolicy, Grandcapital::CURRENCY_USD> GrandcapitalUsd; ///< Модель Grandcapital, долларовый счет
+}
+
+#endif // PAYOUT_MODEL_POLICY_HPP_INCLUDED
@@ -0,0 +1,541 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_PORTFOLIO_HPP_INCLUDED
+#define PAYOUT_MODEL_PORTFOLIO_HPP_INCLUDED
+
+#include "intrade-bar-payout-model.hpp"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "xtime.hpp"
+
+namespace payout_model {
+
+    /// Сигнал для совместного распределения ставок
+    class PortfolioSignal {
+    public:
+        double winrate = 0.0;           ///< Винрейт
+        double low_payout = 0.0;        ///< Процент выплат для ставки меньше порога повышенной выплаты
+        double high_payout = 0.0;       ///< Процент выплат для ставки не меньше порога повышенной выплаты
+        double min_amount = 0.0;        ///< Минимальная ставка
+        double threshold_amount = std::numeric_limits<double>::infinity(); ///< Порог повышенной выплаты
+    };
+
+
+    /** \brief Совместное распределение ставок для одновременных сигналов
+     *
+     * get_amount рассчитывает ставку так, как будто сделка единственная. Если в одну
+     * минуту приходит много сигналов, независимые ставки в сумме переоценивают депозит.
+     * Распределитель ищет ставки, которые вместе максимизируют ожидаемый логарифмический рост
+     * депозита при независимых исходах сделок.
+     *
+     * Рост каждой сделки считается точно, а взаимное влияние сделок - по второму порядку разложения
+     * логарифма: G = sum(E[log(1 + x_i * r_i)]) - sum(x_i * x_j * m_i * m_j, i < j), где m_i - средний результат
+     * единичной ставки. Без ступеней выплат функция вогнутая, и ответ не зависит от порядка сигналов.
+     * Для одного сигнала это точная формула Келли, и ставка совпадает с get_amount.
+     *
+     * Ставка выбирается среди нуля, отрезка от минимальной ставки до порога повышенной выплаты
+     * и ставок не меньше порога, поэтому распределитель может поднять ставку до порога,
+     * если повышенная выплата дает больший рост. Коэффициент ослабления Келли применяется как в get_amount:
+     * ставки равны attenuator * (доля депозита по Келли). Сумма ставок не превышает attenuator * balance,
+     * при нехватке бюджета ко всем сделкам добавляется одинаковая цена доли депозита.
+     *
+     * Поиск чередует проход покоординатного подъема, который выбирает вид ставок, и шаги Ньютона
+     * по ставкам внутри отрезков при закрепленном виде ставок; снаружи подбирается цена бюджета.
+     * Минимальная ставка и порог делают задачу невыпуклой: найденный ответ - лучший из просмотренных
+     * локальных максимумов, и при другом порядке сигналов он может немного отличаться.
+     * Объект хранит рабочие массивы, чтобы не выделять память при каждом вызове.
+     * Один объект нельзя использовать из нескольких потоков одновременно.
+     */
+    class PortfolioKellyAllocator {
+    public:
+        typedef IntradeBar::PayoutCancelType PayoutCancelType;  ///< Коды состояний выплат совпадают у всех брокеров
+
+        static const uint32_t MAX_SWEEPS = 64;          ///< Максимальное количество проходов покоординатного подъема
+        static const uint32_t MAX_NEWTON_STEPS = 16;    ///< Максимальное количество шагов Ньютона после одного прохода
+
+    private:
+
+        /// Вид выбранной ставки
+        enum StakeType {
+            STAKE_ZERO = 0,         ///< Сделка не открывается
+            STAKE_INNER = 1,        ///< Ставка внутри отрезка
+            STAKE_MIN = 2,          ///< Минимальная ставка
+            STAKE_THRESHOLD = 3,    ///< Порог повышенной выплаты
+        };
+
+        /// Состояние сигнала при поиске (доли депозита, деленные на коэффициент ослабления)
+        class State {
+        public:
+            double winrate;
+            double low_payout;
+            double high_payout;
+            double low;             ///< Минимальная ставка
+            double high;            ///< Порог повышенной выплаты
+            double fraction;        ///< Текущая ставка
+            double payout;          ///< Процент выплат текущей ставки
+            double mean;            ///< Средний результат единичной ставки
+            double slope;           ///< Производная роста по ставке для шага Ньютона
+            double curvature;       ///< Кривизна роста по ставке для шага Ньютона
+            int type;               ///< Вид ставки, см. StakeType
+            bool is_high;           ///< Ставка не меньше порога повышенной выплаты
+        };
+
+        /// Итоги одного прохода по сигналам
+        class Sweep {
+        public:
+            double total = 0.0;         ///< Сумма долей депозита
+            double change = 0.0;        ///< Наибольшее изменение ставки
+            uint32_t switches = 0;      ///< Количество сигналов, сменивших вид ставки
+        };
+
+        std::vector<State> states;
+        std::vector<State> best_states;
+        std::vector<State> low_states;
+        std::vector<PortfolioSignal> active_signals;
+        std::vector<size_t> active_index;
+        std::vector<double> active_amount;
+        std::vector<double> active_payout;
+        std::vector<int> active_err;
+
+        /// Доля депозита, которую нельзя превысить суммой ставок
+        static constexpr double BUDGET = 1.0 - 1e-9;
+        /// Допустимая недостача суммы ставок до бюджета при подборе цены
+        static constexpr double BUDGET_TOLERANCE = 1e-6;
+        /// Допустимое изменение ставки при остановке поиска
+        static constexpr double TOLERANCE = 1e-9;
+
+        inline static const double get_growth(
+                const double fraction, const double winrate, const double payout,
+                const double price) {
+            return winrate * std::log1p(fraction * payout) +
+                (1.0 - winrate) * std::log1p(-fraction) - price * fraction;
+        }
+
+        /** \brief Найти ставку с наибольшим ростом без ограничений
+         *
+         * Производная роста w * p / (1 + x * p) - (1 - w) / (1 - x) - price обращается в ноль
+         * в меньшем корне уравнения price * p * x^2 - (p + price * (p - 1)) * x + (w * (1 + p) - 1 - price) = 0.
+         * При price = 0 это формула Келли в том же виде, что и в get_amount
+         */
+        inline static const double get_root(
+                const double winrate, const double payout, const double price) {
+            if(price == 0.0) return ((1.0 + payout) * winrate - 1.0) / payout;
+            const double a = price * payout;
+            const double b = payout + price * (payout - 1.0);
+            const double c = (1.0 + payout) * winrate - 1.0 - price;
+            const double d = b + std::sqrt(std::max(b * b - 4.0 * a * c, 0.0));
+            return d > 0.0 ? 2.0 * c / d : 0.0;
+        }
+
+        inline static const int get_stake_type(const State &state, const double fraction) {
+            return fraction == state.high ? STAKE_THRESHOLD : fraction == state.low ? STAKE_MIN : STAKE_INNER;
+        }
+
+        /** \brief Проход покоординатного подъема при заданной цене бюджета
+         *
+         * Для каждого сигнала по очереди выбирается ставка с наибольшим ростом при остальных ставках.
+         * Рост вогнутый и равен 0 в нуле: при корне не больше 0 любая ставка дает отрицательный рост,
+         * а ставка между нулем и корнем дает положительный рост. Поэтому логарифмы нужны только
+         * для сравнения ставки на краю отрезка с другими вариантами.
+         * \param size Количество сигналов
+         * \param budget_price Цена доли депозита
+         * \return Итоги прохода
+         */
+        const Sweep run_sweep(const size_t size, const double budget_price) {
+            Sweep result;
+            double total_mean = 0.0;
+            for(size_t i = 0; i < size; ++i) {
+                total_mean += states[i].fraction * states[i].mean;
+            }
+            for(size_t i = 0; i < size; ++i) {
+                State &state = states[i];
+                /* ставки с отрицательным средним не выбираются, поэтому сумма остальных не меньше 0 */
+                const double others = std::max(total_mean - state.fraction * state.mean, 0.0);
+                const double low_end = std::min(state.high, BUDGET);
+                const double high_begin = std::max(state.high, state.low);
+                const bool is_high = state.high_payout > 0.0 && high_begin <= BUDGET;
+
+                double best_fraction = 0.0;
+                double best_payout = state.low_payout;
+                double best_mean = 0.0;
+                double best_growth = 0.0;
+                bool best_is_high = false;
+                int best_type = STAKE_ZERO;
+
+                if(state.low_payout > 0.0 && state.low <= low_end) {
+                    const double mean = (1.0 + state.low_payout) * state.winrate - 1.0;
+                    const double price = mean * others + budget_price;
+                    const double root = get_root(state.winrate, state.low_payout, price);
+                    const double fraction = std::min(std::max(root, state.low), low_end);
+                    if(root > 0.0) {
+                        const double growth = is_high || root <= state.low ?
+                            get_growth(fraction, state.winrate, state.low_payout, price) : 1.0;
+                        if(growth > best_growth) {
+                            best_fraction = fraction;
+                            best_mean = mean;
+                            best_growth = growth;
+                            best_type = fraction == state.low ? STAKE_MIN : STAKE_INNER;
+                        }
+                    }
+                }
+                if(is_high) {
+                    const double mean = (1.0 + state.high_payout) * state.winrate - 1.0;
+                    const double price = mean * others + budget_price;
+                    const double root = get_root(state.winrate, state.high_payout, price);
+                    const double fraction = std::min(std::max(root, high_begin), BUDGET);
+                    if(root > 0.0) {
+                        const double growth = best_type != STAKE_ZERO || root <= high_begin ?
+                            get_growth(fraction, state.winrate, state.high_payout, price) : 1.0;
+                        if(growth > best_growth) {
+                            best_fraction = fraction;
+                            best_payout = state.high_payout;
+                            best_mean = mean;
+                            best_growth = growth;
+                            best_is_high = true;
+                            best_type = get_stake_type(state, fraction);
+                        }
+                    }
+                }
+
+                total_mean += best_fraction * best_mean - state.fraction * state.mean;
+                result.total += best_fraction;
+                result.change = std::max(result.change, std::abs(best_fraction - state.fraction));
+                if(best_type != state.type || best_is_high != state.is_high) ++result.switches;
+                state.fraction = best_fraction;
+                state.payout = best_payout;
+                state.mean = best_mean;
+                state.type = best_type;
+                state.is_high = best_is_high;
+            }
+            return result;
+        }
+
+        /** \brief Шаг Ньютона при закрепленном виде ставок
+         *
+         * Матрица вторых производных роста по ставкам внутри отрезков равна -(D + m * m^T), где D - диагональ
+         * кривизны с учетом собственного вклада ставки в среднюю сумму результатов, поэтому шаг находится
+         * за линейное время по формуле Шермана-Моррисона.
+         * Если задан бюджет, вместе со ставками уточняется цена бюджета, чтобы сумма ставок
+         * оказалась на границе бюджета.
+         * \param size Количество сигналов
+         * \param budget_price Цена доли депозита
+         * \param is_budget Удерживать сумму ставок на границе бюджета
+         * \param switches Количество ставок, вышедших на край отрезка
+         * \return Наибольшее изменение ставки
+         */
+        const double run_newton(const size_t size, double &budget_price, const bool is_budget, uint32_t &switches) {
+            double total = 0.0, total_mean = 0.0;
+            for(size_t i = 0; i < size; ++i) {
+                total += states[i].fraction;
+                total_mean += states[i].fraction * states[i].mean;
+            }
+            double mean_slope = 0.0, mean_mean = 0.0, unit_slope = 0.0, unit_mean = 0.0, unit_unit = 0.0;
+            for(size_t i = 0; i < size; ++i) {
+                State &state = states[i];
+                if(state.type != STAKE_INNER) continue;
+                const double win = state.payout / (1.0 + state.fraction * state.payout);
+                const double loss = 1.0 / (1.0 - state.fraction);
+                state.slope = state.winrate * win - (1.0 - state.winrate) * loss -
+                    state.mean * (total_mean - state.fraction * state.mean) - budget_price;
+                state.curvature = 1.0 / (state.winrate * win * win + (1.0 - state.winrate) * loss * loss - state.mean * state.mean);
+                mean_slope += state.mean * state.slope * state.curvature;
+                mean_mean += state.mean * state.mean * state.curvature;
+                unit_slope += state.slope * state.curvature;
+                unit_mean += state.mean * state.curvature;
+                unit_unit += state.curvature;
+            }
+            double price_step = 0.0;
+            const double budget_unit = unit_unit - unit_mean * unit_mean / (1.0 + mean_mean);
+            if(is_budget && budget_unit > 0.0) {
+                const double budget_slope = unit_slope - unit_mean * mean_slope / (1.0 + mean_mean);
+                const double target = BUDGET - 0.5 * BUDGET_TOLERANCE - total;
+                price_step = std::max((budget_slope - target) / budget_unit, -budget_price);
+                budget_price += price_step;
+            }
+            const double common = (mean_slope - price_step * unit_mean) / (1.0 + mean_mean);
+            double change = 0.0;
+            for(size_t i = 0; i < size; ++i) {
+                State &state = states[i];
+                if(state.type != STAKE_INNER) continue;
+                const double step = (state.slope - price_step - state.mean * common) * state.curvature;
+                const double begin = state.is_high ? std::max(state.high, state.low) : state.low;
+                const double end = state.is_high ? BUDGET : std::min(state.high, BUDGET);
+                const double fraction = std::min(std::max(state.fraction + step, begin), end);
+                change = std::max(change, std::abs(fraction - state.fraction));
+                state.fraction = fraction;
+                state.type = get_stake_type(state, fraction);
+                if(state.type != STAKE_INNER || fraction == end) ++switches;
+            }
+            return change;
+        }
+
+        /** \brief Найти ставки при заданной цене бюджета
+         *
+         * Проход покоординатного подъема выбирает вид ставок, затем ставки уточняются шагами Ньютона,
+         * пока вид ставок не изменится. Поиск заканчивается, когда проход не меняет ставки
+         * \param size Количество сигналов
+         * \param budget_price Цена доли депозита
+         * \return Итоги последнего прохода
+         */
+        const Sweep solve(const size_t size, double budget_price) {
+            Sweep sweep;
+            for(uint32_t k = 0; k < MAX_SWEEPS; ++k) {
+                sweep = run_sweep(size, budget_price);
+                if(sweep.switches == 0 && sweep.change <= TOLERANCE) break;
+                uint32_t switches = 0;
+                for(uint32_t n = 0; n < MAX_NEWTON_STEPS && switches == 0; ++n) {
+                    if(run_newton(size, budget_price, false, switches) <= TOLERANCE) break;
+                }
+            }
+            return sweep;
+        }
+
+        /// Рост депозита для текущих ставок
+        const double get_total_growth(const size_t size) const {
+            double growth = 0.0, total_mean = 0.0, mean_mean = 0.0;
+            for(size_t i = 0; i < size; ++i) {
+                const State &state = states[i];
+                if(state.type == STAKE_ZERO) continue;
+                const double mean = state.fraction * state.mean;
+                growth += get_growth(state.fraction, state.winrate, state.payout, 0.0);
+                total_mean += mean;
+                mean_mean += mean * mean;
+            }
+            return growth - 0.5 * (total_mean * total_mean - mean_mean);
+        }
+
+        /** \brief Скорость уменьшения суммы ставок при росте цены бюджета
+         *
+         * Учитываются ставки внутри отрезков и отклик средней суммы результатов сделок
+         */
+        const double get_budget_slope(const size_t size) const {
+            double mean_mean = 0.0, unit_mean = 0.0, unit_unit = 0.0;
+            for(size_t i = 0; i < size; ++i) {
+                const State &state = states[i];
+                if(state.type != STAKE_INNER) continue;
+                const double win = state.payout / (1.0 + state.fraction * state.payout);
+                const double loss = 1.0 / (1.0 - state.fraction);
+                const double curvature = 1.0 / (state.winrate * win * win + (1.0 - state.winrate) * loss * loss - state.mean * state.mean);
+                mean_mean += state.mean * state.mean * curvature;
+                unit_mean += state.mean * curvature;
+                unit_unit += curvature;
+            }
+            return unit_unit - unit_mean * unit_mean / (1.0 + mean_mean);
+        }
+
+    public:
+
+        /** \brief Распределить ставки между одновременными сигналами
+         * \param[out] amount Массив размеров ставок
+         * \param[out] payout Массив процентов выплат для выбранных ставок
+         * \param[out] err Массив состояний (0, если ставка больше 0, иначе TOO_LITTLE_WINRATE или TOO_LITTLE_MONEY)
+         * \param[in] signal Массив сигналов
+         * \param[in] size Количество сигналов
+         * \param[in] balance Размер депозита
+         * \param[in] attenuator Коэффициент ослабления Келли
+         */
+        void allocate(
+                double *amount,
+                double *payout,
+                int *err,
+                const PortfolioSignal *signal,
+                const size_t size,
+                const double balance,
+                const double attenuator) {
+            const double scale = attenuator * balance;
+            states.resize(size);
+            for(size_t i = 0; i < size; ++i) {
+                State &state = states[i];
+                const PortfolioSignal &s = signal[i];
+                state.winrate = s.winrate;
+                state.low_payout = s.low_payout;
+                state.high_payout = s.high_payout;
+                state.low = std::max(s.min_amount / scale, 0.0);
+                state.high = s.threshold_amount / scale;
+                state.fraction = 0.0;
+                state.payout = s.low_payout;
+                state.mean = 0.0;
+                state.type = STAKE_ZERO;
+                state.is_high = false;
+            }
+
+            Sweep sweep;
+            if(scale > 0.0) sweep = solve(size, 0.0);
+            if(sweep.total > BUDGET) {
+                /* Цена бюджета ищется методом Ньютона с сохранением отрезка, содержащего ответ.
+                 * Если все ставки стоят на краях отрезков, сумма ставок меняется скачками, и отрезок делится пополам.
+                 * При ступенях выплат ответ зависит от начального приближения, поэтому запоминается
+                 * лучший найденный набор ставок, который укладывается в бюджет
+                 */
+                const double infinity = std::numeric_limits<double>::infinity();
+                double price = 0.0, price_low = 0.0, price_high = infinity;
+                double excess = sweep.total - BUDGET;
+                double best_growth = -infinity;
+                for(uint32_t k = 0; k < MAX_SWEEPS; ++k) {
+                    const double slope = get_budget_slope(size);
+                    double next = slope > 0.0 ? price + (excess + 0.5 * BUDGET_TOLERANCE) / slope : infinity;
+                    if(!(next > price_low && next < price_high)) {
+                        next = price_high == infinity ? 2.0 * price_low + 1.0 / 64.0 : 0.5 * (price_low + price_high);
+                    }
+                    price = next;
+                    sweep = solve(size, price);
+                    excess = sweep.total - BUDGET;
+                    if(excess > 0.0) {
+                        price_low = price;
+                        low_states.assign(states.begin(), states.end());
+                    } else {
+                        price_high = price;
+                        const double growth = get_total_growth(size);
+                        if(growth > best_growth) {
+                            best_growth = growth;
+                            best_states.assign(states.begin(), states.end());
+                        }
+                        if(excess >= -BUDGET_TOLERANCE) break;
+                    }
+                    if(price_high - price_low <= 1e-12 * price_low) break;
+                }
+                if(excess > 0.0 || excess < -BUDGET_TOLERANCE) {
+                    /* поиск остановился на скачке суммы ставок: вид ставок со стороны превышения бюджета
+                     * закрепляется, и ставки внутри отрезков уменьшаются до границы бюджета
+                     */
+                    bool is_budget = false;
+                    if(price_low > 0.0) {
+                        states.swap(low_states);
+                        price = price_low;
+                        for(uint32_t n = 0; n < MAX_NEWTON_STEPS; ++n) {
+                            uint32_t switches = 0;
+                            if(run_newton(size, price, true, switches) <= TOLERANCE) break;
+                        }
+                        double total = 0.0;
+                        for(size_t i = 0; i < size; ++i) {
+                            total += states[i].fraction;
+                        }
+                        is_budget = total <= BUDGET && get_total_growth(size) > best_growth;
+                    }
+                    if(!is_budget) {
+                        if(best_growth > -infinity) {
+                            states.swap(best_states);
+                        } else {
+                            for(size_t i = 0; i < size; ++i) {
+                                states[i].fraction = 0.0;
+                                states[i].type = STAKE_ZERO;
+                            }
+                        }
+                    }
+                }
+            }
+
+            for(size_t i = 0; i < size; ++i) {
+                const State &state = states[i];
+                payout[i] = state.payout;
+                switch(state.type) {
+                case STAKE_MIN:
+                    amount[i] = signal[i].min_amount;
+                    break;
+                case STAKE_THRESHOLD:
+                    amount[i] = signal[i].threshold_amount;
+                    break;
+                case STAKE_INNER:
+                    amount[i] = balance * (state.fraction * attenuator);
+                    break;
+                default:
+                    amount[i] = 0.0;
+                    break;
+                }
+                if(amount[i] > 0.0) {
+                    err[i] = ErrorType::OK;
+                } else {
+                    const bool is_edge =
+                        (state.low_payout > 0.0 && (1.0 + state.low_payout) * state.winrate > 1.0) ||
+                        (state.high_payout > 0.0 && (1.0 + state.high_payout) * state.winrate > 1.0);
+                    err[i] = is_edge ? PayoutCancelType::TOO_LITTLE_MONEY : PayoutCancelType::TOO_LITTLE_WINRATE;
+                }
+            }
+        }
+
+        /** \brief Распределить ставки между одновременными сигналами по модели брокера
+         *
+         * Проценты выплат для обычной и повышенной ставки, минимальная ставка и порог
+         * берутся из модели (IntradeBar, Grandcapital или их снимок). Если модель
+         * не принимает сделку, ставка равна 0, а состояние равно коду ошибки модели.
+         * Если брокер принимает сделку без выплаты (выходные дни), ставка равна 0 и состояние 0, как в get_amount.
+         * \param[in] model Модель брокера
+         * \param[out] amount Массив размеров ставок
+         * \param[out] payout Массив процентов выплат для выбранных ставок
+         * \param[out] err Массив состояний (0 в случае успеха, иначе см. PayoutCancelType)
+         * \param[in] timestamp Массив временных меток unix времени (GMT)
+         * \param[in] duration Массив длительностей опционов в секундах
+         * \param[in] currency_pair_index Массив номеров валютных пар из списка валютных пар брокера
+         * \param[in] winrate Массив винрейтов
+         * \param[in] size Количество сигналов
+         * \param[in] balance Размер депозита
+         * \param[in] attenuator Коэффициент ослабления Келли
+         */
+        template<class MODEL>
+        void allocate(
+                const MODEL &model,
+                double *amount,
+                double *payout,
+                int *err,
+                const xtime::timestamp_t *timestamp,
+                const uint32_t *duration,
+                const uint32_t *currency_pair_index,
+                const double *winrate,
+                const size_t size,
+                const double balance,
+                const double attenuator) {
+            active_signals.clear();
+            active_index.clear();
+            for(size_t i = 0; i < size; ++i) {
+                PortfolioSignal signal;
+                signal.winrate = winrate[i];
+                signal.min_amount = model.get_min_amount();
+                signal.threshold_amount = model.get_threshold_amount();
+                amount[i] = 0.0;
+                payout[i] = 0.0;
+                err[i] = model.get_payout(signal.low_payout, timestamp[i], duration[i], currency_pair_index[i], signal.min_amount);
+                if(err[i] != ErrorType::OK) continue;
+                err[i] = model.get_payout(signal.high_payout, timestamp[i], duration[i], currency_pair_index[i], signal.threshold_amount);
+                if(err[i] != ErrorType::OK || signal.low_payout == 0.0) continue;
+                active_signals.push_back(signal);
+                active_index.push_back(i);
+            }
+            const size_t n = active_signals.size();
+            active_amount.resize(n);
+            active_payout.resize(n);
+            active_err.resize(n);
+            allocate(active_amount.data(), active_payout.data(), active_err.data(), active_signals.data(), n, balance, attenuator);
+            for(size_t j = 0; j < n; ++j) {
+                const size_t i = active_index[j];
+                amount[i] = active_amount[j];
+                payout[i] = active_payout[j];
+                err[i] = active_err[j];
+            }
+        }
+    };
+}
+
+#endif // PAYOUT_MODEL_PORTFOLIO_HPP_INCLUDED
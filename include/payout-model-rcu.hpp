@@ -0,0 +1,213 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_RCU_HPP_INCLUDED
+#define PAYOUT_MODEL_RCU_HPP_INCLUDED
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace payout_model {
+
+    /** \brief Указатель на неизменяемые данные с заменой в стиле RCU
+     *
+     * Читатели не блокируются: чтение сводится к записи номера эпохи в свой слот
+     * и загрузке указателя. Писатель атомарно подменяет указатель и удаляет
+     * старую версию только после того, как все читатели, которые могли ее видеть,
+     * вышли из секции чтения (освобождение по эпохам).
+     * Каждый поток-читатель регистрируется один раз и получает свой слот.
+     */
+    template<class T, size_t MAX_READERS = 64>
+    class RcuPointer {
+    private:
+
+        /// Слот читателя в отдельной линии кэша
+        struct alignas(64) Slot {
+            std::atomic<uint64_t> epoch;    ///< Эпоха входа в секцию чтения, 0 - вне секции
+            std::atomic<bool> is_used;      ///< Слот занят читателем
+        };
+
+        /// Старая версия данных, ожидающая удаления
+        struct Retired {
+            const T *data;
+            uint64_t epoch;                 ///< Эпоха, начиная с которой данные недоступны новым читателям
+        };
+
+        std::atomic<const T*> current;
+        std::atomic<uint64_t> global_epoch;
+        Slot slots[MAX_READERS];
+        std::mutex writer_mutex;
+        std::vector<Retired> retired;
+
+        /// Удалить старые версии, которые не может видеть ни один читатель
+        void reclaim_unlocked() {
+            uint64_t min_epoch = UINT64_MAX;
+            for(size_t i = 0; i < MAX_READERS; ++i) {
+                const uint64_t epoch = slots[i].epoch.load();
+                if(epoch != 0 && epoch < min_epoch) min_epoch = epoch;
+            }
+            size_t n = 0;
+            for(size_t i = 0; i < retired.size(); ++i) {
+                if(retired[i].epoch <= min_epoch) delete retired[i].data;
+                else retired[n++] = retired[i];
+            }
+            retired.resize(n);
+        }
+
+    public:
+
+        /** \brief Секция чтения
+         *
+         * Пока объект существует, данные, на которые он указывает, не будут удалены.
+         * Секции чтения одного читателя не должны быть вложенными.
+         */
+        class Guard {
+        private:
+            Slot *slot;
+            const T *data;
+
+        public:
+
+            Guard(Slot *user_slot, const T *user_data) : slot(user_slot), data(user_data) {}
+
+            Guard(Guard &&other) : slot(other.slot), data(other.data) {
+                other.slot = nullptr;
+            }
+
+            Guard(const Guard &) = delete;
+            Guard &operator = (const Guard &) = delete;
+
+            ~Guard() {
+                if(slot) slot->epoch.store(0, std::memory_order_release);
+            }
+
+            /// Вернет false для пустой секции чтения читателя без слота
+            inline const bool is_valid() const {return data != nullptr;}
+
+            inline const T *get() const {return data;}
+            inline const T &operator * () const {return *data;}
+            inline const T *operator -> () const {return data;}
+        };
+
+        /** \brief Читатель
+         *
+         * Занимает слот на время жизни объекта. Объект используется одним потоком.
+         * Если все MAX_READERS слотов заняты, читатель недействителен (is_valid вернет false),
+         * а lock() вернет пустую секцию чтения.
+         */
+        class Reader {
+        private:
+            RcuPointer *owner;
+            Slot *slot;
+
+        public:
+
+            Reader(RcuPointer &user_owner) : owner(&user_owner), slot(nullptr) {
+                for(size_t i = 0; i < MAX_READERS; ++i) {
+                    bool is_used = false;
+                    if(owner->slots[i].is_used.compare_exchange_strong(is_used, true)) {
+                        slot = &owner->slots[i];
+                        break;
+                    }
+                }
+            }
+
+            Reader(const Reader &) = delete;
+            Reader &operator = (const Reader &) = delete;
+
+            ~Reader() {
+                if(slot) slot->is_used.store(false, std::memory_order_release);
+            }
+
+            /// Вернет true, если для читателя нашелся свободный слот
+            inline const bool is_valid() const {return slot != nullptr;}
+
+            /** \brief Войти в секцию чтения
+             * \return Секция чтения с указателем на текущую версию данных или пустая секция
+             * (get() вернет nullptr), если читателю не хватило слота (см. is_valid)
+             */
+            inline Guard lock() const {
+                if(!slot) return Guard(nullptr, nullptr);
+                /* номер эпохи публикуется до загрузки указателя */
+                slot->epoch.store(owner->global_epoch.load());
+                return Guard(slot, owner->current.load());
+            }
+        };
+
+        /** \brief Конструктор
+         *
+         * Одновременно существовать могут не больше MAX_READERS объектов Reader,
+         * лишние читатели не получают слот и читают пустые секции (см. Reader::lock).
+         * \param data Начальная версия данных
+         */
+        RcuPointer(std::unique_ptr<const T> data) :
+                current(data.release()), global_epoch(1) {
+            for(size_t i = 0; i < MAX_READERS; ++i) {
+                slots[i].epoch.store(0);
+                slots[i].is_used.store(false);
+            }
+        }
+
+        RcuPointer(const RcuPointer &) = delete;
+        RcuPointer &operator = (const RcuPointer &) = delete;
+
+        ~RcuPointer() {
+            for(size_t i = 0; i < retired.size(); ++i) {
+                delete retired[i].data;
+            }
+            delete current.load();
+        }
+
+        /** \brief Опубликовать новую версию данных
+         *
+         * Читатели, вошедшие в секцию чтения после вызова, видят новую версию.
+         * Старые версии удаляются, когда их больше не может видеть ни один читатель.
+         * \param data Новая версия данных
+         */
+        void publish(std::unique_ptr<const T> data) {
+            std::lock_guard<std::mutex> lock(writer_mutex);
+            const T *old_data = current.exchange(data.release());
+            const uint64_t epoch = global_epoch.fetch_add(1) + 1;
+            retired.push_back(Retired{old_data, epoch});
+            reclaim_unlocked();
+        }
+
+        /// Попытаться удалить старые версии данных
+        void reclaim() {
+            std::lock_guard<std::mutex> lock(writer_mutex);
+            reclaim_unlocked();
+        }
+
+        /// Количество старых версий, ожидающих удаления
+        size_t get_retired_size() {
+            std::lock_guard<std::mutex> lock(writer_mutex);
+            return retired.size();
+        }
+    };
+}
+
+#endif // PAYOUT_MODEL_RCU_HPP_INCLUDED
@@ -0,0 +1,259 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_ROUTER_HPP_INCLUDED
+#define PAYOUT_MODEL_ROUTER_HPP_INCLUDED
+
+#include "intrade-bar-payout-model.hpp"
+#include "grandcapital-payout-model.hpp"
+#include <array>
+#include <memory>
+#include <string_view>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "xtime.hpp"
+
+namespace payout_model {
+
+    /// Список брокеров маршрутизатора сделок
+    enum BrokerType {
+        BROKER_NONE = -1,           ///< Сделка не открывается ни у одного брокера
+        BROKER_INTRADE_BAR = 0,     ///< Брокер Intrade.bar
+        BROKER_GRANDCAPITAL = 1,    ///< Брокер Grandcapital
+    };
+
+    /// Количество символов в объединенном списке валютных пар брокеров
+    constexpr uint32_t get_cross_broker_symbols_size() {
+        uint32_t size = INTRADE_BAR_CURRENCY_PAIRS;
+        for(uint32_t i = 0; i < GRANDCAPITAL_CURRENCY_PAIRS; ++i) {
+            if(intrade_bar_currency_pairs_hash.find(grandcapital_currency_pairs[i]) >= INTRADE_BAR_CURRENCY_PAIRS) ++size;
+        }
+        return size;
+    }
+
+    static const uint32_t CROSS_BROKER_SYMBOLS = get_cross_broker_symbols_size(); /**< Количество символов в объединенном списке */
+
+    /** \brief Объединенный список валютных пар брокеров
+     *
+     * Сначала идут валютные пары Intrade.bar в их порядке, затем валютные пары Grandcapital,
+     * которых нет у Intrade.bar. Для каждого символа хранится номер валютной пары у каждого брокера
+     * (INTRADE_BAR_CURRENCY_PAIRS или GRANDCAPITAL_CURRENCY_PAIRS, если у брокера символа нет).
+     */
+    class CrossBrokerSymbolMap {
+    public:
+        std::array<std::string_view, CROSS_BROKER_SYMBOLS> names {};    ///< Имена символов
+        std::array<uint32_t, CROSS_BROKER_SYMBOLS> intrade_bar_index {}; ///< Номера валютных пар Intrade.bar
+        std::array<uint32_t, CROSS_BROKER_SYMBOLS> grandcapital_index {};///< Номера валютных пар Grandcapital
+
+        constexpr CrossBrokerSymbolMap() {
+            uint32_t size = 0;
+            for(uint32_t i = 0; i < INTRADE_BAR_CURRENCY_PAIRS; ++i) {
+                names[size] = intrade_bar_currency_pairs[i];
+                intrade_bar_index[size] = i;
+                grandcapital_index[size] = grandcapital_currency_pairs_hash.find(names[size]);
+                ++size;
+            }
+            for(uint32_t i = 0; i < GRANDCAPITAL_CURRENCY_PAIRS; ++i) {
+                if(intrade_bar_currency_pairs_hash.find(grandcapital_currency_pairs[i]) < INTRADE_BAR_CURRENCY_PAIRS) continue;
+                names[size] = grandcapital_currency_pairs[i];
+                intrade_bar_index[size] = INTRADE_BAR_CURRENCY_PAIRS;
+                grandcapital_index[size] = i;
+                ++size;
+            }
+        }
+    };
+
+    constexpr CrossBrokerSymbolMap cross_broker_symbols; ///< Объединенный список валютных пар брокеров
+    constexpr CurrencyPairHash<CROSS_BROKER_SYMBOLS>
+        cross_broker_symbols_hash(cross_broker_symbols.names); ///< Хеш-таблица объединенного списка валютных пар
+
+    static_assert(cross_broker_symbols_hash.multiplier != 0, "No perfect hash for cross broker currency pairs");
+
+    /** \brief Маршрутизатор сделок между брокерами
+     *
+     * Для каждого сигнала рассчитывает размер ставки у всех брокеров, у которых есть счет,
+     * и выбирает брокера с наибольшим ожидаемым логарифмическим ростом депозита:
+     * winrate * log(1 + amount * payout / balance) + (1 - winrate) * log(1 - amount / balance).
+     * Сигналы обрабатываются блоками: номера символов переводятся в номера валютных пар брокеров
+     * по таблице, затем для каждого брокера вызывается пакетный get_amount,
+     * после чего за один проход выбирается лучший брокер. Виртуальных вызовов нет.
+     */
+    class BrokerRouter {
+    public:
+        static const uint32_t BLOCK_SIZE = 256;     ///< Количество сигналов, обрабатываемых за один проход
+
+    private:
+        std::shared_ptr<const IntradeBar> intrade_bar;      ///< Модель счета Intrade.bar или nullptr
+        std::shared_ptr<const Grandcapital> grandcapital;   ///< Модель счета Grandcapital или nullptr
+
+        /// Результаты одного брокера для блока сигналов
+        class BlockResult {
+        public:
+            uint32_t index[BLOCK_SIZE];
+            double amount[BLOCK_SIZE];
+            double payout[BLOCK_SIZE];
+            int err[BLOCK_SIZE];
+        };
+
+        template<class MODEL, size_t N>
+        inline static void evaluate(
+                BlockResult &result,
+                const MODEL &model,
+                const std::array<uint32_t, N> &symbol_index,
+                const uint32_t missing_index,
+                const xtime::timestamp_t *timestamp,
+                const uint32_t *duration,
+                const uint32_t *symbol,
+                const double *balance,
+                const double *winrate,
+                const double *attenuator,
+                const size_t size) {
+            for(size_t i = 0; i < size; ++i) {
+                result.index[i] = symbol[i] < N ? symbol_index[symbol[i]] : missing_index;
+            }
+            model.get_amount(result.amount, result.payout, result.err, timestamp, duration, result.index,
+                balance, winrate, attenuator, nullptr, nullptr, size);
+        }
+
+    public:
+
+        /** \brief Конструктор маршрутизатора
+         * \param user_intrade_bar Модель счета Intrade.bar (nullptr, если счета нет)
+         * \param user_grandcapital Модель счета Grandcapital (nullptr, если счета нет)
+         */
+        BrokerRouter(
+                std::shared_ptr<const IntradeBar> user_intrade_bar,
+                std::shared_ptr<const Grandcapital> user_grandcapital) :
+            intrade_bar(std::move(user_intrade_bar)),
+            grandcapital(std::move(user_grandcapital)) {
+        }
+
+        /** \brief Найти номер символа в объединенном списке валютных пар
+         * \param currency_pair Имя валютной пары
+         * \return Номер символа или CROSS_BROKER_SYMBOLS, если символ не найден
+         */
+        inline static const uint32_t find_symbol(const std::string_view currency_pair) {
+            return cross_broker_symbols_hash.find(currency_pair);
+        }
+
+        /** \brief Получить имя символа
+         * \param symbol Номер символа в объединенном списке валютных пар
+         * \return Имя символа или пустая строка
+         */
+        inline static const std::string_view get_symbol_name(const uint32_t symbol) {
+            if(symbol >= CROSS_BROKER_SYMBOLS) return std::string_view();
+            return cross_broker_symbols.names[symbol];
+        }
+
+        /** \brief Получить номер валютной пары у брокера
+         * \param broker Брокер
+         * \param symbol Номер символа в объединенном списке валютных пар
+         * \return Номер валютной пары брокера или количество валютных пар брокера, если символа у брокера нет
+         */
+        inline static const uint32_t get_broker_index(const BrokerType broker, const uint32_t symbol) {
+            if(broker == BROKER_INTRADE_BAR) {
+                return symbol < CROSS_BROKER_SYMBOLS ? cross_broker_symbols.intrade_bar_index[symbol] : INTRADE_BAR_CURRENCY_PAIRS;
+            } else
+            if(broker == BROKER_GRANDCAPITAL) {
+                return symbol < CROSS_BROKER_SYMBOLS ? cross_broker_symbols.grandcapital_index[symbol] : GRANDCAPITAL_CURRENCY_PAIRS;
+            }
+            return 0;
+        }
+
+        /** \brief Выбрать брокера и размер ставки для массива сигналов
+         *
+         * Сигнал открывается у брокера, где ставка принята (состояние 0, размер больше 0)
+         * и ожидаемый логарифмический рост депозита больше 0 и наибольший.
+         * При равенстве выбирается брокер с меньшим номером (см. BrokerType).
+         * \param[out] broker Массив выбранных брокеров (BROKER_NONE, если сигнал не открывается)
+         * \param[out] amount Массив размеров ставок (0, если сигнал не открывается)
+         * \param[out] payout Массив процентов выплат выбранного брокера
+         * \param[out] growth Массив ожидаемого логарифмического роста депозита (можно передать nullptr)
+         * \param[in] timestamp Массив временных меток unix времени (GMT)
+         * \param[in] duration Массив длительностей опционов в секундах
+         * \param[in] symbol Массив номеров символов объединенного списка валютных пар (см. find_symbol)
+         * \param[in] winrate Массив винрейтов
+         * \param[in] attenuator Массив коэффициентов ослабления Келли
+         * \param[in] intrade_bar_balance Массив размеров депозита на счете Intrade.bar
+         * \param[in] grandcapital_balance Массив размеров депозита на счете Grandcapital
+         * \param[in] size Количество сигналов
+         */
+        void route(
+                int *broker,
+                double *amount,
+                double *payout,
+                double *growth,
+                const xtime::timestamp_t *timestamp,
+                const uint32_t *duration,
+                const uint32_t *symbol,
+                const double *winrate,
+                const double *attenuator,
+                const double *intrade_bar_balance,
+                const double *grandcapital_balance,
+                const size_t size) const {
+            BlockResult results[2];
+            const bool is_intrade_bar = intrade_bar && intrade_bar_balance;
+            const bool is_grandcapital = grandcapital && grandcapital_balance;
+            for(size_t begin = 0; begin < size; begin += BLOCK_SIZE) {
+                const size_t n = std::min((size_t)BLOCK_SIZE, size - begin);
+                if(is_intrade_bar) {
+                    evaluate(results[BROKER_INTRADE_BAR], *intrade_bar, cross_broker_symbols.intrade_bar_index,
+                        INTRADE_BAR_CURRENCY_PAIRS, timestamp + begin, duration + begin, symbol + begin,
+                        intrade_bar_balance + begin, winrate + begin, attenuator + begin, n);
+                }
+                if(is_grandcapital) {
+                    evaluate(results[BROKER_GRANDCAPITAL], *grandcapital, cross_broker_symbols.grandcapital_index,
+                        GRANDCAPITAL_CURRENCY_PAIRS, timestamp + begin, duration + begin, symbol + begin,
+                        grandcapital_balance + begin, winrate + begin, attenuator + begin, n);
+                }
+                for(size_t i = 0; i < n; ++i) {
+                    const size_t j = begin + i;
+                    int best_broker = BROKER_NONE;
+                    double best_amount = 0.0;
+                    double best_payout = 0.0;
+                    double best_growth = 0.0;
+                    for(int b = BROKER_INTRADE_BAR; b <= BROKER_GRANDCAPITAL; ++b) {
+                        if(b == BROKER_INTRADE_BAR ? !is_intrade_bar : !is_grandcapital) continue;
+                        const BlockResult &result = results[b];
+                        if(result.err[i] != ErrorType::OK || !(result.amount[i] > 0.0)) continue;
+                        const double balance = b == BROKER_INTRADE_BAR ? intrade_bar_balance[j] : grandcapital_balance[j];
+                        const double value = payout_model::get_log_growth(result.amount[i], result.payout[i], balance, winrate[j]);
+                        if(value > best_growth) {
+                            best_broker = b;
+                            best_amount = result.amount[i];
+                            best_payout = result.payout[i];
+                            best_growth = value;
+                        }
+                    }
+                    broker[j] = best_broker;
+                    amount[j] = best_amount;
+                    payout[j] = best_payout;
+                    if(growth) growth[j] = best_growth;
+                }
+            }
+        }
+    };
+}
+
+#endif // PAYOUT_MODEL_ROUTER_HPP_INCLUDED
@@ -0,0 +1,253 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_RULES_HPP_INCLUDED
+#define PAYOUT_MODEL_RULES_HPP_INCLUDED
+
+#include "payout-model-common.hpp"
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cmath>
+
+namespace payout_model {
+
+    /** \brief Правила выплат брокера Intrade.bar
+     *
+     * Значения по умолчанию совпадают со встроенной моделью.
+     * Минимальные винрейты равны 1 / (1 + выплата) и хранятся готовыми,
+     * чтобы модель не выполняла деление при каждом расчете.
+     */
+    class IntradeBarRules {
+    public:
+        std::array<bool, INTRADE_BAR_CURRENCY_PAIRS> is_currency_pairs = is_intrade_bar_currency_pairs;             ///< Доступные валютные пары
+        std::array<bool, INTRADE_BAR_CURRENCY_PAIRS> is_currency_pairs_1m_exp = is_intrade_bar_currency_pairs_1m_exp; ///< Валютные пары с экспирацией 1 минута
+
+        double min_amount_rub = 50.0;           ///< Минимальная ставка, RUB
+        double min_amount_usd = 1.0;            ///< Минимальная ставка, USD
+        double threshold_amount_rub = 5000.0;   ///< Порог повышенной выплаты, RUB
+        double threshold_amount_usd = 80.0;     ///< Порог повышенной выплаты, USD
+
+        double low_payout_60 = 0.6;             ///< Выплата для экспирации 1 минута и в начале/конце часа
+        double high_payout_60 = 0.63;           ///< Повышенная выплата для экспирации 1 минута и в начале/конце часа
+        double low_payout_180 = 0.82;           ///< Выплата для экспирации 3 минуты
+        double low_payout_240 = 0.79;           ///< Выплата для экспирации от 4 до 500 минут
+        double high_payout = 0.85;              ///< Повышенная выплата для экспирации от 3 до 500 минут
+
+        double low_winrate_60 = 1.0 / 1.6;      ///< Минимальный винрейт для low_payout_60
+        double high_winrate_60 = 1.0 / 1.63;    ///< Минимальный винрейт для high_payout_60
+        double low_winrate_180 = 1.0 / 1.82;    ///< Минимальный винрейт для low_payout_180
+        double low_winrate_240 = 1.0 / 1.79;    ///< Минимальный винрейт для low_payout_240
+        double high_winrate = 1.0 / 1.85;       ///< Минимальный винрейт для high_payout
+
+        /// Пересчитать минимальные винрейты по процентам выплат
+        inline void update_winrates() {
+            low_winrate_60 = 1.0 / (1.0 + low_payout_60);
+            high_winrate_60 = 1.0 / (1.0 + high_payout_60);
+            low_winrate_180 = 1.0 / (1.0 + low_payout_180);
+            low_winrate_240 = 1.0 / (1.0 + low_payout_240);
+            high_winrate = 1.0 / (1.0 + high_payout);
+        }
+
+        /// Правила по умолчанию, общие для всех моделей
+        inline static const IntradeBarRules &get_default() {
+            static const IntradeBarRules rules;
+            return rules;
+        }
+    };
+
+    /** \brief Правила выплат брокера Grandcapital
+     *
+     * Значения по умолчанию совпадают со встроенной моделью.
+     */
+    class GrandcapitalRules {
+    public:
+        std::array<bool, GRANDCAPITAL_CURRENCY_PAIRS> is_currency_pairs = is_grandcapital_currency_pairs;           ///< Доступные валютные пары
+        std::array<double, GRANDCAPITAL_CURRENCY_PAIRS> currency_pairs_payout = grandcapital_currency_pairs_payout; ///< Проценты выплат валютных пар
+
+        double min_amount_rub = 50.0;           ///< Минимальная ставка, RUB
+        double min_amount_usd = 1.0;            ///< Минимальная ставка, USD
+
+        /// Правила по умолчанию, общие для всех моделей
+        inline static const GrandcapitalRules &get_default() {
+            static const GrandcapitalRules rules;
+            return rules;
+        }
+    };
+
+    /// Правила выплат всех брокеров
+    class PayoutRules {
+    public:
+        IntradeBarRules intrade_bar;
+        GrandcapitalRules grandcapital;
+    };
+
+    /// Список кодов ошибок загрузки правил
+    enum RulesErrorType {
+        RULES_FILE_NOT_OPEN = -1,       ///< Не удалось открыть файл
+        RULES_SYNTAX_ERROR = -2,        ///< Строка не имеет вид "ключ = значение"
+        RULES_UNKNOWN_KEY = -3,         ///< Неизвестный ключ или имя валютной пары
+        RULES_INVALID_VALUE = -4,       ///< Значение не является числом или вне допустимого диапазона
+    };
+
+    /** \brief Разобрать текст правил выплат
+     *
+     * Каждая строка имеет вид "ключ = значение", пустые строки и текст после # пропускаются.
+     * Ключи, отсутствующие в тексте, сохраняют прежние значения rules.
+     * Поддерживаемые ключи:
+     * intrade_bar.min_amount_rub, intrade_bar.min_amount_usd,
+     * intrade_bar.threshold_amount_rub, intrade_bar.threshold_amount_usd,
+     * intrade_bar.payout.low_60, intrade_bar.payout.high_60, intrade_bar.payout.low_180,
+     * intrade_bar.payout.low_240, intrade_bar.payout.high,
+     * intrade_bar.pair.<ИМЯ>, intrade_bar.pair_1m.<ИМЯ> (0 или 1),
+     * grandcapital.min_amount_rub, grandcapital.min_amount_usd,
+     * grandcapital.pair.<ИМЯ> (0 или 1), grandcapital.payout.<ИМЯ>.
+     * Проценты выплат (ключи *.payout.*) должны быть больше нуля.
+     * \param[in] text Текст правил
+     * \param[in,out] rules Правила, в которые записываются значения
+     * \param[out] error_line Номер строки с ошибкой, начиная с 1 (0, если ошибки нет)
+     * \return Вернет ErrorType::OK или код ошибки, см. RulesErrorType. В случае ошибки rules не изменяются
+     */
+    inline const int parse_payout_rules(
+            const std::string_view text,
+            PayoutRules &rules,
+            uint32_t &error_line) {
+        PayoutRules temp = rules;
+        error_line = 0;
+        uint32_t line_number = 0;
+        size_t pos = 0;
+        while(pos < text.size()) {
+            size_t end = text.find('\n', pos);
+            if(end == std::string_view::npos) end = text.size();
+            std::string_view line = text.substr(pos, end - pos);
+            pos = end + 1;
+            ++line_number;
+
+            const size_t comment = line.find('#');
+            if(comment != std::string_view::npos) line = line.substr(0, comment);
+            const size_t first = line.find_first_not_of(" \t\r");
+            if(first == std::string_view::npos) continue;
+
+            const size_t equal = line.find('=');
+            if(equal == std::string_view::npos) {
+                error_line = line_number;
+                return RulesErrorType::RULES_SYNTAX_ERROR;
+            }
+            std::string_view key = line.substr(first, equal - first);
+            key = key.substr(0, key.find_last_not_of(" \t") + 1);
+            const std::string value_str(line.substr(equal + 1));
+            const char *value_begin = value_str.c_str();
+            char *value_end = nullptr;
+            const double value = std::strtod(value_begin, &value_end);
+            const bool is_number = value_end != value_begin &&
+                value_str.find_first_not_of(" \t\r", value_end - value_begin) == std::string::npos;
+            if(!is_number || !std::isfinite(value) || value < 0.0) {
+                error_line = line_number;
+                return RulesErrorType::RULES_INVALID_VALUE;
+            }
+            const bool is_flag = value == 0.0 || value == 1.0;
+
+            int err = RulesErrorType::RULES_UNKNOWN_KEY;
+            auto set_value = [&](double &field) {
+                field = value;
+                err = ErrorType::OK;
+            };
+            /* нулевая выплата дает деление на ноль в расчете ставки по Келли */
+            auto set_payout = [&](double &field) {
+                if(value > 0.0) {
+                    field = value;
+                    err = ErrorType::OK;
+                } else err = RulesErrorType::RULES_INVALID_VALUE;
+            };
+            /* винрейт пересчитывается только для измененной выплаты, поэтому текст
+             * с прежними значениями не меняет винрейты по умолчанию (1 / 1.82 != 1 / (1 + 0.82))
+             */
+            auto set_intrade_bar_payout = [&](double &field, double &winrate) {
+                const double previous = field;
+                set_payout(field);
+                if(err == ErrorType::OK && field != previous) winrate = 1.0 / (1.0 + field);
+            };
+            auto set_flag = [&](auto &flags, const uint32_t index, const uint32_t size) {
+                if(index >= size) err = RulesErrorType::RULES_UNKNOWN_KEY;
+                else if(!is_flag) err = RulesErrorType::RULES_INVALID_VALUE;
+                else {
+                    flags[index] = value == 1.0;
+                    err = ErrorType::OK;
+                }
+            };
+
+            IntradeBarRules &ib = temp.intrade_bar;
+            GrandcapitalRules &gc = temp.grandcapital;
+            if(key == "intrade_bar.min_amount_rub") set_value(ib.min_amount_rub);
+            else if(key == "intrade_bar.min_amount_usd") set_value(ib.min_amount_usd);
+            else if(key == "intrade_bar.threshold_amount_rub") set_value(ib.threshold_amount_rub);
+            else if(key == "intrade_bar.threshold_amount_usd") set_value(ib.threshold_amount_usd);
+            else if(key == "intrade_bar.payout.low_60") set_intrade_bar_payout(ib.low_payout_60, ib.low_winrate_60);
+            else if(key == "intrade_bar.payout.high_60") set_intrade_bar_payout(ib.high_payout_60, ib.high_winrate_60);
+            else if(key == "intrade_bar.payout.low_180") set_intrade_bar_payout(ib.low_payout_180, ib.low_winrate_180);
+            else if(key == "intrade_bar.payout.low_240") set_intrade_bar_payout(ib.low_payout_240, ib.low_winrate_240);
+            else if(key == "intrade_bar.payout.high") set_intrade_bar_payout(ib.high_payout, ib.high_winrate);
+            else if(key.substr(0, 17) == "intrade_bar.pair.") {
+                set_flag(ib.is_currency_pairs, intrade_bar_currency_pairs_hash.find(key.substr(17)), INTRADE_BAR_CURRENCY_PAIRS);
+            } else if(key.substr(0, 20) == "intrade_bar.pair_1m.") {
+                set_flag(ib.is_currency_pairs_1m_exp, intrade_bar_currency_pairs_hash.find(key.substr(20)), INTRADE_BAR_CURRENCY_PAIRS);
+            } else if(key == "grandcapital.min_amount_rub") set_value(gc.min_amount_rub);
+            else if(key == "grandcapital.min_amount_usd") set_value(gc.min_amount_usd);
+            else if(key.substr(0, 18) == "grandcapital.pair.") {
+                set_flag(gc.is_currency_pairs, grandcapital_currency_pairs_hash.find(key.substr(18)), GRANDCAPITAL_CURRENCY_PAIRS);
+            } else if(key.substr(0, 20) == "grandcapital.payout.") {
+                const uint32_t index = grandcapital_currency_pairs_hash.find(key.substr(20));
+                if(index < GRANDCAPITAL_CURRENCY_PAIRS) set_payout(gc.currency_pairs_payout[index]);
+            }
+
+            if(err != ErrorType::OK) {
+                error_line = line_number;
+                return err;
+            }
+        }
+        rules = temp;
+        return ErrorType::OK;
+    }
+
+    /** \brief Загрузить правила выплат из файла
+     * \param[in] file_name Имя файла правил
+     * \param[in,out] rules Правила, в которые записываются значения
+     * \param[out] error_line Номер строки с ошибкой, начиная с 1 (0, если ошибки нет)
+     * \return Вернет ErrorType::OK или код ошибки, см. RulesErrorType. В случае ошибки rules не изменяются
+     */
+    inline const int load_payout_rules(
+            const std::string &file_name,
+            PayoutRules &rules,
+            uint32_t &error_line) {
+        error_line = 0;
+        std::ifstream file(file_name);
+        if(!file) return RulesErrorType::RULES_FILE_NOT_OPEN;
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return parse_payout_rules(buffer.str(), rules, error_line);
+    }
+}
+
+#endif // PAYOUT_MODEL_RULES_HPP_INCLUDED
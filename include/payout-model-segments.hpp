@@ -0,0 +1,138 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_SEGMENTS_HPP_INCLUDED
+#define PAYOUT_MODEL_SEGMENTS_HPP_INCLUDED
+
+#include "payout-model-common.hpp"
+#include "payout-model-calendar-cursor.hpp"
+#include <vector>
+#include <algorithm>
+#include "xtime.hpp"
+
+namespace payout_model {
+
+    /** \brief Отрезок времени с постоянной выплатой
+     */
+    class PayoutSegment {
+    public:
+        xtime::timestamp_t start = 0;   ///< Начало отрезка
+        xtime::timestamp_t end = 0;     ///< Конец отрезка (не включается)
+        double payout = 0;              ///< Процент выплат сделки, открытой в любую секунду отрезка
+        int err = ErrorType::OK;        ///< Состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType модели)
+    };
+
+    /** \brief Итератор отрезков постоянной выплаты
+     *
+     * Для валютной пары, длительности и ставки выплата меняется лишь на нескольких границах за день
+     * (MODEL::get_next_payout_boundary), поэтому модель вызывается один раз на границу, а не на каждую секунду.
+     * Соседние отрезки с одинаковыми выплатой и состоянием объединяются, поэтому на каждом
+     * следующем отрезке выплата или состояние отличается от предыдущего.
+     * Модель может быть IntradeBar, Grandcapital или PayoutModel и должна существовать, пока используется итератор.
+     */
+    template<class MODEL>
+    class PayoutSegmentIterator {
+    private:
+        const MODEL *model;
+        CalendarCursor cursor;
+        xtime::timestamp_t timestamp;       ///< Начало следующего отрезка
+        xtime::timestamp_t end_timestamp;
+        uint32_t duration;
+        uint32_t currency_pair_index;
+        double amount;
+        double payout = 0;                  ///< Выплата в начале следующего отрезка
+        int err = ErrorType::OK;            ///< Состояние выплаты в начале следующего отрезка
+
+        inline void update() {
+            cursor.update(timestamp);
+            err = model->get_payout(payout, cursor, duration, currency_pair_index, amount);
+        }
+
+    public:
+
+        /** \brief Конструктор итератора
+         * \param user_model Модель процентов выплат
+         * \param t0 Начало интервала
+         * \param t1 Конец интервала (не включается)
+         * \param user_duration Длительность опциона в секундах
+         * \param user_currency_pair_index Номер валютной пары
+         * \param user_amount Размер ставки
+         */
+        PayoutSegmentIterator(
+                const MODEL &user_model,
+                const xtime::timestamp_t t0,
+                const xtime::timestamp_t t1,
+                const uint32_t user_duration,
+                const uint32_t user_currency_pair_index,
+                const double user_amount) :
+                model(&user_model), cursor(t0), timestamp(t0), end_timestamp(t1),
+                duration(user_duration), currency_pair_index(user_currency_pair_index), amount(user_amount) {
+            if(timestamp < end_timestamp) update();
+        }
+
+        /** \brief Получить следующий отрезок
+         * \param[out] segment Отрезок постоянной выплаты
+         * \return Вернет false, если интервал пройден
+         */
+        const bool next(PayoutSegment &segment) {
+            if(timestamp >= end_timestamp) return false;
+            segment.start = timestamp;
+            segment.payout = payout;
+            segment.err = err;
+            while(true) {
+                timestamp = std::min(MODEL::get_next_payout_boundary(timestamp, duration, model->get_model_calendar()), end_timestamp);
+                if(timestamp >= end_timestamp) break;
+                update();
+                if(err != segment.err || payout != segment.payout) break;
+            }
+            segment.end = timestamp;
+            return true;
+        }
+    };
+
+    /** \brief Получить отрезки постоянной выплаты
+     * \param[out] segments Отрезки, покрывающие интервал [t0, t1) по порядку
+     * \param model Модель процентов выплат
+     * \param t0 Начало интервала
+     * \param t1 Конец интервала (не включается)
+     * \param duration Длительность опциона в секундах
+     * \param currency_pair_index Номер валютной пары
+     * \param amount Размер ставки
+     */
+    template<class MODEL>
+    void get_payout_segments(
+            std::vector<PayoutSegment> &segments,
+            const MODEL &model,
+            const xtime::timestamp_t t0,
+            const xtime::timestamp_t t1,
+            const uint32_t duration,
+            const uint32_t currency_pair_index,
+            const double amount) {
+        segments.clear();
+        PayoutSegmentIterator<MODEL> iterator(model, t0, t1, duration, currency_pair_index, amount);
+        PayoutSegment segment;
+        while(iterator.next(segment)) segments.push_back(segment);
+    }
+}
+
+#endif // PAYOUT_MODEL_SEGMENTS_HPP_INCLUDED
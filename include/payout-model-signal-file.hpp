@@ -0,0 +1,363 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_SIGNAL_FILE_HPP_INCLUDED
+#define PAYOUT_MODEL_SIGNAL_FILE_HPP_INCLUDED
+
+#include "payout-model-mapped-file.hpp"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "xtime.hpp"
+
+namespace payout_model {
+
+    static const uint64_t PAYOUT_SIGNAL_MAGIC = 0x314C4E4753494F42ULL;        /**< Сигнатура файла сигналов ("BOISGNL1" в little-endian) */
+    static const uint64_t PAYOUT_SIGNAL_RESULT_MAGIC = 0x3153455253494F42ULL; /**< Сигнатура файла результатов ("BOISRES1" в little-endian) */
+    static const uint32_t PAYOUT_SIGNAL_VERSION = 1;                          /**< Версия формата файлов сигналов и результатов */
+
+    /// Список кодов ошибок файлов сигналов
+    enum SignalFileErrorType {
+        SIGNAL_FILE_NOT_OPEN = -1,      ///< Не удалось открыть или отобразить файл
+        SIGNAL_WRITE_ERROR = -2,        ///< Не удалось записать файл
+        SIGNAL_BAD_FORMAT = -3,         ///< Неверная сигнатура, размер записи или размер файла
+        SIGNAL_BAD_VERSION = -4,        ///< Неподдерживаемая версия формата
+    };
+
+    /// Расчет для сигналов
+    enum PayoutSignalMode {
+        SIGNAL_PAYOUT = 0,  ///< Процент выплат для ставки сигнала (get_payout)
+        SIGNAL_AMOUNT = 1,  ///< Размер ставки и процент выплат по критерию Келли (get_amount)
+    };
+
+    /** \brief Заголовок файла сигналов и файла результатов
+     *
+     * После заголовка идут записи фиксированного размера без промежутков.
+     * Числа хранятся в порядке байтов машины, которая записала файл.
+     */
+    class PayoutSignalHeader {
+    public:
+        uint64_t magic;         ///< Сигнатура PAYOUT_SIGNAL_MAGIC или PAYOUT_SIGNAL_RESULT_MAGIC
+        uint32_t version;       ///< Версия формата PAYOUT_SIGNAL_VERSION
+        uint32_t header_size;   ///< Размер заголовка в байтах
+        uint32_t record_size;   ///< Размер записи в байтах
+        int32_t mode;           ///< Расчет (PayoutSignalMode) для файла результатов, 0 для файла сигналов
+        uint64_t records;       ///< Количество записей
+    };
+
+    /** \brief Запись файла сигналов
+     *
+     * Размер записи 64 байта, поля без выравнивающих промежутков, поэтому файл можно записать
+     * из массива структур numpy или любого языка с известным порядком полей.
+     */
+    class PayoutSignal {
+    public:
+        xtime::timestamp_t timestamp;   ///< Время открытия сделки (unix время, GMT)
+        uint32_t duration;              ///< Длительность опциона в секундах
+        uint32_t currency_pair_index;   ///< Номер валютной пары из списка валютных пар брокера
+        double amount;                  ///< Размер ставки (для SIGNAL_PAYOUT)
+        double balance;                 ///< Размер депозита (для SIGNAL_AMOUNT)
+        double winrate;                 ///< Винрейт сигнала (для SIGNAL_AMOUNT)
+        double attenuator;              ///< Коэффициент ослабления Келли (для SIGNAL_AMOUNT)
+        double payout_limiter;          ///< Ограничитель процента выплат, 1.0 без ограничения (для SIGNAL_AMOUNT)
+        double winrate_limiter;         ///< Ограничитель винрейта, 1.0 без ограничения (для SIGNAL_AMOUNT)
+    };
+
+    /// Запись файла результатов, номер записи совпадает с номером сигнала
+    class PayoutSignalResult {
+    public:
+        double amount;      ///< Размер ставки (для SIGNAL_PAYOUT - ставка сигнала)
+        double payout;      ///< Процент выплат
+        int32_t err;        ///< Состояние выплаты (0 или PayoutCancelType)
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(PayoutSignalHeader) == 32, "Payout signal header must be 32 bytes");
+    static_assert(sizeof(PayoutSignal) == 64, "Payout signal record must be 64 bytes");
+    static_assert(sizeof(PayoutSignalResult) == 24, "Payout signal result record must be 24 bytes");
+
+    /** \brief Отображенный в память файл записей
+     *
+     * Файл не читается в память процесса, записи читаются прямо из отображения.
+     * \tparam RECORD Класс записи
+     * \tparam MAGIC Сигнатура файла
+     */
+    template<class RECORD, uint64_t MAGIC>
+    class PayoutRecordFile {
+    private:
+        MappedFile file;
+        const PayoutSignalHeader *header = nullptr;
+
+    public:
+
+        /** \brief Открыть файл
+         * \param file_name Имя файла
+         * \return Вернет ErrorType::OK или код ошибки, см. SignalFileErrorType
+         */
+        const int open(const std::string &file_name) {
+            close();
+            const int map_err = file.open(file_name);
+            if(map_err == MappedFileErrorType::MAPPED_FILE_EMPTY) return SignalFileErrorType::SIGNAL_BAD_FORMAT;
+            if(map_err != ErrorType::OK) return SignalFileErrorType::SIGNAL_FILE_NOT_OPEN;
+            const PayoutSignalHeader *temp = reinterpret_cast<const PayoutSignalHeader*>(file.get_data());
+            int err = ErrorType::OK;
+            if(file.get_size() < sizeof(PayoutSignalHeader) || temp->magic != MAGIC) {
+                err = SignalFileErrorType::SIGNAL_BAD_FORMAT;
+            } else
+            if(temp->version != PAYOUT_SIGNAL_VERSION) {
+                err = SignalFileErrorType::SIGNAL_BAD_VERSION;
+            } else
+            if(temp->header_size != sizeof(PayoutSignalHeader) ||
+                temp->record_size != sizeof(RECORD) ||
+                temp->records > (file.get_size() - sizeof(PayoutSignalHeader)) / sizeof(RECORD) ||
+                temp->header_size + temp->records * sizeof(RECORD) != file.get_size()) {
+                err = SignalFileErrorType::SIGNAL_BAD_FORMAT;
+            }
+            if(err != ErrorType::OK) {
+                file.close();
+                return err;
+            }
+            header = temp;
+            return ErrorType::OK;
+        }
+
+        /// Закрыть файл
+        void close() {
+            file.close();
+            header = nullptr;
+        }
+
+        /// Сообщить системе, что записи читаются последовательно
+        inline void advise_sequential() const {file.advise_sequential();}
+
+        inline const bool is_open() const {return header != nullptr;}
+        inline const PayoutSignalHeader *get_header() const {return header;}
+        inline const size_t size() const {return header ? (size_t)header->records : 0;}
+
+        inline const RECORD *get_records() const {
+            return reinterpret_cast<const RECORD*>(file.get_data() + sizeof(PayoutSignalHeader));
+        }
+    };
+
+    typedef PayoutRecordFile<PayoutSignal, PAYOUT_SIGNAL_MAGIC> PayoutSignalFile;               ///< Файл сигналов
+    typedef PayoutRecordFile<PayoutSignalResult, PAYOUT_SIGNAL_RESULT_MAGIC> PayoutSignalResultFile; ///< Файл результатов
+
+    /** \brief Записать файл сигналов
+     * \param file_name Имя файла
+     * \param signal Массив сигналов
+     * \param size Количество сигналов
+     * \return Вернет ErrorType::OK или код ошибки, см. SignalFileErrorType
+     */
+    inline const int save_payout_signals(
+            const std::string &file_name,
+            const PayoutSignal *signal,
+            const size_t size) {
+        PayoutSignalHeader header;
+        std::memset(&header, 0, sizeof(header));
+        header.magic = PAYOUT_SIGNAL_MAGIC;
+        header.version = PAYOUT_SIGNAL_VERSION;
+        header.header_size = sizeof(PayoutSignalHeader);
+        header.record_size = sizeof(PayoutSignal);
+        header.records = size;
+        std::ofstream file(file_name, std::ios::binary | std::ios::trunc);
+        if(!file) return SignalFileErrorType::SIGNAL_FILE_NOT_OPEN;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(signal), size * sizeof(PayoutSignal));
+        file.close();
+        if(!file) return SignalFileErrorType::SIGNAL_WRITE_ERROR;
+        return ErrorType::OK;
+    }
+
+    /// Параметры расчета файла сигналов
+    class PayoutSignalConfig {
+    public:
+        int mode = SIGNAL_PAYOUT;       ///< Расчет, см. PayoutSignalMode
+        uint32_t threads = 0;           ///< Количество потоков (0 - по количеству ядер)
+        size_t chunk = 1 << 16;         ///< Количество сигналов в части, которую поток считает за раз
+    };
+
+    /** \brief Рассчитать файл сигналов и записать файл результатов
+     *
+     * Файл сигналов отображается в память и читается последовательно, в памяти процесса
+     * находятся только буферы частей (threads * chunk записей дважды). Потоки считают части
+     * пакетными методами модели, а запись результатов предыдущей группы частей в файл
+     * идет одновременно с расчетом следующей. Результаты совпадают с вызовами get_payout и get_amount
+     * модели для каждого сигнала. Файл результатов записывается под временным именем и затем переименовывается.
+     * \param model Модель брокера (IntradeBar или Grandcapital)
+     * \param signal_file_name Имя файла сигналов
+     * \param result_file_name Имя файла результатов
+     * \param config Параметры расчета
+     * \param[out] records Количество рассчитанных сигналов (может быть nullptr)
+     * \return Вернет ErrorType::OK или код ошибки, см. SignalFileErrorType
+     */
+    template<class MODEL>
+    const int evaluate_payout_signals(
+            const MODEL &model,
+            const std::string &signal_file_name,
+            const std::string &result_file_name,
+            const PayoutSignalConfig &config = PayoutSignalConfig(),
+            uint64_t *records = nullptr) {
+        if(records) *records = 0;
+        if(config.mode != SIGNAL_PAYOUT && config.mode != SIGNAL_AMOUNT) return SignalFileErrorType::SIGNAL_BAD_FORMAT;
+        PayoutSignalFile signal_file;
+        const int err = signal_file.open(signal_file_name);
+        if(err != ErrorType::OK) return err;
+        signal_file.advise_sequential();
+        const PayoutSignal *signal = signal_file.get_records();
+        const size_t size = signal_file.size();
+
+        const std::string temp_name = result_file_name + ".tmp";
+        std::ofstream file(temp_name, std::ios::binary | std::ios::trunc);
+        if(!file) return SignalFileErrorType::SIGNAL_FILE_NOT_OPEN;
+        PayoutSignalHeader header;
+        std::memset(&header, 0, sizeof(header));
+        header.magic = PAYOUT_SIGNAL_RESULT_MAGIC;
+        header.version = PAYOUT_SIGNAL_VERSION;
+        header.header_size = sizeof(PayoutSignalHeader);
+        header.record_size = sizeof(PayoutSignalResult);
+        header.mode = config.mode;
+        header.records = size;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        const size_t chunk = std::max(config.chunk, (size_t)1);
+        const size_t chunks = (size + chunk - 1) / chunk;
+        size_t threads = config.threads ? config.threads : std::max(1U, std::thread::hardware_concurrency());
+        threads = std::max(std::min(threads, chunks), (size_t)1);
+
+        /// Буферы части: столбцы пакетного метода и записи результатов
+        class Buffer {
+        public:
+            std::vector<xtime::timestamp_t> timestamp;
+            std::vector<uint32_t> duration;
+            std::vector<uint32_t> currency_pair_index;
+            std::vector<double> amount;
+            std::vector<double> balance;
+            std::vector<double> winrate;
+            std::vector<double> attenuator;
+            std::vector<double> payout_limiter;
+            std::vector<double> winrate_limiter;
+            std::vector<double> out_amount;
+            std::vector<double> out_payout;
+            std::vector<int> out_err;
+            std::vector<PayoutSignalResult> result;
+        };
+        std::vector<Buffer> buffers(2 * threads);
+
+        auto work = [&](Buffer &buffer, const size_t begin, const size_t end) {
+            const size_t n = end - begin;
+            const PayoutSignal *s = signal + begin;
+            buffer.timestamp.resize(n);
+            buffer.duration.resize(n);
+            buffer.currency_pair_index.resize(n);
+            buffer.out_payout.resize(n);
+            buffer.out_err.resize(n);
+            buffer.result.resize(n);
+            for(size_t i = 0; i < n; ++i) {
+                buffer.timestamp[i] = s[i].timestamp;
+                buffer.duration[i] = s[i].duration;
+                buffer.currency_pair_index[i] = s[i].currency_pair_index;
+            }
+            if(config.mode == SIGNAL_PAYOUT) {
+                buffer.amount.resize(n);
+                for(size_t i = 0; i < n; ++i) {
+                    buffer.amount[i] = s[i].amount;
+                }
+                model.get_payout(buffer.out_payout.data(), buffer.out_err.data(), buffer.timestamp.data(),
+                    buffer.duration.data(), buffer.currency_pair_index.data(), buffer.amount.data(), n);
+                for(size_t i = 0; i < n; ++i) {
+                    buffer.result[i] = PayoutSignalResult{buffer.amount[i], buffer.out_payout[i], buffer.out_err[i], 0};
+                }
+                return;
+            }
+            buffer.balance.resize(n);
+            buffer.winrate.resize(n);
+            buffer.attenuator.resize(n);
+            buffer.payout_limiter.resize(n);
+            buffer.winrate_limiter.resize(n);
+            buffer.out_amount.resize(n);
+            for(size_t i = 0; i < n; ++i) {
+                buffer.balance[i] = s[i].balance;
+                buffer.winrate[i] = s[i].winrate;
+                buffer.attenuator[i] = s[i].attenuator;
+                buffer.payout_limiter[i] = s[i].payout_limiter;
+                buffer.winrate_limiter[i] = s[i].winrate_limiter;
+            }
+            model.get_amount(buffer.out_amount.data(), buffer.out_payout.data(), buffer.out_err.data(),
+                buffer.timestamp.data(), buffer.duration.data(), buffer.currency_pair_index.data(),
+                buffer.balance.data(), buffer.winrate.data(), buffer.attenuator.data(),
+                buffer.payout_limiter.data(), buffer.winrate_limiter.data(), n);
+            for(size_t i = 0; i < n; ++i) {
+                buffer.result[i] = PayoutSignalResult{buffer.out_amount[i], buffer.out_payout[i], buffer.out_err[i], 0};
+            }
+        };
+
+        /* группа - threads частей подряд, результаты группы пишутся в файл во время расчета следующей группы */
+        auto write_group = [&](const size_t group) {
+            const size_t first = group * threads;
+            const size_t last = std::min(first + threads, chunks);
+            for(size_t c = first; c < last; ++c) {
+                const Buffer &buffer = buffers[(group % 2) * threads + (c - first)];
+                file.write(reinterpret_cast<const char*>(buffer.result.data()),
+                    buffer.result.size() * sizeof(PayoutSignalResult));
+            }
+        };
+        const size_t groups = (chunks + threads - 1) / threads;
+        for(size_t group = 0; group < groups; ++group) {
+            const size_t first = group * threads;
+            const size_t last = std::min(first + threads, chunks);
+            std::vector<std::thread> workers;
+            for(size_t c = first + 1; c < last; ++c) {
+                workers.emplace_back(work, std::ref(buffers[(group % 2) * threads + (c - first)]),
+                    c * chunk, std::min((c + 1) * chunk, size));
+            }
+            if(group > 0) write_group(group - 1);
+            work(buffers[(group % 2) * threads], first * chunk, std::min((first + 1) * chunk, size));
+            for(std::thread &worker : workers) {
+                worker.join();
+            }
+        }
+        if(groups > 0) write_group(groups - 1);
+
+        file.close();
+        if(!file) {
+            std::remove(temp_name.c_str());
+            return SignalFileErrorType::SIGNAL_WRITE_ERROR;
+        }
+#if defined(_WIN32)
+        std::remove(result_file_name.c_str());
+#endif
+        if(std::rename(temp_name.c_str(), result_file_name.c_str()) != 0) {
+            std::remove(temp_name.c_str());
+            return SignalFileErrorType::SIGNAL_WRITE_ERROR;
+        }
+        if(records) *records = size;
+        return ErrorType::OK;
+    }
+}
+
+#endif // PAYOUT_MODEL_SIGNAL_FILE_HPP_INCLUDED
@@ -0,0 +1,214 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_SIMD_HPP_INCLUDED
+#define PAYOUT_MODEL_SIMD_HPP_INCLUDED
+
+/* Векторные ядра пакетных методов выбираются при компиляции:
+ * AVX2 (4 значения double), иначе SSE4.1 (2 значения double).
+ * Определите PAYOUT_MODEL_NO_SIMD, чтобы использовать только скалярный код.
+ */
+#if !defined(PAYOUT_MODEL_NO_SIMD)
+#   if defined(__AVX2__)
+#       define PAYOUT_MODEL_SIMD_AVX2
+#       define PAYOUT_MODEL_SIMD
+#       include <immintrin.h>
+#   elif defined(__SSE4_1__)
+#       define PAYOUT_MODEL_SIMD_SSE4
+#       define PAYOUT_MODEL_SIMD
+#       include <smmintrin.h>
+#   endif
+#endif
+
+#include <cstdint>
+#include <cstddef>
+
+namespace payout_model {
+namespace simd {
+
+#if defined(PAYOUT_MODEL_SIMD)
+
+    /** \brief Вектор значений double
+     *
+     * Маски сравнений хранятся в этом же типе (все биты элемента равны 1 или 0).
+     * Целые числа (метки времени, длительности) переводятся в double точно,
+     * если они меньше 2^52.
+     */
+    class VDouble {
+    public:
+#   if defined(PAYOUT_MODEL_SIMD_AVX2)
+        typedef __m256d native_t;
+        static const size_t size = 4;
+#   else
+        typedef __m128d native_t;
+        static const size_t size = 2;
+#   endif
+        native_t v;
+
+        VDouble() {}
+        VDouble(const native_t value) : v(value) {}
+
+#   if defined(PAYOUT_MODEL_SIMD_AVX2)
+        inline static VDouble set1(const double value) {return _mm256_set1_pd(value);}
+        inline static VDouble load(const double *data) {return _mm256_loadu_pd(data);}
+
+        /// Загрузить беззнаковые 64-битные целые числа меньше 2^52
+        inline static VDouble load_u64(const uint64_t *data) {
+            const __m256i magic = _mm256_set1_epi64x(0x4330000000000000LL);
+            const __m256i x = _mm256_loadu_si256((const __m256i*)data);
+            return _mm256_sub_pd(
+                _mm256_castsi256_pd(_mm256_or_si256(x, magic)),
+                _mm256_castsi256_pd(magic));
+        }
+
+        /// Загрузить беззнаковые 32-битные целые числа
+        inline static VDouble load_u32(const uint32_t *data) {
+            const __m256i magic = _mm256_set1_epi64x(0x4330000000000000LL);
+            const __m256i x = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i*)data));
+            return _mm256_sub_pd(
+                _mm256_castsi256_pd(_mm256_or_si256(x, magic)),
+                _mm256_castsi256_pd(magic));
+        }
+
+        inline void store(double *data) const {_mm256_storeu_pd(data, v);}
+
+        /// Сохранить целые значения как int32
+        inline void store_i32(int32_t *data) const {
+            _mm_storeu_si128((__m128i*)data, _mm256_cvtpd_epi32(v));
+        }
+
+        inline VDouble floor() const {return _mm256_floor_pd(v);}
+
+        friend inline VDouble operator + (const VDouble &a, const VDouble &b) {return _mm256_add_pd(a.v, b.v);}
+        friend inline VDouble operator - (const VDouble &a, const VDouble &b) {return _mm256_sub_pd(a.v, b.v);}
+        friend inline VDouble operator * (const VDouble &a, const VDouble &b) {return _mm256_mul_pd(a.v, b.v);}
+        friend inline VDouble operator / (const VDouble &a, const VDouble &b) {return _mm256_div_pd(a.v, b.v);}
+        friend inline VDouble operator < (const VDouble &a, const VDouble &b) {return _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ);}
+        friend inline VDouble operator <= (const VDouble &a, const VDouble &b) {return _mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ);}
+        friend inline VDouble operator > (const VDouble &a, const VDouble &b) {return _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ);}
+        friend inline VDouble operator >= (const VDouble &a, const VDouble &b) {return _mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ);}
+        friend inline VDouble operator == (const VDouble &a, const VDouble &b) {return _mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ);}
+        friend inline VDouble operator != (const VDouble &a, const VDouble &b) {return _mm256_cmp_pd(a.v, b.v, _CMP_NEQ_UQ);}
+        friend inline VDouble operator & (const VDouble &a, const VDouble &b) {return _mm256_and_pd(a.v, b.v);}
+        friend inline VDouble operator | (const VDouble &a, const VDouble &b) {return _mm256_or_pd(a.v, b.v);}
+
+        friend inline VDouble operator ~ (const VDouble &a) {
+            return _mm256_xor_pd(a.v, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)));
+        }
+
+        /// Вернет ~a & b
+        friend inline VDouble andnot(const VDouble &a, const VDouble &b) {return _mm256_andnot_pd(a.v, b.v);}
+
+        /// Вернет mask ? a : b
+        friend inline VDouble select(const VDouble &mask, const VDouble &a, const VDouble &b) {
+            return _mm256_blendv_pd(b.v, a.v, mask.v);
+        }
+
+        /// Вернет true, если хотя бы один элемент маски установлен
+        friend inline bool any(const VDouble &mask) {return _mm256_movemask_pd(mask.v) != 0;}
+#   else
+        inline static VDouble set1(const double value) {return _mm_set1_pd(value);}
+        inline static VDouble load(const double *data) {return _mm_loadu_pd(data);}
+
+        /// Загрузить беззнаковые 64-битные целые числа меньше 2^52
+        inline static VDouble load_u64(const uint64_t *data) {
+            const __m128i magic = _mm_set1_epi64x(0x4330000000000000LL);
+            const __m128i x = _mm_loadu_si128((const __m128i*)data);
+            return _mm_sub_pd(
+                _mm_castsi128_pd(_mm_or_si128(x, magic)),
+                _mm_castsi128_pd(magic));
+        }
+
+        /// Загрузить беззнаковые 32-битные целые числа
+        inline static VDouble load_u32(const uint32_t *data) {
+            const __m128i magic = _mm_set1_epi64x(0x4330000000000000LL);
+            const __m128i x = _mm_cvtepu32_epi64(_mm_loadl_epi64((const __m128i*)data));
+            return _mm_sub_pd(
+                _mm_castsi128_pd(_mm_or_si128(x, magic)),
+                _mm_castsi128_pd(magic));
+        }
+
+        inline void store(double *data) const {_mm_storeu_pd(data, v);}
+
+        /// Сохранить целые значения как int32
+        inline void store_i32(int32_t *data) const {
+            _mm_storel_epi64((__m128i*)data, _mm_cvtpd_epi32(v));
+        }
+
+        inline VDouble floor() const {return _mm_floor_pd(v);}
+
+        friend inline VDouble operator + (const VDouble &a, const VDouble &b) {return _mm_add_pd(a.v, b.v);}
+        friend inline VDouble operator - (const VDouble &a, const VDouble &b) {return _mm_sub_pd(a.v, b.v);}
+        friend inline VDouble operator * (const VDouble &a, const VDouble &b) {return _mm_mul_pd(a.v, b.v);}
+        friend inline VDouble operator / (const VDouble &a, const VDouble &b) {return _mm_div_pd(a.v, b.v);}
+        friend inline VDouble operator < (const VDouble &a, const VDouble &b) {return _mm_cmplt_pd(a.v, b.v);}
+        friend inline VDouble operator <= (const VDouble &a, const VDouble &b) {return _mm_cmple_pd(a.v, b.v);}
+        friend inline VDouble operator > (const VDouble &a, const VDouble &b) {return _mm_cmpgt_pd(a.v, b.v);}
+        friend inline VDouble operator >= (const VDouble &a, const VDouble &b) {return _mm_cmpge_pd(a.v, b.v);}
+        friend inline VDouble operator == (const VDouble &a, const VDouble &b) {return _mm_cmpeq_pd(a.v, b.v);}
+        friend inline VDouble operator != (const VDouble &a, const VDouble &b) {return _mm_cmpneq_pd(a.v, b.v);}
+        friend inline VDouble operator & (const VDouble &a, const VDouble &b) {return _mm_and_pd(a.v, b.v);}
+        friend inline VDouble operator | (const VDouble &a, const VDouble &b) {return _mm_or_pd(a.v, b.v);}
+
+        friend inline VDouble operator ~ (const VDouble &a) {
+            return _mm_xor_pd(a.v, _mm_castsi128_pd(_mm_set1_epi64x(-1)));
+        }
+
+        /// Вернет ~a & b
+        friend inline VDouble andnot(const VDouble &a, const VDouble &b) {return _mm_andnot_pd(a.v, b.v);}
+
+        /// Вернет mask ? a : b
+        friend inline VDouble select(const VDouble &mask, const VDouble &a, const VDouble &b) {
+            return _mm_blendv_pd(b.v, a.v, mask.v);
+        }
+
+        /// Вернет true, если хотя бы один элемент маски установлен
+        friend inline bool any(const VDouble &mask) {return _mm_movemask_pd(mask.v) != 0;}
+#   endif
+    };
+
+    /** \brief Целочисленное деление неотрицательных целых чисел, хранящихся в double
+     *
+     * Частное через умножение на обратную величину может ошибиться на единицу,
+     * поэтому результат корректируется по остатку.
+     * \param x Делимое (целое число меньше 2^52)
+     * \param divisor Делитель
+     * \return Частное, округленное вниз
+     */
+    inline VDouble floor_div(const VDouble &x, const double divisor) {
+        const VDouble d = VDouble::set1(divisor);
+        const VDouble one = VDouble::set1(1.0);
+        const VDouble zero = VDouble::set1(0.0);
+        VDouble q = (x * VDouble::set1(1.0 / divisor)).floor();
+        const VDouble r = x - q * d;
+        q = q + (one & (r >= d));
+        q = q - (one & (r < zero));
+        return q;
+    }
+
+#endif // PAYOUT_MODEL_SIMD
+
+}
+}
+
+#endif // PAYOUT_MODEL_SIMD_HPP_INCLUDED
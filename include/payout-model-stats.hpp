@@ -0,0 +1,249 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_STATS_HPP_INCLUDED
+#define PAYOUT_MODEL_STATS_HPP_INCLUDED
+
+#include <array>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <cstdio>
+
+namespace payout_model {
+
+    /** \brief Снимок счетчиков состояний выплат
+     *
+     * Счетчики разбиты по валютной паре, часу дня (UTC) и состоянию выплаты.
+     * Последняя строка валютных пар учитывает вызовы с неизвестной валютной парой.
+     */
+    class PayoutStatsSnapshot {
+    public:
+        static const uint32_t CANCEL_TYPES = 12;    ///< Количество состояний (0 и коды от -1 до -11)
+        static const uint32_t HOURS = 24;           ///< Количество часов дня
+
+        uint32_t pairs = 0;             ///< Количество строк валютных пар, включая строку неизвестной пары
+        std::vector<uint64_t> counts;   ///< Счетчики [пара][час][состояние]
+
+        /** \brief Получить имя состояния выплаты
+         * \param err Состояние выплаты (0 или PayoutCancelType)
+         * \return Имя состояния или пустая строка
+         */
+        inline static const char *get_cancel_name(const int err) {
+            static const char *names[CANCEL_TYPES] = {
+                "OK", "DAY_OFF", "NIGHT_HOURS", "BEGIN_EVENING_HOUR", "TOO_LITTLE_TIME", "TOO_MUCH_TIME",
+                "CURRENCY_PAIR_IS_MISSING", "TOO_LITTLE_MONEY", "FXCM_MON", "EXPIRATION_ERROR",
+                "TOO_LITTLE_WINRATE", "EXIT_OVER_END_DAY"};
+            const uint32_t type = (uint32_t)-err;
+            return type < CANCEL_TYPES ? names[type] : "";
+        }
+
+        /** \brief Получить количество вызовов
+         * \param pair Номер валютной пары (pairs - 1 для неизвестной пары)
+         * \param hour Час дня
+         * \param err Состояние выплаты (0 или PayoutCancelType)
+         * \return Количество вызовов
+         */
+        inline const uint64_t get(const uint32_t pair, const uint32_t hour, const int err) const {
+            const uint32_t type = (uint32_t)-err;
+            if(pair >= pairs || hour >= HOURS || type >= CANCEL_TYPES) return 0;
+            return counts[(pair * HOURS + hour) * CANCEL_TYPES + type];
+        }
+
+        /// Количество вызовов для валютной пары за все часы
+        inline const uint64_t get_pair(const uint32_t pair, const int err) const {
+            uint64_t sum = 0;
+            for(uint32_t hour = 0; hour < HOURS; ++hour) sum += get(pair, hour, err);
+            return sum;
+        }
+
+        /// Количество вызовов для часа дня по всем валютным парам
+        inline const uint64_t get_hour(const uint32_t hour, const int err) const {
+            uint64_t sum = 0;
+            for(uint32_t pair = 0; pair < pairs; ++pair) sum += get(pair, hour, err);
+            return sum;
+        }
+
+        /// Количество вызовов с указанным состоянием
+        inline const uint64_t get_total(const int err) const {
+            uint64_t sum = 0;
+            for(uint32_t pair = 0; pair < pairs; ++pair) sum += get_pair(pair, err);
+            return sum;
+        }
+
+        /// Количество всех вызовов
+        inline const uint64_t get_calls() const {
+            uint64_t sum = 0;
+            for(const uint64_t count : counts) sum += count;
+            return sum;
+        }
+
+        /** \brief Преобразовать снимок в текст
+         *
+         * Каждая строка содержит имя валютной пары, имя состояния, час и количество вызовов через табуляцию.
+         * Нулевые счетчики пропускаются.
+         * \param get_pair_name Функция, которая возвращает имя валютной пары по номеру
+         * \return Текст снимка
+         */
+        template<class NAME>
+        std::string to_string(const NAME &get_pair_name) const {
+            std::string text;
+            char buffer[64];
+            for(uint32_t pair = 0; pair < pairs; ++pair)
+            for(uint32_t type = 0; type < CANCEL_TYPES; ++type)
+            for(uint32_t hour = 0; hour < HOURS; ++hour) {
+                const uint64_t count = counts[(pair * HOURS + hour) * CANCEL_TYPES + type];
+                if(count == 0) continue;
+                text += pair + 1 < pairs ? std::string(get_pair_name(pair)) : std::string("UNKNOWN");
+                std::snprintf(buffer, sizeof(buffer), "\t%s\t%u\t%llu\n",
+                    get_cancel_name(-(int)type), hour, (unsigned long long)count);
+                text += buffer;
+            }
+            return text;
+        }
+    };
+
+    /** \brief Счетчики состояний выплат по валютной паре и часу дня
+     *
+     * Счетчики включаются макросом PAYOUT_MODEL_STATS (опция CMake BO_PAYOUT_MODEL_STATS).
+     * Каждый поток пишет в свой блок счетчиков, выровненный по кэш-линии, поэтому учет вызова -
+     * одно увеличение счетчика без атомарных операций чтения-записи и без ложного разделения кэш-линий.
+     * Блоки потоков суммируются только при получении снимка. Счетчики завершившихся потоков
+     * переносятся в общий блок. Без макроса модели не вызывают add и снимок пустой.
+     * \tparam BROKER Класс модели брокера (отделяет счетчики брокеров друг от друга)
+     * \tparam PAIRS Количество валютных пар брокера
+     */
+    template<class BROKER, uint32_t PAIRS>
+    class PayoutStats {
+    public:
+        static const uint32_t CANCEL_TYPES = PayoutStatsSnapshot::CANCEL_TYPES;
+        static const uint32_t HOURS = PayoutStatsSnapshot::HOURS;
+        static const uint32_t ROWS = PAIRS + 1;                     ///< Валютные пары и строка неизвестной пары
+        static const size_t SIZE = (size_t)ROWS * HOURS * CANCEL_TYPES;
+
+#       if defined(PAYOUT_MODEL_STATS)
+        static const bool is_enabled = true;
+#       else
+        static const bool is_enabled = false;
+#       endif
+
+    private:
+
+        class Block;
+
+        /// Список блоков работающих потоков и сумма счетчиков завершившихся потоков
+        class Registry {
+        public:
+            std::mutex mutex;
+            std::vector<Block*> blocks;
+            std::vector<uint64_t> retired = std::vector<uint64_t>(SIZE, 0);
+        };
+
+        inline static Registry &get_registry() {
+            static Registry registry;
+            return registry;
+        }
+
+        /// Блок счетчиков потока. Записывает только поток-владелец, поэтому достаточно relaxed
+        class alignas(64) Block {
+        public:
+            std::array<std::atomic<uint64_t>, SIZE> counts {};
+
+            Block() {
+                Registry &registry = get_registry();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                registry.blocks.push_back(this);
+            }
+
+            ~Block() {
+                Registry &registry = get_registry();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                for(size_t i = 0; i < SIZE; ++i) {
+                    registry.retired[i] += counts[i].load(std::memory_order_relaxed);
+                }
+                registry.blocks.erase(std::find(registry.blocks.begin(), registry.blocks.end(), this));
+            }
+        };
+
+        inline static std::atomic<uint64_t> *get_counts() {
+            /* указатель без конструктора не требует проверки инициализации при каждом обращении */
+            thread_local std::atomic<uint64_t> *counts = nullptr;
+            if(counts) return counts;
+            thread_local Block block;
+            counts = block.counts.data();
+            return counts;
+        }
+
+    public:
+
+        /** \brief Учесть вызов
+         * \param currency_pair_index Номер валютной пары (неизвестные номера учитываются отдельной строкой)
+         * \param hour Час дня (UTC)
+         * \param err Состояние выплаты (0 или PayoutCancelType)
+         */
+        inline static void add(const uint32_t currency_pair_index, const uint32_t hour, const int err) {
+            const uint32_t type = (uint32_t)-err;
+            if(type >= CANCEL_TYPES || hour >= HOURS) return;
+            const uint32_t pair = std::min(currency_pair_index, PAIRS);
+            std::atomic<uint64_t> &counter = get_counts()[((size_t)pair * HOURS + hour) * CANCEL_TYPES + type];
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        /** \brief Получить снимок счетчиков всех потоков
+         * \return Снимок счетчиков
+         */
+        static PayoutStatsSnapshot get_snapshot() {
+            PayoutStatsSnapshot snapshot;
+            snapshot.pairs = ROWS;
+            Registry &registry = get_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            snapshot.counts = registry.retired;
+            for(const Block *block : registry.blocks) {
+                for(size_t i = 0; i < SIZE; ++i) {
+                    snapshot.counts[i] += block->counts[i].load(std::memory_order_relaxed);
+                }
+            }
+            return snapshot;
+        }
+
+        /** \brief Обнулить счетчики всех потоков
+         *
+         * Вызовы, которые другие потоки учитывают одновременно с обнулением, могут сохраниться или потеряться.
+         * Для точного учета за интервал лучше вычитать снимки.
+         */
+        static void reset() {
+            Registry &registry = get_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            std::fill(registry.retired.begin(), registry.retired.end(), 0);
+            for(Block *block : registry.blocks) {
+                for(size_t i = 0; i < SIZE; ++i) {
+                    block->counts[i].store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+    };
+}
+
+#endif // PAYOUT_MODEL_STATS_HPP_INCLUDED
@@ -0,0 +1,477 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_SURFACE_HPP_INCLUDED
+#define PAYOUT_MODEL_SURFACE_HPP_INCLUDED
+
+#include "intrade-bar-payout-model.hpp"
+#include "grandcapital-payout-model.hpp"
+#include "payout-model-mapped-file.hpp"
+#include "payout-model-tradability.hpp"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include "xtime.hpp"
+
+namespace payout_model {
+
+    static const uint64_t PAYOUT_SURFACE_MAGIC = 0x3146525553504F42ULL; /**< Сигнатура файла поверхности выплат ("BOPSURF1" в little-endian) */
+    static const uint32_t PAYOUT_SURFACE_VERSION = 1;               /**< Версия формата файла поверхности выплат */
+    static const uint32_t PAYOUT_SURFACE_VALUES = 256;              /**< Максимальное количество различных процентов выплат */
+
+    static const uint32_t INTRADE_BAR_SURFACE_DURATION_CLASSES = 4; /**< Классы длительности Intrade.bar: 60, 180, 240-30000, 181-239 */
+    static const uint32_t INTRADE_BAR_SURFACE_AMOUNT_TIERS = 3;     /**< Уровни ставки Intrade.bar: меньше минимальной, обычная, повышенная */
+    static const uint32_t GRANDCAPITAL_SURFACE_DURATION_CLASSES = 1;/**< Классы длительности Grandcapital: 60-172800 */
+    static const uint32_t GRANDCAPITAL_SURFACE_AMOUNT_TIERS = 2;    /**< Уровни ставки Grandcapital: меньше минимальной, обычная */
+
+    /// Список кодов ошибок файла поверхности выплат
+    enum SurfaceErrorType {
+        SURFACE_FILE_NOT_OPEN = -1,     ///< Не удалось открыть или отобразить файл
+        SURFACE_WRITE_ERROR = -2,       ///< Не удалось записать файл
+        SURFACE_BAD_FORMAT = -3,        ///< Неверная сигнатура, размеры или смещения
+        SURFACE_BAD_VERSION = -4,       ///< Неподдерживаемая версия формата
+        SURFACE_BAD_CHECKSUM = -5,      ///< Контрольная сумма не совпадает
+        SURFACE_TOO_MANY_PAYOUTS = -6,  ///< Различных процентов выплат больше PAYOUT_SURFACE_VALUES
+    };
+
+    /** \brief Заголовок файла поверхности выплат
+     *
+     * После заголовка идут: массив процентов выплат (double[PAYOUT_SURFACE_VALUES]),
+     * ячейки Intrade.bar и ячейки Grandcapital. Ячейки (uint16_t) упорядочены как
+     * [валютная пара][минута недели][класс длительности][уровень ставки]:
+     * младший байт - номер процента выплат, старший - код ошибки со знаком минус.
+     * Контрольная сумма FNV-1a считается по всем байтам после заголовка.
+     * Числа хранятся в порядке байтов машины, которая записала файл.
+     */
+    class PayoutSurfaceHeader {
+    public:
+        uint64_t magic;                     ///< Сигнатура PAYOUT_SURFACE_MAGIC
+        uint32_t version;                   ///< Версия формата PAYOUT_SURFACE_VERSION
+        uint32_t header_size;               ///< Размер заголовка в байтах
+        uint32_t minutes;                   ///< Количество минут недели
+        uint32_t intrade_bar_pairs;         ///< Количество валютных пар Intrade.bar
+        uint32_t intrade_bar_cells;         ///< Количество ячеек на минуту недели Intrade.bar
+        uint32_t grandcapital_pairs;        ///< Количество валютных пар Grandcapital
+        uint32_t grandcapital_cells;        ///< Количество ячеек на минуту недели Grandcapital
+        uint32_t reserved;
+        double intrade_bar_min_amount[2];       ///< Минимальная ставка Intrade.bar (RUB, USD)
+        double intrade_bar_threshold_amount[2]; ///< Порог повышенной выплаты Intrade.bar (RUB, USD)
+        double grandcapital_min_amount[2];      ///< Минимальная ставка Grandcapital (RUB, USD)
+        uint64_t payouts_offset;            ///< Смещение массива процентов выплат
+        uint64_t intrade_bar_offset;        ///< Смещение ячеек Intrade.bar
+        uint64_t grandcapital_offset;       ///< Смещение ячеек Grandcapital
+        uint64_t file_size;                 ///< Размер файла в байтах
+        uint64_t checksum;                  ///< Контрольная сумма данных после заголовка
+    };
+
+    static_assert(sizeof(PayoutSurfaceHeader) % 8 == 0, "Payout surface header must keep 8-byte alignment");
+
+    /** \brief Посчитать контрольную сумму FNV-1a 64
+     * \param data Данные
+     * \param size Размер данных в байтах
+     * \return Контрольная сумма
+     */
+    inline const uint64_t get_payout_surface_checksum(const uint8_t *data, const size_t size) {
+        uint64_t hash = 0xCBF29CE484222325ULL;
+        for(size_t i = 0; i < size; ++i) {
+            hash ^= data[i];
+            hash *= 0x100000001B3ULL;
+        }
+        return hash;
+    }
+
+    /** \brief Построить поверхность выплат
+     *
+     * Ячейки рассчитываются моделями IntradeBar и Grandcapital с указанными правилами
+     * для каждой валютной пары, минуты недели, класса длительности и уровня ставки.
+     * От валюты счета зависят только границы уровней ставки, они хранятся в заголовке,
+     * поэтому один файл обслуживает счета в любой валюте.
+     * Номер процента выплат хранится в одном байте ячейки, поэтому правила,
+     * дающие больше PAYOUT_SURFACE_VALUES различных процентов выплат, не поддерживаются.
+     * \param[out] data Содержимое файла (пустое в случае ошибки)
+     * \param[in] rules Правила выплат
+     * \return Вернет ErrorType::OK или SurfaceErrorType::SURFACE_TOO_MANY_PAYOUTS
+     */
+    inline const int build_payout_surface(
+            std::vector<uint8_t> &data,
+            const PayoutRules &rules = PayoutRules()) {
+        const uint32_t intrade_bar_cells = INTRADE_BAR_SURFACE_DURATION_CLASSES * INTRADE_BAR_SURFACE_AMOUNT_TIERS;
+        const uint32_t grandcapital_cells = GRANDCAPITAL_SURFACE_DURATION_CLASSES * GRANDCAPITAL_SURFACE_AMOUNT_TIERS;
+
+        PayoutSurfaceHeader header;
+        std::memset(&header, 0, sizeof(header));
+        header.magic = PAYOUT_SURFACE_MAGIC;
+        header.version = PAYOUT_SURFACE_VERSION;
+        header.header_size = sizeof(PayoutSurfaceHeader);
+        header.minutes = MINUTES_IN_WEEK;
+        header.intrade_bar_pairs = INTRADE_BAR_CURRENCY_PAIRS;
+        header.intrade_bar_cells = intrade_bar_cells;
+        header.grandcapital_pairs = GRANDCAPITAL_CURRENCY_PAIRS;
+        header.grandcapital_cells = grandcapital_cells;
+        header.intrade_bar_min_amount[0] = rules.intrade_bar.min_amount_rub;
+        header.intrade_bar_min_amount[1] = rules.intrade_bar.min_amount_usd;
+        header.intrade_bar_threshold_amount[0] = rules.intrade_bar.threshold_amount_rub;
+        header.intrade_bar_threshold_amount[1] = rules.intrade_bar.threshold_amount_usd;
+        header.grandcapital_min_amount[0] = rules.grandcapital.min_amount_rub;
+        header.grandcapital_min_amount[1] = rules.grandcapital.min_amount_usd;
+        header.payouts_offset = sizeof(PayoutSurfaceHeader);
+        header.intrade_bar_offset = header.payouts_offset + PAYOUT_SURFACE_VALUES * sizeof(double);
+        header.grandcapital_offset = header.intrade_bar_offset +
+            (uint64_t)INTRADE_BAR_CURRENCY_PAIRS * MINUTES_IN_WEEK * intrade_bar_cells * sizeof(uint16_t);
+        header.file_size = header.grandcapital_offset +
+            (uint64_t)GRANDCAPITAL_CURRENCY_PAIRS * MINUTES_IN_WEEK * grandcapital_cells * sizeof(uint16_t);
+
+        data.assign(header.file_size, 0);
+        double *payouts = reinterpret_cast<double*>(data.data() + header.payouts_offset);
+        uint32_t payouts_size = 1;
+        bool is_overflow = false;
+        auto get_cell = [&](const int err, const double payout) -> uint16_t {
+            uint32_t p = 0;
+            while(p < payouts_size && payouts[p] != payout) ++p;
+            if(p == payouts_size) {
+                /* номер процента выплат не должен попасть в байт кода ошибки */
+                if(payouts_size == PAYOUT_SURFACE_VALUES) {
+                    is_overflow = true;
+                    return 0;
+                }
+                payouts[payouts_size++] = payout;
+            }
+            return (uint16_t)(((-err) << 8) | p);
+        };
+
+        /* Уровень ставки меньше минимальной считается моделью рублевого счета со ставкой -inf,
+         * остальные уровни - моделью счета без ограничений ставки (валюта не RUB и не USD),
+         * чтобы ячейки не зависели от соотношения порогов разных валют
+         */
+        const uint32_t any_currency = 2;
+        const double below_amount = -std::numeric_limits<double>::infinity();
+        /* 4 января 1970 года - воскресенье */
+        const xtime::timestamp_t first_timestamp_week = 3 * xtime::SECONDS_IN_DAY;
+
+        auto intrade_bar_rules = std::make_shared<const IntradeBarRules>(rules.intrade_bar);
+        auto intrade_bar_rub = IntradeBar::make_snapshot(IntradeBar::CURRENCY_RUB, intrade_bar_rules);
+        auto intrade_bar_any = IntradeBar::make_snapshot(any_currency, intrade_bar_rules);
+        const uint32_t class_duration[INTRADE_BAR_SURFACE_DURATION_CLASSES] = {60, 180, 240, 181};
+        uint16_t *intrade_bar = reinterpret_cast<uint16_t*>(data.data() + header.intrade_bar_offset);
+        for(uint32_t p = 0; p < INTRADE_BAR_CURRENCY_PAIRS; ++p)
+        for(uint32_t m = 0; m < MINUTES_IN_WEEK; ++m) {
+            const xtime::timestamp_t timestamp = first_timestamp_week + m * xtime::SECONDS_IN_MINUTE;
+            for(uint32_t c = 0; c < INTRADE_BAR_SURFACE_DURATION_CLASSES; ++c) {
+                double payout = 0.0;
+                int err = intrade_bar_rub->get_payout(payout, timestamp, class_duration[c], p, below_amount);
+                *intrade_bar++ = get_cell(err, payout);
+                err = intrade_bar_any->get_payout(payout, timestamp, class_duration[c], p, 0.0);
+                *intrade_bar++ = get_cell(err, payout);
+                err = intrade_bar_any->get_payout(payout, timestamp, class_duration[c], p,
+                    std::numeric_limits<double>::infinity());
+                *intrade_bar++ = get_cell(err, payout);
+            }
+        }
+
+        auto grandcapital_rules = std::make_shared<const GrandcapitalRules>(rules.grandcapital);
+        auto grandcapital_rub = Grandcapital::make_snapshot(Grandcapital::CURRENCY_RUB, grandcapital_rules);
+        auto grandcapital_any = Grandcapital::make_snapshot(any_currency, grandcapital_rules);
+        uint16_t *grandcapital = reinterpret_cast<uint16_t*>(data.data() + header.grandcapital_offset);
+        for(uint32_t p = 0; p < GRANDCAPITAL_CURRENCY_PAIRS; ++p)
+        for(uint32_t m = 0; m < MINUTES_IN_WEEK; ++m) {
+            const xtime::timestamp_t timestamp = first_timestamp_week + m * xtime::SECONDS_IN_MINUTE;
+            double payout = 0.0;
+            int err = grandcapital_rub->get_payout(payout, timestamp, 60, p, below_amount);
+            *grandcapital++ = get_cell(err, payout);
+            err = grandcapital_any->get_payout(payout, timestamp, 60, p, 0.0);
+            *grandcapital++ = get_cell(err, payout);
+        }
+
+        if(is_overflow) {
+            data.clear();
+            return SurfaceErrorType::SURFACE_TOO_MANY_PAYOUTS;
+        }
+        header.checksum = get_payout_surface_checksum(
+            data.data() + sizeof(PayoutSurfaceHeader), data.size() - sizeof(PayoutSurfaceHeader));
+        std::memcpy(data.data(), &header, sizeof(header));
+        return ErrorType::OK;
+    }
+
+    /** \brief Записать поверхность выплат в файл
+     *
+     * Файл сначала записывается под временным именем и затем переименовывается,
+     * поэтому процессы, которые уже отобразили старый файл, продолжают работать с ним.
+     * \param file_name Имя файла
+     * \param rules Правила выплат
+     * \return Вернет ErrorType::OK или код ошибки, см. SurfaceErrorType
+     */
+    inline const int save_payout_surface(
+            const std::string &file_name,
+            const PayoutRules &rules = PayoutRules()) {
+        std::vector<uint8_t> data;
+        const int err = build_payout_surface(data, rules);
+        if(err != ErrorType::OK) return err;
+        const std::string temp_name = file_name + ".tmp";
+        {
+            std::ofstream file(temp_name, std::ios::binary | std::ios::trunc);
+            if(!file) return SurfaceErrorType::SURFACE_FILE_NOT_OPEN;
+            file.write(reinterpret_cast<const char*>(data.data()), data.size());
+            if(!file) {
+                file.close();
+                std::remove(temp_name.c_str());
+                return SurfaceErrorType::SURFACE_WRITE_ERROR;
+            }
+        }
+#if defined(_WIN32)
+        std::remove(file_name.c_str());
+#endif
+        if(std::rename(temp_name.c_str(), file_name.c_str()) != 0) {
+            std::remove(temp_name.c_str());
+            return SurfaceErrorType::SURFACE_WRITE_ERROR;
+        }
+        return ErrorType::OK;
+    }
+
+    /** \brief Отображенный в память файл поверхности выплат
+     *
+     * Файл отображается только для чтения, поэтому процессы, открывшие один файл,
+     * разделяют его страницы через страничный кэш. Объект нельзя копировать.
+     */
+    class PayoutSurfaceFile {
+    private:
+        MappedFile file;
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+
+        /// Проверить заголовок
+        const int check_header(const bool is_check_sum) const {
+            if(size < sizeof(PayoutSurfaceHeader)) return SurfaceErrorType::SURFACE_BAD_FORMAT;
+            const PayoutSurfaceHeader *header = get_header();
+            if(header->magic != PAYOUT_SURFACE_MAGIC) return SurfaceErrorType::SURFACE_BAD_FORMAT;
+            if(header->version != PAYOUT_SURFACE_VERSION) return SurfaceErrorType::SURFACE_BAD_VERSION;
+            const uint64_t intrade_bar_size = (uint64_t)header->intrade_bar_pairs *
+                header->minutes * header->intrade_bar_cells * sizeof(uint16_t);
+            const uint64_t grandcapital_size = (uint64_t)header->grandcapital_pairs *
+                header->minutes * header->grandcapital_cells * sizeof(uint16_t);
+            if(header->header_size != sizeof(PayoutSurfaceHeader) ||
+                header->minutes != MINUTES_IN_WEEK ||
+                header->intrade_bar_pairs != INTRADE_BAR_CURRENCY_PAIRS ||
+                header->intrade_bar_cells != INTRADE_BAR_SURFACE_DURATION_CLASSES * INTRADE_BAR_SURFACE_AMOUNT_TIERS ||
+                header->grandcapital_pairs != GRANDCAPITAL_CURRENCY_PAIRS ||
+                header->grandcapital_cells != GRANDCAPITAL_SURFACE_DURATION_CLASSES * GRANDCAPITAL_SURFACE_AMOUNT_TIERS ||
+                header->payouts_offset != sizeof(PayoutSurfaceHeader) ||
+                header->intrade_bar_offset != header->payouts_offset + PAYOUT_SURFACE_VALUES * sizeof(double) ||
+                header->grandcapital_offset != header->intrade_bar_offset + intrade_bar_size ||
+                header->file_size != header->grandcapital_offset + grandcapital_size ||
+                header->file_size != size)
+                return SurfaceErrorType::SURFACE_BAD_FORMAT;
+            if(is_check_sum && header->checksum != get_payout_surface_checksum(
+                    data + sizeof(PayoutSurfaceHeader), size - sizeof(PayoutSurfaceHeader)))
+                return SurfaceErrorType::SURFACE_BAD_CHECKSUM;
+            return ErrorType::OK;
+        }
+
+    public:
+
+        PayoutSurfaceFile() {}
+
+        PayoutSurfaceFile(const PayoutSurfaceFile&) = delete;
+        PayoutSurfaceFile &operator=(const PayoutSurfaceFile&) = delete;
+
+        ~PayoutSurfaceFile() {
+            close();
+        }
+
+        /** \brief Открыть файл поверхности выплат
+         * \param file_name Имя файла
+         * \param is_check_sum Проверить контрольную сумму (читает весь файл)
+         * \return Вернет ErrorType::OK или код ошибки, см. SurfaceErrorType
+         */
+        const int open(const std::string &file_name, const bool is_check_sum = true) {
+            close();
+            const int map_err = file.open(file_name);
+            if(map_err == MappedFileErrorType::MAPPED_FILE_EMPTY) return SurfaceErrorType::SURFACE_BAD_FORMAT;
+            if(map_err != ErrorType::OK) return SurfaceErrorType::SURFACE_FILE_NOT_OPEN;
+            data = file.get_data();
+            size = file.get_size();
+            const int err = check_header(is_check_sum);
+            if(err != ErrorType::OK) close();
+            return err;
+        }
+
+        /// Закрыть файл
+        void close() {
+            file.close();
+            data = nullptr;
+            size = 0;
+        }
+
+        inline const bool is_open() const {return data != nullptr;}
+        inline const PayoutSurfaceHeader *get_header() const {return reinterpret_cast<const PayoutSurfaceHeader*>(data);}
+        inline const uint8_t *get_data() const {return data;}
+        inline const size_t get_size() const {return size;}
+    };
+
+    /** \brief Поверхность выплат брокера Intrade.bar из файла
+     *
+     * Легкое представление отображенного файла: хранит указатели на данные
+     * и границы уровней ставки для валюты счета. Ответ находится по смещению
+     * ячейки без вычислений модели. Результаты совпадают с IntradeBar::get_payout
+     * для правил, по которым построен файл. Файл должен быть открыт, пока используется представление.
+     */
+    class IntradeBarSurface {
+    public:
+        typedef IntradeBar::PayoutCancelType PayoutCancelType;
+
+    private:
+        const double *payouts;
+        const uint16_t *cells;
+        double min_amount;
+        double threshold_amount;
+
+    public:
+
+        /** \brief Конструктор представления
+         * \param file Открытый файл поверхности выплат
+         * \param user_currency_name Валюта счета
+         */
+        IntradeBarSurface(const PayoutSurfaceFile &file, const uint32_t user_currency_name) {
+            const PayoutSurfaceHeader *header = file.get_header();
+            payouts = reinterpret_cast<const double*>(file.get_data() + header->payouts_offset);
+            cells = reinterpret_cast<const uint16_t*>(file.get_data() + header->intrade_bar_offset);
+            if(user_currency_name == IntradeBar::CURRENCY_RUB || user_currency_name == IntradeBar::CURRENCY_USD) {
+                min_amount = header->intrade_bar_min_amount[user_currency_name];
+                threshold_amount = header->intrade_bar_threshold_amount[user_currency_name];
+            } else {
+                /* для других валют ограничения ставки не проверяются */
+                min_amount = -std::numeric_limits<double>::infinity();
+                threshold_amount = std::numeric_limits<double>::infinity();
+            }
+        }
+
+        /** \brief Получить процент выплат
+         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
+         * \param[out] payout процент выплат
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] amount размер ставки бинарного опциона
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline const int get_payout(
+                double &payout,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double amount) const {
+            payout = 0.0;
+            /* обрабатываем выход экспирации за конец дня */
+            if(((uint64_t)(timestamp % xtime::SECONDS_IN_DAY) + duration) > IntradeBar::SESSION_END_HOUR * xtime::SECONDS_IN_HOUR)
+                return PayoutCancelType::EXIT_OVER_END_DAY;
+
+            const bool is_pair = currency_pair_index < INTRADE_BAR_CURRENCY_PAIRS;
+            uint32_t duration_class = 0;
+            if(duration == 60) {
+                if(!is_pair) return PayoutCancelType::TOO_LITTLE_TIME;
+            } else
+            if(duration < 180) return PayoutCancelType::TOO_LITTLE_TIME;
+            else
+            if(duration > IntradeBar::MAX_DURATION) return PayoutCancelType::TOO_MUCH_TIME;
+            else
+            if(duration == 180) duration_class = 1;
+            else
+            if(duration >= 240) duration_class = 2;
+            else duration_class = 3;
+
+            if(!is_pair) return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
+
+            const uint32_t amount_tier = amount < min_amount ? 0 : amount >= threshold_amount ? 2 : 1;
+            const uint16_t cell = cells[
+                ((size_t)currency_pair_index * MINUTES_IN_WEEK + get_minute_week(timestamp)) *
+                (INTRADE_BAR_SURFACE_DURATION_CLASSES * INTRADE_BAR_SURFACE_AMOUNT_TIERS) +
+                duration_class * INTRADE_BAR_SURFACE_AMOUNT_TIERS + amount_tier];
+            payout = payouts[cell & 0xFF];
+            return -(int)(cell >> 8);
+        }
+    };
+
+    /** \brief Поверхность выплат брокера Grandcapital из файла
+     *
+     * Результаты совпадают с Grandcapital::get_payout для правил, по которым построен файл.
+     * Файл должен быть открыт, пока используется представление.
+     */
+    class GrandcapitalSurface {
+    public:
+        typedef Grandcapital::PayoutCancelType PayoutCancelType;
+
+    private:
+        const double *payouts;
+        const uint16_t *cells;
+        double min_amount;
+
+    public:
+
+        /** \brief Конструктор представления
+         * \param file Открытый файл поверхности выплат
+         * \param user_currency_name Валюта счета
+         */
+        GrandcapitalSurface(const PayoutSurfaceFile &file, const uint32_t user_currency_name) {
+            const PayoutSurfaceHeader *header = file.get_header();
+            payouts = reinterpret_cast<const double*>(file.get_data() + header->payouts_offset);
+            cells = reinterpret_cast<const uint16_t*>(file.get_data() + header->grandcapital_offset);
+            if(user_currency_name == Grandcapital::CURRENCY_RUB || user_currency_name == Grandcapital::CURRENCY_USD) {
+                min_amount = header->grandcapital_min_amount[user_currency_name];
+            } else {
+                /* для других валют ограничения ставки не проверяются */
+                min_amount = -std::numeric_limits<double>::infinity();
+            }
+        }
+
+        /** \brief Получить процент выплат
+         * Проценты выплат варьируются обычно от 0 до 1.0, где 1.0 соответствует 100% выплате брокера
+         * \param[out] payout процент выплат
+         * \param[in] timestamp временную метку unix времени (GMT)
+         * \param[in] duration длительность опциона в секундах
+         * \param[in] currency_pair_index  номер валютной пары из списка валютных пар брокера
+         * \param[in] amount размер ставки бинарного опциона
+         * \return состояние выплаты (0 в случае успеха, иначе см. PayoutCancelType)
+         */
+        inline const int get_payout(
+                double &payout,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double amount) const {
+            payout = 0.0;
+            if(duration < 60) return PayoutCancelType::TOO_LITTLE_TIME;
+            if(duration > Grandcapital::MAX_DURATION) return PayoutCancelType::TOO_MUCH_TIME;
+            if(currency_pair_index >= GRANDCAPITAL_CURRENCY_PAIRS) return PayoutCancelType::CURRENCY_PAIR_IS_MISSING;
+            const uint32_t amount_tier = amount < min_amount ? 0 : 1;
+            const uint16_t cell = cells[
+                ((size_t)currency_pair_index * MINUTES_IN_WEEK + get_minute_week(timestamp)) *
+                GRANDCAPITAL_SURFACE_AMOUNT_TIERS + amount_tier];
+            payout = payouts[cell & 0xFF];
+            return -(int)(cell >> 8);
+        }
+    };
+}
+
+#endif // PAYOUT_MODEL_SURFACE_HPP_INCLUDED
@@ -0,0 +1,304 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_TIMELINE_HPP_INCLUDED
+#define PAYOUT_MODEL_TIMELINE_HPP_INCLUDED
+
+#include "intrade-bar-payout-model.hpp"
+#include "grandcapital-payout-model.hpp"
+#include "xtime.hpp"
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <limits>
+
+namespace payout_model {
+
+    /// Правила выплат и календари торговли, действующие с указанной метки времени
+    class PayoutRulesEpoch {
+    public:
+        xtime::timestamp_t begin = 0;   ///< Метка времени начала действия правил
+        PayoutRules rules;              ///< Правила выплат
+        std::shared_ptr<const TradingCalendar> intrade_bar_calendar;    ///< Календарь Intrade.bar или nullptr (встроенная сессия без закрытых дней)
+        std::shared_ptr<const TradingCalendar> grandcapital_calendar;   ///< Календарь Grandcapital или nullptr (встроенная сессия без закрытых дней)
+    };
+
+    /** \brief Разобрать текст правил выплат с несколькими эпохами
+     *
+     * Строка "epoch = <метка времени>" начинает новую эпоху. Эпоха наследует
+     * правила предыдущей эпохи (первая - правила по умолчанию) и изменяет их
+     * ключами, которые следуют за ней (см. parse_payout_rules).
+     * Строки до первой строки epoch относятся к эпохе, которая начинается с 0,
+     * поэтому метки времени эпох должны быть больше 0 и возрастать.
+     * Строки с ключами "intrade_bar.calendar.<ключ>" и "grandcapital.calendar.<ключ>" изменяют
+     * календарь торговли брокера (ключи см. parse_trading_calendar), например сессию эпохи:
+     * "grandcapital.calendar.session.mon = 01:00-19:00". Календарь тоже наследуется; если у предыдущих эпох
+     * его нет, изменяется встроенный календарь брокера (get_default_calendar).
+     * \param[in] text Текст правил
+     * \param[out] epochs Эпохи правил, отсортированные по времени начала
+     * \param[out] error_line Номер строки с ошибкой, начиная с 1 (0, если ошибки нет)
+     * \return Вернет ErrorType::OK или код ошибки, см. RulesErrorType
+     */
+    inline const int parse_payout_rules_timeline(
+            const std::string_view text,
+            std::vector<PayoutRulesEpoch> &epochs,
+            uint32_t &error_line) {
+        std::vector<PayoutRulesEpoch> temp(1);
+        error_line = 0;
+        uint32_t line_number = 0;
+        uint32_t chunk_line = 1;
+        size_t chunk_begin = 0;
+        size_t pos = 0;
+        auto parse_chunk = [&](const size_t chunk_end) -> int {
+            uint32_t line = 0;
+            const int err = parse_payout_rules(text.substr(chunk_begin, chunk_end - chunk_begin), temp.back().rules, line);
+            if(err != ErrorType::OK) error_line = chunk_line + line - 1;
+            return err;
+        };
+        while(pos < text.size()) {
+            size_t end = text.find('\n', pos);
+            if(end == std::string_view::npos) end = text.size();
+            std::string_view line = text.substr(pos, end - pos);
+            const size_t line_begin = pos;
+            pos = end + 1;
+            ++line_number;
+
+            const size_t first = line.find_first_not_of(" \t");
+            if(first == std::string_view::npos) continue;
+
+            /* строки календаря разбираются отдельно от правил выплат */
+            const std::string_view key = line.substr(first);
+            const bool is_intrade_bar_calendar = key.substr(0, 21) == "intrade_bar.calendar.";
+            if(is_intrade_bar_calendar || key.substr(0, 22) == "grandcapital.calendar.") {
+                int err = parse_chunk(line_begin);
+                if(err != ErrorType::OK) return err;
+                std::shared_ptr<const TradingCalendar> &calendar = is_intrade_bar_calendar ?
+                    temp.back().intrade_bar_calendar : temp.back().grandcapital_calendar;
+                TradingCalendar temp_calendar = calendar ? *calendar : is_intrade_bar_calendar ?
+                    IntradeBar::get_default_calendar() : Grandcapital::get_default_calendar();
+                uint32_t calendar_line = 0;
+                err = parse_trading_calendar(key.substr(is_intrade_bar_calendar ? 21 : 22), temp_calendar, calendar_line);
+                if(err != ErrorType::OK) {
+                    error_line = line_number;
+                    return err;
+                }
+                calendar = std::make_shared<const TradingCalendar>(temp_calendar);
+                chunk_begin = std::min(pos, text.size());
+                chunk_line = line_number + 1;
+                continue;
+            }
+
+            if(line.substr(first, 5) != "epoch") continue;
+            const size_t equal = line.find('=', first);
+            if(equal == std::string_view::npos ||
+                line.substr(first + 5, equal - first - 5).find_first_not_of(" \t") != std::string_view::npos)
+                continue;
+
+            const int err = parse_chunk(line_begin);
+            if(err != ErrorType::OK) return err;
+
+            const std::string value_str(line.substr(equal + 1));
+            char *value_end = nullptr;
+            const unsigned long long begin = std::strtoull(value_str.c_str(), &value_end, 10);
+            const size_t tail = value_str.find_first_not_of(" \t\r", value_end - value_str.c_str());
+            if(value_end == value_str.c_str() ||
+                (tail != std::string::npos && value_str[tail] != '#') ||
+                begin <= temp.back().begin) {
+                error_line = line_number;
+                return RulesErrorType::RULES_INVALID_VALUE;
+            }
+            PayoutRulesEpoch epoch;
+            epoch.begin = begin;
+            epoch.rules = temp.back().rules;
+            epoch.intrade_bar_calendar = temp.back().intrade_bar_calendar;
+            epoch.grandcapital_calendar = temp.back().grandcapital_calendar;
+            temp.push_back(epoch);
+            chunk_begin = std::min(pos, text.size());
+            chunk_line = line_number + 1;
+        }
+        const int err = parse_chunk(text.size());
+        if(err != ErrorType::OK) return err;
+        epochs = std::move(temp);
+        return ErrorType::OK;
+    }
+
+    /** \brief Модели выплат, действующие в разные периоды времени
+     *
+     * Хранит отсортированный список эпох: метку времени начала и неизменяемый снимок модели.
+     * Эпоха действует до начала следующей эпохи, метки времени до первой эпохи
+     * относятся к первой эпохе. Поиск эпохи выполняется бинарным поиском,
+     * а для возрастающих меток времени курсор находит эпоху за O(1).
+     * \tparam MODEL Класс модели (IntradeBar или Grandcapital)
+     */
+    template<class MODEL>
+    class ModelTimeline {
+    public:
+        typedef std::shared_ptr<const MODEL> ModelPtr;
+
+    private:
+        std::vector<xtime::timestamp_t> begins; ///< Метки времени начала эпох
+        std::vector<ModelPtr> models;           ///< Снимки моделей эпох
+
+    public:
+
+        /** \brief Курсор эпохи для возрастающих меток времени
+         *
+         * Запоминает текущую эпоху и ее границы. Пока метка времени
+         * не выходит за границы эпохи, поиск не выполняется.
+         * Список эпох не должен быть пустым и не должен изменяться, пока используется курсор
+         * (make_model_timeline всегда добавляет хотя бы одну эпоху).
+         */
+        class Cursor {
+        private:
+            const ModelTimeline *timeline;
+            size_t index = 0;
+            xtime::timestamp_t begin = 0;
+            xtime::timestamp_t end = 0;
+
+            inline void set_index(const size_t user_index) {
+                index = user_index;
+                begin = index == 0 ? 0 : timeline->begins[index];
+                end = index + 1 < timeline->begins.size() ?
+                    timeline->begins[index + 1] : std::numeric_limits<xtime::timestamp_t>::max();
+            }
+
+        public:
+
+            explicit Cursor(const ModelTimeline &user_timeline) : timeline(&user_timeline) {
+                set_index(0);
+            }
+
+            /** \brief Получить модель для метки времени
+             * \param timestamp Метка времени
+             * \return Модель эпохи, которая действует в указанное время
+             */
+            inline const MODEL &update(const xtime::timestamp_t timestamp) {
+                if(timestamp < begin || timestamp >= end) {
+                    /* переход на следующую эпоху без поиска */
+                    if(timestamp >= end && (index + 2 >= timeline->begins.size() ||
+                        timestamp < timeline->begins[index + 2])) set_index(index + 1);
+                    else set_index(timeline->find(timestamp));
+                }
+                return *timeline->models[index];
+            }
+
+            /** \brief Получить модель для курсора календаря
+             * \param cursor Курсор календаря
+             * \return Модель эпохи, которая действует в указанное время
+             */
+            inline const MODEL &update(const CalendarCursor &cursor) {
+                return update(cursor.get_timestamp());
+            }
+
+            /// Номер текущей эпохи
+            inline const size_t get_index() const {return index;}
+        };
+
+        /** \brief Добавить эпоху
+         *
+         * Если эпоха с таким же началом уже есть, ее модель заменяется.
+         * \param begin Метка времени начала эпохи
+         * \param model Снимок модели
+         */
+        void add(const xtime::timestamp_t begin, ModelPtr model) {
+            const size_t index = std::lower_bound(begins.begin(), begins.end(), begin) - begins.begin();
+            if(index < begins.size() && begins[index] == begin) {
+                models[index] = std::move(model);
+                return;
+            }
+            begins.insert(begins.begin() + index, begin);
+            models.insert(models.begin() + index, std::move(model));
+        }
+
+        /** \brief Найти номер эпохи
+         * \param timestamp Метка времени
+         * \return Номер эпохи, которая действует в указанное время (0 для меток времени до первой эпохи)
+         */
+        inline const size_t find(const xtime::timestamp_t timestamp) const {
+            const size_t index = std::upper_bound(begins.begin(), begins.end(), timestamp) - begins.begin();
+            return index == 0 ? 0 : index - 1;
+        }
+
+        /** \brief Получить модель для метки времени
+         *
+         * Список эпох не должен быть пустым.
+         * \param timestamp Метка времени
+         * \return Модель эпохи, которая действует в указанное время
+         */
+        inline const MODEL &get(const xtime::timestamp_t timestamp) const {
+            return *models[find(timestamp)];
+        }
+
+        /// Получить курсор эпохи (список эпох не должен быть пустым)
+        inline Cursor get_cursor() const {
+            return Cursor(*this);
+        }
+
+        inline const size_t size() const {return begins.size();}
+        inline const bool empty() const {return begins.empty();}
+        inline const xtime::timestamp_t get_begin(const size_t index) const {return begins[index];}
+        inline const MODEL &get_model(const size_t index) const {return *models[index];}
+    };
+
+    /** \brief Создать модели выплат по эпохам правил
+     *
+     * Снимок модели каждой эпохи получает правила и календарь торговли эпохи (см. set_calendar).
+     * Если список эпох пуст, добавляется эпоха с 0 со встроенными правилами, поэтому результат не бывает пустым.
+     * \tparam MODEL Класс модели (IntradeBar или Grandcapital)
+     * \param epochs Эпохи правил
+     * \param user_currency_name Валюта счета
+     * \return Модели выплат по эпохам
+     */
+    template<class MODEL>
+    ModelTimeline<MODEL> make_model_timeline(
+            const std::vector<PayoutRulesEpoch> &epochs,
+            const uint32_t user_currency_name);
+
+    template<>
+    inline ModelTimeline<IntradeBar> make_model_timeline<IntradeBar>(
+            const std::vector<PayoutRulesEpoch> &epochs,
+            const uint32_t user_currency_name) {
+        ModelTimeline<IntradeBar> timeline;
+        for(size_t i = 0; i < epochs.size(); ++i) {
+            timeline.add(epochs[i].begin, IntradeBar::make_snapshot(user_currency_name,
+                std::make_shared<const IntradeBarRules>(epochs[i].rules.intrade_bar), epochs[i].intrade_bar_calendar));
+        }
+        if(timeline.empty()) timeline.add(0, IntradeBar::make_snapshot(user_currency_name));
+        return timeline;
+    }
+
+    template<>
+    inline ModelTimeline<Grandcapital> make_model_timeline<Grandcapital>(
+            const std::vector<PayoutRulesEpoch> &epochs,
+            const uint32_t user_currency_name) {
+        ModelTimeline<Grandcapital> timeline;
+        for(size_t i = 0; i < epochs.size(); ++i) {
+            timeline.add(epochs[i].begin, Grandcapital::make_snapshot(user_currency_name,
+                std::make_shared<const GrandcapitalRules>(epochs[i].rules.grandcapital), epochs[i].grandcapital_calendar));
+        }
+        if(timeline.empty()) timeline.add(0, Grandcapital::make_snapshot(user_currency_name));
+        return timeline;
+    }
+}
+
+#endif // PAYOUT_MODEL_TIMELINE_HPP_INCLUDED
@@ -0,0 +1,221 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_TRACE_HPP_INCLUDED
+#define PAYOUT_MODEL_TRACE_HPP_INCLUDED
+
+#include <vector>
+#include <cstdint>
+#include "xtime.hpp"
+
+/* Код трассировки компилируется только с макросом PAYOUT_MODEL_TRACE,
+ * без него строки трассировки в расчете ставки удаляются препроцессором
+ */
+#if defined(PAYOUT_MODEL_TRACE)
+#   define PAYOUT_MODEL_AMOUNT_TRACE(...) __VA_ARGS__
+#else
+#   define PAYOUT_MODEL_AMOUNT_TRACE(...)
+#endif
+
+namespace payout_model {
+
+    /// Ветвь расчета ставки IntradeBar::get_amount
+    enum AmountTraceBranch {
+        TRACE_BRANCH_NONE = 0,  ///< Отказ до выбора ветви (время, длительность, валютная пара, выходной)
+        TRACE_BRANCH_60 = 1,    ///< 60% - 63%: начало и конец часа вне дневных часов, экспирация 1 минута
+        TRACE_BRANCH_180 = 2,   ///< 82% / 85%: экспирация 3 минуты
+        TRACE_BRANCH_240 = 3,   ///< 79% / 85%: экспирация от 4 до 500 минут
+    };
+
+    /// Флаги записи трассировки
+    enum AmountTraceFlag {
+        TRACE_HIGH_TIER = 1,        ///< Ставка достигла порога повышенной выплаты
+        TRACE_PAYOUT_LIMITED = 2,   ///< Процент выплат ограничен payout_limiter
+        TRACE_WINRATE_LIMITED = 4,  ///< Винрейт ограничен winrate_limiter
+    };
+
+    /** \brief Запись трассировки расчета ставки
+     *
+     * Значения выплаты, винрейта и коэффициента Келли относятся к последнему
+     * рассчитанному уровню выплаты (при отказе по винрейту это может быть проверенный, но не выбранный уровень).
+     */
+    class AmountTrace {
+    public:
+        xtime::timestamp_t timestamp;   ///< Время сделки
+        uint32_t duration;              ///< Длительность опциона в секундах
+        uint32_t currency_pair_index;   ///< Номер валютной пары
+        int32_t err;                    ///< Состояние выплаты (0 или PayoutCancelType)
+        uint8_t branch;                 ///< Ветвь расчета, см. AmountTraceBranch
+        uint8_t flags;                  ///< Флаги, см. AmountTraceFlag
+        double raw_payout;              ///< Процент выплат уровня по правилам брокера
+        double payout;                  ///< Процент выплат после ограничителя
+        double winrate;                 ///< Винрейт после ограничителя
+        double rate;                    ///< Доля депозита по критерию Келли с учетом ослабления
+        double amount;                  ///< Размер ставки
+    };
+
+    /** \brief Кольцевой буфер записей трассировки
+     *
+     * Память выделяется один раз в конструкторе, при заполнении новые записи заменяют самые старые.
+     */
+    class AmountTraceRing {
+    private:
+        std::vector<AmountTrace> records;
+        uint64_t total = 0;
+
+    public:
+
+        /** \brief Создать буфер
+         * \param capacity Количество хранимых записей
+         */
+        AmountTraceRing(const size_t capacity) : records(capacity) {}
+
+        inline void push(const AmountTrace &record) {
+            if(records.empty()) return;
+            records[total % records.size()] = record;
+            ++total;
+        }
+
+        /// Количество хранимых записей
+        inline const size_t size() const {
+            return total < records.size() ? (size_t)total : records.size();
+        }
+
+        /// Количество записей с момента создания или очистки, включая замененные
+        inline const uint64_t get_total() const {return total;}
+
+        /** \brief Получить запись
+         * \param index Номер записи от самой старой (0) до самой новой (size() - 1)
+         * \return Запись трассировки
+         */
+        inline const AmountTrace &get(const size_t index) const {
+            return records[(total - size() + index) % records.size()];
+        }
+
+        inline void clear() {total = 0;}
+    };
+
+    /** \brief Трассировка расчета ставки в текущем потоке
+     *
+     * Расчет ставки заполняет запись текущего вызова, а методы get_amount модели
+     * добавляют ее в буфер потока, установленный AmountTraceScope.
+     */
+    class AmountTracer {
+    public:
+#       if defined(PAYOUT_MODEL_TRACE)
+        static const bool is_enabled = true;
+#       else
+        static const bool is_enabled = false;
+#       endif
+
+        inline static AmountTraceRing *&get_ring() {
+            thread_local AmountTraceRing *ring = nullptr;
+            return ring;
+        }
+
+        inline static AmountTrace &get_record() {
+            thread_local AmountTrace record;
+            return record;
+        }
+
+        /// Начать запись расчета
+        inline static void begin() {
+            AmountTrace &record = get_record();
+            record.branch = TRACE_BRANCH_NONE;
+            record.flags = 0;
+            record.raw_payout = record.payout = record.winrate = record.rate = 0.0;
+        }
+
+        /// Записать выбранную ветвь
+        inline static void set_branch(const AmountTraceBranch branch) {
+            get_record().branch = branch;
+        }
+
+        /** \brief Записать расчет уровня выплаты
+         * \param is_high_tier Ставка достигла порога повышенной выплаты
+         * \param raw_payout Процент выплат уровня
+         * \param payout Процент выплат после ограничителя
+         * \param raw_winrate Винрейт сигнала
+         * \param winrate Винрейт после ограничителя
+         * \param rate Доля депозита по критерию Келли
+         */
+        inline static void set_tier(
+                const bool is_high_tier,
+                const double raw_payout,
+                const double payout,
+                const double raw_winrate,
+                const double winrate,
+                const double rate) {
+            AmountTrace &record = get_record();
+            record.flags = (is_high_tier ? TRACE_HIGH_TIER : 0) |
+                (payout < raw_payout ? TRACE_PAYOUT_LIMITED : 0) |
+                (winrate < raw_winrate ? TRACE_WINRATE_LIMITED : 0);
+            record.raw_payout = raw_payout;
+            record.payout = payout;
+            record.winrate = winrate;
+            record.rate = rate;
+        }
+
+        /// Завершить запись и добавить ее в буфер потока
+        inline static void push(
+                const int err,
+                const xtime::timestamp_t timestamp,
+                const uint32_t duration,
+                const uint32_t currency_pair_index,
+                const double amount) {
+            AmountTraceRing *ring = get_ring();
+            if(!ring) return;
+            AmountTrace &record = get_record();
+            record.timestamp = timestamp;
+            record.duration = duration;
+            record.currency_pair_index = currency_pair_index;
+            record.err = err;
+            record.amount = amount;
+            ring->push(record);
+        }
+    };
+
+    /** \brief Направить трассировку текущего потока в буфер
+     *
+     * Пока объект существует, вызовы get_amount в этом потоке добавляют записи в буфер.
+     * Без макроса PAYOUT_MODEL_TRACE буфер остается пустым.
+     */
+    class AmountTraceScope {
+    private:
+        AmountTraceRing *previous;
+
+    public:
+        AmountTraceScope(AmountTraceRing &ring) : previous(AmountTracer::get_ring()) {
+            AmountTracer::get_ring() = &ring;
+        }
+
+        ~AmountTraceScope() {
+            AmountTracer::get_ring() = previous;
+        }
+
+        AmountTraceScope(const AmountTraceScope &) = delete;
+        AmountTraceScope &operator=(const AmountTraceScope &) = delete;
+    };
+}
+
+#endif // PAYOUT_MODEL_TRACE_HPP_INCLUDED
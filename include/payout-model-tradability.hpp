@@ -0,0 +1,320 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_TRADABILITY_HPP_INCLUDED
+#define PAYOUT_MODEL_TRADABILITY_HPP_INCLUDED
+
+#include "payout-model-common.hpp"
+#include "payout-model-trading-calendar.hpp"
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include "xtime.hpp"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace payout_model {
+
+    /** \brief Получить минуту недели
+     * \param timestamp Метка времени
+     * \return Минута недели, начиная с воскресенья
+     */
+    inline const uint32_t get_minute_week(const xtime::timestamp_t timestamp) {
+        return (uint32_t)((timestamp / xtime::SECONDS_IN_MINUTE +
+            xtime::THU * xtime::MINUTES_IN_DAY) % MINUTES_IN_WEEK);
+    }
+
+    /// Количество единичных битов
+    inline const uint32_t get_popcount(const uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return (uint32_t)__builtin_popcountll(value);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        return (uint32_t)__popcnt64(value);
+#else
+        uint64_t x = value - ((value >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return (uint32_t)((x * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    /** \brief Битовая маска минут недели
+     *
+     * Бит m соответствует минуте недели m, неделя начинается с воскресенья 00:00 UTC (см. get_minute_week).
+     * Количество минут в интервале считается подсчетом единичных битов по словам маски.
+     */
+    class MinuteWeekMask {
+    public:
+        static const uint32_t WORDS = (MINUTES_IN_WEEK + 63) / 64;
+
+    private:
+        std::array<uint64_t, WORDS> words {};
+
+        /// Маска младших битов слова [0, bits)
+        inline static const uint64_t get_low_bits(const uint32_t bits) {
+            return bits >= 64 ? ~(uint64_t)0 : (((uint64_t)1 << bits) - 1);
+        }
+
+    public:
+
+        inline const bool get(const uint32_t minute) const {
+            return (words[minute >> 6] >> (minute & 63)) & 1;
+        }
+
+        inline void set(const uint32_t minute, const bool value) {
+            if(minute >= MINUTES_IN_WEEK) return;
+            if(value) words[minute >> 6] |= (uint64_t)1 << (minute & 63);
+            else words[minute >> 6] &= ~((uint64_t)1 << (minute & 63));
+        }
+
+        /// Количество минут в маске
+        inline const uint32_t count() const {
+            uint32_t sum = 0;
+            for(const uint64_t word : words) sum += get_popcount(word);
+            return sum;
+        }
+
+        /** \brief Количество минут маски в интервале
+         * \param first Первая минута недели
+         * \param last Минута недели после последней (не больше MINUTES_IN_WEEK)
+         * \return Количество минут в интервале [first, last)
+         */
+        inline const uint32_t count(const uint32_t first, uint32_t last) const {
+            last = std::min(last, MINUTES_IN_WEEK);
+            if(first >= last) return 0;
+            const uint32_t first_word = first >> 6;
+            const uint32_t last_word = (last - 1) >> 6;
+            const uint64_t first_mask = ~get_low_bits(first & 63);
+            const uint64_t last_mask = get_low_bits(((last - 1) & 63) + 1);
+            if(first_word == last_word) return get_popcount(words[first_word] & first_mask & last_mask);
+            uint32_t sum = get_popcount(words[first_word] & first_mask);
+            for(uint32_t w = first_word + 1; w < last_word; ++w) sum += get_popcount(words[w]);
+            return sum + get_popcount(words[last_word] & last_mask);
+        }
+
+        /** \brief Найти следующую минуту маски
+         * \param minute Минута недели, с которой начинается поиск
+         * \return Минута недели не меньше minute или MINUTES_IN_WEEK, если до конца недели минут нет
+         */
+        inline const uint32_t find_next(const uint32_t minute) const {
+            if(minute >= MINUTES_IN_WEEK) return MINUTES_IN_WEEK;
+            uint32_t w = minute >> 6;
+            uint64_t word = words[w] & ~get_low_bits(minute & 63);
+            while(word == 0) {
+                if(++w >= WORDS) return MINUTES_IN_WEEK;
+                word = words[w];
+            }
+            /* младший единичный бит - количество битов в маске младших нулей */
+            return std::min(w * 64 + get_popcount((word & (~word + 1)) - 1), MINUTES_IN_WEEK);
+        }
+
+        inline MinuteWeekMask &operator&=(const MinuteWeekMask &other) {
+            for(uint32_t w = 0; w < WORDS; ++w) words[w] &= other.words[w];
+            return *this;
+        }
+
+        inline MinuteWeekMask &operator|=(const MinuteWeekMask &other) {
+            for(uint32_t w = 0; w < WORDS; ++w) words[w] |= other.words[w];
+            return *this;
+        }
+
+        inline void fill(const bool value) {
+            words.fill(value ? ~(uint64_t)0 : 0);
+            if(value) words[WORDS - 1] = get_low_bits(MINUTES_IN_WEEK - (WORDS - 1) * 64);
+        }
+    };
+
+    /** \brief Маски торговых минут недели брокера
+     *
+     * Для каждой валютной пары и длительности из списка хранится маска минут недели, в которые
+     * сделка, открытая в начале минуты (секунда 0), имеет ненулевую выплату без ошибки.
+     * Для каждой минуты недели и длительности хранится также маска открытых валютных пар,
+     * поэтому вопрос "какие пары открыты сейчас" - одно чтение, а "открыты ли все пары набора" - одно И.
+     * Праздники, заданные календарем модели, в маски недели не входят: закрытые дни календаря
+     * исключаются при запросах по меткам времени. Маски строятся методом make_tradability модели
+     * и не меняются, поэтому один объект можно использовать из нескольких потоков.
+     * Календарь модели должен существовать, пока используется объект.
+     */
+    class PayoutTradability {
+    public:
+        static const uint32_t MAX_PAIRS = 64;   ///< Наибольшее количество валютных пар (биты маски пар)
+
+    private:
+        uint32_t pairs = 0;
+        std::vector<uint32_t> durations;
+        std::vector<MinuteWeekMask> masks;      ///< Маски минут [пара][длительность]
+        std::vector<uint64_t> open_pairs;       ///< Маски открытых пар [длительность][минута недели]
+        const TradingCalendar *calendar = nullptr;
+
+        inline const bool is_closed_day(const uint64_t day) const {
+            return calendar && calendar->is_closed_day(day * xtime::SECONDS_IN_DAY);
+        }
+
+    public:
+
+        PayoutTradability() {}
+
+        /** \brief Построить маски
+         *
+         * Минута m недели проверяется сделкой в воскресенье 4 января 1970 года плюс m минут.
+         * \param user_pairs Количество валютных пар брокера (не больше MAX_PAIRS)
+         * \param user_durations Длительности опционов в секундах
+         * \param user_calendar Календарь торговли модели или nullptr
+         * \param is_tradable Функция (метка времени, длительность, номер пары), которая вернет true,
+         * если выплата без ошибки и больше нуля (без проверки закрытых дней календаря)
+         */
+        template<class F>
+        PayoutTradability(
+                const uint32_t user_pairs,
+                const std::vector<uint32_t> &user_durations,
+                const TradingCalendar *user_calendar,
+                const F &is_tradable) :
+                pairs(std::min(user_pairs, MAX_PAIRS)), durations(user_durations), calendar(user_calendar) {
+            /* 4 января 1970 года - воскресенье */
+            const xtime::timestamp_t first_timestamp_week = 3 * xtime::SECONDS_IN_DAY;
+            const size_t size = durations.size();
+            masks.resize((size_t)pairs * size);
+            open_pairs.assign(size * MINUTES_IN_WEEK, 0);
+            for(uint32_t p = 0; p < pairs; ++p)
+            for(size_t d = 0; d < size; ++d) {
+                MinuteWeekMask &mask = masks[p * size + d];
+                for(uint32_t m = 0; m < MINUTES_IN_WEEK; ++m) {
+                    if(!is_tradable(first_timestamp_week + m * xtime::SECONDS_IN_MINUTE, durations[d], p)) continue;
+                    mask.set(m, true);
+                    open_pairs[d * MINUTES_IN_WEEK + m] |= (uint64_t)1 << p;
+                }
+            }
+        }
+
+        inline const uint32_t get_pairs() const {return pairs;}
+        inline const std::vector<uint32_t> &get_durations() const {return durations;}
+
+        /** \brief Получить номер длительности в списке
+         * \param duration Длительность опциона в секундах
+         * \return Номер длительности или размер списка, если длительности нет
+         */
+        inline const uint32_t get_duration_index(const uint32_t duration) const {
+            return (uint32_t)(std::find(durations.begin(), durations.end(), duration) - durations.begin());
+        }
+
+        /** \brief Получить маску минут недели
+         * \param currency_pair_index Номер валютной пары
+         * \param duration_index Номер длительности в списке
+         * \return Маска минут недели
+         */
+        inline const MinuteWeekMask &get_mask(const uint32_t currency_pair_index, const uint32_t duration_index) const {
+            return masks[(size_t)currency_pair_index * durations.size() + duration_index];
+        }
+
+        /** \brief Получить маску минут, в которые открыты все пары набора
+         * \param pair_set Маска номеров валютных пар (бит p - валютная пара p)
+         * \param duration_index Номер длительности в списке
+         * \return Маска минут недели
+         */
+        MinuteWeekMask get_common_mask(const uint64_t pair_set, const uint32_t duration_index) const {
+            MinuteWeekMask mask;
+            mask.fill(true);
+            for(uint32_t p = 0; p < pairs; ++p) {
+                if((pair_set >> p) & 1) mask &= get_mask(p, duration_index);
+            }
+            return mask;
+        }
+
+        /** \brief Получить открытые валютные пары
+         * \param duration_index Номер длительности в списке
+         * \param timestamp Метка времени (проверяется начало минуты)
+         * \return Маска номеров валютных пар (бит p - валютная пара p)
+         */
+        inline const uint64_t get_open_pairs(const uint32_t duration_index, const xtime::timestamp_t timestamp) const {
+            if(duration_index >= durations.size() || is_closed_day(timestamp / xtime::SECONDS_IN_DAY)) return 0;
+            return open_pairs[(size_t)duration_index * MINUTES_IN_WEEK + get_minute_week(timestamp)];
+        }
+
+        /** \brief Проверить, торгуется ли валютная пара
+         * \param currency_pair_index Номер валютной пары
+         * \param duration_index Номер длительности в списке
+         * \param timestamp Метка времени (проверяется начало минуты)
+         * \return Вернет true, если сделка в начале минуты имеет выплату
+         */
+        inline const bool is_tradable(
+                const uint32_t currency_pair_index,
+                const uint32_t duration_index,
+                const xtime::timestamp_t timestamp) const {
+            if(currency_pair_index >= pairs) return false;
+            return (get_open_pairs(duration_index, timestamp) >> currency_pair_index) & 1;
+        }
+
+        /** \brief Посчитать торговые минуты маски в интервале времени
+         *
+         * Учитываются начала минут t, для которых t0 <= t < t1. Закрытые дни календаря модели пропускаются.
+         * Без календаря полные недели считаются одним подсчетом маски.
+         * \param mask Маска минут недели (get_mask или get_common_mask)
+         * \param t0 Начало интервала
+         * \param t1 Конец интервала (не включается)
+         * \return Количество торговых минут
+         */
+        const uint64_t count(const MinuteWeekMask &mask, const xtime::timestamp_t t0, const xtime::timestamp_t t1) const {
+            if(t1 <= t0) return 0;
+            uint64_t first = (t0 + xtime::SECONDS_IN_MINUTE - 1) / xtime::SECONDS_IN_MINUTE;
+            const uint64_t last = (t1 + xtime::SECONDS_IN_MINUTE - 1) / xtime::SECONDS_IN_MINUTE;
+            uint64_t sum = 0;
+            if(!calendar) {
+                const uint64_t weeks = (last - first) / MINUTES_IN_WEEK;
+                sum = weeks * mask.count();
+                first += weeks * MINUTES_IN_WEEK;
+            }
+            /* неделя начинается с начала дня, поэтому интервал внутри дня не переходит через конец недели */
+            while(first < last) {
+                const uint64_t day = first / xtime::MINUTES_IN_DAY;
+                const uint64_t end = std::min((day + 1) * xtime::MINUTES_IN_DAY, last);
+                if(!is_closed_day(day)) {
+                    const uint32_t minute = get_minute_week(first * xtime::SECONDS_IN_MINUTE);
+                    sum += mask.count(minute, minute + (uint32_t)(end - first));
+                }
+                first = end;
+            }
+            return sum;
+        }
+
+        /** \brief Посчитать торговые минуты валютной пары в интервале времени
+         * \param currency_pair_index Номер валютной пары
+         * \param duration_index Номер длительности в списке
+         * \param t0 Начало интервала
+         * \param t1 Конец интервала (не включается)
+         * \return Количество минут, в начале которых сделка имеет выплату
+         */
+        inline const uint64_t count(
+                const uint32_t currency_pair_index,
+                const uint32_t duration_index,
+                const xtime::timestamp_t t0,
+                const xtime::timestamp_t t1) const {
+            if(currency_pair_index >= pairs || duration_index >= durations.size()) return 0;
+            return count(get_mask(currency_pair_index, duration_index), t0, t1);
+        }
+    };
+}
+
+#endif // PAYOUT_MODEL_TRADABILITY_HPP_INCLUDED
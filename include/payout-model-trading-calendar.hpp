@@ -0,0 +1,332 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef PAYOUT_MODEL_TRADING_CALENDAR_HPP_INCLUDED
+#define PAYOUT_MODEL_TRADING_CALENDAR_HPP_INCLUDED
+
+#include "payout-model-rules.hpp"
+#include "payout-model-calendar-cursor.hpp"
+#include <array>
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include "xtime.hpp"
+
+namespace payout_model {
+
+    /** \brief Календарь торговли брокера
+     *
+     * Закрытые дни (выходные и праздники) хранятся битовой маской по номеру дня от 1 января 1970 года
+     * до конца LAST_YEAR, поэтому проверка дня сводится к делению метки времени на длину суток,
+     * сдвигу и маске, без разбора даты. Для дней вне диапазона проверяется только день недели.
+     * Для каждого дня недели задан интервал торговой сессии [начало, конец) в секундах дня.
+     */
+    class TradingCalendar {
+    public:
+        static const uint32_t LAST_YEAR = 2099;     ///< Последний год битовой маски
+        static const uint32_t DAYS = 47482;         ///< Количество дней с 1 января 1970 года до 1 января 2100 года
+
+    private:
+        std::array<uint64_t, (DAYS + 63) / 64> closed_days {};  ///< Битовая маска закрытых дней
+        std::array<uint64_t, (DAYS + 63) / 64> holidays {};     ///< Битовая маска праздников, заданных датой
+        uint32_t closed_weekdays = 0;                           ///< Битовая маска закрытых дней недели
+        std::array<uint32_t, xtime::DAYS_IN_WEEK> session_begin {};  ///< Начало сессии, секунда дня
+        std::array<uint32_t, xtime::DAYS_IN_WEEK> session_end {};    ///< Конец сессии, секунда дня
+
+        inline static void set_bit(std::array<uint64_t, (DAYS + 63) / 64> &mask, const uint64_t day, const bool value) {
+            if(day >= DAYS) return;
+            if(value) mask[day >> 6] |= (uint64_t)1 << (day & 63);
+            else mask[day >> 6] &= ~((uint64_t)1 << (day & 63));
+        }
+
+        inline static const bool get_bit(const std::array<uint64_t, (DAYS + 63) / 64> &mask, const uint64_t day) {
+            return (mask[day >> 6] >> (day & 63)) & 1;
+        }
+
+    public:
+
+        /** \brief Календарь без выходных и праздников с круглосуточной сессией
+         */
+        TradingCalendar() {
+            session_end.fill(xtime::SECONDS_IN_DAY);
+        }
+
+        /** \brief Создать календарь без закрытых дней с одинаковой сессией всех дней недели
+         * \param begin Начало сессии, секунда дня
+         * \param end Конец сессии, секунда дня
+         * \return Календарь торговли
+         */
+        inline static TradingCalendar make_session_calendar(const uint32_t begin, const uint32_t end) {
+            TradingCalendar calendar;
+            calendar.session_begin.fill(begin);
+            calendar.session_end.fill(end);
+            return calendar;
+        }
+
+        /** \brief Календарь с выходными в субботу и воскресенье, праздниками 1 января и 25 декабря
+         * \param user_session_begin Начало сессии всех дней недели, секунда дня
+         * \param user_session_end Конец сессии всех дней недели, секунда дня
+         */
+        TradingCalendar(const uint32_t user_session_begin, const uint32_t user_session_end) {
+            session_begin.fill(user_session_begin);
+            session_end.fill(user_session_end);
+            set_closed_weekday(xtime::SAT, true);
+            set_closed_weekday(xtime::SUN, true);
+            set_yearly_closed_day(1, xtime::JAN, true);
+            set_yearly_closed_day(25, xtime::DEC, true);
+        }
+
+        /** \brief Проверить, закрыт ли день
+         * \param timestamp Метка времени
+         * \return Вернет true, если в этот день брокер не торгует
+         */
+        inline const bool is_closed_day(const xtime::timestamp_t timestamp) const {
+            const uint64_t day = timestamp / xtime::SECONDS_IN_DAY;
+            if(day < DAYS) return get_bit(closed_days, day);
+            return (closed_weekdays >> xtime::get_weekday(timestamp)) & 1;
+        }
+
+        /** \brief Проверить, идет ли торговая сессия
+         * \param weekday День недели
+         * \param second_day Секунда дня
+         * \return Вернет true, если секунда дня внутри сессии
+         */
+        inline const bool is_session(const uint32_t weekday, const uint32_t second_day) const {
+            return second_day >= session_begin[weekday] && second_day < session_end[weekday];
+        }
+
+        /// Получить начало сессии дня недели в секундах дня
+        inline const uint32_t get_session_begin(const uint32_t weekday) const {return session_begin[weekday];}
+
+        /// Получить конец сессии дня недели в секундах дня
+        inline const uint32_t get_session_end(const uint32_t weekday) const {return session_end[weekday];}
+
+        /** \brief Проверить, одинакова ли сессия всех дней недели
+         * \param begin Начало сессии, секунда дня
+         * \param end Конец сессии, секунда дня
+         * \return Вернет true, если у всех дней недели сессия [begin, end)
+         */
+        inline const bool is_uniform_session(const uint32_t begin, const uint32_t end) const {
+            for(uint32_t w = 0; w < xtime::DAYS_IN_WEEK; ++w) {
+                if(session_begin[w] != begin || session_end[w] != end) return false;
+            }
+            return true;
+        }
+
+        /** \brief Установить сессию дня недели
+         * \param weekday День недели
+         * \param begin Начало сессии, секунда дня
+         * \param end Конец сессии, секунда дня (не включается)
+         */
+        inline void set_session(const uint32_t weekday, const uint32_t begin, const uint32_t end) {
+            if(weekday >= xtime::DAYS_IN_WEEK) return;
+            session_begin[weekday] = begin;
+            session_end[weekday] = end;
+        }
+
+        /** \brief Закрыть или открыть день недели во всех неделях
+         *
+         * При открытии дня недели праздники, заданные датой, остаются закрытыми.
+         * \param weekday День недели
+         * \param is_closed День закрыт
+         */
+        void set_closed_weekday(const uint32_t weekday, const bool is_closed) {
+            if(weekday >= xtime::DAYS_IN_WEEK) return;
+            if(is_closed) closed_weekdays |= 1U << weekday;
+            else closed_weekdays &= ~(1U << weekday);
+            /* 1 января 1970 года - четверг */
+            const uint64_t first = (weekday + xtime::DAYS_IN_WEEK - xtime::THU) % xtime::DAYS_IN_WEEK;
+            for(uint64_t day = first; day < DAYS; day += xtime::DAYS_IN_WEEK) {
+                set_bit(closed_days, day, is_closed || get_bit(holidays, day));
+            }
+        }
+
+        /** \brief Закрыть или открыть день
+         *
+         * Несуществующая дата (например, 30 февраля) игнорируется.
+         * \param day День месяца
+         * \param month Месяц
+         * \param year Год
+         * \param is_closed День закрыт
+         */
+        inline void set_closed_day(const uint32_t day, const uint32_t month, const uint32_t year, const bool is_closed) {
+            if(month < xtime::JAN || month > xtime::DEC || day < 1 ||
+                day > CalendarCursor::get_days_in_month(month, year)) return;
+            const uint64_t index = xtime::get_timestamp(day, month, year) / xtime::SECONDS_IN_DAY;
+            set_bit(holidays, index, is_closed);
+            set_bit(closed_days, index, is_closed);
+        }
+
+        /** \brief Закрыть или открыть день каждого года
+         *
+         * 29 февраля закрывается только в високосные годы.
+         * \param day День месяца
+         * \param month Месяц
+         * \param is_closed День закрыт
+         */
+        void set_yearly_closed_day(const uint32_t day, const uint32_t month, const bool is_closed) {
+            for(uint32_t year = 1970; year <= LAST_YEAR; ++year) {
+                set_closed_day(day, month, year, is_closed);
+            }
+        }
+    };
+
+    /** \brief Разобрать текст календаря торговли
+     *
+     * Каждая строка имеет вид "ключ = значение", пустые строки и текст после # пропускаются.
+     * Строки применяются по порядку поверх текущего календаря. Поддерживаемые ключи:
+     * closed = ГГГГ-ММ-ДД и open = ГГГГ-ММ-ДД - закрыть или открыть день,
+     * closed_yearly = ММ-ДД и open_yearly = ММ-ДД - закрыть или открыть день каждого года
+     * (02-29 действует только в високосные годы), несуществующие даты считаются ошибкой,
+     * session.<mon|tue|wed|thu|fri|sat|sun> = ЧЧ:ММ-ЧЧ:ММ - сессия дня недели (день недели открывается),
+     * session.<день недели> = closed - закрыть день недели.
+     * \param[in] text Текст календаря
+     * \param[in,out] calendar Календарь, в который записываются значения
+     * \param[out] error_line Номер строки с ошибкой, начиная с 1 (0, если ошибки нет)
+     * \return Вернет ErrorType::OK или код ошибки, см. RulesErrorType. В случае ошибки calendar не изменяется
+     */
+    inline const int parse_trading_calendar(
+            const std::string_view text,
+            TradingCalendar &calendar,
+            uint32_t &error_line) {
+        static const char *weekday_names[xtime::DAYS_IN_WEEK] = {"sun", "mon", "tue", "wed", "thu", "fri", "sat"};
+        TradingCalendar temp = calendar;
+        error_line = 0;
+        uint32_t line_number = 0;
+        size_t pos = 0;
+
+        /* разобрать число из заданного количества цифр */
+        auto parse_number = [](const std::string_view str, const size_t offset, const size_t digits, uint32_t &value) {
+            if(offset + digits > str.size()) return false;
+            value = 0;
+            for(size_t i = offset; i < offset + digits; ++i) {
+                if(str[i] < '0' || str[i] > '9') return false;
+                value = value * 10 + (uint32_t)(str[i] - '0');
+            }
+            return true;
+        };
+        auto parse_time = [&](const std::string_view str, const size_t offset, uint32_t &second_day) {
+            uint32_t hour = 0, minute = 0;
+            if(!parse_number(str, offset, 2, hour) || str[offset + 2] != ':' ||
+                !parse_number(str, offset + 3, 2, minute)) return false;
+            if(minute >= xtime::MINUTES_IN_HOUR || hour > 24 || (hour == 24 && minute != 0)) return false;
+            second_day = hour * xtime::SECONDS_IN_HOUR + minute * xtime::SECONDS_IN_MINUTE;
+            return true;
+        };
+
+        while(pos < text.size()) {
+            size_t end = text.find('\n', pos);
+            if(end == std::string_view::npos) end = text.size();
+            std::string_view line = text.substr(pos, end - pos);
+            pos = end + 1;
+            ++line_number;
+
+            const size_t comment = line.find('#');
+            if(comment != std::string_view::npos) line = line.substr(0, comment);
+            const size_t first = line.find_first_not_of(" \t\r");
+            if(first == std::string_view::npos) continue;
+
+            const size_t equal = line.find('=');
+            if(equal == std::string_view::npos) {
+                error_line = line_number;
+                return RulesErrorType::RULES_SYNTAX_ERROR;
+            }
+            std::string_view key = line.substr(first, equal - first);
+            key = key.substr(0, key.find_last_not_of(" \t") + 1);
+            std::string_view value = line.substr(equal + 1);
+            const size_t value_first = value.find_first_not_of(" \t");
+            value = value_first == std::string_view::npos ? std::string_view() : value.substr(value_first);
+            value = value.substr(0, value.find_last_not_of(" \t\r") + 1);
+
+            int err = RulesErrorType::RULES_INVALID_VALUE;
+            uint32_t year = 0, month = 0, day = 0;
+            if(key == "closed" || key == "open") {
+                if(value.size() == 10 && value[4] == '-' && value[7] == '-' &&
+                    parse_number(value, 0, 4, year) && parse_number(value, 5, 2, month) && parse_number(value, 8, 2, day) &&
+                    year >= 1970 && year <= TradingCalendar::LAST_YEAR && month >= 1 && month <= 12 && day >= 1 && day <= CalendarCursor::get_days_in_month(month, year)) {
+                    temp.set_closed_day(day, month, year, key == "closed");
+                    err = ErrorType::OK;
+                }
+            } else
+            if(key == "closed_yearly" || key == "open_yearly") {
+                if(value.size() == 5 && value[2] == '-' &&
+                    parse_number(value, 0, 2, month) && parse_number(value, 3, 2, day) &&
+                    month >= 1 && month <= 12 && day >= 1 && day <= CalendarCursor::get_days_in_month(month, 2000)) {
+                    temp.set_yearly_closed_day(day, month, key == "closed_yearly");
+                    err = ErrorType::OK;
+                }
+            } else
+            if(key.substr(0, 8) == "session.") {
+                uint32_t weekday = xtime::DAYS_IN_WEEK;
+                for(uint32_t w = 0; w < xtime::DAYS_IN_WEEK; ++w) {
+                    if(key.substr(8) == weekday_names[w]) weekday = w;
+                }
+                uint32_t begin = 0, end_second = 0;
+                if(weekday == xtime::DAYS_IN_WEEK) {
+                    err = RulesErrorType::RULES_UNKNOWN_KEY;
+                } else
+                if(value == "closed") {
+                    temp.set_closed_weekday(weekday, true);
+                    err = ErrorType::OK;
+                } else
+                if(value.size() == 11 && value[5] == '-' && parse_time(value, 0, begin) &&
+                    parse_time(value, 6, end_second) && begin < end_second) {
+                    temp.set_closed_weekday(weekday, false);
+                    temp.set_session(weekday, begin, end_second);
+                    err = ErrorType::OK;
+                }
+            } else {
+                err = RulesErrorType::RULES_UNKNOWN_KEY;
+            }
+
+            if(err != ErrorType::OK) {
+                error_line = line_number;
+                return err;
+            }
+        }
+        calendar = temp;
+        return ErrorType::OK;
+    }
+
+    /** \brief Загрузить календарь торговли из файла
+     * \param[in] file_name Имя файла календаря
+     * \param[in,out] calendar Календарь, в который записываются значения
+     * \param[out] error_line Номер строки с ошибкой, начиная с 1 (0, если ошибки нет)
+     * \return Вернет ErrorType::OK или код ошибки, см. RulesErrorType. В случае ошибки calendar не изменяется
+     */
+    inline const int load_trading_calendar(
+            const std::string &file_name,
+            TradingCalendar &calendar,
+            uint32_t &error_line) {
+        error_line = 0;
+        std::ifstream file(file_name);
+        if(!file) return RulesErrorType::RULES_FILE_NOT_OPEN;
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return parse_trading_calendar(buffer.str(), calendar, error_line);
+    }
+}
+
+#endif // PAYOUT_MODEL_TRADING_CALENDAR_HPP_INCLUDED
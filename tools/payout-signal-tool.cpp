@@ -0,0 +1,131 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* Пакетный расчет файла сигналов
+ *
+ * payout-signal-tool <payout|amount> <intrade_bar|grandcapital> <rub|usd> <файл сигналов> <файл результатов>
+ *     [--threads N] [--chunk N] [--rules файл правил]
+ *
+ * Формат файлов описан в payout-model-signal-file.hpp.
+ * Коды возврата: 0 - успех, 1 - ошибка файла, 3 - неверные аргументы
+ */
+#include "payout-model-rules.hpp"
+#include "payout-model-signal-file.hpp"
+#include "intrade-bar-payout-model.hpp"
+#include "grandcapital-payout-model.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+    const char *get_signal_error_name(const int err) {
+        switch(err) {
+        case payout_model::SignalFileErrorType::SIGNAL_FILE_NOT_OPEN: return "file not open";
+        case payout_model::SignalFileErrorType::SIGNAL_WRITE_ERROR: return "write error";
+        case payout_model::SignalFileErrorType::SIGNAL_BAD_FORMAT: return "bad format";
+        case payout_model::SignalFileErrorType::SIGNAL_BAD_VERSION: return "unsupported version";
+        default: return "unknown error";
+        }
+    }
+
+    void print_usage() {
+        std::printf("usage:\n"
+            "  payout-signal-tool <payout|amount> <intrade_bar|grandcapital> <rub|usd> <signals file> <results file>\n"
+            "      [--threads N] [--chunk N] [--rules rules file]\n");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if(argc < 6) {
+        print_usage();
+        return 3;
+    }
+    const std::string mode(argv[1]);
+    const std::string broker(argv[2]);
+    const std::string currency(argv[3]);
+    const std::string signal_file_name(argv[4]);
+    const std::string result_file_name(argv[5]);
+
+    payout_model::PayoutSignalConfig config;
+    std::string rules_file_name;
+    for(int i = 6; i < argc; ++i) {
+        const std::string arg(argv[i]);
+        const bool has_value = i + 1 < argc;
+        if(arg == "--threads" && has_value) config.threads = (uint32_t)std::max(0, std::atoi(argv[++i]));
+        else if(arg == "--chunk" && has_value) config.chunk = (size_t)std::max(1, std::atoi(argv[++i]));
+        else if(arg == "--rules" && has_value) rules_file_name = argv[++i];
+        else {
+            print_usage();
+            return 3;
+        }
+    }
+    if(mode == "payout") config.mode = payout_model::SIGNAL_PAYOUT;
+    else if(mode == "amount") config.mode = payout_model::SIGNAL_AMOUNT;
+    else {
+        print_usage();
+        return 3;
+    }
+    if((broker != "intrade_bar" && broker != "grandcapital") || (currency != "rub" && currency != "usd")) {
+        print_usage();
+        return 3;
+    }
+    /* валюты счета у брокеров совпадают */
+    const uint32_t account_currency = currency == "rub" ?
+        payout_model::IntradeBar::CURRENCY_RUB : payout_model::IntradeBar::CURRENCY_USD;
+
+    payout_model::PayoutRules rules;
+    if(!rules_file_name.empty()) {
+        uint32_t error_line = 0;
+        const int err = payout_model::load_payout_rules(rules_file_name, rules, error_line);
+        if(err != payout_model::ErrorType::OK) {
+            std::printf("failed to load rules: %s (error %d, line %u)\n", rules_file_name.c_str(), err, error_line);
+            return 1;
+        }
+    }
+
+    typedef std::chrono::steady_clock clock;
+    const clock::time_point start = clock::now();
+    uint64_t records = 0;
+    int err = payout_model::ErrorType::OK;
+    if(broker == "intrade_bar") {
+        payout_model::IntradeBar model(account_currency);
+        model.set_rules(rules.intrade_bar);
+        err = payout_model::evaluate_payout_signals(model, signal_file_name, result_file_name, config, &records);
+    } else {
+        payout_model::Grandcapital model(account_currency);
+        model.set_rules(rules.grandcapital);
+        err = payout_model::evaluate_payout_signals(model, signal_file_name, result_file_name, config, &records);
+    }
+    if(err != payout_model::ErrorType::OK) {
+        std::printf("failed to evaluate signals: %s -> %s (%s)\n",
+            signal_file_name.c_str(), result_file_name.c_str(), get_signal_error_name(err));
+        return 1;
+    }
+    const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+    std::printf("%s: %llu signals, %.3f s, %.0f signals/s\n", result_file_name.c_str(),
+        (unsigned long long)records, seconds, seconds > 0 ? (double)records / seconds : 0.0);
+    return 0;
+}
@@ -0,0 +1,102 @@
+/*
+* bo-payout-model - C ++ header-only library with binary payout brokers percent payout models
+*
+* Copyright (c) 2020 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* Построение и проверка файла поверхности выплат
+ *
+ * payout-surface-tool build <файл> [файл правил]   построить файл по встроенным правилам или по файлу правил
+ * payout-surface-tool verify <файл>                проверить версию, размеры и контрольную сумму файла
+ *
+ * Коды возврата: 0 - успех, 1 - ошибка файла, 3 - неверные аргументы
+ */
+#include "payout-model-rules.hpp"
+#include "payout-model-surface.hpp"
+#include <cstdio>
+#include <string>
+
+namespace {
+
+    const char *get_surface_error_name(const int err) {
+        switch(err) {
+        case payout_model::SurfaceErrorType::SURFACE_FILE_NOT_OPEN: return "file not open";
+        case payout_model::SurfaceErrorType::SURFACE_WRITE_ERROR: return "write error";
+        case payout_model::SurfaceErrorType::SURFACE_BAD_FORMAT: return "bad format";
+        case payout_model::SurfaceErrorType::SURFACE_BAD_VERSION: return "unsupported version";
+        case payout_model::SurfaceErrorType::SURFACE_BAD_CHECKSUM: return "checksum mismatch";
+        case payout_model::SurfaceErrorType::SURFACE_TOO_MANY_PAYOUTS: return "too many distinct payouts";
+        default: return "unknown error";
+        }
+    }
+
+    void print_usage() {
+        std::printf("usage:\n"
+            "  payout-surface-tool build <file> [rules file]\n"
+            "  payout-surface-tool verify <file>\n");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if(argc < 3) {
+        print_usage();
+        return 3;
+    }
+    const std::string command(argv[1]);
+    const std::string file_name(argv[2]);
+
+    if(command == "build" && argc <= 4) {
+        payout_model::PayoutRules rules;
+        if(argc == 4) {
+            uint32_t error_line = 0;
+            const int err = payout_model::load_payout_rules(argv[3], rules, error_line);
+            if(err != payout_model::ErrorType::OK) {
+                std::printf("failed to load rules: %s (error %d, line %u)\n", argv[3], err, error_line);
+                return 1;
+            }
+        }
+        const int err = payout_model::save_payout_surface(file_name, rules);
+        if(err != payout_model::ErrorType::OK) {
+            std::printf("failed to save payout surface: %s (%s)\n", file_name.c_str(), get_surface_error_name(err));
+            return 1;
+        }
+    } else
+    if(command != "verify" || argc != 3) {
+        print_usage();
+        return 3;
+    }
+
+    payout_model::PayoutSurfaceFile file;
+    const int err = file.open(file_name);
+    if(err != payout_model::ErrorType::OK) {
+        std::printf("invalid payout surface: %s (%s)\n", file_name.c_str(), get_surface_error_name(err));
+        return 1;
+    }
+    const payout_model::PayoutSurfaceHeader *header = file.get_header();
+    std::printf("%s: version %u, %llu bytes, checksum %016llx\n",
+        file_name.c_str(), header->version,
+        (unsigned long long)header->file_size, (unsigned long long)header->checksum);
+    std::printf("intrade_bar: %u pairs x %u minutes x %u cells\n",
+        header->intrade_bar_pairs, header->minutes, header->intrade_bar_cells);
+    std::printf("grandcapital: %u pairs x %u minutes x %u cells\n",
+        header->grandcapital_pairs, header->minutes, header->grandcapital_cells);
+    return 0;
+}